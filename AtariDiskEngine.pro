@@ -1,4 +1,4 @@
-QT       += core gui widgets
+QT       += core gui widgets concurrent network
 
 TARGET = AtariDiskEngine
 TEMPLATE = app
@@ -6,24 +6,98 @@ TEMPLATE = app
 # Standard C++17 requirement for our engine logic
 CONFIG += c++17
 
+# "qmake CONFIG+=coroutines" builds as C++20 so UI code can co_await
+# AsyncEngine calls; without it they are chained with AsyncOp::then()
+coroutines {
+    CONFIG -= c++17
+    CONFIG += c++2a
+    DEFINES += ATARI_COROUTINES
+    gcc:!clang: QMAKE_CXXFLAGS += -fcoroutines
+}
+
 # The QT_CORE_LIB define enables our Qt Bridge in the header
 DEFINES += QT_CORE_LIB
 
+# System zlib inflates disk images stored inside zip archives and measures
+# how well normalized images compress
+LIBS += -lz
+
 # Directory mapping to match our repository tree
 INCLUDEPATH += include ui
 
 HEADERS += \
+    include/ArchiveReader.h \
+    include/AsyncEngine.h \
     include/AtariDiskEngine.h \
+    include/AtariText.h \
+    include/CommandLine.h \
     include/AtariFileSystemModel.h \
+    include/BootSectorAnalyzer.h \
+    include/BootSectorBatch.h \
+    include/Depacker.h \
+    include/DiskBytes.h \
+    include/DiskMaster.h \
+    include/FatVolume.h \
+    include/FileSystemCheck.h \
+    include/FileView.h \
+    include/FolderSync.h \
+    include/GemdosDrive.h \
+    include/GemdosProgram.h \
+    include/HfeImage.h \
+    include/ImageDaemon.h \
+    include/ImageNormalizer.h \
+    include/ImageSniffer.h \
+    include/ImageTransfer.h \
+    include/M68kDisassembler.h \
+    include/MemoryBudget.h \
+    include/MfmCodec.h \
+    include/ScpImage.h \
+    include/StPicture.h \
+    include/StructureMap.h \
+    include/ZipArchive.h \
     ui/MainWindow.h \
-    ui/HexViewWidget.h
+    ui/HexViewWidget.h \
+    ui/DisassemblyView.h \
+    ui/PictureBrowser.h \
+    ui/CorpusBrowser.h \
+    ui/TextViewWidget.h
 
 SOURCES += \
     src/main.cpp \
+    src/ArchiveReader.cpp \
+    src/AsyncEngine.cpp \
     src/AtariDiskEngine.cpp \
+    src/AtariText.cpp \
+    src/CommandLine.cpp \
     src/AtariFileSystemModel.cpp \
+    src/BootSectorAnalyzer.cpp \
+    src/BootSectorBatch.cpp \
+    src/Depacker.cpp \
+    src/DiskMaster.cpp \
+    src/FatVolume.cpp \
+    src/FileSystemCheck.cpp \
+    src/FileView.cpp \
+    src/FolderSync.cpp \
+    src/GemdosDrive.cpp \
+    src/GemdosProgram.cpp \
+    src/HfeImage.cpp \
+    src/ImageDaemon.cpp \
+    src/ImageNormalizer.cpp \
+    src/ImageSniffer.cpp \
+    src/ImageTransfer.cpp \
+    src/M68kDisassembler.cpp \
+    src/MemoryBudget.cpp \
+    src/MfmCodec.cpp \
+    src/ScpImage.cpp \
+    src/StPicture.cpp \
+    src/StructureMap.cpp \
+    src/ZipArchive.cpp \
     ui/MainWindow.cpp \
-    ui/HexViewWidget.cpp
+    ui/HexViewWidget.cpp \
+    ui/DisassemblyView.cpp \
+    ui/PictureBrowser.cpp \
+    ui/CorpusBrowser.cpp \
+    ui/TextViewWidget.cpp
 
 # Output directories
 DESTDIR = bin
@@ -0,0 +1,30 @@
+# libataridisk: the FAT12 reader behind a C ABI, for embedding in
+# emulators and tools. Deliberately free of Qt; see include/AtariDiskApi.h.
+
+TARGET = ataridisk
+TEMPLATE = lib
+VERSION = 1.0.0
+
+CONFIG += c++17 shared
+CONFIG -= qt
+
+# Exports only the atari_* entry points
+DEFINES += ATARI_DISK_BUILD
+QMAKE_CXXFLAGS += -fvisibility=hidden -fvisibility-inlines-hidden
+
+INCLUDEPATH += include
+
+HEADERS += \
+    include/AtariDiskApi.h \
+    include/DiskBytes.h \
+    include/FatVolume.h \
+    include/FileView.h
+
+SOURCES += \
+    src/AtariDiskApi.cpp \
+    src/FatVolume.cpp \
+    src/FileView.cpp
+
+# Output directories
+DESTDIR = bin
+OBJECTS_DIR = obj/lib
@@ -0,0 +1,85 @@
+/**
+ * @file ArchiveReader.h
+ * @brief Read-only ARC and LZH archive access over a FileView.
+ *
+ * Archives are listed by walking their local headers in place; members
+ * are decoded on demand by streaming the compressed bytes through the view,
+ * so an archive on a disk is never extracted to the host first.
+ */
+
+#ifndef ARCHIVEREADER_H
+#define ARCHIVEREADER_H
+
+#include "FileView.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Atari {
+
+/** @brief Largest member we are willing to decode (guards against bombs). */
+inline constexpr uint32_t ARCHIVE_MEMBER_SIZE_LIMIT = 16 * 1024 * 1024;
+
+enum class ArchiveFormat { Unknown, Arc, Lzh };
+
+/**
+ * @struct ArchiveMember
+ * @brief One member of an ARC or LZH archive.
+ */
+struct ArchiveMember {
+  std::string name;            /**< Path inside the archive ('/' separated). */
+  std::string method;          /**< "-lh5-", "crunched", ... */
+  uint8_t arcMethod = 0;       /**< ARC method byte (0 for LZH). */
+  uint32_t compressedSize = 0;
+  uint32_t size = 0;
+  uint32_t dataOffset = 0;     /**< Archive offset of the compressed data. */
+  uint16_t crc16 = 0;          /**< CRC-16 (ARC polynomial) of the data. */
+};
+
+/**
+ * @class ArchiveReader
+ * @brief Lists and decodes members of an ARC or LZH archive.
+ *
+ * Supported methods: ARC stored, packed (RLE), squeezed, crunched (LZW
+ * with RLE) and squashed; LZH -lh0-, -lz4- and -lh4- to -lh7-.
+ */
+class ArchiveReader {
+public:
+  /** @brief Reads the member headers; the view must outlive the reader. */
+  explicit ArchiveReader(const FileView &file);
+
+  /** @return True if a member list was read. */
+  bool isOpen() const { return m_format != ArchiveFormat::Unknown; }
+
+  /** @return Detected container format. */
+  ArchiveFormat format() const { return m_format; }
+
+  /** @return Members in archive order. */
+  const std::vector<ArchiveMember> &members() const { return m_members; }
+
+  /**
+   * @brief Decodes one member and checks its CRC.
+   * @param error Receives a reason on failure.
+   * @return True on success.
+   */
+  bool readMember(const ArchiveMember &member, std::vector<uint8_t> &out,
+                  std::string &error) const;
+
+  /** @return True for .ARC, .LZH and .LHA file names. */
+  static bool isArchiveName(const std::string &name);
+
+private:
+  bool readArcHeaders();
+  bool readLzhHeaders();
+
+  FileView m_file;
+  ArchiveFormat m_format = ArchiveFormat::Unknown;
+  std::vector<ArchiveMember> m_members;
+};
+
+/** @return CRC-16 with the ARC/LHA polynomial (0xA001, reflected). */
+uint16_t crc16Arc(const uint8_t *data, std::size_t size, uint16_t crc = 0);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file AsyncEngine.h
+ * @brief Engine calls that run off the UI thread and report back to it.
+ *
+ * Every call returns an AsyncOp at once. Results arrive through then() on
+ * the thread of a context object, or through co_await when the project is
+ * built with "qmake CONFIG+=coroutines" (C++20):
+ *
+ *   Atari::AsyncTask MainWindow::openDisk(QString path) {
+ *     if (!co_await m_async->load(path))
+ *       co_return;
+ *     const Atari::FsckReport report = co_await m_async->fsck();
+ *     ...
+ *   }
+ *
+ * Without the option the same code reads
+ * m_async->load(path).then(this, [this](bool ok) { ... }).
+ */
+
+#ifndef ASYNCENGINE_H
+#define ASYNCENGINE_H
+
+#include "AtariDiskEngine.h"
+#include "FileSystemCheck.h"
+#include <QByteArray>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#ifdef ATARI_COROUTINES
+#include <coroutine>
+#endif
+
+namespace Atari {
+
+/**
+ * @class AsyncOp
+ * @brief A pending engine call; a thin handle over QFuture<T>.
+ */
+template <typename T> class AsyncOp {
+public:
+  explicit AsyncOp(QFuture<T> future) : m_future(std::move(future)) {}
+
+  QFuture<T> future() const { return m_future; }
+  bool isFinished() const { return m_future.isFinished(); }
+
+  /** @brief Blocks until done; meant for the command line and tests. */
+  T result() const { return m_future.result(); }
+
+  /**
+   * @brief Calls f(result) on context's thread once the call is done.
+   *
+   * Must be called from context's thread. If context is destroyed first,
+   * f is never called.
+   */
+  template <typename F> void then(QObject *context, F f) const {
+    auto *watcher = new QFutureWatcher<T>(context);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, context,
+                     [watcher, f = std::move(f)]() mutable {
+                       watcher->deleteLater();
+                       f(watcher->result());
+                     });
+    watcher->setFuture(m_future);
+  }
+
+#ifdef ATARI_COROUTINES
+  /** @brief Resumes the coroutine on the awaiting thread's event loop. */
+  struct Awaiter {
+    QFuture<T> future;
+
+    bool await_ready() const { return future.isFinished(); }
+    void await_suspend(std::coroutine_handle<> handle) {
+      auto *watcher = new QFutureWatcher<T>();
+      QObject::connect(watcher, &QFutureWatcherBase::finished,
+                       [watcher, handle] {
+                         watcher->deleteLater();
+                         handle.resume();
+                       });
+      watcher->setFuture(future);
+    }
+    T await_resume() const { return future.result(); }
+  };
+
+  Awaiter operator co_await() const { return Awaiter{m_future}; }
+#endif
+
+private:
+  QFuture<T> m_future;
+};
+
+#ifdef ATARI_COROUTINES
+/**
+ * @struct AsyncTask
+ * @brief Return type of fire-and-forget coroutines, e.g. UI slots that
+ * co_await engine calls. The coroutine starts at once and frees itself.
+ */
+struct AsyncTask {
+  struct promise_type {
+    AsyncTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+#endif
+
+/**
+ * @class AsyncEngine
+ * @brief Owns an engine and runs calls on it from a one-thread pool.
+ *
+ * Calls run one at a time in the order they were made, so a save queued
+ * after an inject sees the injected file. The engine itself is not
+ * thread-safe: read it directly only while isIdle().
+ */
+class AsyncEngine : public QObject {
+  Q_OBJECT
+
+public:
+  explicit AsyncEngine(QObject *parent = nullptr);
+
+  /** @brief Waits for queued calls to finish. */
+  ~AsyncEngine() override;
+
+  /** @brief Loads an image (archive member paths allowed). */
+  AsyncOp<bool> load(const QString &path);
+
+  /**
+   * @brief Loads image bytes, e.g. a snapshot of an image the UI is
+   * editing. There is no file behind it until save() names one.
+   */
+  AsyncOp<bool> load(std::vector<uint8_t> image);
+
+  /**
+   * @brief Saves the image. Saving back to the loaded file writes only
+   * the sectors changed since the last load or save.
+   */
+  AsyncOp<bool> save(const QString &path);
+
+  /** @brief Copies a host file into the root directory. */
+  AsyncOp<bool> inject(const QString &localPath);
+
+  /** @brief Writes one file of the image to the host. */
+  AsyncOp<bool> extract(const DirEntry &entry, const QString &hostPath);
+
+  /** @see AtariDiskEngine::searchPattern() */
+  AsyncOp<QVector<SearchResult>> search(const QByteArray &pattern);
+
+  /** @see checkFileSystem() */
+  AsyncOp<FsckReport> fsck();
+
+  /** @return True when no call is queued or running. */
+  bool isIdle() const { return m_pending == 0; }
+
+  /** @brief Direct access between calls; see the class notes. */
+  const AtariDiskEngine &engine() const { return m_engine; }
+
+signals:
+  /** @brief The image was loaded or modified; emitted from the pool. */
+  void imageChanged();
+
+private:
+  template <typename F> auto enqueue(F job) -> AsyncOp<decltype(job())>;
+
+  AtariDiskEngine m_engine;
+  QString m_path;                /**< File the image came from or went to. */
+  uint32_t m_flushedCounter = 0; /**< changeCounter() at that point. */
+  std::atomic<int> m_pending{0};
+  QThreadPool m_pool;
+};
+
+} // namespace Atari
+#endif
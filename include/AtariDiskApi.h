@@ -0,0 +1,166 @@
+/**
+ * @file AtariDiskApi.h
+ * @brief Stable C interface to the FAT12 reader, for embedding.
+ *
+ * Built as libataridisk (AtariDiskLib.pro) with no Qt dependency, so
+ * emulators and C tools can inspect disks in process. All state sits
+ * behind opaque handles; every allocation goes through the allocator
+ * passed to atari_open_*(), or malloc/free if none is given. Images opened
+ * with ATARI_OPEN_BORROW are read in place and never copied.
+ *
+ * Only images with a usable BPB are supported; the application's
+ * heuristics for BPB-less disks are not part of the library. Paths inside
+ * the image use '/' or '\\' and match 8.3 names case-insensitively.
+ *
+ * Handles are not thread-safe, but distinct handles may be used from
+ * different threads. No function throws or calls exit().
+ */
+
+#ifndef ATARIDISKAPI_H
+#define ATARIDISKAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(ATARI_DISK_BUILD)
+#define ATARI_API __declspec(dllexport)
+#else
+#define ATARI_API __declspec(dllimport)
+#endif
+#else
+#define ATARI_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Bumped when a signature or struct layout changes. */
+#define ATARI_API_VERSION 1
+
+typedef enum atari_status {
+  ATARI_OK = 0,
+  ATARI_E_ARGUMENT = -1,  /**< Null handle, buffer or path. */
+  ATARI_E_IO = -2,        /**< Host file could not be read. */
+  ATARI_E_FORMAT = -3,    /**< No usable FAT12 BPB. */
+  ATARI_E_NOT_FOUND = -4, /**< No such file or directory in the image. */
+  ATARI_E_NO_MEMORY = -5, /**< The allocator returned null. */
+  ATARI_E_NOT_DIR = -6,   /**< A path component is a file. */
+  ATARI_E_IS_DIR = -7     /**< File operation on a directory. */
+} atari_status;
+
+/**
+ * @brief Caller-supplied memory functions.
+ *
+ * free receives the size that was passed to alloc, for pool allocators.
+ */
+typedef struct atari_allocator {
+  void *(*alloc)(size_t size, void *user);
+  void (*free)(void *ptr, size_t size, void *user);
+  void *user;
+} atari_allocator;
+
+/** @brief Flags for atari_open_buffer(). */
+enum {
+  /** Read the caller's buffer in place; it must outlive the handle. */
+  ATARI_OPEN_BORROW = 1
+};
+
+typedef struct atari_disk atari_disk;
+typedef struct atari_dir atari_dir;
+
+/** @brief One directory entry. */
+typedef struct atari_entry {
+  char name[13];          /**< "NAME.EXT", NUL-terminated. */
+  uint8_t attributes;     /**< FAT attribute bits; 0x10 is a directory. */
+  uint16_t start_cluster;
+  uint16_t dos_time;      /**< Packed hours, minutes, seconds / 2. */
+  uint16_t dos_date;      /**< Packed year - 1980, month, day. */
+  uint32_t size;          /**< Bytes; 0 for directories. */
+} atari_entry;
+
+/** @brief Volume totals from the FAT. */
+typedef struct atari_stats {
+  uint32_t cluster_bytes;
+  uint32_t total_clusters;
+  uint32_t free_clusters;
+  uint32_t bad_clusters;
+  uint64_t total_bytes;
+  uint64_t free_bytes;
+  uint32_t file_count; /**< Whole tree, not counting "." and "..". */
+  uint32_t dir_count;
+} atari_stats;
+
+/**
+ * @brief Called once per match by atari_search().
+ * @param path '/' separated path of the file.
+ * @return Non-zero to stop the search.
+ */
+typedef int (*atari_search_fn)(const char *path, uint32_t offset, void *user);
+
+/** @return ATARI_API_VERSION of the library actually loaded. */
+ATARI_API int atari_api_version(void);
+
+/** @return A short English description of a status code. */
+ATARI_API const char *atari_status_string(atari_status status);
+
+/**
+ * @brief Opens an image held in memory.
+ * @param allocator May be null for malloc/free; copied into the handle.
+ */
+ATARI_API atari_status atari_open_buffer(const void *data, size_t size,
+                                         unsigned flags,
+                                         const atari_allocator *allocator,
+                                         atari_disk **disk);
+
+/** @brief Reads a raw (.ST) image file into allocator memory and opens it. */
+ATARI_API atari_status atari_open_path(const char *path,
+                                       const atari_allocator *allocator,
+                                       atari_disk **disk);
+
+/** @brief Releases a handle; open directory iterators must be closed first. */
+ATARI_API void atari_close(atari_disk *disk);
+
+/** @brief Volume totals from the FAT and a walk of the directory tree. */
+ATARI_API atari_status atari_get_stats(atari_disk *disk, atari_stats *stats);
+
+/** @brief Looks up one file or directory ("" or "/" is the root). */
+ATARI_API atari_status atari_stat(atari_disk *disk, const char *path,
+                                  atari_entry *entry);
+
+/** @brief Starts iterating a directory ("" or "/" is the root). */
+ATARI_API atari_status atari_opendir(atari_disk *disk, const char *path,
+                                     atari_dir **dir);
+
+/**
+ * @brief Fetches the next live entry; deleted slots, volume labels and
+ * "." / ".." are skipped.
+ * @return 1 with entry filled, 0 at the end.
+ */
+ATARI_API int atari_readdir(atari_dir *dir, atari_entry *entry);
+
+ATARI_API void atari_closedir(atari_dir *dir);
+
+/**
+ * @brief Copies file bytes [offset, offset + capacity) into buf.
+ * @param read Bytes copied; short at end of file. May be null.
+ */
+ATARI_API atari_status atari_read(atari_disk *disk, const char *path,
+                                  uint32_t offset, void *buf, size_t capacity,
+                                  size_t *read);
+
+/**
+ * @brief Finds a byte pattern in every file of the image.
+ *
+ * Files stored in one run of clusters are searched in place; fragmented
+ * files are gathered into one scratch buffer from the allocator.
+ */
+ATARI_API atari_status atari_search(atari_disk *disk, const void *pattern,
+                                    size_t length, atari_search_fn callback,
+                                    void *user);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
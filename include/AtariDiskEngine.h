@@ -6,6 +6,9 @@
 #ifndef ATARIDISKENGINE_H
 #define ATARIDISKENGINE_H
 
+#include "DiskBytes.h"
+#include "FatVolume.h"
+#include "FileView.h"
 #include <QByteArray>
 #include <QString>
 #include <QVector>
@@ -20,47 +23,6 @@
  */
 namespace Atari {
 
-/** @brief Standard sector size for Atari ST disks (512 bytes). */
-inline constexpr uint16_t SECTOR_SIZE = 512;
-/** @brief Size of a directory entry in FAT12 (32 bytes). */
-inline constexpr uint16_t DIRENT_SIZE = 32;
-/** @brief Target value for the boot sector checksum (0x1234). */
-inline constexpr uint16_t BOOT_CHECKSUM_TARGET = 0x1234;
-
-/**
- * @brief Reads a 16-bit little-endian value from a buffer.
- * @param p Pointer to the start of the 16-bit value.
- * @return The 16-bit value in host byte order.
- */
-inline uint16_t readLE16(const uint8_t *p) { return p[0] | (p[1] << 8); }
-
-/**
- * @brief Reads a 16-bit big-endian value from a buffer.
- * @param p Pointer to the start of the 16-bit value.
- * @return The 16-bit value in host byte order.
- */
-inline uint16_t readBE16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
-
-/**
- * @brief Writes a 16-bit value in little-endian format to a buffer.
- * @param p Pointer to the destination buffer.
- * @param val The 16-bit value to write.
- */
-inline void writeLE16(uint8_t *p, uint16_t val) {
-  p[0] = val & 0xFF;
-  p[1] = (val >> 8) & 0xFF;
-}
-
-/**
- * @brief Writes a 16-bit value in big-endian format to a buffer.
- * @param p Pointer to the destination buffer.
- * @param val The 16-bit value to write.
- */
-inline void writeBE16(uint8_t *p, uint16_t val) {
-  p[0] = (val >> 8) & 0xFF;
-  p[1] = val & 0xFF;
-}
-
 /**
  * @struct DiskStats
  * @brief Contains statistics about the disk image.
@@ -178,6 +140,9 @@ public:
   /** @brief Fixes the boot sector checksum to make the disk executable. */
   bool fixBootChecksum();
 
+  /** @brief Fixes the checksum word of an arbitrary 512-byte buffer. */
+  static void fixBootChecksum(uint8_t *sector512) noexcept;
+
   /** @brief Validates checksum for an arbitrary 512-byte buffer. */
   AtariDiskEngine() = default;
 
@@ -190,6 +155,9 @@ public:
   /** @brief Loads disk image data into the engine. */
   void load(const std::vector<uint8_t> &data);
 
+  /** @brief Loads disk image data into the engine, taking ownership. */
+  void load(std::vector<uint8_t> &&data);
+
   /** @return True if an image is currently loaded. */
   bool isLoaded() const { return !m_image.empty(); }
 
@@ -200,12 +168,52 @@ public:
    */
   std::vector<DirEntry> readSubDirectory(uint16_t startCluster) const;
 
+  /**
+   * @return Image sectors that readRootDirectory() (startCluster 0) or
+   * readSubDirectory() parse, ascending.
+   */
+  std::vector<uint32_t> directorySectors(uint16_t startCluster) const;
+
   /** @return Raw bytes of a file specified by its directory entry. */
   std::vector<uint8_t> readFile(const DirEntry &entry) const;
 
-  /** @brief Loads an image from a file path. */
+  /**
+   * @brief Maps a file's cluster chain onto the image without copying.
+   * @return A view valid until the image is modified or reloaded.
+   */
+  FileView fileView(const DirEntry &entry) const;
+
+  /**
+   * @brief Loads an image from a file path.
+   *
+   * Paths of the form "archive.zip!/path/inside.st" inflate that member
+   * straight into the engine buffer.
+   */
   bool loadImage(const QString &path);
 
+  /**
+   * @brief Writes the sectors changed since a changeCounter() value back
+   * into the image file they were loaded from.
+   *
+   * The file must already hold the whole image; archive members are not
+   * writable.
+   */
+  bool saveChanges(const QString &path, uint32_t sinceCounter) const;
+
+  /**
+   * @brief Picks up changes another program made to the image file.
+   * @see mergeImage()
+   */
+  bool reloadImage(const QString &path);
+
+  /**
+   * @brief Replaces the image, copying in only the sectors that differ.
+   *
+   * Copied sectors are marked dirty, so dirtySectorsSince() tells callers
+   * what to re-parse or write back. A new size falls back to a full load.
+   */
+  void mergeImage(std::vector<uint8_t> &&fresh);
+
   /** @return Raw data of a specific sector. */
   QByteArray getSector(uint32_t sectorIndex) const;
 
@@ -239,16 +247,59 @@ public:
   /** @brief Sets the OEM label of the disk image. */
   bool setOemLabel(const QString &newLabel);
 
+  /** @brief Sets the OEM label of an arbitrary 512-byte boot sector. */
+  static void setOemLabel(uint8_t *sector512, const QString &newLabel);
+
   /** @brief Gets a map of all clusters on the disk. */
   ClusterMap getClusterMap() const;
 
   /** @brief Searches for a byte pattern in the disk image. */
   QVector<SearchResult> searchPattern(const QByteArray &pattern) const;
 
+  /**
+   * @brief FAT12 writer bound to this image; its writes are recorded as
+   * dirty sectors. Invalid if the image has no usable BPB.
+   */
+  FatVolume volume();
+
+  /** @return Counter advanced by every write to the image. */
+  uint32_t changeCounter() const { return m_changeCounter; }
+
+  /** @return Sectors written after the given changeCounter(), ascending. */
+  std::vector<uint32_t> dirtySectorsSince(uint32_t counter) const;
+
+  /** @brief Records a write to image bytes [offset, offset + length). */
+  void markDirty(uint32_t offset, uint32_t length);
+
+  /**
+   * @brief Overwrites raw image bytes; the one entry point for byte edits.
+   *
+   * The old bytes go on the undo journal and the sectors are marked dirty.
+   * Touching the boot sector makes the geometry be probed again.
+   * @return False if the range lies outside the image.
+   */
+  bool patchBytes(uint32_t offset, const QByteArray &bytes);
+
+  /** @return True if undoPatch() has an edit to revert. */
+  bool canUndoPatch() const { return !m_journal.empty(); }
+
+  /**
+   * @brief Reverts the latest patchBytes() as a write of its own.
+   *
+   * If other writes have since changed those bytes, the journal is stale
+   * and is dropped instead.
+   * @param offset, length Set to the range restored.
+   * @return False if nothing was reverted.
+   */
+  bool undoPatch(uint32_t &offset, uint32_t &length);
+
 private:
   /** @brief Checks if a block of data appears to be a valid directory entry. */
   bool isValidDirectoryEntry(const uint8_t *data) const;
 
+  /** @return Offset of the root directory; also settles m_geoMode. */
+  uint32_t rootDirectoryOffset() const;
+
   /** @brief Internal initialization after data load. */
   void init();
 
@@ -273,6 +324,16 @@ private:
   std::vector<uint16_t> getClusterChain(uint16_t startCluster) const;
 
   std::vector<uint8_t> m_image;
+  /** changeCounter() value of the last write to each sector. */
+  std::vector<uint32_t> m_sectorStamps;
+  /** One record per patchBytes(), newest last. */
+  struct Patch {
+    uint32_t offset;
+    QByteArray before;
+    QByteArray after;
+  };
+  std::vector<Patch> m_journal;
+  uint32_t m_changeCounter = 0;
   uint32_t m_internalOffset = 0;
   mutable GeometryMode m_geoMode = GeometryMode::Unknown;
   uint32_t m_manualRootSector = 11;
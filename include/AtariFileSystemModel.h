@@ -1,8 +1,10 @@
 #ifndef ATARIFILESYSTEMMODEL_H
 #define ATARIFILESYSTEMMODEL_H
 
+#include "ArchiveReader.h"
 #include "AtariDiskEngine.h"
 #include <QAbstractItemModel>
+#include <QCache>
 #include <memory>
 
 class AtariFileSystemModel : public QAbstractItemModel {
@@ -12,16 +14,45 @@ public:
   void setEngine(Atari::AtariDiskEngine *engine);
   void refresh() { buildTree(); }
 
+  /**
+   * @brief Re-reads only the directories and archives that use one of the
+   * given image sectors (ascending), patching rows in place.
+   */
+  void refreshSectors(const std::vector<uint32_t> &changed);
+
   struct Node {
     Atari::DirEntry entry;
     Node *parent = nullptr;
     std::vector<std::unique_ptr<Node>> children;
+    /** Set on ARC/LZH files; their members become virtual children. */
+    std::shared_ptr<const Atari::ArchiveReader> archive;
+    /** Index into the parent's archive members, or -1 for disk entries. */
+    int memberIndex = -1;
+    /** Image sectors this node's children were read from. */
+    std::vector<uint32_t> sectors;
     Node(const Atari::DirEntry &e, Node *p) : entry(e), parent(p) {}
     Node() = default;
   };
 
   Atari::DirEntry getEntry(const QModelIndex &index) const;
 
+  /** @return Bytes held by caches that dropCaches() frees. */
+  std::size_t cacheBytes() const {
+    return static_cast<std::size_t>(m_memberCache.totalCost());
+  }
+
+  /** @brief Forgets decoded archive members; they decode again on use. */
+  void dropCaches() { m_memberCache.clear(); }
+
+  /** @return True for a virtual child listed from inside an archive. */
+  bool isArchiveMember(const QModelIndex &index) const;
+
+  /**
+   * @brief Decodes an archive member, reusing recently decoded members.
+   * @param error Receives a reason when the member cannot be decoded.
+   */
+  QByteArray memberData(const QModelIndex &index, QString &error) const;
+
   QModelIndex index(int row, int column,
                     const QModelIndex &parent) const override;
   QModelIndex parent(const QModelIndex &index) const override;
@@ -30,12 +61,48 @@ public:
   QVariant data(const QModelIndex &index, int role) const override;
   Qt::ItemFlags flags(const QModelIndex &index) const override;
 
+  // Drag and drop between images. Files and folders dragged out of one
+  // model can be dropped on another model's root or folders; copying is
+  // left to the receiver of entriesDropped(), which can see both engines.
+  QStringList mimeTypes() const override;
+  QMimeData *mimeData(const QModelIndexList &indexes) const override;
+  Qt::DropActions supportedDropActions() const override;
+  bool canDropMimeData(const QMimeData *data, Qt::DropAction action, int row,
+                       int column, const QModelIndex &parent) const override;
+  bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row,
+                    int column, const QModelIndex &parent) override;
+
+signals:
+  /**
+   * @brief Entries of another model were dropped on a directory.
+   * @param source Identity of the model they came from; not to be
+   * dereferenced, as that model may be gone.
+   * @param dirCluster First cluster of the target directory, 0 for root.
+   * @param move True if the source entries should go away (Shift-drag).
+   */
+  void entriesDropped(quintptr source, const QVector<Atari::DirEntry> &entries,
+                      uint16_t dirCluster, bool move);
+
 private:
   void buildTree();
   void buildChildren(Node *parentNode);
+  std::vector<Atari::DirEntry> listDirectory(Node *dirNode);
+  std::unique_ptr<Node> makeNode(const Atari::DirEntry &entry, Node *parent);
+  bool isParsedDirectory(const Node *node) const;
+  void addArchiveMembers(Node *node);
+  void patchNode(Node *node, const QModelIndex &index,
+                 const std::vector<uint32_t> &changed);
+  /** @return The nodes it created (already up to date). */
+  std::vector<const Node *>
+  patchChildren(Node *node, const QModelIndex &index,
+                const std::vector<Atari::DirEntry> &entries);
   Node *nodeFromIndex(const QModelIndex &index) const;
+  /** @return True if entries may be dropped into this node. */
+  bool acceptsDrop(const Node *node) const;
 
   Atari::AtariDiskEngine *m_engine = nullptr;
   std::unique_ptr<Node> m_root;
+  /** Decoded members keyed by node; cost is the size in bytes. */
+  mutable QCache<const Node *, QByteArray> m_memberCache;
 };
 #endif
@@ -0,0 +1,84 @@
+/**
+ * @file AtariText.h
+ * @brief Atari ST character set decoding and incremental line indexing.
+ *
+ * Text is decoded line by line straight from a FileView, so a viewer only
+ * ever converts the lines it is about to paint.
+ */
+
+#ifndef ATARITEXT_H
+#define ATARITEXT_H
+
+#include "FileView.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Atari {
+
+/**
+ * @return Unicode (BMP) code point for every Atari ST character. Control
+ * codes without an ST glyph map to the Unicode control pictures.
+ */
+const std::array<uint16_t, 256> &atariCharset();
+
+/** @return True for names of files that usually hold plain text. */
+bool isTextFileName(const std::string &name);
+
+/**
+ * @brief Decodes file bytes [begin, end) to UTF-16, expanding tabs to
+ * eight-column stops.
+ */
+void decodeAtariText(const FileView &file, uint32_t begin, uint32_t end,
+                     std::u16string &out);
+
+/**
+ * @class LineIndex
+ * @brief Line start offsets of a text file, built a chunk at a time.
+ *
+ * One thread calls indexMore() until it returns false; any thread may query
+ * the lines found so far. LF, CR LF and lone CR all end a line.
+ */
+class LineIndex {
+public:
+  /** @brief Starts an empty index; the view must outlive it. */
+  explicit LineIndex(const FileView &file);
+
+  /**
+   * @brief Scans up to budget more bytes.
+   * @return False once the whole file has been indexed.
+   */
+  bool indexMore(uint32_t budget);
+
+  /** @return True when the whole file has been scanned. */
+  bool isComplete() const;
+
+  /** @return Number of complete lines found so far. */
+  uint32_t lineCount() const;
+
+  /** @return Longest line found so far, in bytes. */
+  uint32_t longestLine() const;
+
+  /**
+   * @brief Byte range of line n without its terminator.
+   * @return False if line n has not been indexed yet.
+   */
+  bool line(uint32_t n, uint32_t &begin, uint32_t &end) const;
+
+private:
+  FileView m_file;
+  uint32_t m_scanned = 0;   /**< Bytes examined by indexMore(). */
+  uint32_t m_lineStart = 0; /**< Start of the line being scanned. */
+  bool m_pendingCr = false; /**< Last scanned byte was a CR. */
+
+  mutable std::mutex m_mutex;
+  std::vector<uint32_t> m_starts{0}; /**< Guarded by m_mutex. */
+  std::vector<uint32_t> m_ends;      /**< Guarded by m_mutex. */
+  uint32_t m_longest = 0;            /**< Guarded by m_mutex. */
+  bool m_complete = false;           /**< Guarded by m_mutex. */
+};
+
+} // namespace Atari
+#endif
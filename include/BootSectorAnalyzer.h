@@ -0,0 +1,113 @@
+/**
+ * @file BootSectorAnalyzer.h
+ * @brief Boot sector classification against a signature database.
+ *
+ * The boot code is reduced to a normalized 64-bit hash that ignores the
+ * parts every disk personalises (OEM label, serial, BPB, checksum word), so
+ * the same loader or virus hashes identically across thousands of disks.
+ */
+
+#ifndef BOOTSECTORANALYZER_H
+#define BOOTSECTORANALYZER_H
+
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief Broad classification of a boot sector. */
+enum class BootCategory {
+  Unknown,    /**< Executable code not in the database. */
+  Blank,      /**< No code at all (zero or filler bytes). */
+  Data,       /**< Code area holds bytes but the sector is not executable. */
+  Loader,     /**< Known game/demo loader. */
+  Virus,      /**< Known boot sector virus. */
+  AntiVirus,  /**< Known anti-virus/immunizer boot sector. */
+  Protection, /**< Known copy-protection boot code. */
+  Suspicious  /**< Unknown executable code that hooks disk/reset vectors. */
+};
+
+/**
+ * @struct BootSignature
+ * @brief One database entry: a normalized code hash and what it is.
+ */
+struct BootSignature {
+  uint64_t hash;
+  BootCategory category;
+  QString name;
+};
+
+/**
+ * @struct BootAnalysis
+ * @brief Result of analyzing one boot sector.
+ */
+struct BootAnalysis {
+  uint64_t codeHash = 0;  /**< Normalized hash of the boot code. */
+  uint16_t wordSum = 0;   /**< Big-endian word sum of the whole sector. */
+  bool isExecutable = false;
+  BootCategory category = BootCategory::Unknown;
+  QString name;           /**< Database name or heuristic description. */
+};
+
+/**
+ * @brief Sums the 256 big-endian words of a sector (SSE2 when available).
+ * @param sector512 Pointer to a 512-byte boot sector.
+ * @return The 16-bit word sum; 0x1234 means executable.
+ */
+uint16_t bootWordSum(const uint8_t *sector512) noexcept;
+
+/**
+ * @brief Hashes the boot code, skipping the OEM/serial/BPB block
+ * (0x02-0x1D) and the checksum word (0x1FE-0x1FF).
+ */
+uint64_t bootCodeHash(const uint8_t *sector512) noexcept;
+
+/**
+ * @class BootSignatureDb
+ * @brief Sorted flat table of known boot code hashes.
+ */
+class BootSignatureDb {
+public:
+  /** @brief Creates a database holding the built-in signatures. */
+  BootSignatureDb();
+
+  /** @return The matching entry, or nullptr if the hash is unknown. */
+  const BootSignature *find(uint64_t hash) const;
+
+  /**
+   * @brief Merges signatures from a text file.
+   *
+   * One entry per line: "<16 hex digit hash> <category> <name>", where the
+   * category is one of blank, data, loader, virus, antivirus, protection.
+   * Lines starting with '#' are ignored.
+   * @return Number of entries added, or -1 if the file cannot be read.
+   */
+  int loadFile(const QString &path);
+
+  /** @return Number of entries in the table. */
+  int size() const { return static_cast<int>(m_entries.size()); }
+
+private:
+  void add(uint64_t hash, BootCategory category, const QString &name);
+  void sortEntries();
+
+  std::vector<BootSignature> m_entries;
+};
+
+/** @return The process-wide signature database. */
+BootSignatureDb &bootSignatureDb();
+
+/**
+ * @brief Analyzes a boot sector against a signature database.
+ * @param sector512 Pointer to a 512-byte boot sector.
+ * @param db Database to look the code hash up in.
+ */
+BootAnalysis analyzeBootSector(const uint8_t *sector512,
+                               const BootSignatureDb &db = bootSignatureDb());
+
+/** @return A short display name for a category ("Virus", ...). */
+const char *bootCategoryName(BootCategory category);
+
+} // namespace Atari
+#endif
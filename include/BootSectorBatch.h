@@ -0,0 +1,71 @@
+/**
+ * @file BootSectorBatch.h
+ * @brief In-place boot sector edits across many image files.
+ *
+ * Only sector 0 is read and, when it changes, only those 512 bytes are
+ * written back with pwrite(); the rest of each image is never touched.
+ */
+
+#ifndef BOOTSECTORBATCH_H
+#define BOOTSECTORBATCH_H
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief The edit applied to each boot sector. */
+enum class BootEdit {
+  FixChecksum, /**< Adjust the checksum word so the sector sums to 0x1234. */
+  SetOemLabel  /**< Replace the OEM label, then fix the checksum. */
+};
+
+/**
+ * @struct BootBatchOptions
+ * @brief Controls a batch run.
+ */
+struct BootBatchOptions {
+  BootEdit edit = BootEdit::FixChecksum;
+  QString oemLabel;       /**< New label for BootEdit::SetOemLabel. */
+  bool dryRun = false;    /**< Report what would change, write nothing. */
+  bool keepMtime = false; /**< Restore the file's access/modify times. */
+};
+
+/**
+ * @struct BootBatchResult
+ * @brief Per-file outcome of a batch run.
+ */
+struct BootBatchResult {
+  enum class Status { Changed, Unchanged, Failed };
+
+  QString path;
+  Status status = Status::Failed;
+  QString message;          /**< Failure reason, empty otherwise. */
+  uint16_t oldChecksum = 0; /**< Word sum before the edit. */
+  uint16_t newChecksum = 0; /**< Word sum after the edit. */
+  QString oldOem;
+  QString newOem;
+};
+
+/**
+ * @brief Applies an edit to the boot sector of a single raw image.
+ * @param path Host path of a raw (.ST) image.
+ * @param options Edit to apply.
+ * @return What happened to the file.
+ */
+BootBatchResult applyBootEdit(const QString &path,
+                              const BootBatchOptions &options);
+
+/**
+ * @brief Applies an edit to many images in parallel.
+ * @param paths Host paths of raw images.
+ * @param options Edit to apply.
+ * @return One result per path, in the same order as paths.
+ */
+std::vector<BootBatchResult> applyBootEdits(const QStringList &paths,
+                                            const BootBatchOptions &options);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,30 @@
+/**
+ * @file CommandLine.h
+ * @brief Headless command-line front end for scripts and batch pipelines.
+ *
+ * Invoked as "AtariDiskEngine <command> [args...]"; without a recognised
+ * command the GUI starts as usual.
+ */
+
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <QStringList>
+
+namespace Atari {
+
+/**
+ * @brief Checks whether the process arguments ask for a CLI command.
+ * @return True if argv[1] names a known command.
+ */
+bool isCommandLineInvocation(int argc, char *argv[]);
+
+/**
+ * @brief Runs a CLI command.
+ * @param args Arguments after the program name (command first).
+ * @return Process exit code (0 success, 1 failure, 2 usage error).
+ */
+int runCommandLine(const QStringList &args);
+
+} // namespace Atari
+#endif
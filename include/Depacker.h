@@ -0,0 +1,116 @@
+/**
+ * @file Depacker.h
+ * @brief Depackers for Atari ST packer formats, with a content-hash cache.
+ *
+ * Packed files (and executables whose depack stub is followed by a packed
+ * stream) are recognised by their packer magic. Pack-Ice 2.3/2.4 and
+ * PowerPacker 2.0 streams decode into a caller-owned arena so batch jobs
+ * reuse one buffer per thread; the other recognised formats are reported
+ * by name only.
+ */
+
+#ifndef DEPACKER_H
+#define DEPACKER_H
+
+#include "FileView.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Atari {
+
+/** Largest depacked size accepted (guards against corrupt headers). */
+inline constexpr uint32_t DEPACK_SIZE_LIMIT = 16 * 1024 * 1024;
+
+/**
+ * @return Packer name for a 4-byte magic at p, or nullptr if unknown.
+ */
+const char *packerNameForMagic(const uint8_t *p);
+
+/**
+ * @class DepackArena
+ * @brief Reusable scratch and output storage; grows, never shrinks.
+ */
+class DepackArena {
+public:
+  /** @return Output storage of at least n bytes. */
+  uint8_t *output(std::size_t n) {
+    if (m_output.size() < n)
+      m_output.resize(n);
+    return m_output.data();
+  }
+
+  /** @return Scratch storage of at least n bytes (for non-contiguous input). */
+  uint8_t *scratch(std::size_t n) {
+    if (m_scratch.size() < n)
+      m_scratch.resize(n);
+    return m_scratch.data();
+  }
+
+private:
+  std::vector<uint8_t> m_output;
+  std::vector<uint8_t> m_scratch;
+};
+
+/**
+ * @struct DepackResult
+ * @brief Outcome of depack(); data points into the arena.
+ */
+struct DepackResult {
+  bool packed = false;          /**< A packer magic was found. */
+  bool ok = false;              /**< The stream was depacked. */
+  const char *format = nullptr; /**< Packer name when packed. */
+  uint32_t magicOffset = 0;     /**< File offset of the packed stream. */
+  std::string error;            /**< Why a packed file was not depacked. */
+  const uint8_t *data = nullptr;
+  uint32_t size = 0;
+};
+
+/**
+ * @brief Finds and depacks the packed stream of a file.
+ *
+ * The magic is looked for at offset 0 (packed data files) and, for GEMDOS
+ * executables, behind the depack stub; there the stream ends with the DATA
+ * segment.
+ */
+DepackResult depack(const FileView &file, DepackArena &arena);
+
+/**
+ * @brief Decodes a Pack-Ice 2.4 stream ("ICE!" header included).
+ * @return False with a reason if the stream is damaged.
+ */
+bool depackIce(const uint8_t *stream, std::size_t available,
+               DepackArena &arena, DepackResult &result);
+
+/**
+ * @brief Decodes a PowerPacker 2.0 stream ("PP20" header included); it
+ * runs to the end of the available bytes, where its trailer is.
+ * @return False with a reason if the stream is damaged.
+ */
+bool depackPowerPacker(const uint8_t *stream, std::size_t available,
+                       DepackArena &arena, DepackResult &result);
+
+/**
+ * @struct DepackedFile
+ * @brief Cached, owning result of depacking one file.
+ */
+struct DepackedFile {
+  bool packed = false;
+  bool ok = false;
+  const char *format = nullptr;
+  std::string error;
+  std::vector<uint8_t> data;  /**< Depacked bytes when ok. */
+  uint64_t contentHash = 0;   /**< FileView::contentHash() of data. */
+};
+
+/**
+ * @brief Depacks through a process-wide LRU cache keyed by the packed
+ * file's content hash; unpacked files are returned with packed = false.
+ * Thread-safe.
+ */
+std::shared_ptr<const DepackedFile> depackCached(const FileView &file);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file DiskBytes.h
+ * @brief Sector constants and byte-order helpers.
+ *
+ * Kept free of Qt so the FAT12 core can be built into the C library
+ * (AtariDiskApi.h) as well as the application.
+ */
+
+#ifndef DISKBYTES_H
+#define DISKBYTES_H
+
+#include <cstdint>
+
+namespace Atari {
+
+/** @brief Standard sector size for Atari ST disks (512 bytes). */
+inline constexpr uint16_t SECTOR_SIZE = 512;
+/** @brief Size of a directory entry in FAT12 (32 bytes). */
+inline constexpr uint16_t DIRENT_SIZE = 32;
+/** @brief Target value for the boot sector checksum (0x1234). */
+inline constexpr uint16_t BOOT_CHECKSUM_TARGET = 0x1234;
+
+/**
+ * @brief Reads a 16-bit little-endian value from a buffer.
+ * @param p Pointer to the start of the 16-bit value.
+ * @return The 16-bit value in host byte order.
+ */
+inline uint16_t readLE16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+/**
+ * @brief Reads a 16-bit big-endian value from a buffer.
+ * @param p Pointer to the start of the 16-bit value.
+ * @return The 16-bit value in host byte order.
+ */
+inline uint16_t readBE16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+
+/**
+ * @brief Reads a 32-bit little-endian value from a buffer.
+ * @param p Pointer to the start of the 32-bit value.
+ * @return The 32-bit value in host byte order.
+ */
+inline uint32_t readLE32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/**
+ * @brief Reads a 32-bit big-endian value from a buffer.
+ * @param p Pointer to the start of the 32-bit value.
+ * @return The 32-bit value in host byte order.
+ */
+inline uint32_t readBE32(const uint8_t *p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) |
+         p[3];
+}
+
+/**
+ * @brief Reads a 64-bit big-endian value from a buffer.
+ * @param p Pointer to the start of the 64-bit value.
+ * @return The 64-bit value in host byte order.
+ */
+inline uint64_t readBE64(const uint8_t *p) {
+  return (static_cast<uint64_t>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+/**
+ * @brief Writes a 16-bit value in little-endian format to a buffer.
+ * @param p Pointer to the destination buffer.
+ * @param val The 16-bit value to write.
+ */
+inline void writeLE16(uint8_t *p, uint16_t val) {
+  p[0] = val & 0xFF;
+  p[1] = (val >> 8) & 0xFF;
+}
+
+/**
+ * @brief Writes a 16-bit value in big-endian format to a buffer.
+ * @param p Pointer to the destination buffer.
+ * @param val The 16-bit value to write.
+ */
+inline void writeBE16(uint8_t *p, uint16_t val) {
+  p[0] = (val >> 8) & 0xFF;
+  p[1] = val & 0xFF;
+}
+
+} // namespace Atari
+#endif
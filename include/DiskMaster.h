@@ -0,0 +1,105 @@
+/**
+ * @file DiskMaster.h
+ * @brief Reproducible release disks built from a manifest.
+ *
+ * A manifest is a text file, one directive per line ('#' starts a comment):
+ *
+ *     geometry 2 80 9                  sides, tracks, sectors per track
+ *     oem      MYDISK                  6-character OEM field
+ *     label    GAMEDISK                volume label entry in the root
+ *     boot     boot.bin exec           512-byte boot sector, made executable
+ *     serial   0x00C0FFEE              24-bit serial number
+ *     date     1991-06-01 12:00:00     timestamp of every entry
+ *     dir      AUTO
+ *     file     AUTO/LOADER.PRG build/loader.prg
+ *     file     GAME.DAT        build/game.dat  rhs
+ *
+ * Entries are written in manifest order; missing parent directories are
+ * created on first use. Host paths are relative to the manifest. Attribute
+ * letters are r(ead-only), h(idden), s(ystem) and a(rchive); files default
+ * to "a".
+ */
+
+#ifndef DISKMASTER_H
+#define DISKMASTER_H
+
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/**
+ * @struct MasterEntry
+ * @brief One "dir" or "file" line of a manifest.
+ */
+struct MasterEntry {
+  QString path;       /**< Path inside the image, '/' separated. */
+  QString source;     /**< Host file; empty for a directory. */
+  uint8_t attributes; /**< FAT attribute bits (without ATTR_DIRECTORY). */
+  int line;           /**< Manifest line, for error messages. */
+
+  bool isDirectory() const { return source.isEmpty(); }
+};
+
+/**
+ * @struct MasterManifest
+ * @brief Everything that goes into a mastered image.
+ */
+struct MasterManifest {
+  uint32_t sides = 2;
+  uint32_t tracks = 80;
+  uint32_t sectorsPerTrack = 9;
+  QString oem;             /**< Bytes 2-7 of the boot sector. */
+  QString volumeLabel;     /**< Empty for no label entry. */
+  QString bootSource;      /**< Host boot sector; empty for a blank one. */
+  bool executable = false; /**< Fix the boot checksum to 0x1234. */
+  uint32_t serial = 0;
+  uint16_t dosTime = 0;
+  uint16_t dosDate = 0x0021; /**< 1980-01-01, the DOS epoch. */
+  std::vector<MasterEntry> entries;
+
+  /**
+   * @brief Parses a manifest file.
+   * @param error Receives "line N: reason" on failure.
+   */
+  static bool load(const QString &path, MasterManifest &manifest,
+                   QString &error);
+};
+
+/**
+ * @struct MasterFile
+ * @brief Where a mastered file ended up.
+ */
+struct MasterFile {
+  QString path;                  /**< Path inside the image. */
+  std::vector<uint32_t> sectors; /**< Image sectors holding its data. */
+};
+
+/**
+ * @brief Builds an image from a manifest.
+ *
+ * The result depends only on the manifest, the bytes of the files it names
+ * and the previous image, and every timestamp comes from the manifest, so
+ * equal inputs give byte-identical images. Clusters of the previous image
+ * are claimed back first: files with unchanged content keep their chains
+ * (matched by content hash, so renames stay put too), directories keep
+ * theirs by path, and changed files keep as much of their old chain as
+ * they still need. Only new and grown files are allocated first-fit in
+ * manifest order. To rebuild incrementally, merge the result into the
+ * previous image with AtariDiskEngine::mergeImage(); only the sectors of
+ * changed files and the FAT and directory sectors that describe them will
+ * differ.
+ *
+ * @param previous The last build; empty, or of another geometry, for a
+ * clean first-fit layout.
+ * @param files Receives the sectors of each file, in manifest order.
+ * @param error Receives a reason on failure.
+ */
+bool masterImage(const MasterManifest &manifest,
+                 const std::vector<uint8_t> &previous,
+                 std::vector<uint8_t> &image, std::vector<MasterFile> &files,
+                 QString &error);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,198 @@
+/**
+ * @file FatVolume.h
+ * @brief In-place FAT12 writer over an image buffer.
+ *
+ * The engine's read paths tolerate odd layouts; writes need an exact
+ * geometry, so FatVolume only binds to images with a sane BPB. Every write
+ * is reported through a callback with the byte range it touched, which is
+ * how the engine tracks dirty sectors.
+ */
+
+#ifndef FATVOLUME_H
+#define FATVOLUME_H
+
+#include "FileView.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Atari {
+
+/** @brief FAT12 end-of-chain marker written by FatVolume. */
+inline constexpr uint16_t FAT_END_OF_CHAIN = 0xFFF;
+
+/** @brief Directory attribute bits. */
+inline constexpr uint8_t ATTR_READ_ONLY = 0x01;
+inline constexpr uint8_t ATTR_HIDDEN = 0x02;
+inline constexpr uint8_t ATTR_SYSTEM = 0x04;
+inline constexpr uint8_t ATTR_VOLUME = 0x08;
+inline constexpr uint8_t ATTR_DIRECTORY = 0x10;
+inline constexpr uint8_t ATTR_ARCHIVE = 0x20;
+
+/**
+ * @struct FatGeometry
+ * @brief Layout taken from the BPB; sector numbers are image-relative.
+ */
+struct FatGeometry {
+  uint32_t sectorsPerCluster = 0;
+  uint32_t reservedSectors = 0;
+  uint32_t fatCount = 0;
+  uint32_t sectorsPerFat = 0;
+  uint32_t rootEntries = 0;
+  uint32_t totalSectors = 0;
+  uint32_t rootSector = 0;
+  uint32_t dataSector = 0;
+  uint32_t clusterCount = 0; /**< Data clusters, numbered from 2. */
+
+  uint32_t clusterBytes() const { return sectorsPerCluster * 512; }
+};
+
+/**
+ * @brief Reads and validates the BPB of a boot sector.
+ * @param imageSize Bytes available from the boot sector on.
+ * @return False if the layout is not a usable FAT12 volume.
+ */
+bool readFatGeometry(const uint8_t *boot, std::size_t imageSize,
+                     FatGeometry &geometry);
+
+/**
+ * @class FatVolume
+ * @brief Allocates clusters, edits directories and rewrites file contents.
+ *
+ * Directories are named by their first cluster, 0 being the root. Entries
+ * are addressed by the image offset of their 32-byte slot. Writes that
+ * would not change a byte are skipped, so rewriting an unchanged file
+ * touches nothing.
+ */
+class FatVolume {
+public:
+  using WriteHook = std::function<void(uint32_t offset, uint32_t length)>;
+
+  /**
+   * @brief Binds to an image; check isValid() before use.
+   * @param base Offset of the boot sector within the buffer.
+   * @param onWrite Called after every byte range that was modified.
+   */
+  FatVolume(std::vector<uint8_t> &image, uint32_t base = 0,
+            WriteHook onWrite = {});
+
+  /** @return True if the BPB describes a usable FAT12 volume. */
+  bool isValid() const { return m_valid; }
+
+  /** @return Layout read from the BPB. */
+  const FatGeometry &geometry() const { return m_geo; }
+
+  /** @return The image buffer the volume writes into. */
+  const std::vector<uint8_t> &image() const { return m_image; }
+
+  /** @return FAT entry of a cluster (FAT_END_OF_CHAIN if out of range). */
+  uint16_t next(uint16_t cluster) const;
+
+  /** @return Cluster chain from start; stops at loops and bad links. */
+  std::vector<uint16_t> chain(uint16_t start) const;
+
+  /** @return Image offset of a data cluster. */
+  uint32_t clusterOffset(uint16_t cluster) const;
+
+  /** @return Number of free clusters. */
+  uint32_t freeClusters() const;
+
+  /** @return Slot offsets of a directory, in order (0 = root). */
+  std::vector<uint32_t> directorySlots(uint16_t dirCluster) const;
+
+  /**
+   * @return Slots of the live entries of a directory: no deleted slots,
+   * volume labels or "." / ".." entries.
+   */
+  std::vector<uint32_t> liveEntries(uint16_t dirCluster) const;
+
+  /** @return Slot holding the 11-byte 8.3 name, or 0 if absent. */
+  uint32_t findEntry(uint16_t dirCluster, const uint8_t *name83) const;
+
+  /**
+   * @brief Adds an empty file entry.
+   * @return Its slot, or 0 if the directory or disk is full.
+   */
+  uint32_t createFile(uint16_t dirCluster, const uint8_t *name83);
+
+  /**
+   * @brief Adds a subdirectory with its "." and ".." entries.
+   * @param claimed First cluster of a chain from claimChain() to use, or 0
+   * to allocate one.
+   * @return Its slot, or 0 if the directory or disk is full.
+   */
+  uint32_t createDirectory(uint16_t dirCluster, const uint8_t *name83,
+                           uint16_t claimed = 0);
+
+  /**
+   * @brief Links free clusters into one chain, in the order given, so that
+   * later allocations pass them by until an entry takes them over.
+   * @return False (and no change) if any cluster is in use or out of range.
+   */
+  bool claimChain(const std::vector<uint16_t> &clusters);
+
+  /** @brief Points an entry at a chain; writeFile() then reuses it. */
+  void setStartCluster(uint32_t slot, uint16_t cluster);
+
+  /**
+   * @brief Replaces a file's contents, reusing its clusters in place.
+   *
+   * The chain is extended or trimmed as needed; only clusters whose bytes
+   * differ are written. Slack after the last byte is zero-filled.
+   * @return False (and no change) if the disk is too full.
+   */
+  bool writeFile(uint32_t slot, const uint8_t *data, uint32_t size);
+
+  /**
+   * @brief As above, streaming the view's extents straight into the
+   * clusters; a view of another image is copied without a buffer.
+   */
+  bool writeFile(uint32_t slot, const FileView &source);
+
+  /** @brief Frees the entry's clusters and marks the slot deleted. */
+  void removeEntry(uint32_t slot);
+
+  /** @brief Zero-fills image bytes [offset, offset + length). */
+  void clear(uint32_t offset, uint32_t length) { fill(offset, 0, length); }
+
+  /** @brief Sets the attribute byte of an entry. */
+  void setAttributes(uint32_t slot, uint8_t attributes);
+
+  /** @brief Sets the DOS time and date words of an entry. */
+  void setTimestamp(uint32_t slot, uint16_t time, uint16_t date);
+
+  /** @return First cluster of an entry. */
+  uint16_t startCluster(uint32_t slot) const;
+
+  /** @return Zero-copy view of a file entry's contents. */
+  FileView fileView(uint32_t slot) const;
+
+  /**
+   * @brief Converts a host name to a padded, upper-case 8.3 name.
+   * @return False if the name does not fit 8.3 or uses invalid characters.
+   */
+  static bool toName83(const std::string &name, uint8_t *name83);
+
+  /** @return "NAME.EXT" for an 11-byte 8.3 name. */
+  static std::string fromName83(const uint8_t *name83);
+
+private:
+  void setNext(uint16_t cluster, uint16_t value);
+  /** @return Free clusters in ascending order, or empty if too few. */
+  std::vector<uint16_t> allocate(uint32_t count);
+  uint32_t allocateSlot(uint16_t dirCluster);
+  void write(uint32_t offset, const void *data, uint32_t length);
+  void fill(uint32_t offset, uint8_t value, uint32_t length);
+  void writeLE16At(uint32_t offset, uint16_t value);
+  void writeLE32At(uint32_t offset, uint32_t value);
+
+  std::vector<uint8_t> &m_image;
+  uint32_t m_base;
+  WriteHook m_onWrite;
+  FatGeometry m_geo;
+  bool m_valid = false;
+};
+
+} // namespace Atari
+#endif
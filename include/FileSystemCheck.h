@@ -0,0 +1,61 @@
+/**
+ * @file FileSystemCheck.h
+ * @brief Read-only consistency check of a FAT12 volume (fsck).
+ *
+ * Walks the directory tree and the FAT together and reports what TOS
+ * would trip over: chains that run into free or bad clusters, clusters
+ * shared by two owners, allocated clusters nothing refers to, and files
+ * whose chain does not match their size. Nothing is repaired.
+ */
+
+#ifndef FILESYSTEMCHECK_H
+#define FILESYSTEMCHECK_H
+
+#include "FatVolume.h"
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief What is wrong with a chain or cluster. */
+enum class FsckProblem {
+  BadLink,       /**< Chain reaches a free, bad or out-of-range cluster. */
+  CrossLinked,   /**< Cluster already owned by another file or directory. */
+  SizeMismatch,  /**< Chain length does not fit the size in the entry. */
+  LostChain,     /**< Allocated clusters no entry refers to. */
+  DirectoryLoop  /**< Directory that is its own ancestor. */
+};
+
+/** @return "bad-link", "cross-linked", "size", "lost" or "loop". */
+const char *fsckProblemName(FsckProblem problem);
+
+/**
+ * @struct FsckIssue
+ * @brief One finding, tied to an entry path where there is one.
+ */
+struct FsckIssue {
+  FsckProblem problem;
+  QString path;     /**< "AUTO/GAME.PRG"; empty for lost chains. */
+  uint16_t cluster; /**< First cluster the problem shows up at. */
+  QString detail;
+};
+
+/**
+ * @struct FsckReport
+ * @brief Findings and totals of one check.
+ */
+struct FsckReport {
+  std::vector<FsckIssue> issues;
+  uint32_t files = 0;
+  uint32_t dirs = 0;
+  uint32_t lostClusters = 0;
+
+  bool isClean() const { return issues.empty(); }
+};
+
+/** @brief Checks the volume; an invalid volume yields an empty report. */
+FsckReport checkFileSystem(const FatVolume &volume);
+
+} // namespace Atari
+#endif
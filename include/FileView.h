@@ -0,0 +1,122 @@
+/**
+ * @file FileView.h
+ * @brief Zero-copy view of a file's bytes scattered across a disk image.
+ *
+ * A file on a FAT12 disk is a chain of clusters; a FileView records that
+ * chain as byte extents into the image buffer so parsers can read a file in
+ * place. Views borrow the image: any write to the disk invalidates them.
+ */
+
+#ifndef FILEVIEW_H
+#define FILEVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/**
+ * @struct FileExtent
+ * @brief A contiguous run of file bytes inside the backing buffer.
+ */
+struct FileExtent {
+  uint32_t offset; /**< Byte offset in the backing buffer. */
+  uint32_t length; /**< Number of bytes in this run. */
+};
+
+/**
+ * @class FileView
+ * @brief Random and sequential access over a list of extents.
+ */
+class FileView {
+public:
+  FileView() = default;
+
+  /** @brief Views the given extents of a buffer (adjacent runs merged). */
+  FileView(const uint8_t *base, const std::vector<FileExtent> &extents);
+
+  /** @return A single-extent view over a plain memory buffer. */
+  static FileView fromBuffer(const uint8_t *data, std::size_t size);
+
+  /** @return Logical file size in bytes. */
+  uint32_t size() const { return m_size; }
+
+  /** @return True if the view holds no bytes. */
+  bool isEmpty() const { return m_size == 0; }
+
+  /** @return The merged extents, in file order. */
+  const std::vector<FileExtent> &extents() const { return m_extents; }
+
+  /**
+   * @return Pointer to bytes [pos, pos + length) if they sit in one extent,
+   * nullptr otherwise (or when out of range).
+   */
+  const uint8_t *contiguous(uint32_t pos, uint32_t length) const;
+
+  /**
+   * @brief Copies bytes out of the view.
+   * @return Number of bytes copied (short at end of file).
+   */
+  uint32_t read(uint32_t pos, uint8_t *dst, uint32_t length) const;
+
+  /** @return Big-endian word at pos, 0 if out of range. */
+  uint16_t readBE16(uint32_t pos) const;
+
+  /** @return Big-endian longword at pos, 0 if out of range. */
+  uint32_t readBE32(uint32_t pos) const;
+
+  /** @return A copy of the whole file. */
+  std::vector<uint8_t> toVector() const;
+
+  /**
+   * @return 64-bit FNV-1a hash of the file bytes, computed extent by extent
+   * (equal for equal content regardless of fragmentation).
+   */
+  uint64_t contentHash() const;
+
+  /**
+   * @class Cursor
+   * @brief Forward-only byte reader that walks extents without lookups.
+   */
+  class Cursor {
+  public:
+    Cursor(const FileView &view, uint32_t pos);
+
+    /** @return False at end of file. */
+    bool next(uint8_t &byte) {
+      if (m_ptr == m_end && !advanceExtent())
+        return false;
+      byte = *m_ptr++;
+      ++m_pos;
+      return true;
+    }
+
+    /** @return False if fewer than four bytes remain. */
+    bool nextBE32(uint32_t &value);
+
+    /** @return Current logical file position. */
+    uint32_t position() const { return m_pos; }
+
+  private:
+    bool advanceExtent();
+
+    const FileView &m_view;
+    std::size_t m_extent = 0;
+    const uint8_t *m_ptr = nullptr;
+    const uint8_t *m_end = nullptr;
+    uint32_t m_pos = 0;
+  };
+
+private:
+  /** @return Index of the extent holding pos (pos must be < size()). */
+  std::size_t extentAt(uint32_t pos) const;
+
+  const uint8_t *m_base = nullptr;
+  std::vector<FileExtent> m_extents;
+  std::vector<uint32_t> m_starts; /**< File position of each extent. */
+  uint32_t m_size = 0;
+};
+
+} // namespace Atari
+#endif
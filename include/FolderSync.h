@@ -0,0 +1,141 @@
+/**
+ * @file FolderSync.h
+ * @brief Two-way incremental sync between a host folder and a directory
+ * inside a disk image.
+ */
+
+#ifndef FOLDERSYNC_H
+#define FOLDERSYNC_H
+
+#include "AtariDiskEngine.h"
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+namespace Atari {
+
+/**
+ * @struct SyncReport
+ * @brief What one sync pass did; paths are relative, '/' separated.
+ */
+struct SyncReport {
+  QStringList toImage;          /**< Copied or updated in the image. */
+  QStringList toHost;           /**< Copied or updated on the host. */
+  QStringList removedFromImage; /**< Deleted on the host since last pass. */
+  QStringList removedFromHost;  /**< Deleted in the image since last pass. */
+  /** Changed on both sides (host kept), or edited on one side and
+   * deleted on the other (edit kept). */
+  QStringList conflicts;
+  QStringList skipped;          /**< Not 8.3, duplicate name or disk full. */
+
+  /** @return True if the image was modified. */
+  bool imageChanged() const {
+    return !toImage.isEmpty() || !removedFromImage.isEmpty();
+  }
+
+  /** @return True if nothing was copied or removed. */
+  bool isEmpty() const {
+    return !imageChanged() && toHost.isEmpty() && removedFromHost.isEmpty();
+  }
+};
+
+/**
+ * @class FolderSync
+ * @brief Keeps a host folder and an image directory in step, file by file.
+ *
+ * Files are compared by content hash against the hash recorded at the last
+ * pass, so a pass knows which side changed. Host files are re-hashed only
+ * when their size or mtime moved; image files only when their entry or one
+ * of their sectors is dirty. Writes into the image go through FatVolume and
+ * touch only the clusters and directory slots that differ.
+ *
+ * The first pass has no history and never deletes: files missing on one
+ * side are copied over. Later passes delete a file only if the copy that
+ * is left is unchanged since the last pass; an edited copy is copied back
+ * and reported as a conflict. Directories are created as needed but never
+ * removed.
+ */
+class FolderSync : public QObject {
+  Q_OBJECT
+
+public:
+  /**
+   * @param imageDir Directory inside the image ("" or "/" for the root);
+   * it must exist.
+   */
+  FolderSync(AtariDiskEngine &engine, const QString &hostDir,
+             const QString &imageDir = QString(), QObject *parent = nullptr);
+
+  /** @return False if the image is not writable or imageDir is missing. */
+  bool isValid() const;
+
+  /** @brief Reconciles both sides once. */
+  SyncReport syncNow();
+
+  /**
+   * @brief Starts watching: inotify on the host folder tree, and a poll of
+   * the engine's change counter for the image.
+   */
+  void start();
+
+  /** @brief Stops watching; history is kept for the next start(). */
+  void stop();
+
+signals:
+  /** @brief Emitted after a watched pass that changed something. */
+  void synced(const Atari::SyncReport &report);
+
+private slots:
+  void scheduleSync();
+  void onPollImage();
+
+private:
+  struct HostFile {
+    QString absPath;
+    qint64 size = 0;
+    qint64 mtime = 0;
+    quint64 hash = 0;
+  };
+  struct ImageFile {
+    uint32_t slot = 0;
+    uint16_t startCluster = 0;
+    uint32_t size = 0;
+    quint64 hash = 0;
+  };
+
+  void scanHost(const QString &absDir, const QString &rel, int depth,
+                QHash<QString, HostFile> &out, SyncReport &report);
+  void scanImage(FatVolume &volume, uint16_t dirCluster, const QString &rel,
+                 int depth, const std::vector<uint32_t> &dirty,
+                 QHash<QString, ImageFile> &out);
+  bool resolveImageDir(FatVolume &volume, const QString &rel, bool create,
+                       uint16_t &cluster) const;
+  bool copyToImage(FatVolume &volume, const QString &rel,
+                   const HostFile &file, ImageFile &result);
+  bool copyToHost(FatVolume &volume, const QString &rel,
+                  const ImageFile &file, HostFile &result);
+  void watchHostTree();
+
+  AtariDiskEngine &m_engine;
+  QString m_hostDir;
+  QString m_imageDir;
+  QHash<QString, quint64> m_synced;     /**< Hash at the last pass. */
+  QHash<QString, HostFile> m_hostCache; /**< Keyed by relative path. */
+  QHash<QString, ImageFile> m_imageCache;
+  QHash<QString, QString> m_hostDirs; /**< 8.3 relative path -> host path. */
+  /** Host files that could not be read this pass; not to be taken as
+   * deleted. */
+  QSet<QString> m_hostUnreadable;
+  uint32_t m_imageCounter = 0; /**< Engine counter at the last scan. */
+  bool m_scanned = false;
+
+  QFileSystemWatcher m_watcher;
+  QTimer m_debounce;
+  QTimer m_imagePoll;
+};
+
+} // namespace Atari
+#endif
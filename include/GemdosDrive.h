@@ -0,0 +1,153 @@
+/**
+ * @file GemdosDrive.h
+ * @brief GEMDOS file calls (Fopen, Fread, Fseek, Fsfirst, Fsnext) over an
+ * image, for emulators that hand a drive's traps to the toolkit.
+ *
+ * Return values follow TOS: a handle, byte count or position on success,
+ * a negative GEMDOS error code otherwise. Access is read-only.
+ */
+
+#ifndef GEMDOSDRIVE_H
+#define GEMDOSDRIVE_H
+
+#include "AtariDiskEngine.h"
+#include <QHash>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief GEMDOS error codes, as TOS returns them. */
+inline constexpr int32_t GEMDOS_E_OK = 0;
+inline constexpr int32_t GEMDOS_EINVFN = -32; /**< Invalid function/mode. */
+inline constexpr int32_t GEMDOS_EFILNF = -33; /**< File not found. */
+inline constexpr int32_t GEMDOS_EPTHNF = -34; /**< Path not found. */
+inline constexpr int32_t GEMDOS_ENHNDL = -35; /**< No handles left. */
+inline constexpr int32_t GEMDOS_EACCDN = -36; /**< Access denied. */
+inline constexpr int32_t GEMDOS_EIHNDL = -37; /**< Invalid handle. */
+inline constexpr int32_t GEMDOS_ENMFIL = -49; /**< No more files. */
+inline constexpr int32_t GEMDOS_ERANGE = -64; /**< Seek out of range. */
+
+/** @brief Fseek() modes. */
+inline constexpr int16_t GEMDOS_SEEK_SET = 0;
+inline constexpr int16_t GEMDOS_SEEK_CUR = 1;
+inline constexpr int16_t GEMDOS_SEEK_END = 2;
+
+/** @brief First file handle; 0-5 are the standard character devices. */
+inline constexpr int16_t GEMDOS_FIRST_HANDLE = 6;
+
+/** @brief Size of a TOS disk transfer address (DTA) block. */
+inline constexpr uint32_t GEMDOS_DTA_SIZE = 44;
+
+/**
+ * @struct GemdosDta
+ * @brief Fsfirst()/Fsnext() state and result.
+ *
+ * The search fields stand in for the reserved first 21 bytes of a TOS DTA;
+ * keep the struct alive between Fsfirst() and Fsnext() like a real DTA.
+ */
+struct GemdosDta {
+  // Search state
+  uint16_t dirCluster = 0; /**< Directory being searched, 0 = root. */
+  uint32_t next = 0;       /**< Index of the next entry to test. */
+  uint8_t pattern[11] = {}; /**< 8.3 template, '?' matches any byte. */
+  uint8_t searchAttr = 0;
+
+  // Result
+  uint8_t attr = 0;
+  uint16_t time = 0;
+  uint16_t date = 0;
+  uint32_t size = 0;
+  char name[14] = {}; /**< "NAME.EXT", NUL-terminated. */
+
+  /**
+   * @brief Writes the result into a 44-byte guest DTA (big-endian, result
+   * at offset 21), leaving the reserved bytes alone.
+   */
+  void store(uint8_t *dta) const;
+};
+
+/**
+ * @class GemdosDrive
+ * @brief Handle table and directory index over one engine.
+ *
+ * Each open file keeps its extent list and the extent it is positioned
+ * in, so sequential Fread() calls cost a memcpy per extent crossed and a
+ * seek is a binary search over a handful of extents; the cluster chain is
+ * walked only at Fopen(). Directories are parsed once and shared by path
+ * lookups and searches until the image changes.
+ */
+class GemdosDrive {
+public:
+  /** @brief Handles allocated before Fopen() reports ENHNDL. */
+  static constexpr int MAX_HANDLES = 64;
+
+  /** @param engine Must outlive the drive; it is only read. */
+  explicit GemdosDrive(const AtariDiskEngine &engine);
+
+  /**
+   * @brief Opens a file; paths may carry a drive letter and use '\\' or '/'.
+   * @param mode 0 read; write modes fail with EACCDN.
+   * @return Handle (>= GEMDOS_FIRST_HANDLE) or error.
+   */
+  int32_t fopen(const QString &path, int16_t mode);
+
+  /** @return GEMDOS_E_OK or EIHNDL. */
+  int32_t fclose(int16_t handle);
+
+  /** @return Bytes copied into buffer (short at end of file) or error. */
+  int32_t fread(int16_t handle, uint32_t count, uint8_t *buffer);
+
+  /** @return New absolute position, or ERANGE/EINVFN/EIHNDL. */
+  int32_t fseek(int32_t offset, int16_t handle, int16_t mode);
+
+  /**
+   * @brief Starts a wildcard search ("A:\\AUTO\\*.PRG").
+   *
+   * Follows TOS matching: the pattern is expanded to an 8.3 template, so
+   * "*" alone only matches names without an extension. Plain files always
+   * match; hidden, system and directory entries only if their bit is in
+   * attr; attr == 0x08 returns just the volume label.
+   * @return GEMDOS_E_OK with dta filled, EFILNF or EPTHNF.
+   */
+  int32_t fsfirst(const QString &spec, uint16_t attr, GemdosDta &dta);
+
+  /** @return GEMDOS_E_OK with dta filled, or ENMFIL. */
+  int32_t fsnext(GemdosDta &dta);
+
+private:
+  struct OpenFile {
+    bool open = false;
+    DirEntry entry{};              /**< To re-map after the image changes. */
+    const uint8_t *base = nullptr; /**< Image buffer the extents index. */
+    uint32_t counter = 0;          /**< Engine change counter at mapping. */
+    std::vector<FileExtent> extents;
+    std::vector<uint32_t> starts; /**< File position of each extent. */
+    uint32_t size = 0;
+    uint32_t pos = 0;
+    std::size_t extent = 0; /**< Extent holding pos (if pos < size). */
+  };
+
+  /** @brief Drops cached directories if the image changed underneath. */
+  void checkImage();
+  const std::vector<DirEntry> &directory(uint16_t cluster);
+  /**
+   * @brief Resolves all but the last component of a path.
+   * @return False if a directory along the way is missing.
+   */
+  bool resolveParent(const QString &path, uint16_t &cluster, QString &leaf);
+  /** @brief (Re)builds a handle's extent list from its entry. */
+  void mapFile(OpenFile &file);
+  /** @return The open file behind a handle, re-mapped if stale. */
+  OpenFile *fileFor(int16_t handle);
+
+  const AtariDiskEngine &m_engine;
+  QHash<uint16_t, std::vector<DirEntry>> m_directories;
+  const uint8_t *m_imageBase = nullptr;
+  uint32_t m_imageCounter = 0;
+  std::vector<OpenFile> m_files;
+};
+
+} // namespace Atari
+#endif
@@ -0,0 +1,138 @@
+/**
+ * @file GemdosProgram.h
+ * @brief GEMDOS executable (PRG/TOS/TTP) layout, symbols and packers.
+ *
+ * Layout of a GEMDOS program: a 28-byte header starting with 0x601A, then
+ * the TEXT and DATA segments, an optional symbol table and finally the
+ * relocation stream that lists every TEXT-relative longword to fix up.
+ * Everything here reads through a FileView, so programs on a disk are
+ * parsed in place.
+ */
+
+#ifndef GEMDOSPROGRAM_H
+#define GEMDOSPROGRAM_H
+
+#include "FileView.h"
+#include "M68kDisassembler.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Atari {
+
+inline constexpr uint16_t PRG_MAGIC = 0x601A;
+inline constexpr uint32_t PRG_HEADER_SIZE = 28;
+
+/**
+ * @struct PrgHeader
+ * @brief Decoded GEMDOS program header.
+ */
+struct PrgHeader {
+  uint32_t textSize = 0;
+  uint32_t dataSize = 0;
+  uint32_t bssSize = 0;
+  uint32_t symbolSize = 0;
+  uint32_t flags = 0;    /**< ph_prgflags (fastload, TT-RAM bits). */
+  bool absolute = false; /**< ph_absflag set: no relocation stream. */
+
+  /** @return File offset of the TEXT segment. */
+  uint32_t textOffset() const { return PRG_HEADER_SIZE; }
+  /** @return File offset of the DATA segment. */
+  uint32_t dataOffset() const { return PRG_HEADER_SIZE + textSize; }
+  /** @return File offset of the symbol table. */
+  uint32_t symbolOffset() const { return dataOffset() + dataSize; }
+  /** @return File offset of the relocation stream. */
+  uint32_t relocationOffset() const { return symbolOffset() + symbolSize; }
+};
+
+/**
+ * @struct PrgSymbol
+ * @brief One DRI (or GST extended-name) symbol table entry.
+ */
+struct PrgSymbol {
+  std::string name;
+  uint16_t type = 0; /**< DRI type bits (0x0200 text, 0x0400 data, ...). */
+  uint32_t value = 0;
+
+  /** @return "TEXT", "DATA", "BSS", "ABS" or "EXT". */
+  const char *segmentName() const;
+};
+
+/**
+ * @struct PrgAnalysis
+ * @brief Everything analyzePrg() can tell about an executable.
+ */
+struct PrgAnalysis {
+  bool valid = false; /**< Header decoded and segments fit the file. */
+  PrgHeader header;
+  std::vector<uint32_t> fixups; /**< TEXT-relative, ascending. */
+  bool relocationsOk = false;
+  std::vector<PrgSymbol> symbols;
+  bool symbolsOk = false;
+  const char *packer = nullptr; /**< Packer name, nullptr if none found. */
+  uint32_t packerOffset = 0;    /**< File offset of the packer magic. */
+};
+
+/**
+ * @brief Decodes the program header.
+ * @return False if the magic is missing or the segments overrun the file.
+ */
+bool parsePrgHeader(const FileView &file, PrgHeader &out);
+
+/**
+ * @brief Decodes the relocation stream in one linear pass.
+ * @param fixups Receives TEXT-relative offsets of the relocated longwords,
+ * in ascending order.
+ * @return False if the stream is truncated or points outside TEXT+DATA.
+ */
+bool decodePrgRelocations(const FileView &file, const PrgHeader &header,
+                          std::vector<uint32_t> &fixups);
+
+/**
+ * @brief Decodes the DRI symbol table, joining GST extended names.
+ * @return False if the table size is not a whole number of entries.
+ */
+bool decodePrgSymbols(const FileView &file, const PrgHeader &header,
+                      std::vector<PrgSymbol> &symbols);
+
+/**
+ * @brief Looks for a known packer magic near the start of the program.
+ * @return The packer name, or nullptr.
+ */
+const char *detectPrgPacker(const FileView &file, const PrgHeader &header,
+                            uint32_t *magicOffset = nullptr);
+
+/** @brief Runs all of the above over one executable. */
+PrgAnalysis analyzePrg(const FileView &file);
+
+/** @brief Buffer convenience wrapper for parsePrgHeader(). */
+inline bool parsePrgHeader(const uint8_t *data, std::size_t size,
+                           PrgHeader &out) {
+  return parsePrgHeader(FileView::fromBuffer(data, size), out);
+}
+
+/** @brief Buffer convenience wrapper for decodePrgRelocations(). */
+inline bool decodePrgRelocations(const uint8_t *data, std::size_t size,
+                                 const PrgHeader &header,
+                                 std::vector<uint32_t> &fixups) {
+  return decodePrgRelocations(FileView::fromBuffer(data, size), header,
+                              fixups);
+}
+
+/**
+ * @return True for the GEMDOS executable extensions (PRG, TOS, TTP, APP,
+ * ACC, GTP), case-insensitively.
+ */
+bool isProgramFileName(const std::string &name);
+
+/**
+ * @brief Builds a disassembler hook that shows relocated longwords as
+ * segment-relative names such as "TEXT+$1A" or "BSS+$100".
+ * @param fixups Sorted fixup offsets; copied into the returned hook.
+ */
+M68kSymbolizer prgSymbolizer(const PrgHeader &header,
+                             const std::vector<uint32_t> &fixups);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file HfeImage.h
+ * @brief HxC Floppy Emulator (.HFE) export and import.
+ *
+ * HFE v1 stores each track as MFM cells, the two sides interleaved in
+ * 256-byte blocks and every byte sent LSB first. Gotek drives running
+ * FlashFloppy and the HxC tools read it, and HxC can write it back to a
+ * real floppy.
+ */
+
+#ifndef HFEIMAGE_H
+#define HFEIMAGE_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/**
+ * @struct HfeOptions
+ * @brief Sector order on the exported tracks.
+ */
+struct HfeOptions {
+  uint32_t interleave = 1; /**< 1 puts logical sectors back to back. */
+  uint32_t skew = 0; /**< Slots sector 1 moves on each cylinder step. */
+};
+
+/**
+ * @struct HfeReport
+ * @brief Geometry found on import and the sectors that did not come back.
+ */
+struct HfeReport {
+  int tracks = 0;
+  int sides = 0;
+  int sectorsPerTrack = 0;
+  int badSectors = 0;     /**< Data CRC errors; the bytes are still used. */
+  int missingSectors = 0; /**< No readable ID field; zero-filled. */
+};
+
+/**
+ * @brief Encodes a sector image as HFE, all tracks in parallel.
+ *
+ * Geometry comes from the BPB, or from the image size when the BPB is
+ * not usable.
+ */
+bool encodeHfe(const std::vector<uint8_t> &image, const HfeOptions &options,
+               std::vector<uint8_t> &hfe, QString &error);
+
+/**
+ * @brief Decodes the MFM tracks of an HFE file back into a sector image.
+ *
+ * Sectors are placed by the physical track and side they were found on,
+ * and by the sector number in their ID field.
+ */
+bool decodeHfe(const uint8_t *data, std::size_t size,
+               std::vector<uint8_t> &image, HfeReport &report,
+               QString &error);
+
+/** @brief encodeHfe() straight to a file. */
+bool exportHfe(const std::vector<uint8_t> &image, const QString &path,
+               const HfeOptions &options, QString &error);
+
+/** @brief decodeHfe() straight from a file. */
+bool importHfe(const QString &path, std::vector<uint8_t> &image,
+               HfeReport &report, QString &error);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file ImageDaemon.h
+ * @brief Long-running local server that answers queries from cached images.
+ *
+ * Scripts that call the CLI per query pay for loading and walking the image
+ * every time. The daemon keeps parsed images in an LRU cache under a memory
+ * budget and serves list, stat, read and search requests over a Unix domain
+ * socket, one compact JSON object per line in each direction.
+ */
+
+#ifndef IMAGEDAEMON_H
+#define IMAGEDAEMON_H
+
+#include "AtariDiskEngine.h"
+#include <QCache>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QObject>
+#include <QString>
+#include <memory>
+#include <vector>
+
+class QLocalSocket;
+
+namespace Atari {
+
+/**
+ * @struct CachedImage
+ * @brief A loaded image with its directory tree already walked.
+ */
+struct CachedImage {
+  struct File {
+    QString path; /**< '/' separated, as stored on disk. */
+    DirEntry entry;
+  };
+
+  AtariDiskEngine engine;
+  std::vector<File> files; /**< Depth-first, directories included. */
+  QHash<QString, int> byPath; /**< Upper-cased path -> index in files. */
+  qint64 fileSize = 0;  /**< Host file size when loaded. */
+  qint64 fileMtime = 0; /**< Host file mtime (ms) when loaded. */
+};
+
+/**
+ * @class ImageCache
+ * @brief LRU cache of parsed images, bounded by their in-memory size.
+ *
+ * Entries are checked against the host file's size and mtime on every
+ * lookup, so an image rewritten on disk is reloaded rather than served
+ * stale. Images larger than the whole budget are loaded but not kept.
+ */
+class ImageCache {
+public:
+  explicit ImageCache(qint64 budgetBytes);
+
+  /**
+   * @return The image, loading it on a miss; null with error set if it
+   * cannot be loaded. Valid until the next lookup.
+   */
+  const CachedImage *image(const QString &path, QString &error);
+
+  /** @brief Drops one image, or every image if path is empty. */
+  void evict(const QString &path = QString());
+
+  /** @return Cached images, hits, misses and bytes held, as JSON. */
+  QJsonObject stats() const;
+
+private:
+  QCache<QString, CachedImage> m_cache; /**< Cost in KiB. */
+  std::unique_ptr<CachedImage> m_uncached; /**< Last over-budget image. */
+  qint64 m_hits = 0;
+  qint64 m_misses = 0;
+};
+
+/**
+ * @class ImageDaemon
+ * @brief Serves ImageCache lookups over a QLocalServer.
+ *
+ * Requests are {"op": ..., "image": ...} plus per-op fields:
+ * - list: every file and directory in the image.
+ * - stat {"path"}: one entry's size, attributes, cluster and timestamp.
+ * - read {"path", "offset", "length"}: file bytes as base64.
+ * - search {"pattern"}: files containing text, or bytes given as "0x..".
+ * - evict: forget the image (or all images without "image").
+ * - stats: cache occupancy and hit counts.
+ * Every reply carries "ok"; failures add "error".
+ */
+class ImageDaemon : public QObject {
+  Q_OBJECT
+
+public:
+  ImageDaemon(qint64 budgetBytes, QObject *parent = nullptr);
+
+  /** @brief Listens on a socket path, replacing a stale socket file. */
+  bool listen(const QString &socketPath, QString &error);
+
+  /** @brief Answers one request; also usable in process. */
+  QJsonObject handle(const QJsonObject &request);
+
+private slots:
+  void onNewConnection();
+
+private:
+  /** @brief Answers every complete line the client has sent. */
+  void onReadyRead(QLocalSocket *socket);
+
+  QLocalServer m_server;
+  ImageCache m_cache;
+};
+
+} // namespace Atari
+#endif
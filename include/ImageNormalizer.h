@@ -0,0 +1,85 @@
+/**
+ * @file ImageNormalizer.h
+ * @brief Clears leftover bytes so archived images compress well.
+ *
+ * Free clusters, the tail of a file's last cluster and unused directory
+ * slots keep whatever was there before: deleted files, old directory
+ * entries, duplicator fill patterns. None of it is reachable through the
+ * filesystem, but all of it ends up in MSA, zip and zstd archives.
+ */
+
+#ifndef IMAGENORMALIZER_H
+#define IMAGENORMALIZER_H
+
+#include "FatVolume.h"
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief Where a run of leftover bytes sits. */
+enum class SlackKind {
+  FreeCluster,  /**< A run of clusters marked free in the FAT. */
+  FileTail,     /**< Past end of file in a file's own clusters. */
+  DirectorySlot /**< Deleted or never-used directory entries. */
+};
+
+/** @return "free", "tail" or "slot". */
+const char *slackKindName(SlackKind kind);
+
+/**
+ * @struct SlackRegion
+ * @brief Image bytes that hold data nothing refers to.
+ */
+struct SlackRegion {
+  SlackKind kind;
+  uint32_t offset; /**< Image offset. */
+  uint32_t length;
+};
+
+/**
+ * @struct NormalizeReport
+ * @brief Bytes cleared and archive sizes before and after.
+ */
+struct NormalizeReport {
+  uint32_t freeBytes = 0; /**< In regions of each kind that were cleared. */
+  uint32_t tailBytes = 0;
+  uint32_t slotBytes = 0;
+  std::size_t deflateBefore = 0; /**< zlib level 9, whole image. */
+  std::size_t deflateAfter = 0;
+  std::size_t msaBefore = 0; /**< MSA track RLE; 0 without a usable BPB. */
+  std::size_t msaAfter = 0;
+};
+
+/**
+ * @brief Lists the regions that still hold non-zero leftover bytes.
+ *
+ * Free clusters come from one pass over the FAT. Clusters claimed by more
+ * than one chain (cross-linked files) are never treated as slack.
+ * Deleted entries keep their 0xE5 marker so the directory's end is not
+ * moved.
+ */
+std::vector<SlackRegion> findSlack(const FatVolume &volume);
+
+/**
+ * @brief Forensic copy: writes each region to dir as
+ * "<offset>-<kind>.bin" before it is cleared.
+ */
+bool saveSlack(const FatVolume &volume, const std::vector<SlackRegion> &slack,
+               const QString &dir, QString &error);
+
+/** @brief Zero-fills the regions and measures the compression gain. */
+NormalizeReport normalizeImage(FatVolume &volume,
+                               const std::vector<SlackRegion> &slack);
+
+/** @return Size of the data after zlib level 9. */
+std::size_t deflatedSize(const uint8_t *data, std::size_t size);
+
+/** @return Size of an MSA file holding the image (track RLE, all tracks). */
+std::size_t msaPackedSize(const uint8_t *image, std::size_t size,
+                          uint32_t sectorsPerTrack, uint32_t sides);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file ImageSniffer.h
+ * @brief Fast image-type classification for batch/corpus ingestion.
+ *
+ * The sniffer looks at the first few kilobytes of a file (plus its total
+ * size) and decides what kind of image it is without a full loadImage().
+ */
+
+#ifndef IMAGESNIFFER_H
+#define IMAGESNIFFER_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+
+namespace Atari {
+
+/** @brief Upper bound on the number of bytes read from a file when sniffing. */
+inline constexpr std::size_t SNIFF_PROBE_SIZE = 4096;
+
+/** @brief Broad categories of files found in disk image collections. */
+enum class ImageType {
+  Unknown,    /**< Nothing recognisable, but not obviously broken. */
+  RawST,      /**< Plain sector dump (.ST). */
+  MSA,        /**< Magic Shadow Archiver (.MSA). */
+  DIM,        /**< FastCopy Pro image (.DIM). */
+  STX,        /**< Pasti copy-protection image (.STX). */
+  HFE,        /**< HxC Floppy Emulator MFM track image (.HFE). */
+  SCP,        /**< SuperCard Pro flux capture (.SCP). */
+  HardDisk,   /**< Partitioned ACSI/SCSI/IDE hard disk image. */
+  Compressed, /**< Generic compressed container (zip, gzip, LZH, ...). */
+  Junk        /**< Too small or structurally impossible for a disk image. */
+};
+
+/**
+ * @struct SniffResult
+ * @brief Outcome of a sniff: the type, how sure we are and any geometry seen.
+ */
+struct SniffResult {
+  ImageType type = ImageType::Unknown;
+  int confidence = 0;        /**< 0 (guess) to 100 (certain). */
+  uint64_t fileSize = 0;     /**< Total size of the file in bytes. */
+  int tracks = 0;            /**< Tracks per side, 0 if unknown. */
+  int sides = 0;             /**< Number of sides, 0 if unknown. */
+  int sectorsPerTrack = 0;   /**< Sectors per track, 0 if unknown. */
+  uint32_t totalSectors = 0; /**< Sector count, 0 if unknown. */
+  QString detail;            /**< Short note, e.g. container kind. */
+
+  /** @return True if the geometry fields were filled in. */
+  bool hasGeometry() const { return sectorsPerTrack > 0 && sides > 0; }
+};
+
+/**
+ * @brief Classifies an image from its leading bytes.
+ * @param head Pointer to the first bytes of the file.
+ * @param headSize Number of valid bytes at head (at most SNIFF_PROBE_SIZE
+ * are looked at).
+ * @param fileSize Total size of the file, used for raw geometry matching.
+ * @return Classification result.
+ */
+SniffResult sniffImage(const uint8_t *head, std::size_t headSize,
+                       uint64_t fileSize);
+
+/**
+ * @brief Reads at most SNIFF_PROBE_SIZE bytes of a file and classifies it.
+ * @param path Host path of the file, or "archive.zip!/member" for a zip
+ * member (only the probe window is inflated).
+ * @return Classification result (Junk if the file cannot be opened).
+ */
+SniffResult sniffImageFile(const QString &path);
+
+/** @return A short display name for an image type ("ST", "MSA", ...). */
+const char *imageTypeName(ImageType type);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file ImageTransfer.h
+ * @brief Copies and moves files and folders between disk images.
+ *
+ * Nothing goes through the host: each file's clusters in the source image
+ * are streamed into clusters allocated on the target in one pass. Folders
+ * are copied with everything below them. Both images may be the same
+ * engine, which makes a copy within one disk.
+ */
+
+#ifndef IMAGETRANSFER_H
+#define IMAGETRANSFER_H
+
+#include "AtariDiskEngine.h"
+#include "FatVolume.h"
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+
+namespace Atari {
+
+/**
+ * @struct TransferReport
+ * @brief What a copy or move did; totals add up over several calls.
+ */
+struct TransferReport {
+  int files = 0;
+  int dirs = 0;
+  uint64_t bytes = 0;
+  QStringList failed; /**< "PATH: reason" per entry not copied. */
+};
+
+/**
+ * @brief Copies the entry in a slot into a directory of another volume.
+ *
+ * A file of the same name is overwritten in place; a folder of the same
+ * name is merged into. Attributes and timestamps are kept.
+ * @param dirCluster Target directory, 0 for the root.
+ * @return False if anything was not copied.
+ */
+bool copyEntry(const FatVolume &from, uint32_t slot, FatVolume &to,
+               uint16_t dirCluster, TransferReport &report);
+
+/** @brief Deletes a file, or a folder with everything in it. */
+void removeTree(FatVolume &volume, uint32_t slot);
+
+/**
+ * @brief Copies a file or folder of one image into a directory of another.
+ * @see copyEntry(const FatVolume &, uint32_t, FatVolume &, uint16_t,
+ * TransferReport &)
+ */
+bool copyEntry(AtariDiskEngine &from, const DirEntry &entry,
+               AtariDiskEngine &to, uint16_t dirCluster,
+               TransferReport &report);
+
+/**
+ * @brief As copyEntry(), then deletes the source if all of it arrived.
+ */
+bool moveEntry(AtariDiskEngine &from, const DirEntry &entry,
+               AtariDiskEngine &to, uint16_t dirCluster,
+               TransferReport &report);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file M68kDisassembler.h
+ * @brief Table-driven Motorola 68000 disassembler for boot code and PRGs.
+ *
+ * Every 16-bit opcode is classified through a 64K-entry table built at
+ * compile time; decoding an instruction is a table lookup plus operand
+ * formatting, so views can decode just the lines currently on screen.
+ */
+
+#ifndef M68KDISASSEMBLER_H
+#define M68KDISASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Atari {
+
+/**
+ * @struct M68kInstruction
+ * @brief One decoded instruction (or a dc.w for an illegal opcode).
+ */
+struct M68kInstruction {
+  uint32_t offset = 0; /**< Offset of the opcode in the code buffer. */
+  uint16_t length = 2; /**< Bytes consumed, including extension words. */
+  bool valid = false;  /**< False for illegal opcodes and truncated code. */
+  std::string text;    /**< e.g. "move.l  d0,(a0)+". */
+};
+
+/**
+ * @brief Optional hook that names 32-bit operands.
+ *
+ * Called for absolute long addresses and long immediates with the offset of
+ * the longword in the code buffer; return true and fill @p out to replace
+ * the plain hex value (used for relocated PRG references).
+ */
+using M68kSymbolizer =
+    std::function<bool(uint32_t offset, uint32_t value, std::string &out)>;
+
+/**
+ * @class M68kDisassembler
+ * @brief Decodes 68000 instructions from a borrowed code buffer.
+ */
+class M68kDisassembler {
+public:
+  /**
+   * @param code Pointer to the code bytes (not copied, must outlive us).
+   * @param size Number of bytes at code.
+   * @param baseAddress Address that code[0] is shown at.
+   */
+  M68kDisassembler(const uint8_t *code, std::size_t size,
+                   uint32_t baseAddress = 0);
+
+  /** @brief Installs a hook used to name relocated/absolute longwords. */
+  void setSymbolizer(M68kSymbolizer symbolizer) {
+    m_symbolizer = std::move(symbolizer);
+  }
+
+  /** @return The instruction starting at the given buffer offset. */
+  M68kInstruction decode(uint32_t offset) const;
+
+  /** @return Address shown for a buffer offset. */
+  uint32_t addressOf(uint32_t offset) const { return m_base + offset; }
+
+  /** @return Size of the code buffer in bytes. */
+  std::size_t size() const { return m_size; }
+
+private:
+  const uint8_t *m_code;
+  std::size_t m_size;
+  uint32_t m_base;
+  M68kSymbolizer m_symbolizer;
+};
+
+/**
+ * @brief Classifies an opcode through the compile-time decode table.
+ * @return 1-based index of the matching opcode pattern, 0 if illegal.
+ */
+uint8_t m68kOpcodeClass(uint16_t opcode) noexcept;
+
+} // namespace Atari
+#endif
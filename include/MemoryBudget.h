@@ -0,0 +1,72 @@
+/**
+ * @file MemoryBudget.h
+ * @brief One memory limit shared by every image open in a session.
+ *
+ * Each open image registers how much it holds and how to give memory
+ * back. Over the limit, the least recently used images first drop their
+ * caches, which are rebuilt on demand, and then page out entirely if they
+ * have no unsaved changes; they are reloaded from file when next used.
+ * The image in use is never trimmed.
+ */
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Atari {
+
+/**
+ * @class MemoryBudget
+ * @brief Least-recently-used trimming across registered clients.
+ */
+class MemoryBudget {
+public:
+  /** @brief What a client holds and how it gives memory back. */
+  struct Client {
+    std::function<std::size_t()> residentBytes;
+    /** Frees caches that can be rebuilt from the image. */
+    std::function<void()> dropCaches;
+    /** Frees the image itself; false if it cannot be reloaded as is. */
+    std::function<bool()> pageOut;
+  };
+
+  explicit MemoryBudget(std::size_t limitBytes) : m_limit(limitBytes) {}
+
+  std::size_t limit() const { return m_limit; }
+
+  /** @return Id of the new client, which counts as most recently used. */
+  int add(Client client);
+
+  void remove(int id);
+
+  /** @brief Marks a client as the one in use. */
+  void touch(int id);
+
+  /** @return Bytes currently held by all clients. */
+  std::size_t residentBytes() const;
+
+  /**
+   * @brief Trims clients, oldest first, until under the limit.
+   * @return Bytes held afterwards; may still exceed the limit.
+   */
+  std::size_t enforce();
+
+private:
+  struct Entry {
+    int id;
+    Client client;
+    uint64_t lastUse;
+  };
+
+  std::vector<Entry> m_clients;
+  std::size_t m_limit;
+  int m_nextId = 1;
+  uint64_t m_clock = 0;
+};
+
+} // namespace Atari
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file MfmCodec.h
+ * @brief MFM track encoding and decoding for the WD1772 floppy format.
+ *
+ * A track is a stream of MFM cells, two per data bit, packed MSB first.
+ * Each sector is an ID field (A1 A1 A1 FE cyl side sector size CRC) and a
+ * data field (A1 A1 A1 FB data CRC); the A1 marks are written with a
+ * missing clock bit (0x4489) so a decoder can find byte alignment.
+ */
+
+#ifndef MFMCODEC_H
+#define MFMCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief Data bytes in one revolution at 250 kbit/s and 300 rpm. */
+inline constexpr uint32_t MFM_DD_TRACK_BYTES = 6250;
+/** @brief Data bytes in one revolution at 500 kbit/s and 300 rpm. */
+inline constexpr uint32_t MFM_HD_TRACK_BYTES = 12500;
+
+/**
+ * @brief CRC16-CCITT (polynomial 0x1021, MSB first), eight bytes per step.
+ * @param crc Running value; 0xFFFF starts a new field.
+ */
+uint16_t crc16Ccitt(const uint8_t *data, std::size_t size,
+                    uint16_t crc = 0xFFFF);
+
+/**
+ * @struct MfmTrackLayout
+ * @brief Gap sizes and sector order of an encoded track.
+ */
+struct MfmTrackLayout {
+  uint32_t sectorsPerTrack = 9;
+  uint32_t trackBytes = MFM_DD_TRACK_BYTES; /**< Data bytes per revolution. */
+  uint32_t gap1 = 60;      /**< 0x4E bytes after the index pulse. */
+  uint32_t syncZeros = 12; /**< 0x00 bytes before each A1 mark. */
+  uint32_t gap2 = 22;      /**< Between ID field and data field. */
+  uint32_t gap3 = 40;      /**< After each data field. */
+  uint32_t interleave = 1; /**< Physical slots between logical sectors. */
+  uint32_t skew = 0; /**< Slots the first sector moves per cylinder. */
+
+  /**
+   * @brief Standard TOS gaps, or the tighter 11-sector gaps when those do
+   * not fit; more than 11 sectors means a high-density track.
+   */
+  static MfmTrackLayout forSectors(uint32_t sectorsPerTrack);
+
+  /** @return Bytes the sectors need, before the final gap fill. */
+  uint32_t usedBytes() const;
+
+  /** @return Sector numbers (from 1) in the order they pass the head. */
+  std::vector<uint8_t> sectorOrder(uint32_t cylinder) const;
+};
+
+/**
+ * @brief Encodes one side of one track.
+ * @param sectors sectorsPerTrack * 512 bytes, in logical order.
+ * @return MFM cells, MSB first; at least 2 * trackBytes bytes.
+ */
+std::vector<uint8_t> encodeMfmTrack(const uint8_t *sectors, uint8_t cylinder,
+                                    uint8_t side,
+                                    const MfmTrackLayout &layout);
+
+/**
+ * @struct MfmSector
+ * @brief A sector found in an MFM bitstream.
+ */
+struct MfmSector {
+  uint8_t cylinder = 0;
+  uint8_t side = 0;
+  uint8_t sector = 0;
+  uint8_t sizeCode = 0; /**< 2 for 512 bytes. */
+  bool dataCrcOk = false;
+  std::vector<uint8_t> data; /**< Empty if no data field followed. */
+};
+
+/**
+ * @brief Finds every sector whose ID field has a good CRC.
+ * @param cells MFM cells, MSB first.
+ * @param cellCount Number of valid cells (bits) at cells.
+ */
+std::vector<MfmSector> decodeMfmTrack(const uint8_t *cells,
+                                      std::size_t cellCount);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file ScpImage.h
+ * @brief SuperCard Pro (.SCP) flux capture import.
+ *
+ * An SCP file holds, per track, the time between flux transitions for one
+ * or more revolutions of the disk. A software PLL turns those intervals
+ * back into MFM cells, which then decode like any other MFM track.
+ */
+
+#ifndef SCPIMAGE_H
+#define SCPIMAGE_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief What went wrong with a sector across all revolutions. */
+enum class FluxSectorState {
+  Weak,   /**< Good CRC, but the revolutions disagree on the data. */
+  Bad,    /**< Data CRC failed in every revolution; best guess used. */
+  Missing /**< No ID field found; zero-filled. */
+};
+
+/**
+ * @struct FluxSectorIssue
+ * @brief One sector that did not read back cleanly.
+ */
+struct FluxSectorIssue {
+  int cylinder;
+  int side;
+  int sector; /**< From 1. */
+  FluxSectorState state;
+};
+
+/**
+ * @struct ScpReport
+ * @brief Geometry found on import and the sectors that need a look.
+ */
+struct ScpReport {
+  int tracks = 0;
+  int sides = 0;
+  int sectorsPerTrack = 0;
+  int revolutions = 0;
+  bool checksumOk = true; /**< False if the header checksum does not match. */
+  std::vector<FluxSectorIssue> issues; /**< By cylinder, side, sector. */
+
+  /** @return The number of issues in the given state. */
+  int count(FluxSectorState state) const;
+};
+
+/** @return "weak", "bad" or "missing". */
+const char *fluxSectorStateName(FluxSectorState state);
+
+/**
+ * @brief Decodes an SCP capture into a sector image.
+ *
+ * Every revolution of every track is decoded on its own, in parallel. For
+ * each sector the first copy with a good CRC wins; tracks past the last
+ * cylinder holding sectors (unformatted overscan) are dropped.
+ */
+bool decodeScp(const uint8_t *data, std::size_t size,
+               std::vector<uint8_t> &image, ScpReport &report,
+               QString &error);
+
+/** @brief decodeScp() straight from a file. */
+bool importScp(const QString &path, std::vector<uint8_t> &image,
+               ScpReport &report, QString &error);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file StPicture.h
+ * @brief DEGAS (PI1-3, PC1-3) and NEOchrome picture decoding.
+ *
+ * Pictures decode to one palette index per pixel plus an ARGB palette, so
+ * the UI can wrap the result in an indexed QImage without another pass.
+ */
+
+#ifndef STPICTURE_H
+#define STPICTURE_H
+
+#include "FileView.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Atari {
+
+/** Size of an uncompressed ST screen (all resolutions). */
+inline constexpr uint32_t ST_SCREEN_SIZE = 32000;
+
+enum class PictureFormat {
+  Unknown,
+  Degas,           /**< PI1/PI2/PI3: header, palette, raw screen. */
+  DegasCompressed, /**< PC1/PC2/PC3: PackBits per plane and scanline. */
+  Neochrome        /**< NEO: 128-byte header, raw screen. */
+};
+
+/**
+ * @struct StPicture
+ * @brief A decoded picture in chunky form.
+ */
+struct StPicture {
+  PictureFormat format = PictureFormat::Unknown;
+  int width = 0;
+  int height = 0;
+  int planes = 0;
+  uint32_t palette[16] = {}; /**< 0xAARRGGBB. */
+  std::vector<uint8_t> pixels; /**< width * height palette indices. */
+};
+
+/** @return The format implied by a file name's extension. */
+PictureFormat pictureFormatForName(const std::string &name);
+
+/**
+ * @brief Decodes a picture file.
+ * @param format Expected format (usually from pictureFormatForName()).
+ * @return False if the header or data does not fit the format.
+ */
+bool decodeStPicture(const FileView &file, PictureFormat format,
+                     StPicture &out);
+
+/**
+ * @brief Converts one scanline of bitplanes to palette indices.
+ *
+ * Byte k of plane p is read from row + p * planeStride + (k / 2) *
+ * groupStride + (k & 1), which covers both the ST's word-interleaved screen
+ * layout and DEGAS's plane-by-plane compressed lines.
+ */
+void planarRowToChunky(const uint8_t *row, int planes, int width,
+                       std::size_t planeStride, std::size_t groupStride,
+                       uint8_t *out);
+
+/** @return ARGB for an ST/STE palette word (STE's extra bit included). */
+uint32_t stColorToArgb(uint16_t color);
+
+} // namespace Atari
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file StructureMap.h
+ * @brief Names the on-disk structure behind each byte of an image.
+ *
+ * The BPB, both FAT copies and every directory slot are split into their
+ * fields, so a viewer can outline them and decode the value under the
+ * mouse. Lookups are arithmetic on the geometry read once per image; the
+ * only walk is over the directory tree, to know which data clusters hold
+ * directories.
+ */
+
+#ifndef STRUCTUREMAP_H
+#define STRUCTUREMAP_H
+
+#include "FatVolume.h"
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+enum class StructureKind { None, BootSector, Fat, Directory };
+
+/**
+ * @struct StructureField
+ * @brief The field a byte, or half of one, belongs to.
+ */
+struct StructureField {
+  StructureKind kind = StructureKind::None;
+  uint32_t id = 0;        /**< Equal for all bytes of one field. */
+  bool alternate = false; /**< Differs between neighbouring fields. */
+
+  bool operator==(const StructureField &o) const {
+    return kind == o.kind && id == o.id;
+  }
+  bool operator!=(const StructureField &o) const { return !(*this == o); }
+};
+
+/**
+ * @class StructureMap
+ * @brief Field lookup over a copy of an image or of its boot sector.
+ */
+class StructureMap {
+public:
+  /**
+   * @brief Maps an image whose boot sector is at offset 0. A lone boot
+   * sector works too; only its BPB is mapped then.
+   */
+  void setImage(std::vector<uint8_t> image);
+
+  void clear();
+
+  /**
+   * @brief Copies edited bytes in. The geometry is read again only if BPB
+   * fields changed, the directory walk redone only if a FAT or directory
+   * did; file contents cost nothing.
+   * @return True if fields may have moved outside the edited range.
+   */
+  bool update(uint32_t offset, const uint8_t *data, uint32_t length);
+
+  bool isEmpty() const { return m_image.empty(); }
+
+  const std::vector<uint8_t> &image() const { return m_image; }
+
+  /**
+   * @return Field of a byte. FAT12 entries share bytes, so the hex digit
+   * matters: nibble 0 is the high (first printed) digit, 1 the low.
+   */
+  StructureField fieldAt(uint32_t offset, int nibble = 0) const;
+
+  /** @return Field name and decoded value, or empty outside any field. */
+  QString describe(uint32_t offset, int nibble = 0) const;
+
+private:
+  void scanDirectories();
+  bool isDirectoryData(uint32_t offset) const;
+  QString describeBoot(uint32_t field) const;
+  QString describeFat(uint32_t copy, uint32_t entry) const;
+  QString describeSlot(uint32_t offset) const;
+
+  std::vector<uint8_t> m_image;
+  FatGeometry m_geo{};
+  bool m_hasGeometry = false;
+  /** Indexed by cluster; true where a subdirectory is stored. */
+  std::vector<bool> m_dirClusters;
+};
+
+} // namespace Atari
+#endif
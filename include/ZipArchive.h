@@ -0,0 +1,98 @@
+/**
+ * @file ZipArchive.h
+ * @brief Minimal read-only zip reader for opening disk images in archives.
+ *
+ * Only what the toolkit needs: central directory listing and streamed
+ * extraction of stored or deflated members through zlib. Paths of the form
+ * "archive.zip!/path/inside.st" address a single member.
+ */
+
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QFile>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Atari {
+
+/** @brief Largest member we are willing to inflate (guards against bombs). */
+inline constexpr uint32_t ZIP_MEMBER_SIZE_LIMIT = 64 * 1024 * 1024;
+
+/**
+ * @struct ZipMember
+ * @brief One entry of the zip central directory.
+ */
+struct ZipMember {
+  QString name;               /**< Path inside the archive ('/' separated). */
+  uint16_t method = 0;        /**< 0 = stored, 8 = deflate. */
+  uint16_t flags = 0;         /**< General purpose bit flags. */
+  uint32_t crc32 = 0;         /**< CRC-32 of the uncompressed data. */
+  uint32_t compressedSize = 0;
+  uint32_t uncompressedSize = 0;
+  uint32_t localHeaderOffset = 0;
+
+  /** @return True if the member is a directory placeholder. */
+  bool isDirectory() const { return name.endsWith('/'); }
+};
+
+/**
+ * @class ZipArchive
+ * @brief Lists and extracts members of a zip file without unpacking it.
+ */
+class ZipArchive {
+public:
+  /** @brief Opens the archive and reads its central directory. */
+  explicit ZipArchive(const QString &path);
+
+  /** @return True if the archive was opened and its directory parsed. */
+  bool isOpen() const { return m_open; }
+
+  /** @return All members in central directory order. */
+  const std::vector<ZipMember> &members() const { return m_members; }
+
+  /** @return Members whose name looks like a disk image (.st, .msa, ...). */
+  std::vector<ZipMember> imageMembers() const;
+
+  /**
+   * @brief Looks a member up by name (exact first, then case-insensitive).
+   * @return Pointer into members(), or nullptr if not present.
+   */
+  const ZipMember *findMember(const QString &name) const;
+
+  /**
+   * @brief Streams a member's data into a buffer.
+   * @param member Entry from members().
+   * @param out Receives the data; resized to the bytes produced.
+   * @param maxBytes Stop after this many bytes (CRC is only checked when the
+   * whole member is read).
+   * @return True on success.
+   */
+  bool readMember(const ZipMember &member, std::vector<uint8_t> &out,
+                  std::size_t maxBytes = SIZE_MAX);
+
+  /**
+   * @brief Splits "archive.zip!/inside/path" into its two halves.
+   * @return True if the path addresses a zip member.
+   */
+  static bool splitArchivePath(const QString &path, QString &archive,
+                               QString &member);
+
+  /** @return The combined "archive!/member" form of a member path. */
+  static QString memberPath(const QString &archive, const QString &member);
+
+  /** @return True if the file name has a disk image extension. */
+  static bool isDiskImageName(const QString &name);
+
+private:
+  bool readCentralDirectory();
+
+  QFile m_file;
+  std::vector<ZipMember> m_members;
+  bool m_open = false;
+};
+
+} // namespace Atari
+#endif
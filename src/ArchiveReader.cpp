@@ -0,0 +1,786 @@
+// =============================================================================
+//  ArchiveReader.cpp
+//  Atari ST Toolkit — ARC and LZH Archives
+//
+//  Header walking for both container formats, and streaming decoders for
+//  the methods found on ST disks: ARC's RLE/Huffman/LZW family and LHA's
+//  static-Huffman -lh4- to -lh7-. Compressed bytes are pulled through a
+//  FileView cursor; output goes straight into the caller's buffer, which
+//  doubles as the LZ77 window.
+// =============================================================================
+
+#include "../include/ArchiveReader.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <memory>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint8_t ARC_MARKER = 0x1A;
+constexpr uint32_t ARC_NAME_SIZE = 13;
+constexpr uint8_t ARC_DLE = 0x90;
+constexpr int ARC_SQUEEZE_EOF = 256;
+constexpr int ARC_CRUNCH_BITS = 12;
+constexpr int ARC_SQUASH_BITS = 13;
+constexpr int LZW_CLEAR = 256;
+constexpr int LZW_FIRST = 257;
+
+uint16_t le16(const uint8_t *p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t le32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/** Compressed bytes of one member, read forward through the view. */
+class Input {
+public:
+  Input(const FileView &file, uint32_t pos, uint32_t length)
+      : m_cursor(file, pos), m_left(length) {}
+
+  /** @return The next byte, or -1 past the member's compressed data. */
+  int get() {
+    uint8_t b;
+    if (m_left == 0 || !m_cursor.next(b))
+      return -1;
+    --m_left;
+    return b;
+  }
+
+private:
+  FileView::Cursor m_cursor;
+  uint32_t m_left;
+};
+
+/** Appends bytes up to the member's declared size. */
+class Output {
+public:
+  Output(std::vector<uint8_t> &out, uint32_t limit)
+      : m_out(out), m_limit(limit) {}
+
+  bool put(uint8_t c) {
+    if (m_out.size() >= m_limit)
+      return false;
+    m_out.push_back(c);
+    return true;
+  }
+
+private:
+  std::vector<uint8_t> &m_out;
+  uint32_t m_limit;
+};
+
+/**
+ * ARC's run-length layer: 0x90 n repeats the previous byte n - 1 more
+ * times; 0x90 0 is a literal 0x90 (and does not become the repeat byte).
+ */
+class RleOutput {
+public:
+  explicit RleOutput(Output &out) : m_out(out) {}
+
+  bool put(uint8_t c) {
+    if (m_repeat) {
+      m_repeat = false;
+      if (c == 0)
+        return m_out.put(ARC_DLE);
+      while (--c)
+        if (!m_out.put(m_last))
+          return false;
+      return true;
+    }
+    if (c == ARC_DLE) {
+      m_repeat = true;
+      return true;
+    }
+    m_last = c;
+    return m_out.put(c);
+  }
+
+private:
+  Output &m_out;
+  uint8_t m_last = 0;
+  bool m_repeat = false;
+};
+
+// =============================================================================
+//  ARC methods
+// =============================================================================
+
+template <class Sink> bool copyAll(Input &in, Sink &sink) {
+  for (int c; (c = in.get()) >= 0;)
+    if (!sink.put(static_cast<uint8_t>(c)))
+      return false;
+  return true;
+}
+
+/** Squeezed: a Huffman tree of int16 node pairs, bits taken LSB first. */
+bool unsqueeze(Input &in, RleOutput &sink) {
+  int lo = in.get(), hi = in.get();
+  if (lo < 0 || hi < 0)
+    return false;
+  const int count = lo | (hi << 8);
+  if (count > ARC_SQUEEZE_EOF)
+    return false;
+
+  std::vector<std::array<int16_t, 2>> nodes(count);
+  for (auto &node : nodes) {
+    for (int16_t &child : node) {
+      lo = in.get();
+      hi = in.get();
+      if (lo < 0 || hi < 0)
+        return false;
+      child = static_cast<int16_t>(lo | (hi << 8));
+    }
+  }
+  if (count == 0)
+    return true;
+
+  int byte = 0, bitsLeft = 0;
+  for (;;) {
+    int i = 0;
+    do {
+      if (bitsLeft == 0) {
+        if ((byte = in.get()) < 0)
+          return false;
+        bitsLeft = 8;
+      }
+      i = nodes[i][byte & 1];
+      byte >>= 1;
+      --bitsLeft;
+      if (i >= count)
+        return false;
+    } while (i >= 0);
+
+    const int c = -(i + 1);
+    if (c == ARC_SQUEEZE_EOF)
+      return true;
+    if (!sink.put(static_cast<uint8_t>(c)))
+      return false;
+  }
+}
+
+/**
+ * Code reader of Unix compress 4.0, which ARC adopted verbatim: codes are
+ * fetched in blocks of n_bits bytes, and whatever is left of a block is
+ * dropped when the code width grows or the table is cleared.
+ */
+class LzwCodes {
+public:
+  LzwCodes(Input &in, int maxBits)
+      : m_in(in), m_maxBits(maxBits), m_maxCodeMax(1 << maxBits) {}
+
+  void clear() { m_clear = true; }
+
+  int next(int freeEnt) {
+    if (m_clear || m_offset >= m_size || freeEnt > m_maxCode) {
+      if (freeEnt > m_maxCode) {
+        ++m_bits;
+        m_maxCode =
+            m_bits == m_maxBits ? m_maxCodeMax : (1 << m_bits) - 1;
+      }
+      if (m_clear) {
+        m_bits = 9;
+        m_maxCode = (1 << m_bits) - 1;
+        m_clear = false;
+      }
+      std::memset(m_buf, 0, sizeof(m_buf));
+      for (m_size = 0; m_size < m_bits; ++m_size) {
+        const int c = m_in.get();
+        if (c < 0)
+          break;
+        m_buf[m_size] = static_cast<uint8_t>(c);
+      }
+      if (m_size <= 0)
+        return -1;
+      m_offset = 0;
+      m_size = (m_size << 3) - (m_bits - 1);
+    }
+
+    const int at = m_offset >> 3;
+    const uint32_t window =
+        m_buf[at] | (m_buf[at + 1] << 8) | (m_buf[at + 2] << 16);
+    const int code = (window >> (m_offset & 7)) & ((1u << m_bits) - 1);
+    m_offset += m_bits;
+    return code;
+  }
+
+private:
+  Input &m_in;
+  int m_maxBits;
+  int m_maxCodeMax;
+  int m_bits = 9;
+  int m_maxCode = 511;
+  uint8_t m_buf[16 + 2];
+  int m_offset = 0;
+  int m_size = 0;
+  bool m_clear = false;
+};
+
+/** Crunched (method 8, through RLE) and squashed (method 9) LZW. */
+template <class Sink> bool unLzw(Input &in, int maxBits, Sink &sink) {
+  const int tableSize = 1 << maxBits;
+  std::vector<uint16_t> prefix(tableSize, 0);
+  std::vector<uint8_t> suffix(tableSize, 0);
+  std::vector<uint8_t> stack;
+  stack.reserve(tableSize);
+  for (int c = 0; c < 256; ++c)
+    suffix[c] = static_cast<uint8_t>(c);
+
+  LzwCodes codes(in, maxBits);
+  int freeEnt = LZW_FIRST;
+  int oldCode = codes.next(freeEnt);
+  if (oldCode < 0)
+    return true;
+  if (oldCode >= 256)
+    return false;
+  uint8_t finChar = static_cast<uint8_t>(oldCode);
+  if (!sink.put(finChar))
+    return false;
+
+  for (int code; (code = codes.next(freeEnt)) >= 0;) {
+    if (code == LZW_CLEAR) {
+      std::fill(prefix.begin(), prefix.begin() + 256, 0);
+      codes.clear();
+      freeEnt = LZW_FIRST - 1;
+      if ((code = codes.next(freeEnt)) < 0)
+        break;
+    }
+
+    const int inCode = code;
+    if (code > freeEnt)
+      return false;
+    if (code == freeEnt) {
+      stack.push_back(finChar);
+      code = oldCode;
+    }
+    while (code >= 256) {
+      if (stack.size() >= static_cast<std::size_t>(tableSize))
+        return false;
+      stack.push_back(suffix[code]);
+      code = prefix[code];
+    }
+    finChar = suffix[code];
+    stack.push_back(finChar);
+    while (!stack.empty()) {
+      if (!sink.put(stack.back()))
+        return false;
+      stack.pop_back();
+    }
+
+    if (freeEnt < tableSize) {
+      prefix[freeEnt] = static_cast<uint16_t>(oldCode);
+      suffix[freeEnt] = finChar;
+      ++freeEnt;
+    }
+    oldCode = inCode;
+  }
+  return true;
+}
+
+const char *arcMethodName(uint8_t method) {
+  switch (method) {
+  case 1:
+  case 2:
+    return "stored";
+  case 3:
+    return "packed";
+  case 4:
+    return "squeezed";
+  case 5:
+  case 6:
+  case 7:
+    return "crunched (old)";
+  case 8:
+    return "crunched";
+  case 9:
+    return "squashed";
+  case 10:
+    return "crushed";
+  case 11:
+    return "distilled";
+  default:
+    return "unknown";
+  }
+}
+
+// =============================================================================
+//  LHA static Huffman (-lh4- .. -lh7-)
+// =============================================================================
+
+constexpr int LH_MAXMATCH = 256;
+constexpr int LH_THRESHOLD = 3;
+constexpr int LH_NC = 255 + LH_MAXMATCH + 2 - LH_THRESHOLD;
+constexpr int LH_NT = 19;
+constexpr int LH_NPT = 19;
+constexpr int LH_CBIT = 9;
+constexpr int LH_TBIT = 5;
+
+class LhDecoder {
+public:
+  LhDecoder(Input &in, int dicBits)
+      : m_in(in), m_np(std::max(dicBits + 1, 14)),
+        m_pbit(dicBits >= 15 ? 5 : 4) {
+    fillBuf(16);
+  }
+
+  bool decode(std::vector<uint8_t> &out, uint32_t size) {
+    uint32_t blockSize = 0;
+    while (out.size() < size) {
+      if (blockSize == 0) {
+        blockSize = getBits(16);
+        if (!readPtLen(LH_NT, LH_TBIT, 3) || !readCLen() ||
+            !readPtLen(m_np, m_pbit, -1))
+          return false;
+      }
+      --blockSize;
+
+      const int c = decodeC();
+      if (c < 256) {
+        out.push_back(static_cast<uint8_t>(c));
+        continue;
+      }
+      const uint32_t length = c - 256 + LH_THRESHOLD;
+      const uint32_t distance = decodeP() + 1;
+      if (distance > out.size() || length > size - out.size())
+        return false;
+      // Byte by byte: overlapping matches repeat recent output.
+      std::size_t from = out.size() - distance;
+      for (uint32_t i = 0; i < length; ++i)
+        out.push_back(out[from++]);
+    }
+    return true;
+  }
+
+private:
+  void fillBuf(int n) {
+    m_bitBuf = static_cast<uint16_t>(m_bitBuf << n);
+    while (n > m_bitCount) {
+      n -= m_bitCount;
+      m_bitBuf = static_cast<uint16_t>(m_bitBuf | (m_subBitBuf << n));
+      const int c = m_in.get();
+      m_subBitBuf = c < 0 ? 0 : static_cast<uint8_t>(c);
+      m_bitCount = 8;
+    }
+    m_bitCount -= n;
+    m_bitBuf = static_cast<uint16_t>(m_bitBuf | (m_subBitBuf >> m_bitCount));
+  }
+
+  uint32_t getBits(int n) {
+    if (n == 0)
+      return 0;
+    const uint32_t x = m_bitBuf >> (16 - n);
+    fillBuf(n);
+    return x;
+  }
+
+  bool makeTable(int nchar, const uint8_t *bitLen, int tableBits,
+                 uint16_t *table) {
+    uint32_t count[17] = {}, weight[17], start[18];
+    for (int i = 0; i < nchar; ++i) {
+      if (bitLen[i] > 16)
+        return false;
+      ++count[bitLen[i]];
+    }
+
+    start[1] = 0;
+    for (int i = 1; i <= 16; ++i)
+      start[i + 1] = start[i] + (count[i] << (16 - i));
+    if (start[17] != (1u << 16))
+      return false;
+
+    const int jutBits = 16 - tableBits;
+    for (int i = 1; i <= tableBits; ++i) {
+      start[i] >>= jutBits;
+      weight[i] = 1u << (tableBits - i);
+    }
+    for (int i = tableBits + 1; i <= 16; ++i)
+      weight[i] = 1u << (16 - i);
+
+    const uint32_t tableSize = 1u << tableBits;
+    for (uint32_t i = start[tableBits + 1] >> jutBits; i < tableSize; ++i)
+      table[i] = 0;
+
+    int avail = nchar;
+    const uint32_t mask = 1u << (15 - tableBits);
+    for (int ch = 0; ch < nchar; ++ch) {
+      const int len = bitLen[ch];
+      if (len == 0)
+        continue;
+      const uint32_t nextCode = start[len] + weight[len];
+      if (len <= tableBits) {
+        for (uint32_t i = start[len]; i < nextCode; ++i)
+          table[i] = static_cast<uint16_t>(ch);
+      } else {
+        uint32_t k = start[len];
+        uint16_t *p = &table[k >> jutBits];
+        for (int i = len - tableBits; i != 0; --i) {
+          if (*p == 0) {
+            if (avail >= 2 * LH_NC - 1)
+              return false;
+            m_right[avail] = m_left[avail] = 0;
+            *p = static_cast<uint16_t>(avail++);
+          }
+          p = (k & mask) ? &m_right[*p] : &m_left[*p];
+          k <<= 1;
+        }
+        *p = static_cast<uint16_t>(ch);
+      }
+      start[len] = nextCode;
+    }
+    return true;
+  }
+
+  bool readPtLen(int nn, int nbit, int special) {
+    const int n = static_cast<int>(getBits(nbit));
+    if (n == 0) {
+      const uint16_t c = static_cast<uint16_t>(getBits(nbit));
+      std::fill(m_ptLen, m_ptLen + nn, 0);
+      std::fill(m_ptTable, m_ptTable + 256, c);
+      return c < nn;
+    }
+    if (n > nn)
+      return false;
+
+    int i = 0;
+    while (i < n) {
+      int c = m_bitBuf >> 13;
+      if (c == 7) {
+        for (uint16_t mask = 1u << 12; mask & m_bitBuf; mask >>= 1)
+          ++c;
+        if (c > 16)
+          return false;
+      }
+      fillBuf(c < 7 ? 3 : c - 3);
+      m_ptLen[i++] = static_cast<uint8_t>(c);
+      if (i == special) {
+        int zeros = static_cast<int>(getBits(2));
+        while (zeros-- > 0 && i < nn)
+          m_ptLen[i++] = 0;
+      }
+    }
+    std::fill(m_ptLen + i, m_ptLen + nn, 0);
+    return makeTable(nn, m_ptLen, 8, m_ptTable);
+  }
+
+  bool readCLen() {
+    const int n = static_cast<int>(getBits(LH_CBIT));
+    if (n == 0) {
+      const uint16_t c = static_cast<uint16_t>(getBits(LH_CBIT));
+      std::fill(m_cLen, m_cLen + LH_NC, 0);
+      std::fill(m_cTable, m_cTable + 4096, c);
+      return c < LH_NC;
+    }
+    if (n > LH_NC)
+      return false;
+
+    int i = 0;
+    while (i < n) {
+      int c = m_ptTable[m_bitBuf >> 8];
+      for (uint16_t mask = 1u << 7; c >= LH_NT; mask >>= 1) {
+        if (!mask)
+          return false;
+        c = (m_bitBuf & mask) ? m_right[c] : m_left[c];
+      }
+      fillBuf(m_ptLen[c]);
+      if (c <= 2) {
+        if (c == 0)
+          c = 1;
+        else if (c == 1)
+          c = static_cast<int>(getBits(4)) + 3;
+        else
+          c = static_cast<int>(getBits(LH_CBIT)) + 20;
+        if (c > n - i)
+          return false;
+        while (c-- > 0)
+          m_cLen[i++] = 0;
+      } else {
+        m_cLen[i++] = static_cast<uint8_t>(c - 2);
+      }
+    }
+    std::fill(m_cLen + i, m_cLen + LH_NC, 0);
+    return makeTable(LH_NC, m_cLen, 12, m_cTable);
+  }
+
+  int decodeC() {
+    int j = m_cTable[m_bitBuf >> 4];
+    for (uint16_t mask = 1u << 3; j >= LH_NC; mask >>= 1) {
+      if (!mask)
+        return 0;
+      j = (m_bitBuf & mask) ? m_right[j] : m_left[j];
+    }
+    fillBuf(m_cLen[j]);
+    return j;
+  }
+
+  uint32_t decodeP() {
+    int j = m_ptTable[m_bitBuf >> 8];
+    for (uint16_t mask = 1u << 7; j >= m_np; mask >>= 1) {
+      if (!mask)
+        return 0;
+      j = (m_bitBuf & mask) ? m_right[j] : m_left[j];
+    }
+    fillBuf(m_ptLen[j]);
+    if (j == 0)
+      return 0;
+    return (1u << (j - 1)) + getBits(j - 1);
+  }
+
+  Input &m_in;
+  int m_np;
+  int m_pbit;
+  uint16_t m_bitBuf = 0;
+  uint8_t m_subBitBuf = 0;
+  int m_bitCount = 0;
+
+  uint16_t m_left[2 * LH_NC - 1] = {};
+  uint16_t m_right[2 * LH_NC - 1] = {};
+  uint16_t m_cTable[4096] = {};
+  uint16_t m_ptTable[256] = {};
+  uint8_t m_cLen[LH_NC] = {};
+  uint8_t m_ptLen[LH_NPT] = {};
+};
+
+/** @return Dictionary bits for -lh4- .. -lh7-, 0 if not a Huffman method. */
+int lhDictionaryBits(const std::string &method) {
+  if (method == "-lh4-")
+    return 12;
+  if (method == "-lh5-")
+    return 13;
+  if (method == "-lh6-")
+    return 15;
+  if (method == "-lh7-")
+    return 16;
+  return 0;
+}
+
+std::string cleanPath(std::string path) {
+  for (char &c : path)
+    if (c == '\\' || c == '\xFF')
+      c = '/';
+  return path;
+}
+
+} // namespace
+
+uint16_t crc16Arc(const uint8_t *data, std::size_t size, uint16_t crc) {
+  static const std::array<uint16_t, 256> table = [] {
+    std::array<uint16_t, 256> t{};
+    for (int i = 0; i < 256; ++i) {
+      uint16_t c = static_cast<uint16_t>(i);
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? static_cast<uint16_t>((c >> 1) ^ 0xA001) : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  for (std::size_t i = 0; i < size; ++i)
+    crc = static_cast<uint16_t>((crc >> 8) ^ table[(crc ^ data[i]) & 0xFF]);
+  return crc;
+}
+
+// =============================================================================
+//  Listing
+// =============================================================================
+
+ArchiveReader::ArchiveReader(const FileView &file) : m_file(file) {
+  uint8_t first[3] = {0, 0, 0};
+  m_file.read(0, first, 3);
+  if (first[0] == ARC_MARKER && readArcHeaders())
+    m_format = ArchiveFormat::Arc;
+  else if (m_file.size() > 21 && first[2] == '-' && readLzhHeaders())
+    m_format = ArchiveFormat::Lzh;
+  else
+    m_members.clear();
+}
+
+bool ArchiveReader::readArcHeaders() {
+  // marker, method, name[13], packed, date, time, crc, [size]
+  constexpr uint32_t HEADER_SIZE = 2 + ARC_NAME_SIZE + 4 + 2 + 2 + 2 + 4;
+  uint32_t pos = 0;
+  for (;;) {
+    uint8_t h[HEADER_SIZE] = {};
+    const uint32_t got = m_file.read(pos, h, HEADER_SIZE);
+    if (got < 2 || h[0] != ARC_MARKER)
+      return false;
+    if (h[1] == 0)
+      return !m_members.empty(); // End-of-archive marker
+    const uint32_t headerSize = h[1] == 1 ? HEADER_SIZE - 4 : HEADER_SIZE;
+    if (got < headerSize)
+      return false;
+
+    ArchiveMember m;
+    const char *name = reinterpret_cast<const char *>(h + 2);
+    m.name = std::string(name, std::find(name, name + ARC_NAME_SIZE, '\0'));
+    m.arcMethod = h[1];
+    m.method = arcMethodName(m.arcMethod);
+    m.compressedSize = le32(h + 15);
+    m.crc16 = le16(h + 23);
+    m.size = h[1] == 1 ? m.compressedSize : le32(h + 25);
+    m.dataOffset = pos + headerSize;
+    if (uint64_t(m.dataOffset) + m.compressedSize > m_file.size())
+      return false;
+    pos = m.dataOffset + m.compressedSize;
+    m_members.push_back(std::move(m));
+    if (pos == m_file.size())
+      return true; // Some archivers omit the end marker
+  }
+}
+
+bool ArchiveReader::readLzhHeaders() {
+  uint32_t pos = 0;
+  while (pos < m_file.size()) {
+    uint8_t h[256 + 2] = {};
+    const uint32_t got = m_file.read(pos, h, sizeof(h));
+    if (h[0] == 0)
+      break; // End-of-archive byte
+    if (got < 24 || h[2] != '-' || h[6] != '-')
+      return false;
+
+    ArchiveMember m;
+    m.method = std::string(reinterpret_cast<const char *>(h + 2), 5);
+    m.compressedSize = le32(h + 7);
+    m.size = le32(h + 11);
+    const int level = h[20];
+    uint32_t extStart, nextExt, dataStart;
+
+    if (level == 0 || level == 1) {
+      const uint32_t baseSize = h[0] + 2u;
+      const uint32_t nameLength = h[21];
+      if (22 + nameLength + 2 > baseSize || baseSize > got)
+        return false;
+      m.name = std::string(reinterpret_cast<const char *>(h + 22), nameLength);
+      m.crc16 = le16(h + 22 + nameLength);
+      extStart = pos + baseSize;
+      nextExt = level == 1 ? le16(h + baseSize - 2) : 0;
+      dataStart = extStart;
+    } else if (level == 2) {
+      const uint32_t total = le16(h);
+      m.crc16 = le16(h + 21);
+      extStart = pos + 26;
+      nextExt = le16(h + 24);
+      dataStart = pos + total;
+    } else {
+      return false;
+    }
+
+    // Extended headers: type byte, payload, size of the next header.
+    std::string dir;
+    uint32_t extTotal = 0;
+    for (uint32_t at = extStart; nextExt != 0;) {
+      std::vector<uint8_t> ext(nextExt);
+      if (nextExt < 3 || m_file.read(at, ext.data(), nextExt) != nextExt)
+        return false;
+      const std::string payload(ext.begin() + 1, ext.end() - 2);
+      if (ext[0] == 0x01)
+        m.name = payload;
+      else if (ext[0] == 0x02)
+        dir = payload;
+      at += nextExt;
+      extTotal += nextExt;
+      nextExt = le16(ext.data() + ext.size() - 2);
+    }
+
+    if (level == 1) {
+      // Level 1 counts the extended headers as part of the packed size.
+      if (extTotal > m.compressedSize)
+        return false;
+      m.compressedSize -= extTotal;
+      dataStart = extStart + extTotal;
+    }
+    const uint32_t next = dataStart + m.compressedSize;
+    if (next > m_file.size() || next <= pos)
+      return false;
+
+    if (!dir.empty() && dir.back() != '\xFF' && dir.back() != '\\')
+      dir += '/';
+    m.name = cleanPath(dir + m.name);
+    m.dataOffset = dataStart;
+    if (m.method != "-lhd-") // Directory entries carry no data
+      m_members.push_back(std::move(m));
+    pos = next;
+  }
+  return !m_members.empty();
+}
+
+bool ArchiveReader::isArchiveName(const std::string &name) {
+  const std::size_t dot = name.rfind('.');
+  if (dot == std::string::npos || name.size() - dot != 4)
+    return false;
+  std::string ext = name.substr(dot + 1);
+  for (char &c : ext)
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  return ext == "ARC" || ext == "LZH" || ext == "LHA";
+}
+
+// =============================================================================
+//  Extraction
+// =============================================================================
+
+bool ArchiveReader::readMember(const ArchiveMember &member,
+                               std::vector<uint8_t> &out,
+                               std::string &error) const {
+  out.clear();
+  if (member.size > ARCHIVE_MEMBER_SIZE_LIMIT) {
+    error = "member too large";
+    return false;
+  }
+  out.reserve(member.size);
+
+  Input in(m_file, member.dataOffset, member.compressedSize);
+  Output sink(out, member.size);
+  RleOutput rle(sink);
+  bool ok = false;
+
+  if (m_format == ArchiveFormat::Arc) {
+    switch (member.arcMethod) {
+    case 1:
+    case 2:
+      ok = copyAll(in, sink);
+      break;
+    case 3:
+      ok = copyAll(in, rle);
+      break;
+    case 4:
+      ok = unsqueeze(in, rle);
+      break;
+    case 8: {
+      const int bits = in.get();
+      ok = bits == ARC_CRUNCH_BITS && unLzw(in, bits, rle);
+      break;
+    }
+    case 9:
+      ok = unLzw(in, ARC_SQUASH_BITS, sink);
+      break;
+    default:
+      error = "unsupported method: " + member.method;
+      return false;
+    }
+  } else if (member.method == "-lh0-" || member.method == "-lz4-") {
+    ok = copyAll(in, sink);
+  } else if (const int dicBits = lhDictionaryBits(member.method)) {
+    // Large tables: keep them off the stack.
+    auto decoder = std::make_unique<LhDecoder>(in, dicBits);
+    ok = decoder->decode(out, member.size);
+  } else {
+    error = "unsupported method: " + member.method;
+    return false;
+  }
+
+  if (!ok || out.size() != member.size) {
+    error = "data is damaged";
+    return false;
+  }
+  if (crc16Arc(out.data(), out.size()) != member.crc16) {
+    error = "CRC mismatch";
+    return false;
+  }
+  return true;
+}
+
+} // namespace Atari
@@ -0,0 +1,125 @@
+// =============================================================================
+//  AsyncEngine.cpp
+//  Atari ST Toolkit — Asynchronous Engine Calls
+//
+//  Each call is a job on a private one-thread pool, so jobs never overlap
+//  and run in order without a lock around the engine. The UI only ever
+//  holds futures; results come back through QFutureWatcher signals.
+// =============================================================================
+
+#include "../include/AsyncEngine.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
+#include <exception>
+
+namespace Atari {
+
+AsyncEngine::AsyncEngine(QObject *parent) : QObject(parent) {
+  m_pool.setMaxThreadCount(1);
+}
+
+AsyncEngine::~AsyncEngine() { m_pool.waitForDone(); }
+
+template <typename F>
+auto AsyncEngine::enqueue(F job) -> AsyncOp<decltype(job())> {
+  ++m_pending;
+  return AsyncOp<decltype(job())>(
+      QtConcurrent::run(&m_pool, [this, job = std::move(job)]() mutable {
+        // Counted off even if the job throws, or isIdle() would never
+        // come back (bad_alloc from a large read, say).
+        struct Done {
+          std::atomic<int> &pending;
+          ~Done() { --pending; }
+        } done{m_pending};
+        return job();
+      }));
+}
+
+// =============================================================================
+//  Calls
+// =============================================================================
+
+AsyncOp<bool> AsyncEngine::load(const QString &path) {
+  return enqueue([this, path] {
+    bool ok = false;
+    try {
+      ok = m_engine.loadImage(path);
+    } catch (const std::exception &) {
+      ok = false; // Unreadable or truncated image
+    }
+    if (ok) {
+      m_path = path;
+      m_flushedCounter = m_engine.changeCounter();
+      emit imageChanged();
+    }
+    return ok;
+  });
+}
+
+AsyncOp<bool> AsyncEngine::load(std::vector<uint8_t> image) {
+  return enqueue([this, image = std::move(image)]() mutable {
+    m_engine.load(std::move(image));
+    m_path.clear();
+    m_flushedCounter = m_engine.changeCounter();
+    emit imageChanged();
+    return m_engine.isLoaded();
+  });
+}
+
+AsyncOp<bool> AsyncEngine::save(const QString &path) {
+  return enqueue([this, path] {
+    if (!m_engine.isLoaded())
+      return false;
+    const bool sameFile =
+        !m_path.isEmpty() && QFileInfo(path).absoluteFilePath() ==
+                                 QFileInfo(m_path).absoluteFilePath();
+    if (sameFile) {
+      if (!m_engine.saveChanges(path, m_flushedCounter))
+        return false;
+    } else {
+      const std::vector<uint8_t> &data = m_engine.getRawImageData();
+      QFile out(path);
+      if (!out.open(QIODevice::WriteOnly) ||
+          out.write(reinterpret_cast<const char *>(data.data()),
+                    static_cast<qint64>(data.size())) !=
+              static_cast<qint64>(data.size()))
+        return false;
+      m_path = path;
+    }
+    m_flushedCounter = m_engine.changeCounter();
+    return true;
+  });
+}
+
+AsyncOp<bool> AsyncEngine::inject(const QString &localPath) {
+  return enqueue([this, localPath] {
+    if (!m_engine.injectFile(localPath))
+      return false;
+    emit imageChanged();
+    return true;
+  });
+}
+
+AsyncOp<bool> AsyncEngine::extract(const DirEntry &entry,
+                                   const QString &hostPath) {
+  return enqueue([this, entry, hostPath] {
+    const QByteArray data = m_engine.readFileQt(entry);
+    QFile out(hostPath);
+    return out.open(QIODevice::WriteOnly) && out.write(data) == data.size();
+  });
+}
+
+AsyncOp<QVector<SearchResult>> AsyncEngine::search(const QByteArray &pattern) {
+  return enqueue([this, pattern] { return m_engine.searchPattern(pattern); });
+}
+
+AsyncOp<FsckReport> AsyncEngine::fsck() {
+  return enqueue([this] {
+    // volume() binds for writing, but the check only reads through it.
+    const FatVolume volume = m_engine.volume();
+    return checkFileSystem(volume);
+  });
+}
+
+} // namespace Atari
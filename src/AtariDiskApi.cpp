@@ -0,0 +1,565 @@
+// =============================================================================
+//  AtariDiskApi.cpp
+//  Atari ST Toolkit — C Interface
+//
+//  Nothing here allocates behind the caller's back: directories are walked
+//  slot by slot straight off the FAT, paths are resolved in place, and the
+//  only buffers are the handles themselves, an owned image copy and the
+//  search scratch, all from the caller's allocator.
+// =============================================================================
+
+#include "../include/AtariDiskApi.h"
+#include "../include/DiskBytes.h"
+#include "../include/FatVolume.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+struct atari_disk {
+  atari_allocator allocator;
+  const uint8_t *image;
+  size_t size;
+  bool owned; /**< image came from allocator and is freed on close. */
+  Atari::FatGeometry geo;
+};
+
+struct atari_dir {
+  atari_disk *disk;
+  uint16_t cluster; /**< 0 while walking the root directory. */
+  uint32_t index;   /**< Next slot in the root or in this cluster. */
+  uint32_t steps;   /**< Clusters followed; bounds FAT loops. */
+  bool done;
+};
+
+namespace Atari {
+
+namespace {
+
+constexpr uint32_t SLOT_SIZE = 32;
+constexpr uint8_t SLOT_FREE = 0x00;
+constexpr uint8_t SLOT_DELETED = 0xE5;
+/** Same limits as FatVolume and the tree model. */
+constexpr uint32_t MAX_DIR_CLUSTERS = 64;
+constexpr int MAX_DEPTH = 16;
+/** Longest path atari_search() reports: 16 levels of "NAME.EXT/". */
+constexpr size_t MAX_PATH_LENGTH = MAX_DEPTH * 13 + 1;
+
+void *mallocAlloc(size_t size, void *) { return std::malloc(size); }
+void mallocFree(void *ptr, size_t, void *) { std::free(ptr); }
+
+void *allocate(const atari_allocator &a, size_t size) {
+  return a.alloc(size, a.user);
+}
+
+void release(const atari_allocator &a, void *ptr, size_t size) {
+  if (ptr)
+    a.free(ptr, size, a.user);
+}
+
+uint16_t nextCluster(const atari_disk &d, uint16_t cluster) {
+  if (cluster < 2 || cluster >= d.geo.clusterCount + 2)
+    return FAT_END_OF_CHAIN;
+  const uint8_t *fat = d.image + d.geo.reservedSectors * SECTOR_SIZE;
+  const uint16_t raw = readLE16(fat + cluster * 3 / 2);
+  return (cluster & 1) ? (raw >> 4) : (raw & 0x0FFF);
+}
+
+bool isDataCluster(const atari_disk &d, uint16_t cluster) {
+  return cluster >= 2 && cluster < d.geo.clusterCount + 2;
+}
+
+const uint8_t *clusterData(const atari_disk &d, uint16_t cluster) {
+  return d.image +
+         (d.geo.dataSector + (cluster - 2) * d.geo.sectorsPerCluster) *
+             SECTOR_SIZE;
+}
+
+void startDir(atari_dir &dir, atari_disk *disk, uint16_t cluster) {
+  dir.disk = disk;
+  dir.cluster = cluster;
+  dir.index = 0;
+  dir.steps = 0;
+  dir.done = cluster != 0 && !isDataCluster(*disk, cluster);
+}
+
+/** @return The next live slot, or null at the end of the directory. */
+const uint8_t *nextSlot(atari_dir &dir) {
+  const atari_disk &d = *dir.disk;
+  const uint32_t perCluster = d.geo.clusterBytes() / SLOT_SIZE;
+  while (!dir.done) {
+    const uint8_t *slot;
+    if (dir.cluster == 0) {
+      if (dir.index >= d.geo.rootEntries)
+        break;
+      slot = d.image + d.geo.rootSector * SECTOR_SIZE +
+             dir.index * SLOT_SIZE;
+    } else {
+      if (dir.index >= perCluster) {
+        dir.cluster = nextCluster(d, dir.cluster);
+        dir.index = 0;
+        if (!isDataCluster(d, dir.cluster) ||
+            ++dir.steps >= MAX_DIR_CLUSTERS)
+          break;
+      }
+      slot = clusterData(d, dir.cluster) + dir.index * SLOT_SIZE;
+    }
+    ++dir.index;
+    if (slot[0] == SLOT_FREE)
+      break;
+    if (slot[0] == SLOT_DELETED || slot[0] == '.' ||
+        (slot[11] & ATTR_VOLUME))
+      continue;
+    return slot;
+  }
+  dir.done = true;
+  return nullptr;
+}
+
+void fillEntry(const uint8_t *slot, atari_entry &e) {
+  size_t n = 0;
+  for (int i = 0; i < 8 && slot[i] != ' '; ++i)
+    e.name[n++] = static_cast<char>(slot[i]);
+  if (slot[8] != ' ') {
+    e.name[n++] = '.';
+    for (int i = 8; i < 11 && slot[i] != ' '; ++i)
+      e.name[n++] = static_cast<char>(slot[i]);
+  }
+  e.name[n] = '\0';
+  e.attributes = slot[11];
+  e.dos_time = readLE16(slot + 22);
+  e.dos_date = readLE16(slot + 24);
+  e.start_cluster = readLE16(slot + 26);
+  e.size = (slot[11] & ATTR_DIRECTORY) ? 0 : readLE32(slot + 28);
+}
+
+/** @return True if a path component (not NUL-terminated) names the entry. */
+bool sameName(const char *part, size_t length, const char *name) {
+  size_t i = 0;
+  for (; i < length && name[i]; ++i) {
+    if (std::toupper(static_cast<unsigned char>(part[i])) !=
+        std::toupper(static_cast<unsigned char>(name[i])))
+      return false;
+  }
+  return i == length && name[i] == '\0';
+}
+
+/**
+ * @brief Resolves a path component by component.
+ * @param slot Set to the entry's slot, or null for the root itself.
+ */
+atari_status resolve(atari_disk *disk, const char *path,
+                     const uint8_t *&slot) {
+  slot = nullptr;
+  uint16_t cluster = 0;
+  for (const char *p = path; *p;) {
+    if (*p == '/' || *p == '\\') {
+      ++p;
+      continue;
+    }
+    const char *end = p;
+    while (*end && *end != '/' && *end != '\\')
+      ++end;
+    if (slot && !(slot[11] & ATTR_DIRECTORY))
+      return ATARI_E_NOT_DIR;
+
+    atari_dir dir;
+    startDir(dir, disk, cluster);
+    const uint8_t *found = nullptr;
+    atari_entry e;
+    while (const uint8_t *s = nextSlot(dir)) {
+      fillEntry(s, e);
+      if (sameName(p, static_cast<size_t>(end - p), e.name)) {
+        found = s;
+        break;
+      }
+    }
+    if (!found)
+      return ATARI_E_NOT_FOUND;
+    slot = found;
+    cluster = readLE16(found + 26);
+    p = end;
+  }
+  return ATARI_OK;
+}
+
+/**
+ * @brief Copies file bytes [offset, offset + capacity) following the chain.
+ * @return Bytes copied.
+ */
+size_t readChain(const atari_disk &d, const uint8_t *slot, uint32_t offset,
+                 uint8_t *out, size_t capacity) {
+  const uint32_t size = readLE32(slot + 28);
+  if (offset >= size)
+    return 0;
+  const uint32_t clusterBytes = d.geo.clusterBytes();
+  size_t copied = 0;
+  uint32_t pos = 0;
+  uint16_t c = readLE16(slot + 26);
+  for (uint32_t steps = 0; isDataCluster(d, c) && pos < size &&
+                           copied < capacity && steps < d.geo.clusterCount;
+       ++steps, c = nextCluster(d, c), pos += clusterBytes) {
+    const uint32_t length = std::min(clusterBytes, size - pos);
+    if (offset >= pos + length)
+      continue;
+    const uint32_t from = offset > pos ? offset - pos : 0;
+    const size_t n = std::min<size_t>(length - from, capacity - copied);
+    std::memcpy(out + copied, clusterData(d, c) + from, n);
+    copied += n;
+  }
+  return copied;
+}
+
+/** @return Pointer to the whole file if its clusters are consecutive. */
+const uint8_t *contiguousFile(const atari_disk &d, const uint8_t *slot) {
+  const uint32_t size = readLE32(slot + 28);
+  uint16_t c = readLE16(slot + 26);
+  if (!isDataCluster(d, c))
+    return nullptr;
+  const uint16_t first = c;
+  const uint32_t clusters =
+      (size + d.geo.clusterBytes() - 1) / d.geo.clusterBytes();
+  for (uint32_t i = 1; i < clusters; ++i) {
+    const uint16_t next = nextCluster(d, c);
+    if (next != c + 1 || !isDataCluster(d, next))
+      return nullptr;
+    c = next;
+  }
+  return clusterData(d, first);
+}
+
+struct Search {
+  atari_disk *disk;
+  const uint8_t *pattern;
+  size_t length;
+  atari_search_fn callback;
+  void *user;
+  uint8_t *scratch = nullptr;
+  size_t scratchSize = 0;
+  char path[MAX_PATH_LENGTH] = {};
+  bool stopped = false;
+};
+
+atari_status searchFile(Search &s, const uint8_t *slot) {
+  const atari_disk &d = *s.disk;
+  // A damaged entry can claim more than the volume holds.
+  size_t size = std::min<size_t>(readLE32(slot + 28),
+                                 size_t(d.geo.clusterCount) *
+                                     d.geo.clusterBytes());
+  if (size < s.length)
+    return ATARI_OK;
+  const uint8_t *bytes = contiguousFile(d, slot);
+  if (!bytes) {
+    if (s.scratchSize < size) {
+      release(d.allocator, s.scratch, s.scratchSize);
+      s.scratchSize = 0;
+      s.scratch = static_cast<uint8_t *>(allocate(d.allocator, size));
+      if (!s.scratch)
+        return ATARI_E_NO_MEMORY;
+      s.scratchSize = size;
+    }
+    size = readChain(d, slot, 0, s.scratch, size);
+    if (size < s.length)
+      return ATARI_OK;
+    bytes = s.scratch;
+  }
+
+  // memchr finds candidates for the first byte; memcmp confirms them.
+  const uint8_t *end = bytes + size - s.length + 1;
+  for (const uint8_t *at = bytes; at < end; ++at) {
+    at = static_cast<const uint8_t *>(
+        std::memchr(at, s.pattern[0], static_cast<size_t>(end - at)));
+    if (!at)
+      break;
+    if (std::memcmp(at, s.pattern, s.length) == 0 &&
+        s.callback(s.path, static_cast<uint32_t>(at - bytes), s.user)) {
+      s.stopped = true;
+      break;
+    }
+  }
+  return ATARI_OK;
+}
+
+atari_status searchDir(Search &s, uint16_t cluster, size_t pathLength,
+                       int depth) {
+  atari_dir dir;
+  startDir(dir, s.disk, cluster);
+  atari_entry e;
+  while (const uint8_t *slot = nextSlot(dir)) {
+    fillEntry(slot, e);
+    const int n = std::snprintf(s.path + pathLength,
+                                MAX_PATH_LENGTH - pathLength, "%s%s",
+                                pathLength ? "/" : "", e.name);
+    if (n < 0 || pathLength + static_cast<size_t>(n) >= MAX_PATH_LENGTH)
+      continue;
+    const size_t length = pathLength + static_cast<size_t>(n);
+
+    atari_status status = ATARI_OK;
+    if (!(e.attributes & ATTR_DIRECTORY))
+      status = searchFile(s, slot);
+    else if (isDataCluster(*s.disk, e.start_cluster) && depth < MAX_DEPTH)
+      status = searchDir(s, e.start_cluster, length, depth + 1);
+    if (status != ATARI_OK || s.stopped)
+      return status;
+  }
+  return ATARI_OK;
+}
+
+void countTree(atari_disk *disk, uint16_t cluster, int depth,
+               atari_stats &stats) {
+  atari_dir dir;
+  startDir(dir, disk, cluster);
+  atari_entry e;
+  while (const uint8_t *slot = nextSlot(dir)) {
+    fillEntry(slot, e);
+    if (!(e.attributes & ATTR_DIRECTORY)) {
+      ++stats.file_count;
+      continue;
+    }
+    ++stats.dir_count;
+    if (isDataCluster(*disk, e.start_cluster) && depth < MAX_DEPTH)
+      countTree(disk, e.start_cluster, depth + 1, stats);
+  }
+}
+
+} // namespace
+
+} // namespace Atari
+
+// =============================================================================
+//  Handles
+// =============================================================================
+
+extern "C" {
+
+int atari_api_version(void) { return ATARI_API_VERSION; }
+
+const char *atari_status_string(atari_status status) {
+  switch (status) {
+  case ATARI_OK:
+    return "ok";
+  case ATARI_E_ARGUMENT:
+    return "invalid argument";
+  case ATARI_E_IO:
+    return "cannot read file";
+  case ATARI_E_FORMAT:
+    return "not a FAT12 image";
+  case ATARI_E_NOT_FOUND:
+    return "not found";
+  case ATARI_E_NO_MEMORY:
+    return "out of memory";
+  case ATARI_E_NOT_DIR:
+    return "not a directory";
+  case ATARI_E_IS_DIR:
+    return "is a directory";
+  }
+  return "unknown error";
+}
+
+atari_status atari_open_buffer(const void *data, size_t size, unsigned flags,
+                               const atari_allocator *allocator,
+                               atari_disk **disk) {
+  if (!data || !disk)
+    return ATARI_E_ARGUMENT;
+  *disk = nullptr;
+  const atari_allocator a = allocator ? *allocator
+                                      : atari_allocator{Atari::mallocAlloc,
+                                                        Atari::mallocFree,
+                                                        nullptr};
+  if (!a.alloc || !a.free)
+    return ATARI_E_ARGUMENT;
+
+  Atari::FatGeometry geo;
+  if (!Atari::readFatGeometry(static_cast<const uint8_t *>(data), size, geo))
+    return ATARI_E_FORMAT;
+
+  void *memory = Atari::allocate(a, sizeof(atari_disk));
+  if (!memory)
+    return ATARI_E_NO_MEMORY;
+  atari_disk *d = new (memory) atari_disk{a, nullptr, size, false, geo};
+
+  if (flags & ATARI_OPEN_BORROW) {
+    d->image = static_cast<const uint8_t *>(data);
+  } else {
+    auto *copy = static_cast<uint8_t *>(Atari::allocate(a, size));
+    if (!copy) {
+      Atari::release(a, d, sizeof(atari_disk));
+      return ATARI_E_NO_MEMORY;
+    }
+    std::memcpy(copy, data, size);
+    d->image = copy;
+    d->owned = true;
+  }
+  *disk = d;
+  return ATARI_OK;
+}
+
+atari_status atari_open_path(const char *path,
+                             const atari_allocator *allocator,
+                             atari_disk **disk) {
+  if (!path || !disk)
+    return ATARI_E_ARGUMENT;
+  *disk = nullptr;
+  const atari_allocator a = allocator ? *allocator
+                                      : atari_allocator{Atari::mallocAlloc,
+                                                        Atari::mallocFree,
+                                                        nullptr};
+  if (!a.alloc || !a.free)
+    return ATARI_E_ARGUMENT;
+
+  std::FILE *file = std::fopen(path, "rb");
+  if (!file)
+    return ATARI_E_IO;
+  long size = -1;
+  if (std::fseek(file, 0, SEEK_END) == 0)
+    size = std::ftell(file);
+  if (size <= 0 || std::fseek(file, 0, SEEK_SET) != 0) {
+    std::fclose(file);
+    return size == 0 ? ATARI_E_FORMAT : ATARI_E_IO;
+  }
+
+  auto *data =
+      static_cast<uint8_t *>(Atari::allocate(a, static_cast<size_t>(size)));
+  if (!data) {
+    std::fclose(file);
+    return ATARI_E_NO_MEMORY;
+  }
+  const bool ok = std::fread(data, 1, static_cast<size_t>(size), file) ==
+                  static_cast<size_t>(size);
+  std::fclose(file);
+  atari_status status = ok ? atari_open_buffer(data, static_cast<size_t>(size),
+                                               ATARI_OPEN_BORROW, &a, disk)
+                           : ATARI_E_IO;
+  if (status != ATARI_OK) {
+    Atari::release(a, data, static_cast<size_t>(size));
+    return status;
+  }
+  (*disk)->owned = true; // Hand the buffer to the handle
+  return ATARI_OK;
+}
+
+void atari_close(atari_disk *disk) {
+  if (!disk)
+    return;
+  const atari_allocator a = disk->allocator;
+  if (disk->owned)
+    Atari::release(a, const_cast<uint8_t *>(disk->image), disk->size);
+  disk->~atari_disk();
+  Atari::release(a, disk, sizeof(atari_disk));
+}
+
+// =============================================================================
+//  Queries
+// =============================================================================
+
+atari_status atari_get_stats(atari_disk *disk, atari_stats *stats) {
+  if (!disk || !stats)
+    return ATARI_E_ARGUMENT;
+  atari_stats s{};
+  s.cluster_bytes = disk->geo.clusterBytes();
+  s.total_clusters = disk->geo.clusterCount;
+  for (uint16_t c = 2; c < disk->geo.clusterCount + 2; ++c) {
+    const uint16_t v = Atari::nextCluster(*disk, c);
+    s.free_clusters += v == 0;
+    s.bad_clusters += v == 0xFF7;
+  }
+  s.total_bytes = uint64_t(s.total_clusters) * s.cluster_bytes;
+  s.free_bytes = uint64_t(s.free_clusters) * s.cluster_bytes;
+  Atari::countTree(disk, 0, 0, s);
+  *stats = s;
+  return ATARI_OK;
+}
+
+atari_status atari_stat(atari_disk *disk, const char *path,
+                        atari_entry *entry) {
+  if (!disk || !path || !entry)
+    return ATARI_E_ARGUMENT;
+  const uint8_t *slot;
+  const atari_status status = Atari::resolve(disk, path, slot);
+  if (status != ATARI_OK)
+    return status;
+  if (slot) {
+    Atari::fillEntry(slot, *entry);
+  } else {
+    *entry = atari_entry{};
+    entry->attributes = Atari::ATTR_DIRECTORY;
+  }
+  return ATARI_OK;
+}
+
+atari_status atari_opendir(atari_disk *disk, const char *path,
+                           atari_dir **dir) {
+  if (!disk || !path || !dir)
+    return ATARI_E_ARGUMENT;
+  *dir = nullptr;
+  const uint8_t *slot;
+  atari_status status = Atari::resolve(disk, path, slot);
+  if (status != ATARI_OK)
+    return status;
+  if (slot && !(slot[11] & Atari::ATTR_DIRECTORY))
+    return ATARI_E_NOT_DIR;
+
+  void *memory = Atari::allocate(disk->allocator, sizeof(atari_dir));
+  if (!memory)
+    return ATARI_E_NO_MEMORY;
+  atari_dir *d = new (memory) atari_dir;
+  Atari::startDir(*d, disk, slot ? Atari::readLE16(slot + 26) : 0);
+  *dir = d;
+  return ATARI_OK;
+}
+
+int atari_readdir(atari_dir *dir, atari_entry *entry) {
+  if (!dir || !entry)
+    return 0;
+  const uint8_t *slot = Atari::nextSlot(*dir);
+  if (!slot)
+    return 0;
+  Atari::fillEntry(slot, *entry);
+  return 1;
+}
+
+void atari_closedir(atari_dir *dir) {
+  if (!dir)
+    return;
+  const atari_allocator a = dir->disk->allocator;
+  dir->~atari_dir();
+  Atari::release(a, dir, sizeof(atari_dir));
+}
+
+atari_status atari_read(atari_disk *disk, const char *path, uint32_t offset,
+                        void *buf, size_t capacity, size_t *read) {
+  if (read)
+    *read = 0;
+  if (!disk || !path || (!buf && capacity > 0))
+    return ATARI_E_ARGUMENT;
+  const uint8_t *slot;
+  const atari_status status = Atari::resolve(disk, path, slot);
+  if (status != ATARI_OK)
+    return status;
+  if (!slot || (slot[11] & Atari::ATTR_DIRECTORY))
+    return ATARI_E_IS_DIR;
+
+  const size_t n =
+      Atari::readChain(*disk, slot, offset, static_cast<uint8_t *>(buf),
+                       capacity);
+  if (read)
+    *read = n;
+  return ATARI_OK;
+}
+
+atari_status atari_search(atari_disk *disk, const void *pattern,
+                          size_t length, atari_search_fn callback,
+                          void *user) {
+  if (!disk || !pattern || length == 0 || !callback)
+    return ATARI_E_ARGUMENT;
+  Atari::Search s{disk, static_cast<const uint8_t *>(pattern), length, callback,
+           user};
+  s.path[0] = '\0';
+  const atari_status status = Atari::searchDir(s, 0, 0, 0);
+  Atari::release(disk->allocator, s.scratch, s.scratchSize);
+  return status;
+}
+
+} // extern "C"
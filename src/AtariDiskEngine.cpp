@@ -7,6 +7,8 @@
 // =============================================================================
 
 #include "../include/AtariDiskEngine.h"
+#include "../include/BootSectorAnalyzer.h"
+#include "../include/ZipArchive.h"
 #include <QByteArray>
 #include <QDebug>
 #include <QFile>
@@ -88,11 +90,7 @@ AtariDiskEngine::validateBootChecksum(const uint8_t *sector512) noexcept {
    * The Atari TOS boot sector is considered "executable" if the sum of all
    * 16-bit big-endian words in the sector is 0x1234.
    */
-  uint16_t sum = 0;
-  for (int i = 0; i < 512; i += 2) {
-    sum += (static_cast<uint16_t>(sector512[i]) << 8) | sector512[i + 1];
-  }
-  return sum == BOOT_CHECKSUM_TARGET;
+  return bootWordSum(sector512) == BOOT_CHECKSUM_TARGET;
 }
 
 bool AtariDiskEngine::validateBootChecksum() const noexcept {
@@ -149,13 +147,9 @@ Atari::AtariDiskEngine::clusterOffset(uint16_t cluster) const noexcept {
 // =============================================================================
 
 /**
- * @brief Reads the root directory from the disk image.
+ * @brief Finds the root directory and settles the geometry mode.
  **/
-std::vector<Atari::DirEntry> Atari::AtariDiskEngine::readRootDirectory() const {
-  std::vector<DirEntry> entries;
-  if (!isLoaded())
-    return entries;
-
+uint32_t Atari::AtariDiskEngine::rootDirectoryOffset() const {
   auto *self = const_cast<AtariDiskEngine *>(this);
   const uint8_t *d = m_image.data() + m_internalOffset;
 
@@ -217,6 +211,19 @@ std::vector<Atari::DirEntry> Atari::AtariDiskEngine::readRootDirectory() const {
     foundOffset = 11 * SECTOR_SIZE;
     self->m_geoMode = GeometryMode::BPB;
   }
+  return foundOffset;
+}
+
+/**
+ * @brief Reads the root directory from the disk image.
+ **/
+std::vector<Atari::DirEntry> Atari::AtariDiskEngine::readRootDirectory() const {
+  std::vector<DirEntry> entries;
+  if (!isLoaded())
+    return entries;
+
+  const uint8_t *d = m_image.data() + m_internalOffset;
+  const uint32_t foundOffset = rootDirectoryOffset();
 
   // 3. Extraction of entries
   const uint8_t *dirPtr = d + foundOffset;
@@ -355,55 +362,72 @@ Atari::AtariDiskEngine::readSubDirectory(uint16_t startCluster) const {
   return entries;
 }
 
+/**
+ * @brief Lists the sectors the two directory readers above look at.
+ **/
+std::vector<uint32_t>
+Atari::AtariDiskEngine::directorySectors(uint16_t startCluster) const {
+  std::vector<uint32_t> sectors;
+  if (!isLoaded())
+    return sectors;
+
+  // Root: up to 112 entries; subdirectories: the first 32 of their cluster.
+  const uint32_t begin = startCluster == 0
+                             ? m_internalOffset + rootDirectoryOffset()
+                             : clusterOffset(startCluster);
+  const uint32_t end = static_cast<uint32_t>(std::min<std::size_t>(
+      begin + (startCluster == 0 ? 112 : 32) * DIRENT_SIZE, m_image.size()));
+  for (uint32_t s = begin / SECTOR_SIZE; s * SECTOR_SIZE < end; ++s)
+    sectors.push_back(s);
+  return sectors;
+}
+
 /**
  * @brief Reads a file from the disk image.
  **/
 std::vector<uint8_t>
 Atari::AtariDiskEngine::readFile(const DirEntry &entry) const {
+  return fileView(entry).toVector();
+}
+
+/**
+ * @brief Maps a file onto image extents.
+ **/
+Atari::FileView
+Atari::AtariDiskEngine::fileView(const DirEntry &entry) const {
   uint32_t fileSize = entry.getFileSize();
   uint16_t startCluster = entry.getStartCluster();
 
   if (fileSize == 0 || m_image.empty())
     return {};
 
-  // Safety cap to avoid memory exhaustion on malformed images.
+  // Safety cap to avoid runaway chains on malformed images.
   if (fileSize > 4 * 1024 * 1024) {
     return {};
   }
 
-  std::vector<uint8_t> data;
-  data.reserve(fileSize);
+  std::vector<FileExtent> extents;
+  uint32_t mapped = 0;
 
   auto chain = getClusterChain(startCluster);
   uint32_t spc = (m_geoMode == GeometryMode::HatariGuess) ? 1 : 2;
 
-  for (size_t cIdx = 0; cIdx < chain.size(); ++cIdx) {
-    uint16_t cluster = chain[cIdx];
-    uint32_t clusterBase = clusterOffset(cluster);
+  for (size_t cIdx = 0; cIdx < chain.size() && mapped < fileSize; ++cIdx) {
+    uint32_t clusterBase = clusterOffset(chain[cIdx]);
 
-    for (uint32_t s = 0; s < spc; ++s) {
+    for (uint32_t s = 0; s < spc && mapped < fileSize; ++s) {
       uint32_t sectorOffset = clusterBase + (s * SECTOR_SIZE);
-      uint32_t currentRead = data.size();
-      uint32_t remaining = fileSize - currentRead;
-      uint32_t toRead = std::min((uint32_t)SECTOR_SIZE, remaining);
-
-      if (toRead > 0) {
-        if (sectorOffset + toRead <= m_image.size()) {
-          const uint8_t *ptr = m_image.data() + sectorOffset;
-          data.insert(data.end(), ptr, ptr + toRead);
-        } else {
-          break; // OOB
-        }
-      }
+      uint32_t toRead = std::min((uint32_t)SECTOR_SIZE, fileSize - mapped);
 
-      if (data.size() >= fileSize)
-        break;
+      if (sectorOffset + toRead > m_image.size())
+        return FileView(m_image.data(), extents); // OOB: keep what we have
+
+      extents.push_back({sectorOffset, toRead});
+      mapped += toRead;
     }
-    if (data.size() >= fileSize)
-      break;
   }
 
-  return data;
+  return FileView(m_image.data(), extents);
 }
 
 /**
@@ -430,6 +454,18 @@ QString AtariDiskEngine::getFormatInfoString() const {
  * @brief Loads an image from a file path.
  **/
 bool Atari::AtariDiskEngine::loadImage(const QString &path) {
+  QString archivePath, memberPath;
+  if (ZipArchive::splitArchivePath(path, archivePath, memberPath)) {
+    ZipArchive zip(archivePath);
+    const ZipMember *member =
+        zip.isOpen() ? zip.findMember(memberPath) : nullptr;
+    std::vector<uint8_t> data;
+    if (!member || !zip.readMember(*member, data) || data.size() < SECTOR_SIZE)
+      return false;
+    load(std::move(data));
+    return true;
+  }
+
   QFile file(path);
   if (!file.open(QIODevice::ReadOnly))
     return false;
@@ -438,6 +474,85 @@ bool Atari::AtariDiskEngine::loadImage(const QString &path) {
   return true;
 }
 
+/**
+ * @brief Writes back runs of dirty sectors in place.
+ **/
+bool Atari::AtariDiskEngine::saveChanges(const QString &path,
+                                         uint32_t sinceCounter) const {
+  QString archivePath, memberPath;
+  if (ZipArchive::splitArchivePath(path, archivePath, memberPath))
+    return false;
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadWrite) ||
+      file.size() != static_cast<qint64>(m_image.size()))
+    return false;
+
+  const std::vector<uint32_t> dirty = dirtySectorsSince(sinceCounter);
+  for (std::size_t i = 0; i < dirty.size();) {
+    std::size_t j = i + 1;
+    while (j < dirty.size() && dirty[j] == dirty[j - 1] + 1)
+      ++j;
+    const qint64 offset = static_cast<qint64>(dirty[i]) * SECTOR_SIZE;
+    const qint64 length =
+        std::min<qint64>(static_cast<qint64>(dirty[j - 1] + 1) * SECTOR_SIZE,
+                         static_cast<qint64>(m_image.size())) -
+        offset;
+    if (!file.seek(offset) ||
+        file.write(reinterpret_cast<const char *>(m_image.data() + offset),
+                   length) != length)
+      return false;
+    i = j;
+  }
+  return file.flush();
+}
+
+/**
+ * @brief Re-reads an image file, copying in only the sectors that differ.
+ **/
+bool Atari::AtariDiskEngine::reloadImage(const QString &path) {
+  QString archivePath, memberPath;
+  if (ZipArchive::splitArchivePath(path, archivePath, memberPath))
+    return loadImage(path);
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  const QByteArray data = file.readAll();
+  if (data.size() < static_cast<int>(SECTOR_SIZE))
+    return false; // Caught mid-write; keep what we have
+
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+  mergeImage(std::vector<uint8_t>(bytes, bytes + data.size()));
+  return true;
+}
+
+/**
+ * @brief Copies in the sectors of a new image that differ from ours.
+ **/
+void Atari::AtariDiskEngine::mergeImage(std::vector<uint8_t> &&fresh) {
+  if (fresh.size() != m_image.size()) {
+    load(std::move(fresh));
+    return;
+  }
+
+  // Plain memcmp per sector: the C library already compares 512 bytes
+  // with vector loads, and the loop stops at the first differing byte.
+  // A hand-written kernel pays off where the work is arithmetic, as in
+  // bootWordSum(), not here, where the file read dominates.
+  const std::size_t size = fresh.size();
+  for (std::size_t pos = 0; pos < size; pos += SECTOR_SIZE) {
+    const std::size_t length = std::min<std::size_t>(SECTOR_SIZE, size - pos);
+    if (std::memcmp(&fresh[pos], &m_image[pos], length) != 0) {
+      std::memcpy(&m_image[pos], &fresh[pos], length);
+      markDirty(static_cast<uint32_t>(pos), static_cast<uint32_t>(length));
+      // A new boot sector may mean a new layout: probe it again.
+      if (pos == 0)
+        m_geoMode = GeometryMode::Unknown;
+    }
+  }
+}
+
 /**
  * @brief Gets a specific sector from the disk image.
  **/
@@ -485,6 +600,24 @@ void Atari::AtariDiskEngine::load(const std::vector<uint8_t> &data) {
   m_internalOffset = 0;
   m_useManualOverride = false;
   m_geoMode = GeometryMode::Unknown;
+  m_journal.clear();
+  markDirty(0, static_cast<uint32_t>(m_image.size()));
+
+  if (m_image.empty())
+    return;
+  init();
+}
+
+/**
+ * @brief Loads disk image data into the engine, taking ownership.
+ **/
+void Atari::AtariDiskEngine::load(std::vector<uint8_t> &&data) {
+  m_image = std::move(data);
+  m_internalOffset = 0;
+  m_useManualOverride = false;
+  m_geoMode = GeometryMode::Unknown;
+  m_journal.clear();
+  markDirty(0, static_cast<uint32_t>(m_image.size()));
 
   if (m_image.empty())
     return;
@@ -547,6 +680,8 @@ void Atari::AtariDiskEngine::createNew720KImage() {
 
   m_geoMode = GeometryMode::BPB;
   m_internalOffset = 0;
+  m_journal.clear();
+  markDirty(0, DISK_720K_SIZE);
   qDebug() << "[ENGINE] New 720KB Disk Template Created.";
 }
 
@@ -633,7 +768,10 @@ bool Atari::AtariDiskEngine::injectFile(const QString &localPath) {
   uint32_t physOffset = (18 * SECTOR_SIZE);
   if (physOffset + fileData.size() <= m_image.size()) {
     std::memcpy(&m_image[physOffset], fileData.data(), fileData.size());
+    markDirty(physOffset, fileData.size());
   }
+  markDirty(1 * SECTOR_SIZE, 10 * SECTOR_SIZE);
+  markDirty(rootOffset + entryIndex * 32, 32);
 
   return true;
 }
@@ -662,6 +800,7 @@ bool Atari::AtariDiskEngine::deleteFile(const DirEntry &entry) {
     if (std::memcmp(&m_image[offset], entry.name, 8) == 0 &&
         std::memcmp(&m_image[offset + 8], entry.ext, 3) == 0) {
       m_image[offset] = 0xE5; // Standard FAT "Deleted" marker
+      markDirty(offset, 1);
       entryFound = true;
       break;
     }
@@ -703,6 +842,7 @@ bool Atari::AtariDiskEngine::deleteFile(const DirEntry &entry) {
   // 3. Sync FAT2
   std::memcpy(&m_image[6 * SECTOR_SIZE], &m_image[1 * SECTOR_SIZE],
               5 * SECTOR_SIZE);
+  markDirty(1 * SECTOR_SIZE, 10 * SECTOR_SIZE);
 
   qDebug() << "[ENGINE] Deleted file starting at cluster" << startCluster;
   return true;
@@ -782,13 +922,8 @@ Atari::BootSectorInfo Atari::AtariDiskEngine::checkBootSector() const {
   if (reserved > 0 && reserved < 10)
     info.hasValidBpb = true;
 
-  // 3. Calculate Atari 16-bit Checksum (Word-wise)
-  uint16_t sum = 0;
-  for (int i = 0; i < 256; ++i) {
-    // Atari ST is Big-Endian for code/checksums
-    uint16_t word = (boot[i * 2] << 8) | boot[i * 2 + 1];
-    sum += word;
-  }
+  // 3. Calculate Atari 16-bit Checksum (Word-wise, Big-Endian)
+  uint16_t sum = bootWordSum(boot);
 
   info.currentChecksum = sum;
   info.isExecutable = (sum == 0x1234);
@@ -803,7 +938,18 @@ bool Atari::AtariDiskEngine::fixBootChecksum() {
   if (m_image.size() < 512)
     return false;
 
-  uint8_t *boot = m_image.data();
+  fixBootChecksum(m_image.data());
+  markDirty(0, SECTOR_SIZE);
+  qDebug() << "[ENGINE] Boot Checksum Fixed. Final Word set to:" << hex
+           << readBE16(m_image.data() + 510);
+  return true;
+}
+
+/**
+ * @brief Fixes the boot checksum of a standalone boot sector buffer.
+ **/
+/*static*/ void
+Atari::AtariDiskEngine::fixBootChecksum(uint8_t *boot) noexcept {
   uint16_t runningSum = 0;
 
   // 1. Calculate sum of the first 255 words (0 to 509 bytes)
@@ -820,10 +966,6 @@ bool Atari::AtariDiskEngine::fixBootChecksum() {
   // 3. Write the adjustment word to the last two bytes (Big Endian)
   boot[510] = (finalWord >> 8) & 0xFF;
   boot[511] = finalWord & 0xFF;
-
-  qDebug() << "[ENGINE] Boot Checksum Fixed. Final Word set to:" << hex
-           << finalWord;
-  return true;
 }
 
 /**
@@ -853,6 +995,7 @@ bool Atari::AtariDiskEngine::renameFile(const DirEntry &entry,
     if (std::memcmp(&m_image[offset], entry.name, 8) == 0 &&
         std::memcmp(&m_image[offset + 8], entry.ext, 3) == 0) {
       std::memcpy(&m_image[offset], formattedName, 11);
+      markDirty(offset, 11);
       found = true;
       break;
     }
@@ -930,6 +1073,7 @@ bool Atari::AtariDiskEngine::formatDisk() {
 
   // 2. Wipe Root Directory (Sectors 11-17)
   std::memset(&m_image[11 * SECTOR_SIZE], 0, 7 * SECTOR_SIZE);
+  markDirty(1 * SECTOR_SIZE, 17 * SECTOR_SIZE);
 
   // 3. Optional: Wipe Data Area (Sector 18 onwards)
   // We'll skip this for "Quick Format" speed, but we could zero it if desired.
@@ -945,6 +1089,19 @@ bool Atari::AtariDiskEngine::setOemLabel(const QString &newLabel) {
   if (!isLoaded())
     return false;
 
+  setOemLabel(m_image.data(), newLabel);
+  markDirty(0, SECTOR_SIZE);
+  qDebug() << "[ENGINE] OEM Label updated to:"
+           << QString::fromLatin1(
+                  reinterpret_cast<const char *>(m_image.data() + 2), 6);
+  return true;
+}
+
+/**
+ * @brief Sets the OEM label of a standalone boot sector buffer.
+ **/
+/*static*/ void Atari::AtariDiskEngine::setOemLabel(uint8_t *boot,
+                                                    const QString &newLabel) {
   // 1. Prepare 6-byte buffer (Atari standard is often 6 bytes for OEM)
   char labelBuffer[7];
   std::memset(labelBuffer, ' ', 6);
@@ -955,15 +1112,11 @@ bool Atari::AtariDiskEngine::setOemLabel(const QString &newLabel) {
   std::memcpy(labelBuffer, stdLabel.c_str(), len);
 
   // 2. Write to Boot Sector at offset 0x02
-  std::memcpy(&m_image[2], labelBuffer, 6);
-
-  qDebug() << "[ENGINE] OEM Label updated to:" << labelBuffer;
+  std::memcpy(boot + 2, labelBuffer, 6);
 
   // 3. IMPORTANT: Changing the label changes the Boot Checksum!
   // We should re-fix it so the disk remains bootable.
-  fixBootChecksum();
-
-  return true;
+  fixBootChecksum(boot);
 }
 
 /**
@@ -1046,4 +1199,90 @@ Atari::AtariDiskEngine::searchPattern(const QByteArray &pattern) const {
   return results;
 }
 
+// =============================================================================
+//  Write Access & Change Tracking
+// =============================================================================
+
+Atari::FatVolume Atari::AtariDiskEngine::volume() {
+  return FatVolume(m_image, m_internalOffset,
+                   [this](uint32_t offset, uint32_t length) {
+                     markDirty(offset, length);
+                   });
+}
+
+void Atari::AtariDiskEngine::markDirty(uint32_t offset, uint32_t length) {
+  const std::size_t sectors = (m_image.size() + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  m_sectorStamps.resize(sectors, 0);
+  ++m_changeCounter;
+  if (length == 0 || sectors == 0)
+    return;
+  const std::size_t last =
+      std::min<std::size_t>((offset + length - 1) / SECTOR_SIZE, sectors - 1);
+  for (std::size_t s = offset / SECTOR_SIZE; s <= last; ++s)
+    m_sectorStamps[s] = m_changeCounter;
+}
+
+namespace {
+
+/** Edits older than this many fall off the undo journal. */
+constexpr std::size_t kMaxJournal = 4096;
+
+bool overlapsBootSector(uint32_t boot, uint32_t offset, uint32_t length) {
+  return offset < boot + SECTOR_SIZE && offset + length > boot;
+}
+
+} // namespace
+
+bool Atari::AtariDiskEngine::patchBytes(uint32_t offset,
+                                        const QByteArray &bytes) {
+  const auto length = static_cast<uint32_t>(bytes.size());
+  if (offset > m_image.size() || length > m_image.size() - offset)
+    return false;
+  uint8_t *at = m_image.data() + offset;
+  if (length == 0 || std::memcmp(at, bytes.constData(), length) == 0)
+    return true;
+
+  m_journal.push_back(
+      {offset, QByteArray(reinterpret_cast<const char *>(at), length), bytes});
+  if (m_journal.size() > kMaxJournal)
+    m_journal.erase(m_journal.begin());
+  std::memcpy(at, bytes.constData(), length);
+  markDirty(offset, length);
+  if (overlapsBootSector(m_internalOffset, offset, length))
+    m_geoMode = GeometryMode::Unknown;
+  return true;
+}
+
+bool Atari::AtariDiskEngine::undoPatch(uint32_t &offset, uint32_t &length) {
+  if (m_journal.empty())
+    return false;
+  const Patch patch = std::move(m_journal.back());
+  m_journal.pop_back();
+
+  const auto size = static_cast<uint32_t>(patch.after.size());
+  if (patch.offset + size > m_image.size() ||
+      std::memcmp(m_image.data() + patch.offset, patch.after.constData(),
+                  size) != 0) {
+    m_journal.clear();
+    return false;
+  }
+  std::memcpy(m_image.data() + patch.offset, patch.before.constData(), size);
+  markDirty(patch.offset, size);
+  if (overlapsBootSector(m_internalOffset, patch.offset, size))
+    m_geoMode = GeometryMode::Unknown;
+  offset = patch.offset;
+  length = size;
+  return true;
+}
+
+std::vector<uint32_t>
+Atari::AtariDiskEngine::dirtySectorsSince(uint32_t counter) const {
+  std::vector<uint32_t> sectors;
+  for (std::size_t s = 0; s < m_sectorStamps.size(); ++s) {
+    if (m_sectorStamps[s] > counter)
+      sectors.push_back(static_cast<uint32_t>(s));
+  }
+  return sectors;
+}
+
 } // namespace Atari
@@ -1,9 +1,48 @@
 #include "AtariFileSystemModel.h"
+#include <QDataStream>
 #include <QDebug>
+#include <QMimeData>
 #include <QRegExp>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+/** Bytes of decoded archive members kept for re-selection and extraction. */
+constexpr int kMemberCacheBytes = 8 * 1024 * 1024;
+
+/** Source model identity followed by raw 32-byte directory entries. */
+const char kEntriesMimeType[] = "application/x-atari-dir-entries";
+
+/** @return Image sectors covered by a file's extents, ascending. */
+std::vector<uint32_t> extentSectors(const Atari::FileView &view) {
+  std::vector<uint32_t> sectors;
+  for (const Atari::FileExtent &e : view.extents()) {
+    for (uint32_t s = e.offset / Atari::SECTOR_SIZE;
+         s * Atari::SECTOR_SIZE < e.offset + e.length; ++s)
+      sectors.push_back(s);
+  }
+  std::sort(sectors.begin(), sectors.end());
+  sectors.erase(std::unique(sectors.begin(), sectors.end()), sectors.end());
+  return sectors;
+}
+
+/** @return True if two ascending sector lists share a sector. */
+bool intersects(const std::vector<uint32_t> &a,
+                const std::vector<uint32_t> &b) {
+  auto i = a.begin();
+  auto j = b.begin();
+  while (i != a.end() && j != b.end()) {
+    if (*i == *j)
+      return true;
+    *i < *j ? ++i : ++j;
+  }
+  return false;
+}
+} // namespace
 
 AtariFileSystemModel::AtariFileSystemModel(QObject *parent)
-    : QAbstractItemModel(parent), m_engine(nullptr) {
+    : QAbstractItemModel(parent), m_engine(nullptr),
+      m_memberCache(kMemberCacheBytes) {
   // Initialize with an empty root node
   m_root = std::make_unique<Node>();
 }
@@ -15,38 +54,44 @@ void AtariFileSystemModel::setEngine(Atari::AtariDiskEngine *engine) {
 
 void AtariFileSystemModel::buildTree() {
   beginResetModel();
+  m_memberCache.clear(); // Keys point into the old tree
   m_root = std::make_unique<Node>(); // Clear old data
 
-  if (m_engine && m_engine->isLoaded()) {
-    // Retrieve entries using the Hatari-style probing logic
-    std::vector<Atari::DirEntry> rootEntries = m_engine->readRootDirectory();
-
-    for (const auto &entry : rootEntries) {
-      auto child = std::make_unique<Node>(entry, m_root.get());
-      if (entry.isDirectory()) {
-        buildChildren(child.get());
-      }
-      m_root->children.push_back(std::move(child));
-    }
-  }
+  if (m_engine && m_engine->isLoaded())
+    buildChildren(m_root.get());
   endResetModel();
 }
 
 void AtariFileSystemModel::buildChildren(Node *parentNode) {
+  for (const auto &entry : listDirectory(parentNode))
+    parentNode->children.push_back(makeNode(entry, parentNode));
+}
+
+std::vector<Atari::DirEntry>
+AtariFileSystemModel::listDirectory(Node *dirNode) {
   if (!m_engine)
-    return;
+    return {};
+
+  // Retrieve entries using the Hatari-style probing logic
+  if (dirNode == m_root.get()) {
+    dirNode->sectors = m_engine->directorySectors(0);
+    return m_engine->readRootDirectory();
+  }
 
   // Safety: If the start cluster is 0 or 1, and it's not the root,
   // it's likely a fake directory entry.
-  if (parentNode->entry.getStartCluster() < 2) {
+  if (dirNode->entry.getStartCluster() < 2) {
     qDebug() << "[MODEL] Skipping sub-directory scan for suspicious cluster:"
-             << parentNode->entry.getStartCluster();
-    return;
+             << dirNode->entry.getStartCluster();
+    return {};
   }
 
+  dirNode->sectors =
+      m_engine->directorySectors(dirNode->entry.getStartCluster());
   std::vector<Atari::DirEntry> subEntries =
-      m_engine->readSubDirectory(parentNode->entry.getStartCluster());
+      m_engine->readSubDirectory(dirNode->entry.getStartCluster());
 
+  std::vector<Atari::DirEntry> entries;
   for (const auto &entry : subEntries) {
     // Only add if the name actually looks printable
     QString name = Atari::AtariDiskEngine::toQString(entry.getFilename());
@@ -54,13 +99,162 @@ void AtariFileSystemModel::buildChildren(Node *parentNode) {
       qDebug() << "[MODEL] Blocking scrambled child entry:" << name;
       continue;
     }
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+std::unique_ptr<AtariFileSystemModel::Node>
+AtariFileSystemModel::makeNode(const Atari::DirEntry &entry, Node *parent) {
+  auto node = std::make_unique<Node>(entry, parent);
+  if (isParsedDirectory(node.get())) {
+    buildChildren(node.get());
+  } else if (!entry.isDirectory()) {
+    addArchiveMembers(node.get());
+  }
+  return node;
+}
+
+bool AtariFileSystemModel::isParsedDirectory(const Node *node) const {
+  return node == m_root.get() ||
+         (node->memberIndex < 0 && node->entry.isDirectory() &&
+          node->entry.name[0] != '.');
+}
+
+// =============================================================================
+//  Incremental Refresh
+// =============================================================================
+
+void AtariFileSystemModel::refreshSectors(
+    const std::vector<uint32_t> &changed) {
+  if (changed.empty())
+    return;
+  // The boot sector decides the geometry; anything there means start over.
+  if (!m_engine || !m_engine->isLoaded() || changed.front() == 0) {
+    buildTree();
+    return;
+  }
+  m_memberCache.clear();
+  patchNode(m_root.get(), QModelIndex(), changed);
+}
+
+void AtariFileSystemModel::patchNode(Node *node, const QModelIndex &index,
+                                     const std::vector<uint32_t> &changed) {
+  if (isParsedDirectory(node)) {
+    // Unchanged children keep their nodes (and the view's expansion state).
+    const std::vector<uint32_t> sectors =
+        node == m_root.get()
+            ? m_engine->directorySectors(0)
+            : m_engine->directorySectors(node->entry.getStartCluster());
+    std::vector<const Node *> fresh;
+    if (sectors != node->sectors || intersects(sectors, changed))
+      fresh = patchChildren(node, index, listDirectory(node));
+
+    for (int row = 0; row < static_cast<int>(node->children.size()); ++row) {
+      Node *child = node->children[row].get();
+      if (std::find(fresh.begin(), fresh.end(), child) == fresh.end())
+        patchNode(child, this->index(row, 0, index), changed);
+    }
+    return;
+  }
+
+  // Archives: re-list members if the file's sectors moved or changed.
+  if (node->entry.isDirectory() ||
+      !Atari::ArchiveReader::isArchiveName(node->entry.getFilename()))
+    return;
+  const std::vector<uint32_t> sectors =
+      extentSectors(m_engine->fileView(node->entry));
+  if (sectors == node->sectors && !intersects(sectors, changed))
+    return;
+
+  if (!node->children.empty()) {
+    beginRemoveRows(index, 0, static_cast<int>(node->children.size()) - 1);
+    node->children.clear();
+    node->archive.reset();
+    endRemoveRows();
+  }
+  Node scratch(node->entry, node->parent);
+  addArchiveMembers(&scratch);
+  node->sectors = scratch.sectors;
+  if (scratch.children.empty())
+    return;
+  beginInsertRows(index, 0, static_cast<int>(scratch.children.size()) - 1);
+  for (auto &child : scratch.children) {
+    child->parent = node;
+    node->children.push_back(std::move(child));
+  }
+  node->archive = std::move(scratch.archive);
+  endInsertRows();
+}
+
+std::vector<const AtariFileSystemModel::Node *>
+AtariFileSystemModel::patchChildren(
+    Node *node, const QModelIndex &index,
+    const std::vector<Atari::DirEntry> &entries) {
+  auto &children = node->children;
 
-    auto child = std::make_unique<Node>(entry, parentNode);
-    if (entry.isDirectory() && entry.name[0] != '.') {
-      buildChildren(child.get());
+  // Pair each child with an identical new entry, keeping their order.
+  std::vector<bool> used(entries.size(), false);
+  std::vector<bool> keep(children.size(), false);
+  std::size_t last = 0;
+  bool ordered = true;
+  for (std::size_t i = 0; i < children.size() && ordered; ++i) {
+    for (std::size_t j = 0; j < entries.size(); ++j) {
+      if (!used[j] && std::memcmp(&children[i]->entry, &entries[j],
+                                  sizeof(Atari::DirEntry)) == 0) {
+        ordered = j >= last;
+        used[j] = keep[i] = true;
+        last = j;
+        break;
+      }
     }
-    parentNode->children.push_back(std::move(child));
   }
+  if (!ordered) {
+    std::fill(used.begin(), used.end(), false);
+    std::fill(keep.begin(), keep.end(), false);
+  }
+
+  for (int row = static_cast<int>(children.size()) - 1; row >= 0; --row) {
+    if (keep[row])
+      continue;
+    beginRemoveRows(index, row, row);
+    children.erase(children.begin() + row);
+    endRemoveRows();
+  }
+
+  std::vector<const Node *> fresh;
+  int row = 0;
+  for (std::size_t j = 0; j < entries.size(); ++j, ++row) {
+    if (used[j])
+      continue;
+    auto child = makeNode(entries[j], node);
+    fresh.push_back(child.get());
+    beginInsertRows(index, row, row);
+    children.insert(children.begin() + row, std::move(child));
+    endInsertRows();
+  }
+  return fresh;
+}
+
+void AtariFileSystemModel::addArchiveMembers(Node *node) {
+  if (!Atari::ArchiveReader::isArchiveName(node->entry.getFilename()))
+    return;
+
+  const Atari::FileView view = m_engine->fileView(node->entry);
+  node->sectors = extentSectors(view);
+
+  // Only the headers are walked here; members decode when selected.
+  auto archive = std::make_shared<const Atari::ArchiveReader>(view);
+  if (!archive->isOpen())
+    return;
+
+  const auto &members = archive->members();
+  for (int i = 0; i < static_cast<int>(members.size()); ++i) {
+    auto child = std::make_unique<Node>(node->entry, node);
+    child->memberIndex = i;
+    node->children.push_back(std::move(child));
+  }
+  node->archive = std::move(archive);
 }
 
 AtariFileSystemModel::Node *
@@ -90,6 +284,38 @@ Atari::DirEntry AtariFileSystemModel::getEntry(const QModelIndex &index) const {
 
   return node->entry;
 }
+
+bool AtariFileSystemModel::isArchiveMember(const QModelIndex &index) const {
+  return index.isValid() && nodeFromIndex(index)->memberIndex >= 0;
+}
+
+QByteArray AtariFileSystemModel::memberData(const QModelIndex &index,
+                                            QString &error) const {
+  if (!isArchiveMember(index)) {
+    error = "not an archive member";
+    return QByteArray();
+  }
+
+  const Node *node = nodeFromIndex(index);
+  if (const QByteArray *cached = m_memberCache.object(node))
+    return *cached;
+
+  const Atari::ArchiveReader &archive = *node->parent->archive;
+  std::vector<uint8_t> data;
+  std::string why;
+  if (!archive.readMember(archive.members()[node->memberIndex], data, why)) {
+    error = QString::fromStdString(why);
+    return QByteArray();
+  }
+
+  QByteArray bytes(reinterpret_cast<const char *>(data.data()),
+                   static_cast<int>(data.size()));
+  // Members larger than the whole budget are simply not cached.
+  m_memberCache.insert(node, new QByteArray(bytes),
+                       std::max(1, bytes.size()));
+  return bytes;
+}
+
 // =============================================================================
 //  QAbstractItemModel Overrides
 // =============================================================================
@@ -143,13 +369,105 @@ QVariant AtariFileSystemModel::data(const QModelIndex &index, int role) const {
 
   Node *node = static_cast<Node *>(index.internalPointer());
   if (role == Qt::DisplayRole) {
+    if (node->memberIndex >= 0)
+      return QString::fromStdString(
+          node->parent->archive->members()[node->memberIndex].name);
     return Atari::AtariDiskEngine::toQString(node->entry.getFilename());
   }
+  if (role == Qt::ToolTipRole && node->memberIndex >= 0) {
+    const Atari::ArchiveMember &m =
+        node->parent->archive->members()[node->memberIndex];
+    return QString("%1 bytes, %2 packed (%3)")
+        .arg(m.size)
+        .arg(m.compressedSize)
+        .arg(QString::fromStdString(m.method));
+  }
   return QVariant();
 }
 
 Qt::ItemFlags AtariFileSystemModel::flags(const QModelIndex &index) const {
   if (!index.isValid())
-    return Qt::NoItemFlags;
-  return QAbstractItemModel::flags(index);
+    return acceptsDrop(m_root.get()) ? Qt::ItemIsDropEnabled : Qt::NoItemFlags;
+  Qt::ItemFlags f = QAbstractItemModel::flags(index);
+  const Node *node = nodeFromIndex(index);
+  if (node->memberIndex < 0)
+    f |= Qt::ItemIsDragEnabled;
+  if (acceptsDrop(node))
+    f |= Qt::ItemIsDropEnabled;
+  return f;
+}
+
+// =============================================================================
+//  Drag and Drop
+// =============================================================================
+
+bool AtariFileSystemModel::acceptsDrop(const Node *node) const {
+  return m_engine && m_engine->isLoaded() && isParsedDirectory(node);
+}
+
+QStringList AtariFileSystemModel::mimeTypes() const {
+  return {kEntriesMimeType};
+}
+
+Qt::DropActions AtariFileSystemModel::supportedDropActions() const {
+  return Qt::CopyAction | Qt::MoveAction;
+}
+
+QMimeData *
+AtariFileSystemModel::mimeData(const QModelIndexList &indexes) const {
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out << static_cast<quint64>(reinterpret_cast<quintptr>(this));
+  for (const QModelIndex &index : indexes) {
+    const Node *node = nodeFromIndex(index);
+    if (!index.isValid() || node->memberIndex >= 0 ||
+        node->entry.name[0] == '.')
+      continue;
+    out.writeRawData(reinterpret_cast<const char *>(&node->entry),
+                     sizeof(Atari::DirEntry));
+  }
+
+  auto *data = new QMimeData;
+  data->setData(kEntriesMimeType, payload);
+  return data;
+}
+
+bool AtariFileSystemModel::canDropMimeData(const QMimeData *data,
+                                           Qt::DropAction action, int, int,
+                                           const QModelIndex &parent) const {
+  if ((action != Qt::CopyAction && action != Qt::MoveAction) ||
+      !data->hasFormat(kEntriesMimeType) ||
+      !acceptsDrop(nodeFromIndex(parent)))
+    return false;
+  // Only drops from other tabs; a drag inside one tree is too easy to do
+  // by accident.
+  QDataStream in(data->data(kEntriesMimeType));
+  quint64 source = 0;
+  in >> source;
+  return source != reinterpret_cast<quintptr>(this);
+}
+
+bool AtariFileSystemModel::dropMimeData(const QMimeData *data,
+                                        Qt::DropAction action, int row,
+                                        int column, const QModelIndex &parent) {
+  if (!canDropMimeData(data, action, row, column, parent))
+    return false;
+
+  QDataStream in(data->data(kEntriesMimeType));
+  quint64 source = 0;
+  in >> source;
+  QVector<Atari::DirEntry> entries;
+  Atari::DirEntry entry;
+  while (in.readRawData(reinterpret_cast<char *>(&entry), sizeof(entry)) ==
+         static_cast<int>(sizeof(entry)))
+    entries.push_back(entry);
+  if (entries.isEmpty())
+    return false;
+
+  const Node *target = nodeFromIndex(parent);
+  emit entriesDropped(static_cast<quintptr>(source), entries,
+                      target == m_root.get() ? 0
+                                             : target->entry.getStartCluster(),
+                      action == Qt::MoveAction);
+  return true;
 }
\ No newline at end of file
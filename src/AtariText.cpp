@@ -0,0 +1,183 @@
+// =============================================================================
+//  AtariText.cpp
+//  Atari ST Toolkit — Text Decoding
+//
+//  The ST character set is ASCII in 0x20-0x7E; the rest is a fixed table
+//  (CP437-like accents, Hebrew, Greek and maths symbols). Line indexing
+//  walks the file once, front to back, and publishes each batch of line
+//  offsets under a lock so a viewer can scroll while the scan continues.
+// =============================================================================
+
+#include "../include/AtariText.h"
+#include <algorithm>
+#include <cctype>
+
+namespace Atari {
+
+namespace {
+
+constexpr int TAB_WIDTH = 8;
+
+/** 0x80-0xFF of the ST character set. */
+const uint16_t kHighHalf[128] = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7, // 80
+    0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5, // 88
+    0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9, // 90
+    0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x00DF, 0x0192, // 98
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA, // A0
+    0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB, // A8
+    0x00E3, 0x00F5, 0x00D8, 0x00F8, 0x0153, 0x0152, 0x00C0, 0x00C3, // B0
+    0x00D5, 0x00A8, 0x00B4, 0x2020, 0x00B6, 0x00A9, 0x00AE, 0x2122, // B8
+    0x0133, 0x0132, 0x05D0, 0x05D1, 0x05D2, 0x05D3, 0x05D4, 0x05D5, // C0
+    0x05D6, 0x05D7, 0x05D8, 0x05D9, 0x05DB, 0x05DC, 0x05DE, 0x05E0, // C8
+    0x05E1, 0x05E2, 0x05E4, 0x05E6, 0x05E7, 0x05E8, 0x05E9, 0x05EA, // D0
+    0x05DF, 0x05DA, 0x05DD, 0x05E3, 0x05E5, 0x00A7, 0x2227, 0x221E, // D8
+    0x03B1, 0x03B2, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4, // E0
+    0x03A6, 0x0398, 0x03A9, 0x03B4, 0x222E, 0x03C6, 0x2208, 0x2229, // E8
+    0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, // F0
+    0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x00B3, 0x00AF, // F8
+};
+
+} // namespace
+
+const std::array<uint16_t, 256> &atariCharset() {
+  static const std::array<uint16_t, 256> table = [] {
+    std::array<uint16_t, 256> t{};
+    for (int c = 0; c < 0x20; ++c)
+      t[c] = static_cast<uint16_t>(0x2400 + c);
+    // The four cursor arrows of the GEM desktop font.
+    t[0x01] = 0x21E7;
+    t[0x02] = 0x21E9;
+    t[0x03] = 0x21E8;
+    t[0x04] = 0x21E6;
+    for (int c = 0x20; c < 0x7F; ++c)
+      t[c] = static_cast<uint16_t>(c);
+    t[0x7F] = 0x2302;
+    std::copy(std::begin(kHighHalf), std::end(kHighHalf), t.begin() + 0x80);
+    return t;
+  }();
+  return table;
+}
+
+bool isTextFileName(const std::string &name) {
+  std::string upper = name;
+  for (char &c : upper)
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+  const std::size_t dot = upper.rfind('.');
+  const std::string base = upper.substr(0, dot);
+  if (base == "README" || base == "READ")
+    return true;
+  if (dot == std::string::npos)
+    return false;
+
+  static const char *const kExtensions[] = {"TXT", "DOC", "ASC", "1ST",
+                                            "ME",  "NFO", "DIZ", "LST"};
+  const std::string ext = upper.substr(dot + 1);
+  return std::any_of(std::begin(kExtensions), std::end(kExtensions),
+                     [&ext](const char *e) { return ext == e; });
+}
+
+void decodeAtariText(const FileView &file, uint32_t begin, uint32_t end,
+                     std::u16string &out) {
+  const std::array<uint16_t, 256> &charset = atariCharset();
+  out.clear();
+  out.reserve(end > begin ? end - begin : 0);
+
+  FileView::Cursor in(file, begin);
+  uint8_t byte;
+  while (in.position() < end && in.next(byte)) {
+    if (byte == '\t') {
+      out.append(TAB_WIDTH - out.size() % TAB_WIDTH, u' ');
+      continue;
+    }
+    out.push_back(static_cast<char16_t>(charset[byte]));
+  }
+}
+
+// =============================================================================
+//  LineIndex
+// =============================================================================
+
+LineIndex::LineIndex(const FileView &file) : m_file(file) {}
+
+bool LineIndex::indexMore(uint32_t budget) {
+  const uint32_t size = m_file.size();
+  const uint32_t stop = m_scanned + std::min(budget, size - m_scanned);
+
+  // Collected without the lock, published in one go below.
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> ends;
+  uint32_t longest = 0;
+  auto endLine = [&](uint32_t pos) {
+    ends.push_back(pos);
+    longest = std::max(longest, pos - m_lineStart);
+  };
+  auto startLine = [&](uint32_t pos) {
+    starts.push_back(pos);
+    m_lineStart = pos;
+  };
+
+  FileView::Cursor in(m_file, m_scanned);
+  uint8_t byte;
+  for (uint32_t pos = m_scanned; pos < stop && in.next(byte); ++pos) {
+    if (m_pendingCr) {
+      m_pendingCr = false;
+      if (byte == '\n') {
+        startLine(pos + 1);
+        continue;
+      }
+      startLine(pos);
+    }
+    if (byte == '\n') {
+      endLine(pos);
+      startLine(pos + 1);
+    } else if (byte == '\r') {
+      // The next line starts after an LF if one follows.
+      endLine(pos);
+      m_pendingCr = true;
+    }
+  }
+  m_scanned = stop;
+
+  const bool done = m_scanned == size;
+  if (done) {
+    if (m_pendingCr)
+      startLine(size);
+    else if (m_lineStart < size)
+      endLine(size);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_starts.insert(m_starts.end(), starts.begin(), starts.end());
+  m_ends.insert(m_ends.end(), ends.begin(), ends.end());
+  m_longest = std::max(m_longest, longest);
+  m_complete = done;
+  return !done;
+}
+
+bool LineIndex::isComplete() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_complete;
+}
+
+uint32_t LineIndex::lineCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return static_cast<uint32_t>(m_ends.size());
+}
+
+uint32_t LineIndex::longestLine() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_longest;
+}
+
+bool LineIndex::line(uint32_t n, uint32_t &begin, uint32_t &end) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (n >= m_ends.size())
+    return false;
+  begin = m_starts[n];
+  end = m_ends[n];
+  return true;
+}
+
+} // namespace Atari
@@ -0,0 +1,120 @@
+// =============================================================================
+//  BootSectorBatch.cpp
+//  Atari ST Toolkit — Bulk In-Place Boot Sector Edits
+//
+//  Each file is opened once, sector 0 is pread() into a stack buffer, the
+//  edit is applied there and only a changed sector is pwrite() back.
+// =============================================================================
+
+#include "../include/BootSectorBatch.h"
+#include "../include/AtariDiskEngine.h"
+#include "../include/BootSectorAnalyzer.h"
+#include "../include/ImageSniffer.h"
+#include <QFile>
+#include <QtConcurrent>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Atari {
+
+namespace {
+
+QString oemOf(const uint8_t *boot) {
+  return QString::fromLatin1(reinterpret_cast<const char *>(boot + 2), 6)
+      .trimmed();
+}
+
+/** Closes the descriptor on every return path. */
+struct FdGuard {
+  int fd;
+  ~FdGuard() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+};
+
+} // namespace
+
+BootBatchResult applyBootEdit(const QString &path,
+                              const BootBatchOptions &options) {
+  BootBatchResult result;
+  result.path = path;
+
+  const QByteArray nativePath = QFile::encodeName(path);
+  FdGuard guard{::open(nativePath.constData(),
+                       options.dryRun ? O_RDONLY : O_RDWR)};
+  if (guard.fd < 0) {
+    result.message = QString::fromLocal8Bit(std::strerror(errno));
+    return result;
+  }
+
+  struct stat st;
+  if (::fstat(guard.fd, &st) != 0) {
+    result.message = QString::fromLocal8Bit(std::strerror(errno));
+    return result;
+  }
+
+  uint8_t sector[SECTOR_SIZE];
+  if (::pread(guard.fd, sector, SECTOR_SIZE, 0) != SECTOR_SIZE) {
+    result.message = "short read of sector 0";
+    return result;
+  }
+
+  // Containers keep their own header at offset 0; only raw dumps qualify.
+  SniffResult kind =
+      sniffImage(sector, SECTOR_SIZE, static_cast<uint64_t>(st.st_size));
+  if (kind.type != ImageType::RawST) {
+    result.message =
+        QString("not a raw sector image (%1)").arg(imageTypeName(kind.type));
+    return result;
+  }
+
+  uint8_t edited[SECTOR_SIZE];
+  std::memcpy(edited, sector, SECTOR_SIZE);
+  if (options.edit == BootEdit::SetOemLabel)
+    AtariDiskEngine::setOemLabel(edited, options.oemLabel);
+  else
+    AtariDiskEngine::fixBootChecksum(edited);
+
+  result.oldChecksum = bootWordSum(sector);
+  result.newChecksum = bootWordSum(edited);
+  result.oldOem = oemOf(sector);
+  result.newOem = oemOf(edited);
+
+  if (std::memcmp(sector, edited, SECTOR_SIZE) == 0) {
+    result.status = BootBatchResult::Status::Unchanged;
+    return result;
+  }
+
+  if (!options.dryRun) {
+    if (::pwrite(guard.fd, edited, SECTOR_SIZE, 0) != SECTOR_SIZE) {
+      result.message = QString::fromLocal8Bit(std::strerror(errno));
+      return result;
+    }
+    if (options.keepMtime) {
+      const struct timespec times[2] = {st.st_atim, st.st_mtim};
+      ::futimens(guard.fd, times);
+    }
+  }
+
+  result.status = BootBatchResult::Status::Changed;
+  return result;
+}
+
+std::vector<BootBatchResult> applyBootEdits(const QStringList &paths,
+                                            const BootBatchOptions &options) {
+  std::vector<BootBatchResult> results(paths.size());
+  for (int i = 0; i < paths.size(); ++i)
+    results[i].path = paths[i];
+
+  // Each file is independent, so the global pool can take them in any order.
+  QtConcurrent::blockingMap(results, [&options](BootBatchResult &r) {
+    r = applyBootEdit(r.path, options);
+  });
+  return results;
+}
+
+} // namespace Atari
@@ -0,0 +1,1216 @@
+// =============================================================================
+//  CommandLine.cpp
+//  Atari ST Toolkit — Headless Command-Line Front End
+//
+//  Thin wrappers over the engine for scripting and corpus pipelines. Every
+//  command that takes an image path also accepts "archive.zip!/inside.st".
+// =============================================================================
+
+#include "../include/CommandLine.h"
+#include "../include/ArchiveReader.h"
+#include "../include/AtariDiskEngine.h"
+#include "../include/BootSectorAnalyzer.h"
+#include "../include/BootSectorBatch.h"
+#include "../include/Depacker.h"
+#include "../include/DiskMaster.h"
+#include "../include/FileSystemCheck.h"
+#include "../include/FolderSync.h"
+#include "../include/GemdosDrive.h"
+#include "../include/GemdosProgram.h"
+#include "../include/HfeImage.h"
+#include "../include/ImageDaemon.h"
+#include "../include/ImageNormalizer.h"
+#include "../include/ImageSniffer.h"
+#include "../include/ImageTransfer.h"
+#include "../include/M68kDisassembler.h"
+#include "../include/ScpImage.h"
+#include "../include/ZipArchive.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace Atari {
+
+namespace {
+
+using EntryVisitor =
+    std::function<void(const QString &path, const DirEntry &entry)>;
+
+struct Command {
+  const char *name;
+  const char *usage;
+  int minArgs;
+  int (*run)(const QStringList &args, QTextStream &out, QTextStream &err);
+};
+
+// =============================================================================
+//  Helpers
+// =============================================================================
+
+bool openImage(AtariDiskEngine &engine, const QString &path,
+               QTextStream &err) {
+  bool ok = false;
+  try {
+    ok = engine.loadImage(path);
+  } catch (const std::exception &e) {
+    err << "error: " << path << ": " << e.what() << "\n";
+    return false;
+  }
+  if (!ok) {
+    err << "error: cannot load image " << path << "\n";
+    return false;
+  }
+  engine.readRootDirectory(); // Settles the geometry mode
+  return true;
+}
+
+bool isDotEntry(const DirEntry &e) { return e.name[0] == '.'; }
+
+void walkDirectory(const AtariDiskEngine &engine,
+                   const std::vector<DirEntry> &entries, const QString &prefix,
+                   const EntryVisitor &visit, int depth = 0) {
+  for (const DirEntry &e : entries) {
+    if (isDotEntry(e))
+      continue;
+    const QString path =
+        prefix + AtariDiskEngine::toQString(e.getFilename());
+    visit(path, e);
+    // Same guards as the tree model: bogus clusters and runaway nesting.
+    if (e.isDirectory() && e.getStartCluster() >= 2 && depth < 16)
+      walkDirectory(engine, engine.readSubDirectory(e.getStartCluster()),
+                    path + "/", visit, depth + 1);
+  }
+}
+
+bool findEntry(const AtariDiskEngine &engine, const QString &path,
+               DirEntry &found) {
+  QStringList parts = QString(path).replace('\\', '/').split(
+      '/', Qt::SkipEmptyParts);
+  std::vector<DirEntry> dir = engine.readRootDirectory();
+  for (int i = 0; i < parts.size(); ++i) {
+    bool matched = false;
+    for (const DirEntry &e : dir) {
+      if (AtariDiskEngine::toQString(e.getFilename())
+              .compare(parts[i], Qt::CaseInsensitive) != 0)
+        continue;
+      if (i == parts.size() - 1) {
+        found = e;
+        return true;
+      }
+      if (!e.isDirectory() || e.getStartCluster() < 2)
+        return false;
+      dir = engine.readSubDirectory(e.getStartCluster());
+      matched = true;
+      break;
+    }
+    if (!matched)
+      return false;
+  }
+  return false;
+}
+
+void printSniff(QTextStream &out, const QString &path, const SniffResult &r) {
+  out << imageTypeName(r.type) << "\t" << r.confidence << "\t";
+  if (r.hasGeometry())
+    out << r.tracks << "x" << r.sides << "x" << r.sectorsPerTrack;
+  else
+    out << "-";
+  out << "\t" << path;
+  if (!r.detail.isEmpty())
+    out << "\t(" << r.detail << ")";
+  out << "\n";
+}
+
+void sniffPath(QTextStream &out, const QString &path) {
+  SniffResult r = sniffImageFile(path);
+  printSniff(out, path, r);
+  if (r.type != ImageType::Compressed || r.detail != "zip")
+    return;
+
+  // Zip members are first-class images: classify each one in place.
+  ZipArchive zip(path);
+  for (const ZipMember &m : zip.imageMembers()) {
+    std::vector<uint8_t> head;
+    const QString memberPath = ZipArchive::memberPath(path, m.name);
+    if (zip.readMember(m, head, SNIFF_PROBE_SIZE))
+      printSniff(out, memberPath,
+                 sniffImage(head.data(), head.size(), m.uncompressedSize));
+    else
+      out << "Junk\t100\t-\t" << memberPath << "\t(unreadable member)\n";
+  }
+}
+
+// =============================================================================
+//  Commands
+// =============================================================================
+
+int cmdInfo(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  DiskStats stats = engine.getDiskStats();
+  BootSectorInfo boot = engine.checkBootSector();
+  out << "Image:\t" << args[0] << "\n"
+      << "Format:\t" << engine.getFormatInfoString() << "\n"
+      << "OEM:\t" << boot.oemName << "\n"
+      << "Boot:\t" << (boot.isExecutable ? "executable" : "data") << "\n"
+      << "Size:\t" << stats.totalBytes << "\n"
+      << "Free:\t" << stats.freeBytes << "\n"
+      << "Files:\t" << stats.fileCount << "\n"
+      << "Dirs:\t" << stats.dirCount << "\n";
+  return 0;
+}
+
+int cmdList(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  walkDirectory(engine, engine.readRootDirectory(), QString(),
+                [&out](const QString &path, const DirEntry &e) {
+                  if (e.isDirectory())
+                    out << "<DIR>\t" << path << "/\n";
+                  else
+                    out << e.getFileSize() << "\t" << path << "\n";
+                });
+  return 0;
+}
+
+int cmdDir(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  // Answered through Fsfirst()/Fsnext(), so this is what a TOS program
+  // would see for the same search spec.
+  GemdosDrive drive(engine);
+  GemdosDta dta;
+  const QString spec = args.size() > 1 ? args[1] : QString("*.*");
+  const uint16_t attr = ATTR_HIDDEN | ATTR_SYSTEM | ATTR_DIRECTORY;
+  int32_t status = drive.fsfirst(spec, attr, dta);
+  if (status == GEMDOS_EPTHNF) {
+    err << "error: no such directory in image: " << spec << "\n";
+    return 1;
+  }
+  for (; status == GEMDOS_E_OK; status = drive.fsnext(dta)) {
+    if (dta.attr & ATTR_DIRECTORY)
+      out << "<DIR>";
+    else
+      out << dta.size;
+    out << "\t" << dta.name << "\n";
+  }
+  return 0;
+}
+
+int cmdExtract(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  DirEntry entry;
+  if (!findEntry(engine, args[1], entry) || entry.isDirectory()) {
+    err << "error: no such file in image: " << args[1] << "\n";
+    return 1;
+  }
+
+  QByteArray data = engine.readFileQt(entry);
+  QFile dest(args[2]);
+  if (!dest.open(QIODevice::WriteOnly) || dest.write(data) != data.size()) {
+    err << "error: cannot write " << args[2] << "\n";
+    return 1;
+  }
+  out << data.size() << "\t" << args[2] << "\n";
+  return 0;
+}
+
+int cmdSniff(const QStringList &args, QTextStream &out, QTextStream &) {
+  for (const QString &arg : args) {
+    if (!QFileInfo(arg).isDir()) {
+      sniffPath(out, arg);
+      continue;
+    }
+    QDirIterator it(arg, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+      sniffPath(out, it.next());
+  }
+  return 0;
+}
+
+/**
+ * Expands directories to the raw images below them, for the in-place batch
+ * edits; those write files directly, so zip archives are left out.
+ */
+QStringList collectRawImages(const QStringList &args) {
+  QStringList paths;
+  for (const QString &arg : args) {
+    if (!QFileInfo(arg).isDir()) {
+      paths << arg;
+      continue;
+    }
+    QDirIterator it(arg, QStringList() << "*.st" << "*.ST", QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext())
+      paths << it.next();
+  }
+  return paths;
+}
+
+/**
+ * Expands directories and zip archives for read-only scans. Zip members are
+ * first-class images and come back as "archive.zip!/member" paths; an
+ * unreadable archive is passed through so that opening it reports why.
+ */
+QStringList collectImages(const QStringList &args) {
+  QStringList files;
+  for (const QString &arg : args) {
+    if (!QFileInfo(arg).isDir()) {
+      files << arg;
+      continue;
+    }
+    const QStringList patterns = {"*.st", "*.ST", "*.zip", "*.ZIP"};
+    QDirIterator it(arg, patterns, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+      files << it.next();
+  }
+
+  QStringList paths;
+  for (const QString &file : files) {
+    if (!file.endsWith(".zip", Qt::CaseInsensitive)) {
+      paths << file;
+      continue;
+    }
+    ZipArchive zip(file);
+    if (!zip.isOpen()) {
+      paths << file;
+      continue;
+    }
+    for (const ZipMember &m : zip.imageMembers())
+      paths << ZipArchive::memberPath(file, m.name);
+  }
+  return paths;
+}
+
+int runBootBatch(QStringList args, BootBatchOptions options, QTextStream &out,
+                 QTextStream &err) {
+  options.dryRun = args.removeAll("--dry-run") > 0;
+  options.keepMtime = args.removeAll("--keep-mtime") > 0;
+  if (args.isEmpty()) {
+    err << "error: no images given\n";
+    return 2;
+  }
+
+  int changed = 0, unchanged = 0, failed = 0;
+  for (const BootBatchResult &r :
+       applyBootEdits(collectRawImages(args), options)) {
+    switch (r.status) {
+    case BootBatchResult::Status::Changed:
+      ++changed;
+      out << (options.dryRun ? "would-change\t" : "changed\t");
+      break;
+    case BootBatchResult::Status::Unchanged:
+      ++unchanged;
+      out << "unchanged\t";
+      break;
+    case BootBatchResult::Status::Failed:
+      ++failed;
+      out << "failed\t" << r.message << "\t" << r.path << "\n";
+      continue;
+    }
+    out << QString("0x%1->0x%2")
+               .arg(r.oldChecksum, 4, 16, QChar('0'))
+               .arg(r.newChecksum, 4, 16, QChar('0'))
+        << "\t" << r.oldOem << "->" << r.newOem << "\t" << r.path << "\n";
+  }
+
+  err << changed << " changed, " << unchanged << " unchanged, " << failed
+      << " failed" << (options.dryRun ? " (dry run)" : "") << "\n";
+  return failed > 0 ? 1 : 0;
+}
+
+int cmdFixBoot(const QStringList &args, QTextStream &out, QTextStream &err) {
+  BootBatchOptions options;
+  options.edit = BootEdit::FixChecksum;
+  return runBootBatch(args, options, out, err);
+}
+
+int cmdSetOem(const QStringList &args, QTextStream &out, QTextStream &err) {
+  BootBatchOptions options;
+  options.edit = BootEdit::SetOemLabel;
+  options.oemLabel = args[0];
+  return runBootBatch(args.mid(1), options, out, err);
+}
+
+/** Reads sector 0 of a raw image or raw zip member without a full load. */
+bool readBootSector(const QString &path, uint8_t *sector, QString &why) {
+  std::vector<uint8_t> head;
+  uint64_t size = 0;
+  QString archivePath, memberPath;
+  if (ZipArchive::splitArchivePath(path, archivePath, memberPath)) {
+    ZipArchive zip(archivePath);
+    const ZipMember *m = zip.isOpen() ? zip.findMember(memberPath) : nullptr;
+    if (!m || !zip.readMember(*m, head, SECTOR_SIZE)) {
+      why = "unreadable member";
+      return false;
+    }
+    size = m->uncompressedSize;
+  } else {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+      why = "cannot open";
+      return false;
+    }
+    QByteArray data = file.read(SECTOR_SIZE);
+    head.assign(data.begin(), data.end());
+    size = static_cast<uint64_t>(file.size());
+  }
+
+  if (head.size() < SECTOR_SIZE) {
+    why = "shorter than one sector";
+    return false;
+  }
+  SniffResult kind = sniffImage(head.data(), head.size(), size);
+  if (kind.type != ImageType::RawST) {
+    why = QString("not a raw image (%1)").arg(imageTypeName(kind.type));
+    return false;
+  }
+  std::memcpy(sector, head.data(), SECTOR_SIZE);
+  return true;
+}
+
+int cmdBootScan(const QStringList &args, QTextStream &out, QTextStream &err) {
+  QStringList rest = args;
+  const int dbFlag = rest.indexOf("--db");
+  if (dbFlag >= 0) {
+    if (dbFlag + 1 >= rest.size() ||
+        bootSignatureDb().loadFile(rest[dbFlag + 1]) < 0) {
+      err << "error: cannot read signature database\n";
+      return 2;
+    }
+    rest.removeAt(dbFlag + 1);
+    rest.removeAt(dbFlag);
+  }
+
+  struct Row {
+    QString path;
+    QString error;
+    BootAnalysis analysis;
+  };
+  std::vector<Row> rows;
+  for (const QString &path : collectImages(rest))
+    rows.push_back({path, QString(), BootAnalysis()});
+
+  // Only sector 0 is read per file, so the scan is I/O bound; fan it out.
+  QtConcurrent::blockingMap(rows, [](Row &row) {
+    uint8_t sector[SECTOR_SIZE];
+    if (readBootSector(row.path, sector, row.error))
+      row.analysis = analyzeBootSector(sector);
+  });
+
+  for (const Row &row : rows) {
+    if (!row.error.isEmpty()) {
+      out << "-\tError\t" << row.error << "\t" << row.path << "\n";
+      continue;
+    }
+    const BootAnalysis &a = row.analysis;
+    out << QString("%1").arg(a.codeHash, 16, 16, QChar('0')) << "\t"
+        << bootCategoryName(a.category) << "\t" << a.name << "\t" << row.path
+        << "\n";
+  }
+  return 0;
+}
+
+int cmdZipList(const QStringList &args, QTextStream &out, QTextStream &err) {
+  ZipArchive zip(args[0]);
+  if (!zip.isOpen()) {
+    err << "error: cannot read zip archive " << args[0] << "\n";
+    return 1;
+  }
+  for (const ZipMember &m : zip.imageMembers())
+    out << m.uncompressedSize << "\t"
+        << ZipArchive::memberPath(args[0], m.name) << "\n";
+  return 0;
+}
+
+void printListing(QTextStream &out, const M68kDisassembler &dis,
+                  uint32_t from) {
+  for (uint32_t offset = from; offset < dis.size();) {
+    const M68kInstruction ins = dis.decode(offset);
+    out << QString("%1").arg(dis.addressOf(offset), 6, 16, QChar('0'))
+        << "  " << QString::fromStdString(ins.text) << "\n";
+    offset += ins.length ? ins.length : 1;
+  }
+}
+
+int cmdDisasm(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  if (args.size() < 2) {
+    // Boot code: the branch at 0x00, then everything past the BPB block.
+    const QByteArray boot = engine.getSector(0);
+    const auto *bytes = reinterpret_cast<const uint8_t *>(boot.constData());
+    M68kDisassembler dis(bytes, SECTOR_SIZE - 2);
+    out << "000000  " << QString::fromStdString(dis.decode(0).text) << "\n";
+    printListing(out, dis, 0x1E);
+    return 0;
+  }
+
+  DirEntry entry;
+  if (!findEntry(engine, args[1], entry) || entry.isDirectory()) {
+    err << "error: no such file in image: " << args[1] << "\n";
+    return 1;
+  }
+
+  const QByteArray file = engine.readFileQt(entry);
+  const auto *bytes = reinterpret_cast<const uint8_t *>(file.constData());
+  PrgHeader header;
+  if (!parsePrgHeader(bytes, file.size(), header)) {
+    err << "error: not a GEMDOS executable: " << args[1] << "\n";
+    return 1;
+  }
+
+  std::vector<uint32_t> fixups;
+  if (!decodePrgRelocations(bytes, file.size(), header, fixups))
+    err << "warning: relocation table damaged\n";
+
+  out << "; TEXT " << header.textSize << ", DATA " << header.dataSize
+      << ", BSS " << header.bssSize << ", " << fixups.size() << " fixups\n";
+  M68kDisassembler dis(bytes + header.textOffset(), header.textSize);
+  dis.setSymbolizer(prgSymbolizer(header, fixups));
+  printListing(out, dis, 0);
+  return 0;
+}
+
+/** One prg-scan column block: sizes, symbol count, fixups, packer. */
+QString prgInventory(const PrgAnalysis &a) {
+  if (!a.valid)
+    return "-\t-\t-\t-\t-\tinvalid";
+  return QString("%1\t%2\t%3\t%4\t%5\t%6")
+      .arg(a.header.textSize)
+      .arg(a.header.dataSize)
+      .arg(a.header.bssSize)
+      .arg(a.symbols.size())
+      .arg(a.relocationsOk ? QString::number(a.fixups.size()) : "bad")
+      .arg(a.packer ? a.packer : "-");
+}
+
+/**
+ * The bytes a content command works on: the file itself or, with
+ * --depacked, the cached depacked form of a packed file.
+ */
+struct Content {
+  FileView view;
+  std::shared_ptr<const DepackedFile> depacked; /**< Owns view's bytes. */
+  QString state = "-"; /**< Packer name, or "packed" if not depacked. */
+
+  /** @return Content hash; depacked hashes come from the cache. */
+  uint64_t hash() const {
+    return depacked && depacked->ok ? depacked->contentHash
+                                    : view.contentHash();
+  }
+};
+
+Content fileContent(const FileView &file, bool wantDepacked) {
+  Content c;
+  c.view = file;
+  if (!wantDepacked)
+    return c;
+  c.depacked = depackCached(file);
+  if (!c.depacked->packed)
+    return c;
+  if (!c.depacked->ok) {
+    c.state = "packed";
+    return c;
+  }
+  c.view = FileView::fromBuffer(c.depacked->data.data(),
+                                c.depacked->data.size());
+  c.state = c.depacked->format;
+  return c;
+}
+
+/** "0x" followed by hex digits is a byte pattern, anything else text. */
+QByteArray parsePattern(const QString &arg) {
+  if (arg.startsWith("0x", Qt::CaseInsensitive))
+    return QByteArray::fromHex(arg.mid(2).toLatin1());
+  return arg.toLatin1();
+}
+
+/**
+ * Runs a job over every file of every image, one image per worker, and
+ * prints the non-empty result lines followed by image and path.
+ */
+int forEachFile(
+    const QStringList &images, QTextStream &out, QTextStream &err,
+    const std::function<QString(const DirEntry &e, const FileView &file)>
+        &job) {
+  struct Row {
+    QString image;
+    QString error;
+    QStringList lines;
+  };
+  std::vector<Row> rows;
+  for (const QString &path : collectImages(images))
+    rows.push_back({path, QString(), QStringList()});
+
+  // Files are read in place through views, never extracted.
+  QtConcurrent::blockingMap(rows, [&job](Row &row) {
+    AtariDiskEngine engine;
+    QTextStream errors(&row.error);
+    if (!openImage(engine, row.image, errors))
+      return;
+
+    walkDirectory(engine, engine.readRootDirectory(), QString(),
+                  [&](const QString &path, const DirEntry &e) {
+                    if (e.isDirectory())
+                      return;
+                    const QString line = job(e, engine.fileView(e));
+                    if (!line.isEmpty())
+                      row.lines << line + "\t" + row.image + "\t" + path;
+                  });
+  });
+
+  int failed = 0;
+  for (const Row &row : rows) {
+    if (!row.error.isEmpty()) {
+      err << row.error;
+      ++failed;
+      continue;
+    }
+    for (const QString &line : row.lines)
+      out << line << "\n";
+  }
+  return failed > 0 ? 1 : 0;
+}
+
+int cmdPrgScan(const QStringList &args, QTextStream &out, QTextStream &err) {
+  return forEachFile(args, out, err,
+                     [](const DirEntry &e, const FileView &file) {
+    if (!isProgramFileName(e.getFilename()))
+      return QString();
+    return prgInventory(analyzePrg(file));
+  });
+}
+
+int cmdDepack(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  DirEntry entry;
+  if (!findEntry(engine, args[1], entry) || entry.isDirectory()) {
+    err << "error: no such file in image: " << args[1] << "\n";
+    return 1;
+  }
+
+  DepackArena arena;
+  const DepackResult r = depack(engine.fileView(entry), arena);
+  if (!r.packed) {
+    err << "error: no known packer in " << args[1] << "\n";
+    return 1;
+  }
+  if (!r.ok) {
+    err << "error: " << r.format << ": "
+        << QString::fromStdString(r.error) << "\n";
+    return 1;
+  }
+
+  QFile dest(args[2]);
+  if (!dest.open(QIODevice::WriteOnly) ||
+      dest.write(reinterpret_cast<const char *>(r.data), r.size) != r.size) {
+    err << "error: cannot write " << args[2] << "\n";
+    return 1;
+  }
+  out << r.size << "\t" << r.format << "\t" << args[2] << "\n";
+  return 0;
+}
+
+int cmdHash(const QStringList &args, QTextStream &out, QTextStream &err) {
+  QStringList images = args;
+  const bool depacked = images.removeAll("--depacked") > 0;
+  return forEachFile(images, out, err,
+                     [depacked](const DirEntry &, const FileView &file) {
+    const Content c = fileContent(file, depacked);
+    return QString("%1\t%2\t%3")
+        .arg(c.hash(), 16, 16, QChar('0'))
+        .arg(c.view.size())
+        .arg(c.state);
+  });
+}
+
+int cmdFind(const QStringList &args, QTextStream &out, QTextStream &err) {
+  QStringList rest = args;
+  const bool depacked = rest.removeAll("--depacked") > 0;
+  if (rest.size() < 2) {
+    err << "error: need a pattern and at least one image\n";
+    return 2;
+  }
+  const QByteArray pattern = parsePattern(rest.takeFirst());
+  if (pattern.isEmpty()) {
+    err << "error: empty search pattern\n";
+    return 2;
+  }
+
+  const std::boyer_moore_horspool_searcher<const char *> searcher(
+      pattern.constData(), pattern.constData() + pattern.size());
+  return forEachFile(rest, out, err, [&](const DirEntry &,
+                                         const FileView &file) {
+    const Content c = fileContent(file, depacked);
+    std::vector<uint8_t> copy;
+    const uint8_t *bytes = c.view.contiguous(0, c.view.size());
+    if (!bytes && !c.view.isEmpty()) {
+      copy = c.view.toVector();
+      bytes = copy.data();
+    }
+    const char *begin = reinterpret_cast<const char *>(bytes);
+    const char *end = begin + c.view.size();
+
+    QStringList hits;
+    for (const char *at = begin;;) {
+      at = std::search(at, end, searcher);
+      if (at == end)
+        break;
+      hits << QString("0x%1").arg(at - begin, 0, 16);
+      ++at;
+    }
+    if (hits.isEmpty())
+      return QString();
+    return hits.join(',') + "\t" + c.state;
+  });
+}
+
+bool openArchive(const AtariDiskEngine &engine, const QString &path,
+                 FileView &view, QTextStream &err) {
+  DirEntry entry;
+  if (!findEntry(engine, path, entry) || entry.isDirectory()) {
+    err << "error: no such file in image: " << path << "\n";
+    return false;
+  }
+  view = engine.fileView(entry);
+  return true;
+}
+
+int cmdArcList(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  FileView view;
+  if (!openImage(engine, args[0], err) ||
+      !openArchive(engine, args[1], view, err))
+    return 1;
+
+  const ArchiveReader archive(view);
+  if (!archive.isOpen()) {
+    err << "error: not an ARC or LZH archive: " << args[1] << "\n";
+    return 1;
+  }
+  for (const ArchiveMember &m : archive.members())
+    out << m.size << "\t" << m.compressedSize << "\t"
+        << QString::fromStdString(m.method) << "\t"
+        << QString::fromStdString(m.name) << "\n";
+  return 0;
+}
+
+int cmdArcExtract(const QStringList &args, QTextStream &out,
+                  QTextStream &err) {
+  AtariDiskEngine engine;
+  FileView view;
+  if (!openImage(engine, args[0], err) ||
+      !openArchive(engine, args[1], view, err))
+    return 1;
+
+  const ArchiveReader archive(view);
+  const auto &members = archive.members();
+  const auto it = std::find_if(
+      members.begin(), members.end(), [&args](const ArchiveMember &m) {
+        return QString::fromStdString(m.name).compare(
+                   args[2], Qt::CaseInsensitive) == 0;
+      });
+  if (it == members.end()) {
+    err << "error: no such member in " << args[1] << ": " << args[2] << "\n";
+    return 1;
+  }
+
+  std::vector<uint8_t> data;
+  std::string why;
+  if (!archive.readMember(*it, data, why)) {
+    err << "error: " << args[2] << ": " << QString::fromStdString(why)
+        << "\n";
+    return 1;
+  }
+
+  QFile dest(args[3]);
+  const auto size = static_cast<qint64>(data.size());
+  if (!dest.open(QIODevice::WriteOnly) ||
+      dest.write(reinterpret_cast<const char *>(data.data()), size) != size) {
+    err << "error: cannot write " << args[3] << "\n";
+    return 1;
+  }
+  out << size << "\t" << args[3] << "\n";
+  return 0;
+}
+
+int cmdSync(const QStringList &args, QTextStream &out, QTextStream &err) {
+  AtariDiskEngine engine;
+  if (!openImage(engine, args[0], err))
+    return 1;
+
+  FolderSync sync(engine, args[1], args.value(2));
+  if (!sync.isValid()) {
+    err << "error: " << args[0] << ": no writable directory "
+        << (args.value(2).isEmpty() ? QString("/") : args[2]) << "\n";
+    return 1;
+  }
+
+  const uint32_t before = engine.changeCounter();
+  const SyncReport report = sync.syncNow();
+  const auto print = [&out](const char *tag, const QStringList &paths) {
+    for (const QString &path : paths)
+      out << tag << "\t" << path << "\n";
+  };
+  print(">", report.toImage);
+  print("<", report.toHost);
+  print("-", report.removedFromImage + report.removedFromHost);
+  print("!", report.conflicts);
+  print("?", report.skipped);
+
+  if (report.imageChanged() && !engine.saveChanges(args[0], before)) {
+    err << "error: cannot write " << args[0] << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+/** Copies or moves "<from> <path-in-image> <to> [dir-in-image]". */
+int transfer(const QStringList &args, bool move, QTextStream &out,
+             QTextStream &err) {
+  const bool sameImage = QFileInfo(args[0]).absoluteFilePath() ==
+                         QFileInfo(args[2]).absoluteFilePath();
+  AtariDiskEngine source;
+  AtariDiskEngine target;
+  if (!openImage(source, args[0], err) ||
+      (!sameImage && !openImage(target, args[2], err)))
+    return 1;
+  AtariDiskEngine &dest = sameImage ? source : target;
+
+  DirEntry entry;
+  if (!findEntry(source, args[1], entry)) {
+    err << "error: no such file in image: " << args[1] << "\n";
+    return 1;
+  }
+  uint16_t dirCluster = 0;
+  if (!args.value(3).isEmpty()) {
+    DirEntry dir;
+    if (!findEntry(dest, args[3], dir) || !dir.isDirectory()) {
+      err << "error: no such folder in image: " << args[3] << "\n";
+      return 1;
+    }
+    dirCluster = dir.getStartCluster();
+  }
+
+  const uint32_t sourceBefore = source.changeCounter();
+  const uint32_t before = dest.changeCounter();
+  TransferReport report;
+  const bool ok = move ? moveEntry(source, entry, dest, dirCluster, report)
+                       : copyEntry(source, entry, dest, dirCluster, report);
+  for (const QString &failure : report.failed)
+    err << "error: " << failure << "\n";
+  out << report.files << " files\t" << report.dirs << " dirs\t"
+      << report.bytes << " bytes\t" << args[2] << "\n";
+
+  // Only the sectors the copy touched are written back.
+  if (dest.changeCounter() != before && !dest.saveChanges(args[2], before)) {
+    err << "error: cannot write " << args[2] << "\n";
+    return 1;
+  }
+  if (!sameImage && source.changeCounter() != sourceBefore &&
+      !source.saveChanges(args[0], sourceBefore)) {
+    err << "error: cannot write " << args[0] << "\n";
+    return 1;
+  }
+  return ok ? 0 : 1;
+}
+
+int cmdCopy(const QStringList &args, QTextStream &out, QTextStream &err) {
+  return transfer(args, false, out, err);
+}
+
+int cmdMove(const QStringList &args, QTextStream &out, QTextStream &err) {
+  return transfer(args, true, out, err);
+}
+
+int cmdMaster(const QStringList &args, QTextStream &out, QTextStream &err) {
+  MasterManifest manifest;
+  QString error;
+  if (!MasterManifest::load(args[0], manifest, error)) {
+    err << "error: " << args[0] << ": " << error << "\n";
+    return 1;
+  }
+
+  // Lay the build out over the previous one, then patch that in place:
+  // only differing sectors are written.
+  AtariDiskEngine engine;
+  const qint64 bytes = static_cast<qint64>(manifest.sides) * manifest.tracks *
+                       manifest.sectorsPerTrack * SECTOR_SIZE;
+  const bool reuse =
+      QFileInfo(args[1]).size() == bytes && engine.loadImage(args[1]);
+  const std::vector<uint8_t> none;
+  std::vector<uint8_t> image;
+  std::vector<MasterFile> files;
+  if (!masterImage(manifest, reuse ? engine.getRawImageData() : none, image,
+                   files, error)) {
+    err << "error: " << args[0] << ": " << error << "\n";
+    return 1;
+  }
+
+  const uint32_t before = engine.changeCounter();
+  engine.mergeImage(std::move(image));
+  const std::vector<uint32_t> dirty = engine.dirtySectorsSince(before);
+
+  bool written;
+  if (reuse) {
+    written = engine.saveChanges(args[1], before);
+  } else {
+    const std::vector<uint8_t> &data = engine.getRawImageData();
+    const auto size = static_cast<qint64>(data.size());
+    QFile dest(args[1]);
+    written =
+        dest.open(QIODevice::WriteOnly) &&
+        dest.write(reinterpret_cast<const char *>(data.data()), size) == size;
+  }
+  if (!written) {
+    err << "error: cannot write " << args[1] << "\n";
+    return 1;
+  }
+
+  for (const MasterFile &f : files) {
+    const bool changed =
+        std::any_of(f.sectors.begin(), f.sectors.end(), [&dirty](uint32_t s) {
+          return std::binary_search(dirty.begin(), dirty.end(), s);
+        });
+    if (changed)
+      out << "written\t" << f.path << "\n";
+  }
+  err << dirty.size() << " of "
+      << engine.getRawImageData().size() / SECTOR_SIZE << " sectors written\n";
+  return 0;
+}
+
+/** @return "12.3%" smaller, or "-" when there is nothing to compare. */
+QString percentSmaller(std::size_t before, std::size_t after) {
+  if (before == 0)
+    return "-";
+  return QString::number(100.0 * (static_cast<double>(before) -
+                                  static_cast<double>(after)) /
+                             static_cast<double>(before),
+                         'f', 1) +
+         "%";
+}
+
+int cmdNormalize(const QStringList &args, QTextStream &out,
+                 QTextStream &err) {
+  QStringList images = args;
+  const bool dryRun = images.removeAll("--dry-run") > 0;
+  QString forensicDir;
+  const int forensicFlag = images.indexOf("--forensic");
+  if (forensicFlag >= 0) {
+    if (forensicFlag + 1 >= images.size()) {
+      err << "error: --forensic needs a directory\n";
+      return 2;
+    }
+    forensicDir = images[forensicFlag + 1];
+    images.removeAt(forensicFlag + 1);
+    images.removeAt(forensicFlag);
+  }
+
+  int failed = 0;
+  for (const QString &path : images) {
+    AtariDiskEngine engine;
+    if (!openImage(engine, path, err)) {
+      ++failed;
+      continue;
+    }
+    FatVolume volume = engine.volume();
+    if (!volume.isValid()) {
+      err << "error: " << path << ": no usable FAT12 layout\n";
+      ++failed;
+      continue;
+    }
+
+    const std::vector<SlackRegion> slack = findSlack(volume);
+    QString error;
+    if (!forensicDir.isEmpty() &&
+        !saveSlack(volume, slack,
+                   QDir(forensicDir).filePath(QFileInfo(path).fileName()),
+                   error)) {
+      err << "error: " << error << "\n";
+      ++failed;
+      continue;
+    }
+
+    const uint32_t before = engine.changeCounter();
+    const NormalizeReport r = normalizeImage(volume, slack);
+    if (!dryRun && !engine.saveChanges(path, before)) {
+      err << "error: cannot write " << path << "\n";
+      ++failed;
+      continue;
+    }
+    out << r.freeBytes << "\t" << r.tailBytes << "\t" << r.slotBytes
+        << "\tdeflate " << r.deflateBefore << "->" << r.deflateAfter << " ("
+        << percentSmaller(r.deflateBefore, r.deflateAfter) << ")\tmsa "
+        << r.msaBefore << "->" << r.msaAfter << " ("
+        << percentSmaller(r.msaBefore, r.msaAfter) << ")\t" << path << "\n";
+  }
+  return failed > 0 ? 1 : 0;
+}
+
+int cmdFsck(const QStringList &args, QTextStream &out, QTextStream &err) {
+  int failed = 0;
+  for (const QString &path : args) {
+    AtariDiskEngine engine;
+    if (!openImage(engine, path, err)) {
+      ++failed;
+      continue;
+    }
+    const FatVolume volume = engine.volume();
+    if (!volume.isValid()) {
+      err << "error: " << path << ": no usable FAT12 layout\n";
+      ++failed;
+      continue;
+    }
+
+    const FsckReport report = checkFileSystem(volume);
+    for (const FsckIssue &i : report.issues)
+      out << fsckProblemName(i.problem) << "\t" << i.cluster << "\t"
+          << (i.path.isEmpty() ? QString("-") : i.path) << "\t" << i.detail
+          << "\t" << path << "\n";
+    out << report.files << " files\t" << report.dirs << " dirs\t"
+        << report.issues.size() << " problems\t" << path << "\n";
+    if (!report.isClean())
+      ++failed;
+  }
+  return failed > 0 ? 1 : 0;
+}
+
+/**
+ * @brief Removes "flag N" from args.
+ * @return False if the flag is there without a number after it.
+ */
+bool takeNumber(QStringList &args, const QString &flag, uint32_t &value) {
+  const int at = args.indexOf(flag);
+  if (at < 0)
+    return true;
+  bool ok = false;
+  if (at + 1 < args.size())
+    value = args[at + 1].toUInt(&ok);
+  if (!ok)
+    return false;
+  args.removeAt(at + 1);
+  args.removeAt(at);
+  return true;
+}
+
+int cmdHfeExport(const QStringList &args, QTextStream &out,
+                 QTextStream &err) {
+  QStringList rest = args;
+  HfeOptions options;
+  if (!takeNumber(rest, "--interleave", options.interleave) ||
+      !takeNumber(rest, "--skew", options.skew) || rest.size() != 2) {
+    err << "error: expected [--interleave N] [--skew N] <image> <out.hfe>\n";
+    return 2;
+  }
+
+  AtariDiskEngine engine;
+  if (!openImage(engine, rest[0], err))
+    return 1;
+  QString error;
+  if (!exportHfe(engine.getRawImageData(), rest[1], options, error)) {
+    err << "error: " << rest[0] << ": " << error << "\n";
+    return 1;
+  }
+  out << QFileInfo(rest[1]).size() << "\t" << rest[1] << "\n";
+  return 0;
+}
+
+int cmdHfeImport(const QStringList &args, QTextStream &out,
+                 QTextStream &err) {
+  std::vector<uint8_t> image;
+  HfeReport report;
+  QString error;
+  if (!importHfe(args[0], image, report, error)) {
+    err << "error: " << args[0] << ": " << error << "\n";
+    return 1;
+  }
+
+  const auto size = static_cast<qint64>(image.size());
+  QFile dest(args[1]);
+  if (!dest.open(QIODevice::WriteOnly) ||
+      dest.write(reinterpret_cast<const char *>(image.data()), size) != size) {
+    err << "error: cannot write " << args[1] << "\n";
+    return 1;
+  }
+  out << report.tracks << "x" << report.sides << "x"
+      << report.sectorsPerTrack << "\t" << report.badSectors << " bad\t"
+      << report.missingSectors << " missing\t" << args[1] << "\n";
+  return report.badSectors + report.missingSectors > 0 ? 1 : 0;
+}
+
+int cmdScpImport(const QStringList &args, QTextStream &out,
+                 QTextStream &err) {
+  std::vector<uint8_t> image;
+  ScpReport report;
+  QString error;
+  if (!importScp(args[0], image, report, error)) {
+    err << "error: " << args[0] << ": " << error << "\n";
+    return 1;
+  }
+
+  const auto size = static_cast<qint64>(image.size());
+  QFile dest(args[1]);
+  if (!dest.open(QIODevice::WriteOnly) ||
+      dest.write(reinterpret_cast<const char *>(image.data()), size) != size) {
+    err << "error: cannot write " << args[1] << "\n";
+    return 1;
+  }
+  if (!report.checksumOk)
+    err << "warning: " << args[0] << ": header checksum does not match\n";
+  for (const FluxSectorIssue &i : report.issues)
+    out << fluxSectorStateName(i.state) << "\t" << i.cylinder << "/" << i.side
+        << "/" << i.sector << "\n";
+  out << report.tracks << "x" << report.sides << "x"
+      << report.sectorsPerTrack << "\t" << report.revolutions << " revs\t"
+      << report.count(FluxSectorState::Weak) << " weak\t"
+      << report.count(FluxSectorState::Bad) << " bad\t"
+      << report.count(FluxSectorState::Missing) << " missing\t" << args[1]
+      << "\n";
+  const bool lost = report.count(FluxSectorState::Bad) > 0 ||
+                    report.count(FluxSectorState::Missing) > 0;
+  return lost ? 1 : 0;
+}
+
+/** Default memory budget of the daemon's image cache. */
+constexpr uint32_t kDaemonBudgetMb = 256;
+
+int cmdDaemon(const QStringList &args, QTextStream &out, QTextStream &err) {
+  QStringList rest = args;
+  QString socketPath = QDir::temp().filePath("atari-disk-engine.sock");
+  const int socketFlag = rest.indexOf("--socket");
+  if (socketFlag >= 0) {
+    if (socketFlag + 1 >= rest.size()) {
+      err << "error: --socket needs a path\n";
+      return 2;
+    }
+    socketPath = rest[socketFlag + 1];
+    rest.removeAt(socketFlag + 1);
+    rest.removeAt(socketFlag);
+  }
+  uint32_t budgetMb = kDaemonBudgetMb;
+  if (!takeNumber(rest, "--budget-mb", budgetMb) || budgetMb == 0 ||
+      !rest.isEmpty()) {
+    err << "error: expected [--socket <path>] [--budget-mb N]\n";
+    return 2;
+  }
+
+  ImageDaemon daemon(qint64(budgetMb) * 1024 * 1024);
+  QString error;
+  if (!daemon.listen(socketPath, error)) {
+    err << "error: " << socketPath << ": " << error << "\n";
+    return 1;
+  }
+  out << "listening\t" << socketPath << "\t" << budgetMb << " MB\n";
+  out.flush();
+  return QCoreApplication::exec();
+}
+
+const Command kCommands[] = {
+    {"info", "info <image>", 1, cmdInfo},
+    {"ls", "ls <image>", 1, cmdList},
+    {"dir", "dir <image> [spec, e.g. \\AUTO\\*.PRG]", 1, cmdDir},
+    {"extract", "extract <image> <path-in-image> <host-file>", 3, cmdExtract},
+    {"sniff", "sniff <file|dir>...", 1, cmdSniff},
+    {"zip-ls", "zip-ls <archive.zip>", 1, cmdZipList},
+    {"fix-boot", "fix-boot [--dry-run] [--keep-mtime] <image|dir>...", 1,
+     cmdFixBoot},
+    {"set-oem", "set-oem <label> [--dry-run] [--keep-mtime] <image|dir>...",
+     2, cmdSetOem},
+    {"boot-scan", "boot-scan [--db signatures.txt] <image|dir>...", 1,
+     cmdBootScan},
+    {"disasm", "disasm <image> [path-in-image]", 1, cmdDisasm},
+    {"prg-scan", "prg-scan <image|dir>...", 1, cmdPrgScan},
+    {"depack", "depack <image> <path-in-image> <host-file>", 3, cmdDepack},
+    {"hash", "hash [--depacked] <image|dir>...", 1, cmdHash},
+    {"find", "find [--depacked] <text|0xHEX> <image|dir>...", 2, cmdFind},
+    {"arc-ls", "arc-ls <image> <archive-in-image>", 2, cmdArcList},
+    {"arc-extract",
+     "arc-extract <image> <archive-in-image> <member> <host-file>", 4,
+     cmdArcExtract},
+    {"sync", "sync <image> <host-dir> [dir-in-image]", 2, cmdSync},
+    {"copy", "copy <image> <path-in-image> <to-image> [dir-in-image]", 3,
+     cmdCopy},
+    {"move", "move <image> <path-in-image> <to-image> [dir-in-image]", 3,
+     cmdMove},
+    {"master", "master <manifest> <image>", 2, cmdMaster},
+    {"hfe-export", "hfe-export [--interleave N] [--skew N] <image> <out.hfe>",
+     2, cmdHfeExport},
+    {"hfe-import", "hfe-import <image.hfe> <out.st>", 2, cmdHfeImport},
+    {"scp-import", "scp-import <capture.scp> <out.st>", 2, cmdScpImport},
+    {"normalize", "normalize [--dry-run] [--forensic <dir>] <image>...", 1,
+     cmdNormalize},
+    {"fsck", "fsck <image>...", 1, cmdFsck},
+    {"daemon", "daemon [--socket <path>] [--budget-mb N]", 0, cmdDaemon},
+};
+
+const Command *findCommand(const char *name) {
+  for (const Command &c : kCommands) {
+    if (std::strcmp(c.name, name) == 0)
+      return &c;
+  }
+  return nullptr;
+}
+
+void printUsage(QTextStream &err) {
+  err << "usage: AtariDiskEngine <command> [args...]\n"
+      << "Image paths may name a zip member: archive.zip!/path/inside.st\n\n";
+  for (const Command &c : kCommands)
+    err << "  " << c.usage << "\n";
+}
+
+} // namespace
+
+// =============================================================================
+//  Entry Points
+// =============================================================================
+
+bool isCommandLineInvocation(int argc, char *argv[]) {
+  if (argc < 2)
+    return false;
+  return findCommand(argv[1]) != nullptr || std::strcmp(argv[1], "help") == 0 ||
+         std::strcmp(argv[1], "--help") == 0;
+}
+
+int runCommandLine(const QStringList &args) {
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  const QByteArray name = args.isEmpty() ? QByteArray() : args[0].toLatin1();
+  const Command *cmd = findCommand(name.constData());
+  if (!cmd) {
+    printUsage(err);
+    return args.isEmpty() || name == "help" || name == "--help" ? 0 : 2;
+  }
+
+  const QStringList rest = args.mid(1);
+  if (rest.size() < cmd->minArgs) {
+    err << "usage: AtariDiskEngine " << cmd->usage << "\n";
+    return 2;
+  }
+  return cmd->run(rest, out, err);
+}
+
+} // namespace Atari
@@ -0,0 +1,520 @@
+// =============================================================================
+//  Depacker.cpp
+//  Atari ST Toolkit — Packer Detection and Depacking
+//
+//  Packed streams are decoded backwards into an arena, the way the 68000
+//  depack stubs do it in place. Results of whole-file depacks are kept in a
+//  small LRU cache keyed by the packed file's content hash, so repeated
+//  searches and hashes over the same program only decode it once.
+// =============================================================================
+
+#include "../include/Depacker.h"
+#include "../include/GemdosProgram.h"
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace Atari {
+
+namespace {
+
+using DecodeFn = bool (*)(const uint8_t *, std::size_t, DepackArena &,
+                          DepackResult &);
+
+/**
+ * Magics that packers leave in front of their packed stream, right behind
+ * the depack stub. Ambiguous short magics are not listed. Formats without a
+ * decoder are still recognised so callers can say what they are.
+ */
+struct PackerFormat {
+  char magic[5];
+  const char *name;
+  DecodeFn decode;
+};
+
+const PackerFormat kPackerFormats[] = {
+    {"ICE!", "Pack-Ice 2.3/2.4", depackIce},
+    {"Ice!", "Pack-Ice 2.0/2.1", nullptr},
+    {"ATM5", "Atomik 3.5", nullptr},
+    {"AU5!", "Automation 5.01", nullptr},
+    {"LSD!", "Automation 2.3", nullptr},
+    {"FIRE", "Fire Packer 2.0", nullptr},
+    {"SPv3", "Speed Packer 3", nullptr},
+    {"PP20", "PowerPacker 2.0", depackPowerPacker},
+    {"RNC\x01", "Rob Northen 1", nullptr},
+    {"RNC\x02", "Rob Northen 2", nullptr},
+};
+
+const PackerFormat *formatForMagic(const uint8_t *p) {
+  for (const PackerFormat &f : kPackerFormats)
+    if (std::memcmp(p, f.magic, 4) == 0)
+      return &f;
+  return nullptr;
+}
+
+/** Depacked bytes kept by depackCached() before old entries are dropped. */
+constexpr std::size_t DEPACK_CACHE_BUDGET = 32 * 1024 * 1024;
+
+uint32_t be32(const uint8_t *p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) |
+         p[3];
+}
+
+// =============================================================================
+//  Pack-Ice 2.4
+// =============================================================================
+
+constexpr uint32_t ICE_HEADER_SIZE = 12;
+constexpr uint32_t ICE_PICTURE_SIZE = 32000;
+
+/**
+ * Pack-Ice reads its bitstream backwards one byte at a time. The byte
+ * register carries a sentinel bit, so "empty" is simply zero after a shift.
+ */
+class IceBits {
+public:
+  IceBits(const uint8_t *begin, const uint8_t *end)
+      : m_begin(begin), m_src(end) {}
+
+  uint8_t byte() {
+    if (m_src == m_begin) {
+      m_overrun = true;
+      return 0;
+    }
+    return *--m_src;
+  }
+
+  void start() { m_bits = byte(); }
+
+  int bit() {
+    int carry = m_bits >> 7;
+    m_bits = static_cast<uint8_t>(m_bits << 1);
+    if (m_bits == 0) {
+      const uint8_t b = byte();
+      m_bits = static_cast<uint8_t>((b << 1) | carry);
+      carry = b >> 7;
+    }
+    return carry;
+  }
+
+  /** Reads count + 1 bits, most significant first (the stub's dbf loop). */
+  uint32_t bits(int count) {
+    uint32_t v = 0;
+    for (int i = 0; i <= count; ++i)
+      v = (v << 1) | bit();
+    return v;
+  }
+
+  bool overrun() const { return m_overrun; }
+
+private:
+  const uint8_t *m_begin;
+  const uint8_t *m_src;
+  uint8_t m_bits = 0;
+  bool m_overrun = false;
+};
+
+/** Literal run lengths: bits to read, all-ones escape, base count - 1. */
+const uint8_t kIceLiteralBits[5] = {14, 7, 2, 1, 1};
+const uint16_t kIceLiteralMask[5] = {0x7FFF, 0xFF, 7, 3, 3};
+const uint16_t kIceLiteralBase[5] = {269, 14, 7, 4, 1};
+
+/** Match lengths - 2: extra bits to read (-1: none) and base. */
+const int8_t kIceLengthBits[5] = {9, 1, 0, -1, -1};
+const uint8_t kIceLengthBase[5] = {8, 4, 2, 1, 0};
+
+/** Match offsets for lengths above 2: bits to read and base. */
+const uint8_t kIceOffsetBits[3] = {11, 4, 7};
+const int16_t kIceOffsetBase[3] = {0x11F, -1, 0x1F};
+
+/** Undoes Pack-Ice's picture mode: bitplane words were packed chunkwise. */
+void iceUnpicture(uint8_t *end) {
+  uint8_t *p = end;
+  uint16_t planes[4] = {0, 0, 0, 0};
+  for (uint32_t group = 0; group < ICE_PICTURE_SIZE / 8; ++group) {
+    for (int w = 0; w < 4; ++w) {
+      p -= 2;
+      uint16_t word = static_cast<uint16_t>((p[0] << 8) | p[1]);
+      for (int i = 0; i < 4; ++i) {
+        for (uint16_t &plane : planes) {
+          plane = static_cast<uint16_t>((plane << 1) | (word >> 15));
+          word = static_cast<uint16_t>(word << 1);
+        }
+      }
+    }
+    for (int i = 0; i < 4; ++i) {
+      p[2 * i] = static_cast<uint8_t>(planes[i] >> 8);
+      p[2 * i + 1] = static_cast<uint8_t>(planes[i]);
+    }
+  }
+}
+
+// =============================================================================
+//  PowerPacker 2.0
+// =============================================================================
+
+/** "PP20", then the offset widths for the four match length codes. */
+constexpr uint32_t PP_HEADER_SIZE = 8;
+/** Depacked size (24 bits, big-endian), then bits to skip at the start. */
+constexpr uint32_t PP_TRAILER_SIZE = 4;
+constexpr int PP_MAX_OFFSET_BITS = 16;
+
+/**
+ * PowerPacker's bitstream also runs backwards, but low bit first: each byte
+ * taken from the end is stacked above the bits still buffered, and values
+ * are assembled most significant bit first from the bottom of the buffer.
+ */
+class PpBits {
+public:
+  PpBits(const uint8_t *begin, const uint8_t *end)
+      : m_begin(begin), m_src(end) {}
+
+  uint32_t bits(int count) {
+    while (m_left < count) {
+      if (m_src == m_begin) {
+        m_overrun = true;
+        return 0;
+      }
+      m_buffer |= static_cast<uint64_t>(*--m_src) << m_left;
+      m_left += 8;
+    }
+    uint32_t v = 0;
+    for (int i = 0; i < count; ++i) {
+      v = (v << 1) | static_cast<uint32_t>(m_buffer & 1);
+      m_buffer >>= 1;
+    }
+    m_left -= count;
+    return v;
+  }
+
+  bool overrun() const { return m_overrun; }
+
+private:
+  const uint8_t *m_begin;
+  const uint8_t *m_src;
+  uint64_t m_buffer = 0;
+  int m_left = 0;
+  bool m_overrun = false;
+};
+
+} // namespace
+
+const char *packerNameForMagic(const uint8_t *p) {
+  const PackerFormat *f = formatForMagic(p);
+  return f ? f->name : nullptr;
+}
+
+bool depackIce(const uint8_t *stream, std::size_t available,
+               DepackArena &arena, DepackResult &result) {
+  if (available < ICE_HEADER_SIZE) {
+    result.error = "truncated header";
+    return false;
+  }
+  const uint32_t packedSize = be32(stream + 4);
+  const uint32_t size = be32(stream + 8);
+  if (packedSize < ICE_HEADER_SIZE || packedSize > available) {
+    result.error = "packed length exceeds file";
+    return false;
+  }
+  if (size == 0 || size > DEPACK_SIZE_LIMIT) {
+    result.error = "implausible depacked length";
+    return false;
+  }
+
+  uint8_t *const out = arena.output(size);
+  uint8_t *dst = out + size;
+  IceBits in(stream + ICE_HEADER_SIZE, stream + packedSize);
+  in.start();
+
+  for (;;) {
+    // Literal run.
+    if (in.bit()) {
+      uint32_t count = 0;
+      if (in.bit()) {
+        int i = 4;
+        for (;;) {
+          count = in.bits(kIceLiteralBits[i]);
+          if (count != kIceLiteralMask[i] || i == 0)
+            break;
+          --i;
+        }
+        count += kIceLiteralBase[i];
+      }
+      if (count + 1 > static_cast<uint32_t>(dst - out)) {
+        result.error = "literal run overflows output";
+        return false;
+      }
+      for (uint32_t k = 0; k <= count; ++k)
+        *--dst = in.byte();
+    }
+    if (in.overrun()) {
+      result.error = "packed stream ends early";
+      return false;
+    }
+    if (dst == out)
+      break;
+
+    // Back-reference.
+    int lengthClass = 3;
+    while (lengthClass >= 0 && in.bit())
+      --lengthClass;
+    const int li = lengthClass + 1;
+    const int length = kIceLengthBase[li] +
+                       (kIceLengthBits[li] >= 0
+                            ? static_cast<int>(in.bits(kIceLengthBits[li]))
+                            : 0);
+
+    int offset;
+    if (length == 0) {
+      const bool far = in.bit();
+      offset = static_cast<int>(in.bits(far ? 8 : 5)) + (far ? 0x3F : -1);
+    } else {
+      int offsetClass = 1;
+      while (offsetClass >= 0 && in.bit())
+        --offsetClass;
+      const int oi = offsetClass + 1;
+      offset = static_cast<int>(in.bits(kIceOffsetBits[oi])) +
+               kIceOffsetBase[oi];
+      if (offset < 0)
+        offset -= length; // Repeat of the byte just written
+    }
+
+    const int count = length + 2;
+    const uint8_t *src = dst + count + offset;
+    if (count > dst - out || src > out + size) {
+      result.error = "match outside output";
+      return false;
+    }
+    for (int k = 0; k < count; ++k)
+      *--dst = *--src;
+  }
+
+  if (in.bit()) {
+    if (size < ICE_PICTURE_SIZE) {
+      result.error = "picture mode on short output";
+      return false;
+    }
+    iceUnpicture(out + size);
+  }
+
+  result.data = out;
+  result.size = size;
+  return true;
+}
+
+bool depackPowerPacker(const uint8_t *stream, std::size_t available,
+                       DepackArena &arena, DepackResult &result) {
+  if (available < PP_HEADER_SIZE + PP_TRAILER_SIZE) {
+    result.error = "truncated header";
+    return false;
+  }
+  // No packed length in the header: the stream runs to the end of the file.
+  const uint8_t *trailer = stream + available - PP_TRAILER_SIZE;
+  const uint32_t size = (trailer[0] << 16) | (trailer[1] << 8) | trailer[2];
+  const int skip = trailer[3];
+  const uint8_t *widths = stream + 4;
+  if (size == 0 || size > DEPACK_SIZE_LIMIT) {
+    result.error = "implausible depacked length";
+    return false;
+  }
+  if (skip > 32 || *std::max_element(widths, widths + 4) > PP_MAX_OFFSET_BITS) {
+    result.error = "damaged header";
+    return false;
+  }
+
+  uint8_t *const out = arena.output(size);
+  uint8_t *dst = out + size;
+  PpBits in(stream + PP_HEADER_SIZE, trailer);
+  in.bits(skip);
+
+  while (dst != out) {
+    // A 0 bit puts a literal run in front of the match.
+    if (in.bits(1) == 0) {
+      uint32_t count = 1;
+      uint32_t chunk;
+      do {
+        chunk = in.bits(2);
+        count += chunk;
+      } while (chunk == 3);
+      if (count > static_cast<uint32_t>(dst - out)) {
+        result.error = "literal run overflows output";
+        return false;
+      }
+      for (uint32_t k = 0; k < count; ++k)
+        *--dst = static_cast<uint8_t>(in.bits(8));
+      if (in.overrun()) {
+        result.error = "packed stream ends early";
+        return false;
+      }
+      if (dst == out)
+        break;
+    }
+
+    // Back-reference: codes 0-2 are lengths 2-4, code 3 is 5 and up.
+    const uint32_t code = in.bits(2);
+    int width = widths[code];
+    uint32_t count = code + 2;
+    if (code == 3 && in.bits(1) == 0)
+      width = 7;
+    const uint32_t offset = in.bits(width);
+    if (code == 3) {
+      uint32_t chunk;
+      do {
+        chunk = in.bits(3);
+        count += chunk;
+      } while (chunk == 7);
+    }
+    if (in.overrun()) {
+      result.error = "packed stream ends early";
+      return false;
+    }
+    if (count > static_cast<uint32_t>(dst - out) ||
+        offset >= static_cast<uint32_t>(out + size - dst)) {
+      result.error = "match outside output";
+      return false;
+    }
+    for (uint32_t k = 0; k < count; ++k) {
+      const uint8_t b = dst[offset];
+      *--dst = b;
+    }
+  }
+
+  result.data = out;
+  result.size = size;
+  return true;
+}
+
+// =============================================================================
+//  Detection
+// =============================================================================
+
+DepackResult depack(const FileView &file, DepackArena &arena) {
+  DepackResult result;
+  const uint32_t size = file.size();
+  if (size < 4)
+    return result;
+
+  uint8_t magic[4];
+  file.read(0, magic, 4);
+  const PackerFormat *format = formatForMagic(magic);
+  uint32_t offset = 0;
+  uint32_t end = size;
+
+  if (!format) {
+    PrgHeader header;
+    if (!parsePrgHeader(file, header) ||
+        !detectPrgPacker(file, header, &offset))
+      return result;
+    file.read(offset, magic, 4);
+    format = formatForMagic(magic);
+    // The stream ends with the DATA segment; symbols and relocation
+    // follow it, and PowerPacker looks for its trailer at the very end.
+    end = std::min(size, header.dataOffset() + header.dataSize);
+  }
+
+  result.packed = true;
+  result.format = format->name;
+  result.magicOffset = offset;
+  if (!format->decode) {
+    result.error = "no depacker for this format";
+    return result;
+  }
+
+  // Decode straight from the image when the stream is in one extent.
+  const uint32_t available = end > offset ? end - offset : 0;
+  const uint8_t *stream = file.contiguous(offset, available);
+  if (!stream) {
+    uint8_t *copy = arena.scratch(available);
+    file.read(offset, copy, available);
+    stream = copy;
+  }
+  result.ok = format->decode(stream, available, arena, result);
+  return result;
+}
+
+// =============================================================================
+//  Cache
+// =============================================================================
+
+namespace {
+
+class DepackCache {
+public:
+  std::shared_ptr<const DepackedFile> find(uint64_t key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+      return nullptr;
+    m_order.splice(m_order.begin(), m_order, it->second.second);
+    return it->second.first;
+  }
+
+  void insert(uint64_t key, std::shared_ptr<const DepackedFile> file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.count(key))
+      return; // Another thread decoded the same content first
+    m_bytes += file->data.size();
+    m_order.push_front(key);
+    m_entries.emplace(key, std::make_pair(std::move(file), m_order.begin()));
+
+    while (m_bytes > DEPACK_CACHE_BUDGET && m_order.size() > 1) {
+      auto victim = m_entries.find(m_order.back());
+      m_bytes -= victim->second.first->data.size();
+      m_entries.erase(victim);
+      m_order.pop_back();
+    }
+  }
+
+private:
+  using Slot = std::pair<std::shared_ptr<const DepackedFile>,
+                         std::list<uint64_t>::iterator>;
+
+  std::mutex m_mutex;
+  std::list<uint64_t> m_order; /**< Most recently used first. */
+  std::unordered_map<uint64_t, Slot> m_entries;
+  std::size_t m_bytes = 0;
+};
+
+DepackCache &depackCache() {
+  static DepackCache cache;
+  return cache;
+}
+
+} // namespace
+
+std::shared_ptr<const DepackedFile> depackCached(const FileView &file) {
+  // Cheap magic checks first: only packed files pay for hashing.
+  thread_local DepackArena arena;
+  uint8_t magic[4] = {0, 0, 0, 0};
+  file.read(0, magic, 4);
+  PrgHeader header;
+  const bool candidate =
+      formatForMagic(magic) ||
+      (parsePrgHeader(file, header) && detectPrgPacker(file, header));
+  if (!candidate)
+    return std::make_shared<DepackedFile>();
+
+  const uint64_t key = file.contentHash() ^ (uint64_t(file.size()) << 32);
+  if (auto hit = depackCache().find(key))
+    return hit;
+
+  const DepackResult r = depack(file, arena);
+  auto entry = std::make_shared<DepackedFile>();
+  entry->packed = r.packed;
+  entry->ok = r.ok;
+  entry->format = r.format;
+  entry->error = r.error;
+  if (r.ok) {
+    entry->data.assign(r.data, r.data + r.size);
+    entry->contentHash =
+        FileView::fromBuffer(entry->data.data(), entry->data.size())
+            .contentHash();
+  }
+  depackCache().insert(key, entry);
+  return entry;
+}
+
+} // namespace Atari
@@ -0,0 +1,464 @@
+// =============================================================================
+//  DiskMaster.cpp
+//  Atari ST Toolkit — Manifest Mastering
+//
+//  Images are always built from a zeroed buffer with FatVolume. Clusters
+//  the previous build used are claimed back before anything is allocated,
+//  so unchanged files and directories stay put; everything else is placed
+//  first-fit in manifest order.
+// =============================================================================
+
+#include "../include/DiskMaster.h"
+#include "../include/AtariDiskEngine.h"
+#include "../include/FatVolume.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint32_t SECTORS_PER_CLUSTER = 2;
+constexpr uint32_t ROOT_ENTRIES = 112;
+/** TOS formats every floppy with 5-sector FATs; larger disks need more. */
+constexpr uint32_t MIN_SECTORS_PER_FAT = 5;
+
+bool parseAttributes(const QString &letters, uint8_t &attributes) {
+  attributes = 0;
+  for (const QChar c : letters.toLower()) {
+    switch (c.toLatin1()) {
+    case 'r':
+      attributes |= ATTR_READ_ONLY;
+      break;
+    case 'h':
+      attributes |= ATTR_HIDDEN;
+      break;
+    case 's':
+      attributes |= ATTR_SYSTEM;
+      break;
+    case 'a':
+      attributes |= ATTR_ARCHIVE;
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+QString normalizePath(QString path) {
+  path.replace('\\', '/');
+  while (path.startsWith('/'))
+    path.remove(0, 1);
+  return path;
+}
+
+uint32_t sectorsPerFat(uint32_t totalSectors) {
+  const uint32_t rootSectors = ROOT_ENTRIES * DIRENT_SIZE / SECTOR_SIZE;
+  for (uint32_t spf = MIN_SECTORS_PER_FAT;; ++spf) {
+    const uint32_t fixed = 1 + 2 * spf + rootSectors;
+    const uint32_t clusters =
+        totalSectors > fixed ? (totalSectors - fixed) / SECTORS_PER_CLUSTER
+                             : 0;
+    const uint32_t fatBytes = (clusters + 2) * 3 / 2 + 1;
+    if ((fatBytes + SECTOR_SIZE - 1) / SECTOR_SIZE <= spf)
+      return spf;
+  }
+}
+
+void writeBootSector(const MasterManifest &m, const QByteArray &custom,
+                     uint8_t *b) {
+  if (!custom.isEmpty())
+    std::memcpy(b, custom.constData(), SECTOR_SIZE);
+
+  if (!m.oem.isEmpty()) {
+    const QByteArray oem = m.oem.toLatin1().leftJustified(6, ' ', true);
+    std::memcpy(b + 2, oem.constData(), 6);
+  }
+  b[0x08] = static_cast<uint8_t>(m.serial);
+  b[0x09] = static_cast<uint8_t>(m.serial >> 8);
+  b[0x0A] = static_cast<uint8_t>(m.serial >> 16);
+
+  const uint32_t total = m.sides * m.tracks * m.sectorsPerTrack;
+  writeLE16(b + 0x0B, SECTOR_SIZE);
+  b[0x0D] = SECTORS_PER_CLUSTER;
+  writeLE16(b + 0x0E, 1); // Reserved sectors
+  b[0x10] = 2;            // FAT copies
+  writeLE16(b + 0x11, ROOT_ENTRIES);
+  writeLE16(b + 0x13, static_cast<uint16_t>(total));
+  b[0x15] = m.sides == 1 ? 0xF8 : 0xF9;
+  writeLE16(b + 0x16, static_cast<uint16_t>(sectorsPerFat(total)));
+  writeLE16(b + 0x18, static_cast<uint16_t>(m.sectorsPerTrack));
+  writeLE16(b + 0x1A, static_cast<uint16_t>(m.sides));
+  writeLE16(b + 0x1C, 0); // Hidden sectors
+
+  if (m.executable)
+    AtariDiskEngine::fixBootChecksum(b);
+}
+
+/** Chain and content of a file in the previous build. */
+struct PreviousFile {
+  std::vector<uint16_t> clusters;
+  uint64_t hash = 0;
+  uint32_t size = 0;
+  bool taken = false;
+};
+
+/** Where the previous build put things, by upper-case 8.3 path. */
+struct PreviousLayout {
+  QHash<QString, std::vector<uint16_t>> dirs;
+  QHash<QString, PreviousFile> files;
+  /** Paths of files by content, in directory order. */
+  std::map<std::pair<uint64_t, uint32_t>, std::vector<QString>> byContent;
+};
+
+bool sameGeometry(const FatGeometry &a, const FatGeometry &b) {
+  return a.sectorsPerCluster == b.sectorsPerCluster &&
+         a.reservedSectors == b.reservedSectors && a.fatCount == b.fatCount &&
+         a.sectorsPerFat == b.sectorsPerFat &&
+         a.rootEntries == b.rootEntries && a.clusterCount == b.clusterCount;
+}
+
+/** @return Layout of the previous image, or nothing if it does not match. */
+PreviousLayout readPreviousLayout(const std::vector<uint8_t> &previous,
+                                  const FatGeometry &geometry) {
+  PreviousLayout layout;
+  std::vector<uint8_t> copy(previous);
+  FatVolume volume(copy);
+  if (!volume.isValid() || !sameGeometry(volume.geometry(), geometry))
+    return layout;
+
+  std::vector<bool> seen(geometry.clusterCount + 2);
+  std::vector<std::pair<uint16_t, QString>> todo{{0, QString()}};
+  for (std::size_t d = 0; d < todo.size(); ++d) {
+    const QString prefix = todo[d].second;
+    for (uint32_t slot : volume.liveEntries(todo[d].first)) {
+      const QString path =
+          prefix + QString::fromStdString(FatVolume::fromName83(&copy[slot]));
+      const uint16_t start = volume.startCluster(slot);
+      if (!(copy[slot + 11] & ATTR_DIRECTORY)) {
+        PreviousFile file;
+        file.clusters = volume.chain(start);
+        const FileView view = volume.fileView(slot);
+        file.hash = view.contentHash();
+        file.size = view.size();
+        layout.byContent[{file.hash, file.size}].push_back(path);
+        layout.files.insert(path, std::move(file));
+      } else if (start >= 2 && start < seen.size() && !seen[start]) {
+        seen[start] = true;
+        layout.dirs.insert(path, volume.chain(start));
+        todo.push_back({start, path + "/"});
+      }
+    }
+  }
+  return layout;
+}
+
+/** @return The first count parts of a path as upper-case 8.3 names. */
+QString layoutPath(const QStringList &parts, int count) {
+  QStringList names;
+  for (int i = 0; i < count; ++i) {
+    uint8_t name83[11];
+    if (!FatVolume::toName83(parts[i].toStdString(), name83))
+      return QString();
+    names << QString::fromStdString(FatVolume::fromName83(name83));
+  }
+  return names.join('/');
+}
+
+} // namespace
+
+// =============================================================================
+//  Manifest Parsing
+// =============================================================================
+
+bool MasterManifest::load(const QString &path, MasterManifest &manifest,
+                          QString &error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  MasterManifest m;
+  const QDir base = QFileInfo(path).absoluteDir();
+  QTextStream in(&file);
+  int lineNo = 0;
+  while (!in.atEnd()) {
+    ++lineNo;
+    QString line = in.readLine();
+    const int comment = line.indexOf('#');
+    if (comment >= 0)
+      line.truncate(comment);
+    const QStringList f = line.simplified().split(' ', Qt::SkipEmptyParts);
+    if (f.isEmpty())
+      continue;
+
+    const QString key = f[0].toLower();
+    QString why;
+    bool ok = true;
+    if (key == "geometry" && f.size() == 4) {
+      bool s, t, n;
+      m.sides = f[1].toUInt(&s);
+      m.tracks = f[2].toUInt(&t);
+      m.sectorsPerTrack = f[3].toUInt(&n);
+      const uint32_t total = m.sides * m.tracks * m.sectorsPerTrack;
+      ok = s && t && n && m.sides >= 1 && m.sides <= 2 && m.tracks >= 1 &&
+           m.tracks <= 86 && m.sectorsPerTrack >= 1 &&
+           m.sectorsPerTrack <= 63 && total > 64;
+      why = "bad geometry";
+    } else if (key == "oem" && f.size() >= 2) {
+      m.oem = f.mid(1).join(' ');
+      ok = m.oem.size() <= 6;
+      why = "OEM field is 6 characters at most";
+    } else if (key == "label" && f.size() >= 2) {
+      m.volumeLabel = f.mid(1).join(' ').toUpper();
+      ok = m.volumeLabel.size() <= 11;
+      why = "volume labels are 11 characters at most";
+    } else if (key == "boot" && (f.size() == 2 || f.size() == 3)) {
+      m.bootSource = base.absoluteFilePath(f[1]);
+      m.executable = f.size() == 3 && f[2].toLower() == "exec";
+      ok = f.size() == 2 || m.executable;
+      why = "expected \"boot <file> [exec]\"";
+    } else if (key == "serial" && f.size() == 2) {
+      m.serial = f[1].toUInt(&ok, 0);
+      ok = ok && m.serial <= 0xFFFFFF;
+      why = "serial must fit 24 bits";
+    } else if (key == "date" && (f.size() == 2 || f.size() == 3)) {
+      const QDateTime when = QDateTime::fromString(
+          f[1] + " " + (f.size() == 3 ? f[2] : QString("00:00:00")),
+          "yyyy-MM-dd HH:mm:ss");
+      ok = when.isValid() && when.date().year() >= 1980 &&
+           when.date().year() <= 2107;
+      why = "expected \"date YYYY-MM-DD [HH:MM:SS]\" from 1980 to 2107";
+      if (ok) {
+        const QDate d = when.date();
+        const QTime t = when.time();
+        m.dosDate = static_cast<uint16_t>(((d.year() - 1980) << 9) |
+                                          (d.month() << 5) | d.day());
+        m.dosTime = static_cast<uint16_t>(
+            (t.hour() << 11) | (t.minute() << 5) | (t.second() / 2));
+      }
+    } else if ((key == "dir" && (f.size() == 2 || f.size() == 3)) ||
+               (key == "file" && (f.size() == 3 || f.size() == 4))) {
+      MasterEntry e;
+      e.path = normalizePath(f[1]);
+      e.line = lineNo;
+      const bool isFile = key == "file";
+      if (isFile)
+        e.source = base.absoluteFilePath(f[2]);
+      const int attrField = isFile ? 3 : 2;
+      e.attributes = isFile ? ATTR_ARCHIVE : 0;
+      ok = !e.path.isEmpty() && (f.size() <= attrField ||
+                                 parseAttributes(f[attrField], e.attributes));
+      why = e.path.isEmpty() ? "empty path" : "attributes are r, h, s and a";
+      m.entries.push_back(e);
+    } else {
+      ok = false;
+      why = "unknown or malformed directive \"" + f[0] + "\"";
+    }
+
+    if (!ok) {
+      error = QString("line %1: %2").arg(lineNo).arg(why);
+      return false;
+    }
+  }
+
+  manifest = std::move(m);
+  return true;
+}
+
+// =============================================================================
+//  Building
+// =============================================================================
+
+bool masterImage(const MasterManifest &m, const std::vector<uint8_t> &previous,
+                 std::vector<uint8_t> &image, std::vector<MasterFile> &files,
+                 QString &error) {
+  files.clear();
+  QByteArray boot;
+  if (!m.bootSource.isEmpty()) {
+    QFile f(m.bootSource);
+    if (!f.open(QIODevice::ReadOnly) ||
+        (boot = f.readAll()).size() != static_cast<int>(SECTOR_SIZE)) {
+      error = "boot sector must be a readable 512-byte file: " + m.bootSource;
+      return false;
+    }
+  }
+
+  std::vector<uint8_t> out(
+      static_cast<std::size_t>(m.sides) * m.tracks * m.sectorsPerTrack *
+          SECTOR_SIZE,
+      0);
+  writeBootSector(m, boot, out.data());
+  FatVolume volume(out);
+  if (!volume.isValid()) {
+    error = "geometry does not give a usable FAT12 volume";
+    return false;
+  }
+  const FatGeometry &g = volume.geometry();
+  for (uint32_t fat = 0; fat < g.fatCount; ++fat) {
+    uint8_t *p =
+        &out[(g.reservedSectors + fat * g.sectorsPerFat) * SECTOR_SIZE];
+    p[0] = out[0x15]; // Media descriptor
+    p[1] = p[2] = 0xFF;
+  }
+
+  auto fail = [&error](const MasterEntry &e, const QString &why) {
+    error = QString("line %1: %2: %3").arg(e.line).arg(e.path, why);
+    return false;
+  };
+
+  std::vector<QByteArray> contents(m.entries.size());
+  for (std::size_t i = 0; i < m.entries.size(); ++i) {
+    const MasterEntry &e = m.entries[i];
+    if (e.isDirectory())
+      continue;
+    QFile source(e.source);
+    if (!source.open(QIODevice::ReadOnly))
+      return fail(e, "cannot read " + e.source);
+    contents[i] = source.readAll();
+  }
+
+  // Claim back the previous build's clusters before allocating anything:
+  // unchanged files by content (wherever they were), then directories by
+  // path, then changed files by path, up to the clusters they still need.
+  // Only new and grown files are left to first-fit allocation.
+  PreviousLayout old = readPreviousLayout(previous, g);
+  std::vector<uint16_t> pinned(m.entries.size(), 0);
+  QHash<QString, uint16_t> pinnedDirs;
+  for (std::size_t i = 0; i < m.entries.size(); ++i) {
+    const QByteArray &data = contents[i];
+    if (m.entries[i].isDirectory() || data.isEmpty())
+      continue;
+    const uint64_t hash =
+        FileView::fromBuffer(reinterpret_cast<const uint8_t *>(data.data()),
+                             data.size())
+            .contentHash();
+    const auto same =
+        old.byContent.find({hash, static_cast<uint32_t>(data.size())});
+    if (same == old.byContent.end())
+      continue;
+    for (const QString &path : same->second) {
+      PreviousFile &file = old.files[path];
+      if (!file.taken && volume.claimChain(file.clusters)) {
+        file.taken = true;
+        pinned[i] = file.clusters[0];
+        break;
+      }
+    }
+  }
+  for (const MasterEntry &e : m.entries) {
+    const QStringList parts = e.path.split('/', Qt::SkipEmptyParts);
+    const int dirParts = e.isDirectory() ? parts.size() : parts.size() - 1;
+    for (int i = 1; i <= dirParts; ++i) {
+      const QString path = layoutPath(parts, i);
+      const auto dir = old.dirs.constFind(path);
+      if (dir != old.dirs.constEnd() && !pinnedDirs.contains(path) &&
+          volume.claimChain(*dir))
+        pinnedDirs.insert(path, dir->front());
+    }
+  }
+  for (std::size_t i = 0; i < m.entries.size(); ++i) {
+    const MasterEntry &e = m.entries[i];
+    if (e.isDirectory() || pinned[i] != 0)
+      continue;
+    const QStringList parts = e.path.split('/', Qt::SkipEmptyParts);
+    const auto file = old.files.find(layoutPath(parts, parts.size()));
+    if (file == old.files.end() || file->taken)
+      continue;
+    const uint32_t needed = static_cast<uint32_t>(
+        (contents[i].size() + g.clusterBytes() - 1) / g.clusterBytes());
+    std::vector<uint16_t> clusters = file->clusters;
+    clusters.resize(std::min<std::size_t>(clusters.size(), needed));
+    if (!clusters.empty() && volume.claimChain(clusters)) {
+      file->taken = true;
+      pinned[i] = clusters[0];
+    }
+  }
+
+  if (!m.volumeLabel.isEmpty()) {
+    const QByteArray label =
+        m.volumeLabel.toLatin1().leftJustified(11, ' ', true);
+    const uint32_t slot = volume.createFile(
+        0, reinterpret_cast<const uint8_t *>(label.constData()));
+    volume.setAttributes(slot, ATTR_VOLUME);
+    volume.setTimestamp(slot, m.dosTime, m.dosDate);
+  }
+
+  // Directory clusters by upper-case 8.3 path; "" is the root.
+  QHash<QString, uint16_t> dirs;
+  dirs.insert(QString(), 0);
+
+  for (std::size_t index = 0; index < m.entries.size(); ++index) {
+    const MasterEntry &e = m.entries[index];
+    const QStringList parts = e.path.toUpper().split('/', Qt::SkipEmptyParts);
+    uint16_t parent = 0;
+    QString key;
+    for (int i = 0; i < parts.size(); ++i) {
+      uint8_t name83[11];
+      if (!FatVolume::toName83(parts[i].toStdString(), name83))
+        return fail(e, "\"" + parts[i] + "\" is not a valid 8.3 name");
+
+      const bool last = i + 1 == parts.size();
+      key += (key.isEmpty() ? "" : "/") +
+             QString::fromStdString(FatVolume::fromName83(name83));
+      const auto known = dirs.constFind(key);
+      if (!last && known != dirs.constEnd()) {
+        parent = *known;
+        continue;
+      }
+      if (volume.findEntry(parent, name83) != 0)
+        return fail(e, "listed twice");
+
+      if (!last || e.isDirectory()) {
+        const uint32_t slot =
+            volume.createDirectory(parent, name83, pinnedDirs.value(key, 0));
+        if (slot == 0)
+          return fail(e, "disk or directory full");
+        volume.setAttributes(slot, static_cast<uint8_t>(
+                                       ATTR_DIRECTORY |
+                                       (last ? e.attributes : 0)));
+        volume.setTimestamp(slot, m.dosTime, m.dosDate);
+        parent = volume.startCluster(slot);
+        dirs.insert(key, parent);
+        continue;
+      }
+
+      const QByteArray &data = contents[index];
+      const uint32_t slot = volume.createFile(parent, name83);
+      if (slot != 0 && pinned[index] != 0)
+        volume.setStartCluster(slot, pinned[index]);
+      if (slot == 0 ||
+          !volume.writeFile(slot,
+                            reinterpret_cast<const uint8_t *>(data.constData()),
+                            static_cast<uint32_t>(data.size())))
+        return fail(e, "disk or directory full");
+      volume.setAttributes(slot, e.attributes);
+      volume.setTimestamp(slot, m.dosTime, m.dosDate);
+
+      MasterFile file;
+      file.path = e.path;
+      const FileView view = volume.fileView(slot);
+      for (const FileExtent &x : view.extents()) {
+        for (uint32_t s = x.offset / SECTOR_SIZE;
+             s * SECTOR_SIZE < x.offset + x.length; ++s)
+          file.sectors.push_back(s);
+      }
+      files.push_back(std::move(file));
+    }
+  }
+
+  image = std::move(out);
+  return true;
+}
+
+} // namespace Atari
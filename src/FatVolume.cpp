@@ -0,0 +1,422 @@
+// =============================================================================
+//  FatVolume.cpp
+//  Atari ST Toolkit — FAT12 Writer
+//
+//  All writes go through write()/fill(), which skip identical bytes and
+//  report the rest, so callers can tell exactly which sectors changed.
+//  Allocation is first-fit from cluster 2: the same operations on the same
+//  image always produce the same layout.
+// =============================================================================
+
+#include "../include/FatVolume.h"
+#include "../include/DiskBytes.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint32_t SLOT_SIZE = 32;
+constexpr uint8_t SLOT_FREE = 0x00;
+constexpr uint8_t SLOT_DELETED = 0xE5;
+/** Upper bound on a directory chain; a floppy never needs more. */
+constexpr std::size_t MAX_DIR_CLUSTERS = 64;
+
+bool isValidNameChar(unsigned char c) {
+  if (std::isupper(c) || std::isdigit(c))
+    return true;
+  return std::strchr("!#$%&'()-@^_`{}~", c) != nullptr && c != '\0';
+}
+
+bool isDotEntry(const uint8_t *slot) { return slot[0] == '.'; }
+
+} // namespace
+
+bool readFatGeometry(const uint8_t *boot, std::size_t imageSize,
+                     FatGeometry &g) {
+  if (imageSize < SECTOR_SIZE || readLE16(boot + 0x0B) != SECTOR_SIZE)
+    return false;
+
+  g.sectorsPerCluster = boot[0x0D];
+  g.reservedSectors = readLE16(boot + 0x0E);
+  g.fatCount = boot[0x10];
+  g.rootEntries = readLE16(boot + 0x11);
+  g.totalSectors = readLE16(boot + 0x13);
+  g.sectorsPerFat = readLE16(boot + 0x16);
+
+  const uint32_t spc = g.sectorsPerCluster;
+  if (spc == 0 || (spc & (spc - 1)) != 0 || g.reservedSectors == 0 ||
+      g.fatCount == 0 || g.fatCount > 2 || g.sectorsPerFat == 0 ||
+      g.rootEntries == 0 || g.rootEntries % 16 != 0)
+    return false;
+
+  g.rootSector = g.reservedSectors + g.fatCount * g.sectorsPerFat;
+  g.dataSector = g.rootSector + g.rootEntries * SLOT_SIZE / SECTOR_SIZE;
+  // Images are sometimes cut short; only clusters that exist are usable.
+  const uint32_t sectors = std::min<uint32_t>(
+      g.totalSectors, static_cast<uint32_t>(imageSize / SECTOR_SIZE));
+  if (sectors <= g.dataSector)
+    return false;
+  g.clusterCount = (sectors - g.dataSector) / spc;
+
+  const uint32_t fatCapacity = g.sectorsPerFat * SECTOR_SIZE * 2 / 3;
+  g.clusterCount = std::min(g.clusterCount, fatCapacity - 2);
+  return g.clusterCount > 0 && g.clusterCount + 2 < 0xFF0;
+}
+
+FatVolume::FatVolume(std::vector<uint8_t> &image, uint32_t base,
+                     WriteHook onWrite)
+    : m_image(image), m_base(base), m_onWrite(std::move(onWrite)) {
+  m_valid = base < image.size() &&
+            readFatGeometry(image.data() + base, image.size() - base, m_geo);
+}
+
+// =============================================================================
+//  FAT
+// =============================================================================
+
+uint16_t FatVolume::next(uint16_t cluster) const {
+  if (cluster < 2 || cluster >= m_geo.clusterCount + 2)
+    return FAT_END_OF_CHAIN;
+  const uint8_t *fat =
+      m_image.data() + m_base + m_geo.reservedSectors * SECTOR_SIZE;
+  const uint16_t raw = readLE16(fat + cluster * 3 / 2);
+  return (cluster & 1) ? (raw >> 4) : (raw & 0x0FFF);
+}
+
+void FatVolume::setNext(uint16_t cluster, uint16_t value) {
+  const uint32_t at = cluster * 3 / 2;
+  for (uint32_t f = 0; f < m_geo.fatCount; ++f) {
+    const uint32_t offset =
+        m_base + (m_geo.reservedSectors + f * m_geo.sectorsPerFat) *
+                     SECTOR_SIZE + at;
+    uint16_t raw = readLE16(&m_image[offset]);
+    raw = (cluster & 1) ? static_cast<uint16_t>((raw & 0x000F) | (value << 4))
+                        : static_cast<uint16_t>((raw & 0xF000) | value);
+    writeLE16At(offset, raw);
+  }
+}
+
+std::vector<uint16_t> FatVolume::chain(uint16_t start) const {
+  std::vector<uint16_t> clusters;
+  std::vector<bool> seen(m_geo.clusterCount + 2);
+  for (uint16_t c = start; c >= 2 && c < m_geo.clusterCount + 2 && !seen[c];
+       c = next(c)) {
+    seen[c] = true;
+    clusters.push_back(c);
+  }
+  return clusters;
+}
+
+uint32_t FatVolume::clusterOffset(uint16_t cluster) const {
+  return m_base +
+         (m_geo.dataSector + (cluster - 2) * m_geo.sectorsPerCluster) *
+             SECTOR_SIZE;
+}
+
+uint32_t FatVolume::freeClusters() const {
+  uint32_t count = 0;
+  for (uint16_t c = 2; c < m_geo.clusterCount + 2; ++c)
+    count += next(c) == 0;
+  return count;
+}
+
+std::vector<uint16_t> FatVolume::allocate(uint32_t count) {
+  std::vector<uint16_t> found;
+  for (uint16_t c = 2; c < m_geo.clusterCount + 2 && found.size() < count;
+       ++c) {
+    if (next(c) == 0)
+      found.push_back(c);
+  }
+  if (found.size() < count)
+    found.clear();
+  return found;
+}
+
+bool FatVolume::claimChain(const std::vector<uint16_t> &clusters) {
+  std::vector<bool> seen(m_geo.clusterCount + 2);
+  for (uint16_t c : clusters) {
+    if (c < 2 || c >= m_geo.clusterCount + 2 || seen[c] || next(c) != 0)
+      return false;
+    seen[c] = true;
+  }
+  for (std::size_t k = 0; k < clusters.size(); ++k)
+    setNext(clusters[k],
+            k + 1 < clusters.size() ? clusters[k + 1] : FAT_END_OF_CHAIN);
+  return true;
+}
+
+// =============================================================================
+//  Directories
+// =============================================================================
+
+std::vector<uint32_t> FatVolume::directorySlots(uint16_t dirCluster) const {
+  std::vector<uint32_t> offsets;
+  if (dirCluster == 0) {
+    const uint32_t root = m_base + m_geo.rootSector * SECTOR_SIZE;
+    for (uint32_t i = 0; i < m_geo.rootEntries; ++i)
+      offsets.push_back(root + i * SLOT_SIZE);
+    return offsets;
+  }
+  const std::vector<uint16_t> clusters = chain(dirCluster);
+  const uint32_t perCluster = m_geo.clusterBytes() / SLOT_SIZE;
+  for (std::size_t k = 0; k < clusters.size() && k < MAX_DIR_CLUSTERS; ++k) {
+    const uint32_t base = clusterOffset(clusters[k]);
+    for (uint32_t i = 0; i < perCluster; ++i)
+      offsets.push_back(base + i * SLOT_SIZE);
+  }
+  return offsets;
+}
+
+std::vector<uint32_t> FatVolume::liveEntries(uint16_t dirCluster) const {
+  std::vector<uint32_t> live;
+  for (uint32_t slot : directorySlots(dirCluster)) {
+    const uint8_t *p = &m_image[slot];
+    if (p[0] == SLOT_FREE)
+      break;
+    if (p[0] == SLOT_DELETED || isDotEntry(p) || (p[11] & ATTR_VOLUME))
+      continue;
+    live.push_back(slot);
+  }
+  return live;
+}
+
+uint32_t FatVolume::findEntry(uint16_t dirCluster,
+                              const uint8_t *name83) const {
+  for (uint32_t slot : liveEntries(dirCluster)) {
+    if (std::memcmp(&m_image[slot], name83, 11) == 0)
+      return slot;
+  }
+  return 0;
+}
+
+uint32_t FatVolume::allocateSlot(uint16_t dirCluster) {
+  for (uint32_t slot : directorySlots(dirCluster)) {
+    const uint8_t first = m_image[slot];
+    if (first == SLOT_FREE || first == SLOT_DELETED)
+      return slot;
+  }
+  if (dirCluster == 0)
+    return 0;
+
+  // Subdirectories grow by one zeroed cluster.
+  const std::vector<uint16_t> clusters = chain(dirCluster);
+  if (clusters.empty() || clusters.size() >= MAX_DIR_CLUSTERS)
+    return 0;
+  const std::vector<uint16_t> extra = allocate(1);
+  if (extra.empty())
+    return 0;
+  fill(clusterOffset(extra[0]), 0, m_geo.clusterBytes());
+  setNext(extra[0], FAT_END_OF_CHAIN);
+  setNext(clusters.back(), extra[0]);
+  return clusterOffset(extra[0]);
+}
+
+uint32_t FatVolume::createFile(uint16_t dirCluster, const uint8_t *name83) {
+  const uint32_t slot = allocateSlot(dirCluster);
+  if (slot == 0)
+    return 0;
+  uint8_t entry[SLOT_SIZE] = {};
+  std::memcpy(entry, name83, 11);
+  entry[11] = ATTR_ARCHIVE;
+  write(slot, entry, SLOT_SIZE);
+  return slot;
+}
+
+uint32_t FatVolume::createDirectory(uint16_t dirCluster,
+                                    const uint8_t *name83, uint16_t claimed) {
+  uint16_t first = claimed;
+  if (first == 0) {
+    const std::vector<uint16_t> cluster = allocate(1);
+    if (cluster.empty())
+      return 0;
+    // Claim the cluster first so a growing parent cannot take it.
+    first = cluster[0];
+    setNext(first, FAT_END_OF_CHAIN);
+  }
+  const uint32_t slot = allocateSlot(dirCluster);
+  if (slot == 0) {
+    if (claimed == 0)
+      setNext(first, 0);
+    return 0;
+  }
+
+  uint8_t entry[SLOT_SIZE] = {};
+  std::memcpy(entry, name83, 11);
+  entry[11] = ATTR_DIRECTORY;
+  Atari::writeLE16(entry + 26, first);
+  write(slot, entry, SLOT_SIZE);
+
+  for (uint16_t c : chain(first))
+    fill(clusterOffset(c), 0, m_geo.clusterBytes());
+  const uint32_t body = clusterOffset(first);
+  uint8_t dot[SLOT_SIZE] = {};
+  std::memset(dot, ' ', 11);
+  dot[0] = '.';
+  dot[11] = ATTR_DIRECTORY;
+  Atari::writeLE16(dot + 26, first);
+  write(body, dot, SLOT_SIZE);
+  dot[1] = '.';
+  Atari::writeLE16(dot + 26, dirCluster);
+  write(body + SLOT_SIZE, dot, SLOT_SIZE);
+  return slot;
+}
+
+// =============================================================================
+//  File Contents
+// =============================================================================
+
+bool FatVolume::writeFile(uint32_t slot, const uint8_t *data, uint32_t size) {
+  return writeFile(slot, FileView::fromBuffer(data, size));
+}
+
+bool FatVolume::writeFile(uint32_t slot, const FileView &source) {
+  const uint32_t size = source.size();
+  const uint32_t clusterBytes = m_geo.clusterBytes();
+  const uint32_t needed = (size + clusterBytes - 1) / clusterBytes;
+  std::vector<uint16_t> clusters = chain(startCluster(slot));
+
+  if (needed > clusters.size()) {
+    const std::vector<uint16_t> extra =
+        allocate(static_cast<uint32_t>(needed - clusters.size()));
+    if (extra.empty())
+      return false;
+    clusters.insert(clusters.end(), extra.begin(), extra.end());
+  }
+  for (std::size_t k = needed; k < clusters.size(); ++k)
+    setNext(clusters[k], 0);
+  clusters.resize(needed);
+
+  const std::vector<FileExtent> &extents = source.extents();
+  std::size_t extent = 0;
+  uint32_t extentEnd = extents.empty() ? 0 : extents[0].length;
+  for (std::size_t k = 0; k < clusters.size(); ++k) {
+    setNext(clusters[k],
+            k + 1 < clusters.size() ? clusters[k + 1] : FAT_END_OF_CHAIN);
+    const uint32_t done = static_cast<uint32_t>(k) * clusterBytes;
+    const uint32_t length = std::min(clusterBytes, size - done);
+    const uint32_t at = clusterOffset(clusters[k]);
+    // Source extents and clusters rarely line up; copy the overlaps.
+    for (uint32_t pos = done; pos < done + length;) {
+      while (pos >= extentEnd)
+        extentEnd += extents[++extent].length;
+      const uint32_t n = std::min(done + length, extentEnd) - pos;
+      write(at + (pos - done), source.contiguous(pos, n), n);
+      pos += n;
+    }
+    fill(at + length, 0, clusterBytes - length);
+  }
+
+  writeLE16At(slot + 26, clusters.empty() ? 0 : clusters[0]);
+  writeLE32At(slot + 28, size);
+  return true;
+}
+
+void FatVolume::removeEntry(uint32_t slot) {
+  for (uint16_t c : chain(startCluster(slot)))
+    setNext(c, 0);
+  const uint8_t deleted = SLOT_DELETED;
+  write(slot, &deleted, 1);
+}
+
+void FatVolume::setAttributes(uint32_t slot, uint8_t attributes) {
+  write(slot + 11, &attributes, 1);
+}
+
+void FatVolume::setTimestamp(uint32_t slot, uint16_t time, uint16_t date) {
+  writeLE16At(slot + 22, time);
+  writeLE16At(slot + 24, date);
+}
+
+void FatVolume::setStartCluster(uint32_t slot, uint16_t cluster) {
+  writeLE16At(slot + 26, cluster);
+}
+
+uint16_t FatVolume::startCluster(uint32_t slot) const {
+  return readLE16(&m_image[slot + 26]);
+}
+
+FileView FatVolume::fileView(uint32_t slot) const {
+  uint32_t remaining = readLE32(&m_image[slot + 28]);
+  std::vector<FileExtent> extents;
+  for (uint16_t c : chain(startCluster(slot))) {
+    if (remaining == 0)
+      break;
+    const uint32_t length = std::min(remaining, m_geo.clusterBytes());
+    extents.push_back({clusterOffset(c), length});
+    remaining -= length;
+  }
+  return FileView(m_image.data(), extents);
+}
+
+// =============================================================================
+//  Names
+// =============================================================================
+
+bool FatVolume::toName83(const std::string &name, uint8_t *name83) {
+  const std::size_t dot = name.rfind('.');
+  const std::string base = name.substr(0, dot);
+  const std::string ext =
+      dot == std::string::npos ? std::string() : name.substr(dot + 1);
+  if (base.empty() || base.size() > 8 || ext.size() > 3)
+    return false;
+
+  std::memset(name83, ' ', 11);
+  auto copy = [](const std::string &part, uint8_t *dst) {
+    for (std::size_t i = 0; i < part.size(); ++i) {
+      const auto c = static_cast<unsigned char>(std::toupper(
+          static_cast<unsigned char>(part[i])));
+      if (!isValidNameChar(c))
+        return false;
+      dst[i] = c;
+    }
+    return true;
+  };
+  return copy(base, name83) && copy(ext, name83 + 8);
+}
+
+std::string FatVolume::fromName83(const uint8_t *name83) {
+  std::string base(reinterpret_cast<const char *>(name83), 8);
+  std::string ext(reinterpret_cast<const char *>(name83 + 8), 3);
+  base.erase(base.find_last_not_of(' ') + 1);
+  ext.erase(ext.find_last_not_of(' ') + 1);
+  return ext.empty() ? base : base + "." + ext;
+}
+
+// =============================================================================
+//  Raw Writes
+// =============================================================================
+
+void FatVolume::write(uint32_t offset, const void *data, uint32_t length) {
+  if (length == 0 || std::memcmp(&m_image[offset], data, length) == 0)
+    return;
+  std::memcpy(&m_image[offset], data, length);
+  if (m_onWrite)
+    m_onWrite(offset, length);
+}
+
+void FatVolume::fill(uint32_t offset, uint8_t value, uint32_t length) {
+  uint8_t *p = m_image.data() + offset;
+  if (std::all_of(p, p + length, [value](uint8_t b) { return b == value; }))
+    return;
+  std::memset(p, value, length);
+  if (m_onWrite)
+    m_onWrite(offset, length);
+}
+
+void FatVolume::writeLE16At(uint32_t offset, uint16_t value) {
+  uint8_t bytes[2];
+  Atari::writeLE16(bytes, value);
+  write(offset, bytes, 2);
+}
+
+void FatVolume::writeLE32At(uint32_t offset, uint32_t value) {
+  const uint8_t bytes[4] = {
+      static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+      static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+  write(offset, bytes, 4);
+}
+
+} // namespace Atari
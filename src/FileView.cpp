@@ -0,0 +1,135 @@
+// =============================================================================
+//  FileView.cpp
+//  Atari ST Toolkit — Zero-Copy File Access
+//
+//  Random access binary-searches the extent start table; sequential access
+//  goes through Cursor, which only touches the table at extent boundaries.
+// =============================================================================
+
+#include "../include/FileView.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Atari {
+
+FileView::FileView(const uint8_t *base, const std::vector<FileExtent> &extents)
+    : m_base(base) {
+  for (const FileExtent &e : extents) {
+    if (e.length == 0)
+      continue;
+    // Consecutive clusters are common; one extent keeps contiguous() useful.
+    if (!m_extents.empty() &&
+        m_extents.back().offset + m_extents.back().length == e.offset) {
+      m_extents.back().length += e.length;
+    } else {
+      m_extents.push_back(e);
+      m_starts.push_back(m_size);
+    }
+    m_size += e.length;
+  }
+}
+
+FileView FileView::fromBuffer(const uint8_t *data, std::size_t size) {
+  if (!data || size == 0)
+    return FileView();
+  return FileView(data, {{0, static_cast<uint32_t>(size)}});
+}
+
+std::size_t FileView::extentAt(uint32_t pos) const {
+  auto it = std::upper_bound(m_starts.begin(), m_starts.end(), pos);
+  return static_cast<std::size_t>(it - m_starts.begin()) - 1;
+}
+
+const uint8_t *FileView::contiguous(uint32_t pos, uint32_t length) const {
+  if (pos >= m_size || length > m_size - pos)
+    return nullptr;
+  const std::size_t i = extentAt(pos);
+  const uint32_t inExtent = pos - m_starts[i];
+  if (length > m_extents[i].length - inExtent)
+    return nullptr;
+  return m_base + m_extents[i].offset + inExtent;
+}
+
+uint32_t FileView::read(uint32_t pos, uint8_t *dst, uint32_t length) const {
+  if (pos >= m_size)
+    return 0;
+  length = std::min(length, m_size - pos);
+
+  uint32_t copied = 0;
+  for (std::size_t i = extentAt(pos); copied < length; ++i) {
+    const uint32_t inExtent = pos + copied - m_starts[i];
+    const uint32_t n =
+        std::min(length - copied, m_extents[i].length - inExtent);
+    std::memcpy(dst + copied, m_base + m_extents[i].offset + inExtent, n);
+    copied += n;
+  }
+  return copied;
+}
+
+uint16_t FileView::readBE16(uint32_t pos) const {
+  uint8_t b[2];
+  if (read(pos, b, 2) != 2)
+    return 0;
+  return static_cast<uint16_t>((b[0] << 8) | b[1]);
+}
+
+uint32_t FileView::readBE32(uint32_t pos) const {
+  uint8_t b[4];
+  if (read(pos, b, 4) != 4)
+    return 0;
+  return (static_cast<uint32_t>(b[0]) << 24) | (b[1] << 16) | (b[2] << 8) |
+         b[3];
+}
+
+std::vector<uint8_t> FileView::toVector() const {
+  std::vector<uint8_t> out(m_size);
+  read(0, out.data(), m_size);
+  return out;
+}
+
+uint64_t FileView::contentHash() const {
+  uint64_t h = 0xCBF29CE484222325ull;
+  for (const FileExtent &e : m_extents) {
+    const uint8_t *p = m_base + e.offset;
+    for (uint32_t i = 0; i < e.length; ++i)
+      h = (h ^ p[i]) * 0x100000001B3ull;
+  }
+  return h;
+}
+
+// =============================================================================
+//  Cursor
+// =============================================================================
+
+FileView::Cursor::Cursor(const FileView &view, uint32_t pos)
+    : m_view(view), m_pos(pos) {
+  if (pos >= view.m_size) {
+    m_extent = view.m_extents.size();
+    return;
+  }
+  m_extent = view.extentAt(pos);
+  const FileExtent &e = view.m_extents[m_extent];
+  m_ptr = view.m_base + e.offset + (pos - view.m_starts[m_extent]);
+  m_end = view.m_base + e.offset + e.length;
+}
+
+bool FileView::Cursor::advanceExtent() {
+  if (m_extent + 1 >= m_view.m_extents.size())
+    return false;
+  const FileExtent &e = m_view.m_extents[++m_extent];
+  m_ptr = m_view.m_base + e.offset;
+  m_end = m_ptr + e.length;
+  return true;
+}
+
+bool FileView::Cursor::nextBE32(uint32_t &value) {
+  uint8_t b[4];
+  for (uint8_t &x : b)
+    if (!next(x))
+      return false;
+  value = (static_cast<uint32_t>(b[0]) << 24) | (b[1] << 16) | (b[2] << 8) |
+          b[3];
+  return true;
+}
+
+} // namespace Atari
@@ -0,0 +1,444 @@
+// =============================================================================
+//  FolderSync.cpp
+//  Atari ST Toolkit — Host Folder Sync
+//
+//  A pass lists both sides (reusing cached hashes wherever nothing moved),
+//  then settles each path with a three-way compare against the hash it had
+//  after the previous pass.
+// =============================================================================
+
+#include "../include/FolderSync.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace Atari {
+
+namespace {
+
+/** Host changes are gathered for this long before a pass runs. */
+constexpr int DEBOUNCE_MS = 250;
+/** How often the engine's change counter is compared. */
+constexpr int IMAGE_POLL_MS = 500;
+/** Nesting limit on both sides (a runaway symlink loop ends here). */
+constexpr int MAX_DEPTH = 8;
+
+quint64 hashBytes(const QByteArray &data) {
+  return FileView::fromBuffer(
+             reinterpret_cast<const uint8_t *>(data.constData()),
+             static_cast<std::size_t>(data.size()))
+      .contentHash();
+}
+
+void toDosTime(const QDateTime &when, uint16_t &time, uint16_t &date) {
+  const QDate d = when.date();
+  const QTime t = when.time();
+  const int year = std::min(std::max(d.year(), 1980), 2107);
+  time = static_cast<uint16_t>((t.hour() << 11) | (t.minute() << 5) |
+                               (t.second() / 2));
+  date = static_cast<uint16_t>(((year - 1980) << 9) | (d.month() << 5) |
+                               d.day());
+}
+
+bool intersects(const FileView &view, const std::vector<uint32_t> &dirty) {
+  for (const FileExtent &e : view.extents()) {
+    const uint32_t first = e.offset / SECTOR_SIZE;
+    const uint32_t last = (e.offset + e.length - 1) / SECTOR_SIZE;
+    const auto it = std::lower_bound(dirty.begin(), dirty.end(), first);
+    if (it != dirty.end() && *it <= last)
+      return true;
+  }
+  return false;
+}
+
+QString joinPath(const QString &dir, const QString &name) {
+  return dir.isEmpty() ? name : dir + "/" + name;
+}
+
+} // namespace
+
+FolderSync::FolderSync(AtariDiskEngine &engine, const QString &hostDir,
+                       const QString &imageDir, QObject *parent)
+    : QObject(parent), m_engine(engine),
+      m_hostDir(QDir(hostDir).absolutePath()), m_imageDir(imageDir) {
+  m_debounce.setSingleShot(true);
+  m_debounce.setInterval(DEBOUNCE_MS);
+  connect(&m_debounce, &QTimer::timeout, this, [this] {
+    const SyncReport report = syncNow();
+    if (!report.isEmpty())
+      emit synced(report);
+  });
+  m_imagePoll.setInterval(IMAGE_POLL_MS);
+  connect(&m_imagePoll, &QTimer::timeout, this, &FolderSync::onPollImage);
+  connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this,
+          &FolderSync::scheduleSync);
+  connect(&m_watcher, &QFileSystemWatcher::fileChanged, this,
+          &FolderSync::scheduleSync);
+}
+
+bool FolderSync::isValid() const {
+  FatVolume volume = m_engine.volume();
+  uint16_t cluster;
+  return volume.isValid() && QFileInfo(m_hostDir).isDir() &&
+         resolveImageDir(volume, QString(), false, cluster);
+}
+
+void FolderSync::start() {
+  watchHostTree();
+  m_imagePoll.start();
+}
+
+void FolderSync::stop() {
+  m_debounce.stop();
+  m_imagePoll.stop();
+  const QStringList watched = m_watcher.files() + m_watcher.directories();
+  if (!watched.isEmpty())
+    m_watcher.removePaths(watched);
+}
+
+void FolderSync::scheduleSync() { m_debounce.start(); }
+
+void FolderSync::onPollImage() {
+  if (m_engine.changeCounter() != m_imageCounter)
+    scheduleSync();
+}
+
+// =============================================================================
+//  Scanning
+// =============================================================================
+
+void FolderSync::scanHost(const QString &absDir, const QString &rel,
+                          int depth, QHash<QString, HostFile> &out,
+                          SyncReport &report) {
+  const QFileInfoList entries = QDir(absDir).entryInfoList(
+      QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+  for (const QFileInfo &info : entries) {
+    uint8_t name83[11];
+    const QString relPath = joinPath(rel, info.fileName());
+    if (!FatVolume::toName83(info.fileName().toStdString(), name83)) {
+      report.skipped << relPath;
+      continue;
+    }
+    const QString key =
+        joinPath(rel, QString::fromStdString(FatVolume::fromName83(name83)));
+
+    if (info.isDir()) {
+      m_hostDirs.insert(key, info.absoluteFilePath());
+      if (depth < MAX_DEPTH)
+        scanHost(info.absoluteFilePath(), key, depth + 1, out, report);
+      continue;
+    }
+    if (out.contains(key)) {
+      // "readme.txt" and "README.TXT" cannot both live on the disk.
+      report.skipped << relPath;
+      continue;
+    }
+
+    HostFile file;
+    file.absPath = info.absoluteFilePath();
+    file.size = info.size();
+    file.mtime = info.lastModified().toMSecsSinceEpoch();
+    const auto cached = m_hostCache.constFind(key);
+    if (cached != m_hostCache.constEnd() && cached->absPath == file.absPath &&
+        cached->size == file.size && cached->mtime == file.mtime) {
+      file.hash = cached->hash;
+    } else {
+      QFile f(file.absPath);
+      if (!f.open(QIODevice::ReadOnly)) {
+        report.skipped << relPath;
+        m_hostUnreadable.insert(key);
+        continue;
+      }
+      file.hash = hashBytes(f.readAll());
+    }
+    out.insert(key, file);
+  }
+}
+
+void FolderSync::scanImage(FatVolume &volume, uint16_t dirCluster,
+                           const QString &rel, int depth,
+                           const std::vector<uint32_t> &dirty,
+                           QHash<QString, ImageFile> &out) {
+  const std::vector<uint8_t> &image = m_engine.getRawImageData();
+  for (uint32_t slot : volume.liveEntries(dirCluster)) {
+    const QString key = joinPath(
+        rel, QString::fromStdString(FatVolume::fromName83(&image[slot])));
+    if (image[slot + 11] & ATTR_DIRECTORY) {
+      if (depth < MAX_DEPTH)
+        scanImage(volume, volume.startCluster(slot), key, depth + 1, dirty,
+                  out);
+      continue;
+    }
+
+    ImageFile file;
+    file.slot = slot;
+    file.startCluster = volume.startCluster(slot);
+    file.size = readLE32(&image[slot + 28]);
+    const FileView view = volume.fileView(slot);
+    const auto cached = m_imageCache.constFind(key);
+    if (cached != m_imageCache.constEnd() && cached->slot == file.slot &&
+        cached->startCluster == file.startCluster &&
+        cached->size == file.size && !intersects(view, dirty)) {
+      file.hash = cached->hash;
+    } else {
+      file.hash = view.contentHash();
+    }
+    out.insert(key, file);
+  }
+}
+
+bool FolderSync::resolveImageDir(FatVolume &volume, const QString &rel,
+                                 bool create, uint16_t &cluster) const {
+  const QStringList parts =
+      (m_imageDir + "/" + rel).split('/', Qt::SkipEmptyParts);
+  const std::vector<uint8_t> &image = m_engine.getRawImageData();
+  cluster = 0;
+  for (const QString &part : parts) {
+    uint8_t name83[11];
+    if (!FatVolume::toName83(part.toStdString(), name83))
+      return false;
+    uint32_t slot = volume.findEntry(cluster, name83);
+    if (slot == 0 && create)
+      slot = volume.createDirectory(cluster, name83);
+    if (slot == 0 || !(image[slot + 11] & ATTR_DIRECTORY))
+      return false;
+    cluster = volume.startCluster(slot);
+  }
+  return true;
+}
+
+// =============================================================================
+//  Copying
+// =============================================================================
+
+bool FolderSync::copyToImage(FatVolume &volume, const QString &rel,
+                             const HostFile &file, ImageFile &result) {
+  const int cut = rel.lastIndexOf('/');
+  uint16_t dir;
+  uint8_t name83[11];
+  if (!resolveImageDir(volume, cut < 0 ? QString() : rel.left(cut), true,
+                       dir) ||
+      !FatVolume::toName83(rel.mid(cut + 1).toStdString(), name83))
+    return false;
+
+  QFile f(file.absPath);
+  if (!f.open(QIODevice::ReadOnly))
+    return false;
+  const QByteArray data = f.readAll();
+
+  const std::vector<uint8_t> &image = m_engine.getRawImageData();
+  uint32_t slot = volume.findEntry(dir, name83);
+  if (slot != 0 && (image[slot + 11] & ATTR_DIRECTORY))
+    return false;
+  const bool created = slot == 0;
+  if (created && (slot = volume.createFile(dir, name83)) == 0)
+    return false;
+  if (!volume.writeFile(slot,
+                        reinterpret_cast<const uint8_t *>(data.constData()),
+                        static_cast<uint32_t>(data.size()))) {
+    if (created)
+      volume.removeEntry(slot);
+    return false;
+  }
+
+  uint16_t time, date;
+  toDosTime(QFileInfo(file.absPath).lastModified(), time, date);
+  volume.setTimestamp(slot, time, date);
+  result.slot = slot;
+  result.startCluster = volume.startCluster(slot);
+  result.size = static_cast<uint32_t>(data.size());
+  result.hash = hashBytes(data);
+  return true;
+}
+
+bool FolderSync::copyToHost(FatVolume &volume, const QString &rel,
+                            const ImageFile &file, HostFile &result) {
+  // Reuse the host's own spelling of existing folders ("src", not "SRC").
+  const QStringList parts = rel.split('/');
+  QString absDir = m_hostDir;
+  QString key;
+  for (int i = 0; i + 1 < parts.size(); ++i) {
+    key = joinPath(key, parts[i]);
+    const auto known = m_hostDirs.constFind(key);
+    absDir = known != m_hostDirs.constEnd() ? *known : absDir + "/" + parts[i];
+    m_hostDirs.insert(key, absDir);
+  }
+  if (!QDir().mkpath(absDir))
+    return false;
+
+  const QString path =
+      result.absPath.isEmpty() ? absDir + "/" + parts.last() : result.absPath;
+  const std::vector<uint8_t> data = volume.fileView(file.slot).toVector();
+  QSaveFile out(path);
+  if (!out.open(QIODevice::WriteOnly) ||
+      out.write(reinterpret_cast<const char *>(data.data()),
+                static_cast<qint64>(data.size())) !=
+          static_cast<qint64>(data.size()) ||
+      !out.commit())
+    return false;
+
+  const QFileInfo info(path);
+  result.absPath = path;
+  result.size = info.size();
+  result.mtime = info.lastModified().toMSecsSinceEpoch();
+  result.hash = file.hash;
+  return true;
+}
+
+// =============================================================================
+//  Sync Pass
+// =============================================================================
+
+SyncReport FolderSync::syncNow() {
+  SyncReport report;
+  FatVolume volume = m_engine.volume();
+  uint16_t baseCluster;
+  if (!volume.isValid() ||
+      !resolveImageDir(volume, QString(), false, baseCluster))
+    return report;
+
+  QHash<QString, HostFile> host;
+  m_hostDirs.clear();
+  m_hostUnreadable.clear();
+  scanHost(m_hostDir, QString(), 0, host, report);
+
+  QHash<QString, ImageFile> image;
+  if (m_scanned && m_engine.changeCounter() == m_imageCounter) {
+    image = m_imageCache;
+  } else {
+    const std::vector<uint32_t> dirty =
+        m_scanned ? m_engine.dirtySectorsSince(m_imageCounter)
+                  : std::vector<uint32_t>();
+    scanImage(volume, baseCluster, QString(), 0, dirty, image);
+  }
+
+  QStringList paths = host.keys() + image.keys();
+  paths.sort();
+  paths.removeDuplicates();
+
+  for (const QString &path : paths) {
+    const bool onHost = host.contains(path);
+    const bool inImage = image.contains(path);
+    const auto synced = m_synced.constFind(path);
+    const bool known = synced != m_synced.constEnd();
+
+    enum { Keep, ToImage, ToHost, DropImage, DropHost } action = Keep;
+    if (onHost && inImage) {
+      const quint64 h = host[path].hash;
+      const quint64 i = image[path].hash;
+      if (h == i)
+        action = Keep;
+      else if (known && i == *synced)
+        action = ToImage;
+      else if (known && h == *synced)
+        action = ToHost;
+      else {
+        report.conflicts << path;
+        action = ToImage;
+      }
+    } else if (onHost) {
+      // A copy edited since the last pass outlives the other's deletion.
+      if (!known)
+        action = ToImage;
+      else if (host[path].hash == *synced)
+        action = DropHost;
+      else {
+        report.conflicts << path;
+        action = ToImage;
+      }
+    } else {
+      // Still on the host, just not readable: neither deleted nor synced.
+      if (m_hostUnreadable.contains(path))
+        continue;
+      if (!known)
+        action = ToHost;
+      else if (image[path].hash == *synced)
+        action = DropImage;
+      else {
+        report.conflicts << path;
+        action = ToHost;
+      }
+    }
+
+    switch (action) {
+    case Keep:
+      m_synced.insert(path, host[path].hash);
+      break;
+    case ToImage: {
+      ImageFile written;
+      if (copyToImage(volume, path, host[path], written)) {
+        image.insert(path, written);
+        m_synced.insert(path, written.hash);
+        report.toImage << path;
+      } else {
+        report.skipped << path;
+      }
+      break;
+    }
+    case ToHost: {
+      HostFile written = host.value(path);
+      if (copyToHost(volume, path, image[path], written)) {
+        host.insert(path, written);
+        m_synced.insert(path, written.hash);
+        report.toHost << path;
+      } else {
+        report.skipped << path;
+      }
+      break;
+    }
+    case DropImage:
+      volume.removeEntry(image[path].slot);
+      image.remove(path);
+      m_synced.remove(path);
+      report.removedFromImage << path;
+      break;
+    case DropHost:
+      if (QFile::remove(host[path].absPath)) {
+        host.remove(path);
+        m_synced.remove(path);
+        report.removedFromHost << path;
+      } else {
+        report.skipped << path;
+      }
+      break;
+    }
+  }
+
+  // Our own writes are already reflected in the caches.
+  m_hostCache = host;
+  m_imageCache = image;
+  m_imageCounter = m_engine.changeCounter();
+  m_scanned = true;
+  if (m_imagePoll.isActive())
+    watchHostTree();
+  return report;
+}
+
+void FolderSync::watchHostTree() {
+  QStringList wanted{m_hostDir};
+  for (const QString &dir : m_hostDirs)
+    wanted << dir;
+  for (const HostFile &file : m_hostCache)
+    wanted << file.absPath;
+
+  const QStringList watched = m_watcher.files() + m_watcher.directories();
+  QStringList stale;
+  for (const QString &path : watched) {
+    if (!wanted.contains(path))
+      stale << path;
+  }
+  if (!stale.isEmpty())
+    m_watcher.removePaths(stale);
+  QStringList fresh;
+  for (const QString &path : wanted) {
+    if (!watched.contains(path))
+      fresh << path;
+  }
+  if (!fresh.isEmpty())
+    m_watcher.addPaths(fresh);
+}
+
+} // namespace Atari
@@ -0,0 +1,328 @@
+// =============================================================================
+//  GemdosDrive.cpp
+//  Atari ST Toolkit — GEMDOS File Handles
+//
+//  Reads never touch the FAT: Fopen() maps the cluster chain to extents
+//  once, and the handle remembers which extent its position falls in, so
+//  the next Fread() continues with a pointer add.
+// =============================================================================
+
+#include "../include/GemdosDrive.h"
+#include "../include/FatVolume.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint8_t NAME_DOT[11] = {'.', ' ', ' ', ' ', ' ', ' ',
+                                  ' ', ' ', ' ', ' ', ' '};
+constexpr uint8_t NAME_DOTDOT[11] = {'.', '.', ' ', ' ', ' ', ' ',
+                                     ' ', ' ', ' ', ' ', ' '};
+
+/** @return Path components; a leading "X:" drive is dropped. */
+QStringList splitPath(const QString &path) {
+  QString p = path;
+  if (p.size() >= 2 && p[1] == ':')
+    p = p.mid(2);
+  return p.replace('/', '\\').split('\\', Qt::SkipEmptyParts);
+}
+
+/**
+ * @brief Expands a GEMDOS name or pattern into an 11-byte 8.3 template:
+ * '*' fills the rest of its half with '?', case is folded to upper.
+ */
+void toTemplate(const QString &name, uint8_t *out) {
+  std::memset(out, ' ', 11);
+  if (name == "." || name == "..") {
+    std::memcpy(out, name == "." ? NAME_DOT : NAME_DOTDOT, 11);
+    return;
+  }
+  const QByteArray bytes = name.toUpper().toLatin1();
+  const int dot = bytes.lastIndexOf('.');
+  auto fill = [](const QByteArray &part, uint8_t *dst, int width) {
+    for (int i = 0; i < part.size() && i < width; ++i) {
+      if (part[i] == '*') {
+        std::memset(dst + i, '?', static_cast<std::size_t>(width - i));
+        return;
+      }
+      dst[i] = static_cast<uint8_t>(part[i]);
+    }
+  };
+  fill(dot < 0 ? bytes : bytes.left(dot), out, 8);
+  if (dot >= 0)
+    fill(bytes.mid(dot + 1), out + 8, 3);
+}
+
+/** @return The 11 name and extension bytes of an entry, side by side. */
+const uint8_t *rawName(const DirEntry &e) {
+  return reinterpret_cast<const uint8_t *>(&e);
+}
+
+bool matchesTemplate(const uint8_t *name83, const uint8_t *pattern) {
+  for (int i = 0; i < 11; ++i) {
+    if (pattern[i] != '?' &&
+        pattern[i] != std::toupper(static_cast<unsigned char>(name83[i])))
+      return false;
+  }
+  return true;
+}
+
+bool matchesAttributes(uint8_t attr, uint8_t searchAttr) {
+  if (searchAttr == ATTR_VOLUME)
+    return attr & ATTR_VOLUME;
+  if (attr & ATTR_VOLUME)
+    return false;
+  const uint8_t special = ATTR_HIDDEN | ATTR_SYSTEM | ATTR_DIRECTORY;
+  return (attr & special & ~searchAttr) == 0;
+}
+
+void fillResult(const DirEntry &e, GemdosDta &dta) {
+  dta.attr = e.attr;
+  dta.time = readLE16(e.time);
+  dta.date = readLE16(e.date);
+  dta.size = e.getFileSize();
+  const std::string name = e.getFilename();
+  const std::size_t n = std::min(name.size(), sizeof(dta.name) - 1);
+  std::memcpy(dta.name, name.data(), n);
+  dta.name[n] = '\0';
+}
+
+} // namespace
+
+void GemdosDta::store(uint8_t *dta) const {
+  dta[21] = attr;
+  writeBE16(dta + 22, time);
+  writeBE16(dta + 24, date);
+  writeBE16(dta + 26, static_cast<uint16_t>(size >> 16));
+  writeBE16(dta + 28, static_cast<uint16_t>(size));
+  std::memcpy(dta + 30, name, sizeof(name));
+}
+
+GemdosDrive::GemdosDrive(const AtariDiskEngine &engine)
+    : m_engine(engine), m_files(MAX_HANDLES) {}
+
+// =============================================================================
+//  Directory Index
+// =============================================================================
+
+void GemdosDrive::checkImage() {
+  const uint8_t *base = m_engine.getRawImageData().data();
+  if (base == m_imageBase && m_engine.changeCounter() == m_imageCounter)
+    return;
+  m_directories.clear();
+  m_imageBase = base;
+  m_imageCounter = m_engine.changeCounter();
+}
+
+const std::vector<DirEntry> &GemdosDrive::directory(uint16_t cluster) {
+  checkImage();
+  auto it = m_directories.find(cluster);
+  if (it == m_directories.end()) {
+    std::vector<DirEntry> entries = cluster == 0
+                                        ? m_engine.readRootDirectory()
+                                        : m_engine.readSubDirectory(cluster);
+    if (cluster == 0) {
+      // The engine skips the volume label; Fsfirst(..., 0x08) wants it.
+      const std::vector<uint8_t> &image = m_engine.getRawImageData();
+      FatGeometry geo;
+      if (readFatGeometry(image.data(), image.size(), geo)) {
+        const uint8_t *root = image.data() + geo.rootSector * SECTOR_SIZE;
+        for (uint32_t i = 0; i < geo.rootEntries; ++i) {
+          const uint8_t *slot = root + i * DIRENT_SIZE;
+          if (slot[0] == 0x00)
+            break;
+          if (slot[0] != 0xE5 && (slot[11] & ATTR_VOLUME) &&
+              slot[11] != 0x0F) {
+            DirEntry label;
+            std::memcpy(&label, slot, sizeof(label));
+            entries.push_back(label);
+            break;
+          }
+        }
+      }
+    }
+    it = m_directories.insert(cluster, std::move(entries));
+  }
+  return it.value();
+}
+
+bool GemdosDrive::resolveParent(const QString &path, uint16_t &cluster,
+                                QString &leaf) {
+  QStringList parts = splitPath(path);
+  leaf = parts.isEmpty() ? QString() : parts.takeLast();
+  cluster = 0;
+  uint8_t name83[11];
+  for (const QString &part : parts) {
+    toTemplate(part, name83);
+    const std::vector<DirEntry> &dir = directory(cluster);
+    auto it = std::find_if(dir.begin(), dir.end(), [&](const DirEntry &e) {
+      return e.isDirectory() && matchesTemplate(rawName(e), name83);
+    });
+    if (it == dir.end())
+      return false;
+    cluster = it->getStartCluster(); // ".." of a top-level folder is 0
+  }
+  return true;
+}
+
+// =============================================================================
+//  Handles
+// =============================================================================
+
+void GemdosDrive::mapFile(OpenFile &file) {
+  const FileView view = m_engine.fileView(file.entry);
+  file.base = m_engine.getRawImageData().data();
+  file.counter = m_engine.changeCounter();
+  file.extents = view.extents();
+  file.size = view.size();
+  file.starts.clear();
+  uint32_t start = 0;
+  for (const FileExtent &e : file.extents) {
+    file.starts.push_back(start);
+    start += e.length;
+  }
+  file.pos = std::min(file.pos, file.size);
+  file.extent = 0;
+  if (file.pos < file.size)
+    file.extent = static_cast<std::size_t>(
+        std::upper_bound(file.starts.begin(), file.starts.end(), file.pos) -
+        file.starts.begin() - 1);
+}
+
+GemdosDrive::OpenFile *GemdosDrive::fileFor(int16_t handle) {
+  const int index = handle - GEMDOS_FIRST_HANDLE;
+  if (index < 0 || index >= MAX_HANDLES || !m_files[index].open)
+    return nullptr;
+  OpenFile &file = m_files[index];
+  if (file.base != m_engine.getRawImageData().data() ||
+      file.counter != m_engine.changeCounter())
+    mapFile(file);
+  return &file;
+}
+
+int32_t GemdosDrive::fopen(const QString &path, int16_t mode) {
+  if (mode != 0)
+    return mode > 0 && mode <= 2 ? GEMDOS_EACCDN : GEMDOS_EINVFN;
+  uint16_t cluster;
+  QString leaf;
+  if (!resolveParent(path, cluster, leaf))
+    return GEMDOS_EPTHNF;
+  uint8_t name83[11];
+  toTemplate(leaf, name83);
+  if (leaf.isEmpty() || std::count(name83, name83 + 11, '?') > 0)
+    return GEMDOS_EFILNF;
+
+  const std::vector<DirEntry> &dir = directory(cluster);
+  auto it = std::find_if(dir.begin(), dir.end(), [&](const DirEntry &e) {
+    return !(e.attr & (ATTR_DIRECTORY | ATTR_VOLUME)) &&
+           std::memcmp(rawName(e), name83, 11) == 0;
+  });
+  if (it == dir.end())
+    return GEMDOS_EFILNF;
+
+  auto slot = std::find_if(m_files.begin(), m_files.end(),
+                           [](const OpenFile &f) { return !f.open; });
+  if (slot == m_files.end())
+    return GEMDOS_ENHNDL;
+  *slot = OpenFile();
+  slot->open = true;
+  slot->entry = *it;
+  mapFile(*slot);
+  return GEMDOS_FIRST_HANDLE + static_cast<int32_t>(slot - m_files.begin());
+}
+
+int32_t GemdosDrive::fclose(int16_t handle) {
+  OpenFile *file = fileFor(handle);
+  if (!file)
+    return GEMDOS_EIHNDL;
+  *file = OpenFile();
+  return GEMDOS_E_OK;
+}
+
+int32_t GemdosDrive::fread(int16_t handle, uint32_t count, uint8_t *buffer) {
+  OpenFile *file = fileFor(handle);
+  if (!file)
+    return GEMDOS_EIHNDL;
+  OpenFile &f = *file;
+  count = std::min({count, f.size - f.pos, uint32_t(INT32_MAX)});
+
+  uint32_t copied = 0;
+  while (copied < count) {
+    const FileExtent &e = f.extents[f.extent];
+    const uint32_t inExtent = f.pos - f.starts[f.extent];
+    const uint32_t n = std::min(count - copied, e.length - inExtent);
+    std::memcpy(buffer + copied, f.base + e.offset + inExtent, n);
+    copied += n;
+    f.pos += n;
+    if (inExtent + n == e.length && f.extent + 1 < f.extents.size())
+      ++f.extent;
+  }
+  return static_cast<int32_t>(copied);
+}
+
+int32_t GemdosDrive::fseek(int32_t offset, int16_t handle, int16_t mode) {
+  OpenFile *file = fileFor(handle);
+  if (!file)
+    return GEMDOS_EIHNDL;
+  OpenFile &f = *file;
+  int64_t target;
+  switch (mode) {
+  case GEMDOS_SEEK_SET:
+    target = offset;
+    break;
+  case GEMDOS_SEEK_CUR:
+    target = int64_t(f.pos) + offset;
+    break;
+  case GEMDOS_SEEK_END:
+    target = int64_t(f.size) + offset;
+    break;
+  default:
+    return GEMDOS_EINVFN;
+  }
+  if (target < 0 || target > f.size)
+    return GEMDOS_ERANGE;
+
+  f.pos = static_cast<uint32_t>(target);
+  if (f.pos < f.size) {
+    // Short hops stay O(1); anything else is a search over the extents.
+    const uint32_t start = f.starts[f.extent];
+    if (f.pos < start || f.pos >= start + f.extents[f.extent].length)
+      f.extent = static_cast<std::size_t>(
+          std::upper_bound(f.starts.begin(), f.starts.end(), f.pos) -
+          f.starts.begin() - 1);
+  }
+  return static_cast<int32_t>(f.pos);
+}
+
+// =============================================================================
+//  Searches
+// =============================================================================
+
+int32_t GemdosDrive::fsfirst(const QString &spec, uint16_t attr,
+                             GemdosDta &dta) {
+  QString leaf;
+  if (!resolveParent(spec, dta.dirCluster, leaf))
+    return GEMDOS_EPTHNF;
+  toTemplate(leaf.isEmpty() ? QString("*.*") : leaf, dta.pattern);
+  dta.searchAttr = static_cast<uint8_t>(attr);
+  dta.next = 0;
+  return fsnext(dta) == GEMDOS_E_OK ? GEMDOS_E_OK : GEMDOS_EFILNF;
+}
+
+int32_t GemdosDrive::fsnext(GemdosDta &dta) {
+  const std::vector<DirEntry> &dir = directory(dta.dirCluster);
+  while (dta.next < dir.size()) {
+    const DirEntry &e = dir[dta.next++];
+    if (matchesAttributes(e.attr, dta.searchAttr) &&
+        matchesTemplate(rawName(e), dta.pattern)) {
+      fillResult(e, dta);
+      return GEMDOS_E_OK;
+    }
+  }
+  return GEMDOS_ENMFIL;
+}
+
+} // namespace Atari
@@ -0,0 +1,247 @@
+// =============================================================================
+//  GemdosProgram.cpp
+//  Atari ST Toolkit — GEMDOS Executable Analysis
+//
+//  Header decoding, relocation walking, DRI symbols and packer detection for
+//  PRG/TOS/TTP files. Everything reads through a FileView; only the small
+//  packer probe window is copied.
+// =============================================================================
+
+#include "../include/GemdosProgram.h"
+#include "../include/Depacker.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace Atari {
+
+namespace {
+
+/** DRI symbol entry: 8 name bytes, type word, value longword. */
+constexpr uint32_t SYMBOL_ENTRY_SIZE = 14;
+/** GST linkers flag an entry whose name continues in the next entry. */
+constexpr uint16_t SYMBOL_GST_LONG_NAME = 0x0048;
+
+/** Bytes of TEXT+DATA searched for a packer magic. */
+constexpr uint32_t PACKER_PROBE_SIZE = 4096;
+
+std::string symbolName(const uint8_t *p, std::size_t length) {
+  std::size_t n = 0;
+  while (n < length && p[n])
+    ++n;
+  return std::string(reinterpret_cast<const char *>(p), n);
+}
+
+} // namespace
+
+// =============================================================================
+//  Layout
+// =============================================================================
+
+bool parsePrgHeader(const FileView &file, PrgHeader &out) {
+  uint8_t h[PRG_HEADER_SIZE];
+  if (file.read(0, h, PRG_HEADER_SIZE) != PRG_HEADER_SIZE)
+    return false;
+  if (((h[0] << 8) | h[1]) != PRG_MAGIC)
+    return false;
+
+  auto be32 = [&h](int at) {
+    return (static_cast<uint32_t>(h[at]) << 24) | (h[at + 1] << 16) |
+           (h[at + 2] << 8) | h[at + 3];
+  };
+
+  PrgHeader header;
+  header.textSize = be32(2);
+  header.dataSize = be32(6);
+  header.bssSize = be32(10);
+  header.symbolSize = be32(14);
+  header.flags = be32(22);
+  header.absolute = (h[26] | h[27]) != 0;
+
+  // Sum in 64 bits so corrupt headers cannot wrap around.
+  const uint64_t end = uint64_t(PRG_HEADER_SIZE) + header.textSize +
+                       header.dataSize + header.symbolSize;
+  if (end > file.size())
+    return false;
+
+  out = header;
+  return true;
+}
+
+bool decodePrgRelocations(const FileView &file, const PrgHeader &header,
+                          std::vector<uint32_t> &fixups) {
+  fixups.clear();
+  if (header.absolute)
+    return true;
+
+  /**
+   * The stream is a longword holding the first fixup offset (0 = none),
+   * then one byte per further fixup: 1 advances 254 bytes without fixing
+   * anything, 0 ends the list, any other even value is the distance to
+   * the next fixup.
+   */
+  if (header.relocationOffset() == file.size())
+    return true; // Linkers may omit the stream entirely
+
+  FileView::Cursor in(file, header.relocationOffset());
+  uint32_t offset;
+  if (!in.nextBE32(offset))
+    return false;
+  if (offset == 0)
+    return true;
+
+  const uint32_t limit = header.textSize + header.dataSize;
+  for (;;) {
+    if (offset > limit || limit - offset < 4 || (offset & 1))
+      return false;
+    fixups.push_back(offset);
+
+    uint8_t step;
+    do {
+      if (!in.next(step))
+        return false;
+      if (step == 1)
+        offset += 254;
+    } while (step == 1);
+
+    if (step == 0)
+      return true;
+    offset += step;
+  }
+}
+
+// =============================================================================
+//  Symbols
+// =============================================================================
+
+const char *PrgSymbol::segmentName() const {
+  if (type & 0x0200)
+    return "TEXT";
+  if (type & 0x0400)
+    return "DATA";
+  if (type & 0x0100)
+    return "BSS";
+  if (type & 0x0800)
+    return "EXT";
+  return "ABS";
+}
+
+bool decodePrgSymbols(const FileView &file, const PrgHeader &header,
+                      std::vector<PrgSymbol> &symbols) {
+  symbols.clear();
+  if (header.symbolSize % SYMBOL_ENTRY_SIZE != 0)
+    return false;
+
+  const uint32_t count = header.symbolSize / SYMBOL_ENTRY_SIZE;
+  symbols.reserve(count);
+
+  FileView::Cursor in(file, header.symbolOffset());
+  uint8_t entry[SYMBOL_ENTRY_SIZE];
+  auto nextEntry = [&in, &entry]() {
+    for (uint8_t &b : entry)
+      if (!in.next(b))
+        return false;
+    return true;
+  };
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!nextEntry())
+      return false;
+
+    PrgSymbol sym;
+    sym.name = symbolName(entry, 8);
+    sym.type = static_cast<uint16_t>((entry[8] << 8) | entry[9]);
+    sym.value = (static_cast<uint32_t>(entry[10]) << 24) | (entry[11] << 16) |
+                (entry[12] << 8) | entry[13];
+
+    // GST extended names: the whole following entry is name bytes.
+    if ((sym.type & SYMBOL_GST_LONG_NAME) == SYMBOL_GST_LONG_NAME &&
+        i + 1 < count) {
+      if (!nextEntry())
+        return false;
+      ++i;
+      sym.name += symbolName(entry, SYMBOL_ENTRY_SIZE);
+    }
+    symbols.push_back(std::move(sym));
+  }
+  return true;
+}
+
+// =============================================================================
+//  Packers
+// =============================================================================
+
+const char *detectPrgPacker(const FileView &file, const PrgHeader &header,
+                            uint32_t *magicOffset) {
+  uint8_t probe[PACKER_PROBE_SIZE];
+  const uint32_t wanted =
+      std::min(PACKER_PROBE_SIZE, header.textSize + header.dataSize);
+  const uint32_t got = file.read(header.textOffset(), probe, wanted);
+
+  // The 68000 reads the magic as a longword, so it sits on an even address.
+  for (uint32_t i = 0; i + 4 <= got; i += 2) {
+    if (const char *name = packerNameForMagic(probe + i)) {
+      if (magicOffset)
+        *magicOffset = header.textOffset() + i;
+      return name;
+    }
+  }
+  return nullptr;
+}
+
+PrgAnalysis analyzePrg(const FileView &file) {
+  PrgAnalysis a;
+  if (!parsePrgHeader(file, a.header))
+    return a;
+
+  a.valid = true;
+  a.relocationsOk = decodePrgRelocations(file, a.header, a.fixups);
+  a.symbolsOk = decodePrgSymbols(file, a.header, a.symbols);
+  a.packer = detectPrgPacker(file, a.header, &a.packerOffset);
+  return a;
+}
+
+bool isProgramFileName(const std::string &name) {
+  static const char *const kExtensions[] = {"PRG", "TOS", "TTP",
+                                            "APP", "ACC", "GTP"};
+  const std::size_t dot = name.rfind('.');
+  if (dot == std::string::npos || name.size() - dot != 4)
+    return false;
+
+  std::string ext = name.substr(dot + 1);
+  for (char &c : ext)
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  for (const char *e : kExtensions)
+    if (ext == e)
+      return true;
+  return false;
+}
+
+// =============================================================================
+//  Disassembly
+// =============================================================================
+
+M68kSymbolizer prgSymbolizer(const PrgHeader &header,
+                             const std::vector<uint32_t> &fixups) {
+  return [header, fixups](uint32_t offset, uint32_t value, std::string &out) {
+    if (!std::binary_search(fixups.begin(), fixups.end(), offset))
+      return false;
+
+    const char *segment = "TEXT";
+    uint32_t rel = value;
+    if (value >= header.textSize + header.dataSize) {
+      segment = "BSS";
+      rel = value - header.textSize - header.dataSize;
+    } else if (value >= header.textSize) {
+      segment = "DATA";
+      rel = value - header.textSize;
+    }
+
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%s+$%X", segment, rel);
+    out = buf;
+    return true;
+  };
+}
+
+} // namespace Atari
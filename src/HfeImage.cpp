@@ -0,0 +1,276 @@
+// =============================================================================
+//  HfeImage.cpp
+//  Atari ST Toolkit — HxC Floppy Emulator Images
+//
+//  Tracks are independent, so both directions hand them to the global
+//  thread pool and only assemble the file (or the sector image) at the end.
+// =============================================================================
+
+#include "../include/HfeImage.h"
+#include "../include/AtariDiskEngine.h"
+#include "../include/ImageSniffer.h"
+#include "../include/MfmCodec.h"
+#include <QFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+
+namespace Atari {
+
+namespace {
+
+constexpr std::size_t HFE_BLOCK = 512;
+constexpr std::size_t HFE_HALF_BLOCK = HFE_BLOCK / 2;
+constexpr uint8_t HFE_ENCODING_MFM = 0x00;
+constexpr uint8_t HFE_MODE_ATARIST_DD = 0x02;
+constexpr uint8_t HFE_MODE_ATARIST_HD = 0x03;
+constexpr uint16_t HFE_RPM = 300;
+/** Cells of an MFM 0x4E gap byte, used to pad the shorter side. */
+constexpr uint8_t GAP_CELLS[2] = {0x92, 0x54};
+
+/**
+ * HFE v1 header, block 0 (little-endian):
+ * 0x00 "HXCPICFE", 0x08 revision, 0x09 tracks, 0x0A sides, 0x0B encoding,
+ * 0x0C bit rate (kbit/s), 0x0E rpm, 0x10 interface mode, 0x11 unused,
+ * 0x12 track list block, 0x14 write allowed, 0x15 single step,
+ * 0x16-0x19 alternate encodings for track 0. The rest is 0xFF.
+ */
+constexpr char HFE_SIGNATURE[8] = {'H', 'X', 'C', 'P', 'I', 'C', 'F', 'E'};
+
+struct TrackJob {
+  uint32_t cylinder;
+  uint32_t side;
+  std::vector<uint8_t> cells;
+};
+
+uint8_t reverseBits(uint8_t b) {
+  b = static_cast<uint8_t>((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+  b = static_cast<uint8_t>((b & 0xCC) >> 2 | (b & 0x33) << 2);
+  return static_cast<uint8_t>((b & 0xAA) >> 1 | (b & 0x55) << 1);
+}
+
+const uint8_t *bitReverseTable() {
+  static const auto table = [] {
+    std::vector<uint8_t> t(256);
+    for (unsigned b = 0; b < 256; ++b)
+      t[b] = reverseBits(static_cast<uint8_t>(b));
+    return t;
+  }();
+  return table.data();
+}
+
+std::size_t blocksFor(std::size_t bytes) {
+  return (bytes + HFE_BLOCK - 1) / HFE_BLOCK;
+}
+
+} // namespace
+
+// =============================================================================
+//  Export
+// =============================================================================
+
+bool encodeHfe(const std::vector<uint8_t> &image, const HfeOptions &options,
+               std::vector<uint8_t> &hfe, QString &error) {
+  const SniffResult geo = sniffImage(image.data(), image.size(), image.size());
+  if (geo.type != ImageType::RawST || !geo.hasGeometry()) {
+    error = "cannot tell the disk geometry";
+    return false;
+  }
+  const uint32_t spt = static_cast<uint32_t>(geo.sectorsPerTrack);
+  const uint32_t sides = static_cast<uint32_t>(geo.sides);
+  const std::size_t trackSize = std::size_t(spt) * SECTOR_SIZE;
+  const std::size_t cylinders = image.size() / (trackSize * sides);
+  if (cylinders == 0 || cylinders > 255 ||
+      cylinders * trackSize * sides != image.size()) {
+    error = "image is not a whole number of tracks";
+    return false;
+  }
+
+  MfmTrackLayout layout = MfmTrackLayout::forSectors(spt);
+  layout.interleave = options.interleave;
+  layout.skew = options.skew;
+
+  std::vector<TrackJob> jobs;
+  for (uint32_t c = 0; c < cylinders; ++c) {
+    for (uint32_t s = 0; s < sides; ++s)
+      jobs.push_back({c, s, {}});
+  }
+  QtConcurrent::blockingMap(jobs, [&](TrackJob &job) {
+    const uint8_t *sectors =
+        image.data() + (job.cylinder * sides + job.side) * trackSize;
+    job.cells = encodeMfmTrack(sectors, static_cast<uint8_t>(job.cylinder),
+                               static_cast<uint8_t>(job.side), layout);
+  });
+
+  // Both sides of a cylinder share one length; pad the shorter with gap.
+  std::size_t sideBytes = 0;
+  for (const TrackJob &job : jobs)
+    sideBytes = std::max(sideBytes, job.cells.size());
+  if (2 * sideBytes > 0xFFFF) {
+    error = "tracks are too long for HFE";
+    return false;
+  }
+
+  const std::size_t listBlocks = blocksFor(cylinders * 4);
+  const std::size_t trackBlocks = blocksFor(2 * sideBytes);
+  hfe.assign((1 + listBlocks + cylinders * trackBlocks) * HFE_BLOCK, 0xFF);
+
+  uint8_t *h = hfe.data();
+  const bool highDensity = layout.trackBytes == MFM_HD_TRACK_BYTES;
+  std::memcpy(h, HFE_SIGNATURE, sizeof(HFE_SIGNATURE));
+  h[0x08] = 0;
+  h[0x09] = static_cast<uint8_t>(cylinders);
+  h[0x0A] = static_cast<uint8_t>(sides);
+  h[0x0B] = HFE_ENCODING_MFM;
+  writeLE16(h + 0x0C, highDensity ? 500 : 250);
+  writeLE16(h + 0x0E, HFE_RPM);
+  h[0x10] = highDensity ? HFE_MODE_ATARIST_HD : HFE_MODE_ATARIST_DD;
+  h[0x11] = 0x01;
+  writeLE16(h + 0x12, 1);
+
+  const uint8_t *reverse = bitReverseTable();
+  for (std::size_t c = 0; c < cylinders; ++c) {
+    const std::size_t firstBlock = 1 + listBlocks + c * trackBlocks;
+    writeLE16(h + HFE_BLOCK + c * 4, static_cast<uint16_t>(firstBlock));
+    writeLE16(h + HFE_BLOCK + c * 4 + 2,
+              static_cast<uint16_t>(2 * sideBytes));
+
+    uint8_t *track = h + firstBlock * HFE_BLOCK;
+    for (uint32_t s = 0; s < 2; ++s) {
+      const std::vector<uint8_t> *cells =
+          s < sides ? &jobs[c * sides + s].cells : nullptr;
+      for (std::size_t i = 0; i < trackBlocks * HFE_HALF_BLOCK; ++i) {
+        uint8_t b;
+        if (cells && i < cells->size())
+          b = (*cells)[i];
+        else
+          b = GAP_CELLS[i & 1];
+        track[(i / HFE_HALF_BLOCK) * HFE_BLOCK + s * HFE_HALF_BLOCK +
+              i % HFE_HALF_BLOCK] = reverse[b];
+      }
+    }
+  }
+  return true;
+}
+
+bool exportHfe(const std::vector<uint8_t> &image, const QString &path,
+               const HfeOptions &options, QString &error) {
+  std::vector<uint8_t> hfe;
+  if (!encodeHfe(image, options, hfe, error))
+    return false;
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly) ||
+      file.write(reinterpret_cast<const char *>(hfe.data()),
+                 static_cast<qint64>(hfe.size())) !=
+          static_cast<qint64>(hfe.size())) {
+    error = "cannot write " + path;
+    return false;
+  }
+  return true;
+}
+
+// =============================================================================
+//  Import
+// =============================================================================
+
+bool decodeHfe(const uint8_t *data, std::size_t size,
+               std::vector<uint8_t> &image, HfeReport &report,
+               QString &error) {
+  report = HfeReport();
+  if (size < HFE_BLOCK ||
+      std::memcmp(data, HFE_SIGNATURE, sizeof(HFE_SIGNATURE)) != 0) {
+    error = "not an HFE v1 file";
+    return false;
+  }
+  if (data[0x0B] != HFE_ENCODING_MFM) {
+    error = "only MFM-encoded HFE files are supported";
+    return false;
+  }
+  const uint32_t cylinders = data[0x09];
+  const uint32_t sides = data[0x0A];
+  const std::size_t list = std::size_t(readLE16(data + 0x12)) * HFE_BLOCK;
+  if (cylinders == 0 || sides == 0 || sides > 2 ||
+      list + cylinders * 4 > size) {
+    error = "HFE header is damaged";
+    return false;
+  }
+
+  std::vector<TrackJob> jobs;
+  for (uint32_t c = 0; c < cylinders; ++c) {
+    for (uint32_t s = 0; s < sides; ++s)
+      jobs.push_back({c, s, {}});
+  }
+  std::vector<std::vector<MfmSector>> found(jobs.size());
+  const uint8_t *reverse = bitReverseTable();
+  QtConcurrent::blockingMap(jobs, [&](TrackJob &job) {
+    const uint8_t *entry = data + list + job.cylinder * 4;
+    const std::size_t offset = std::size_t(readLE16(entry)) * HFE_BLOCK;
+    const std::size_t sideBytes = readLE16(entry + 2) / 2;
+    job.cells.reserve(sideBytes);
+    for (std::size_t i = 0; i < sideBytes; ++i) {
+      const std::size_t at = offset + (i / HFE_HALF_BLOCK) * HFE_BLOCK +
+                             job.side * HFE_HALF_BLOCK + i % HFE_HALF_BLOCK;
+      if (at >= size)
+        break;
+      job.cells.push_back(reverse[data[at]]);
+    }
+    found[&job - jobs.data()] =
+        decodeMfmTrack(job.cells.data(), job.cells.size() * 8);
+  });
+
+  // The highest 512-byte sector number seen sets the geometry.
+  uint32_t spt = 0;
+  for (const std::vector<MfmSector> &track : found) {
+    for (const MfmSector &s : track) {
+      if (s.sizeCode == 2 && s.sector <= 63)
+        spt = std::max<uint32_t>(spt, s.sector);
+    }
+  }
+  if (spt == 0) {
+    error = "no readable sectors";
+    return false;
+  }
+
+  const std::size_t trackSize = std::size_t(spt) * SECTOR_SIZE;
+  image.assign(cylinders * sides * trackSize, 0);
+  for (std::size_t t = 0; t < found.size(); ++t) {
+    uint8_t *track = image.data() + t * trackSize;
+    for (uint32_t n = 1; n <= spt; ++n) {
+      const MfmSector *best = nullptr;
+      for (const MfmSector &s : found[t]) {
+        if (s.sector != n || s.sizeCode != 2 || s.data.empty())
+          continue;
+        if (!best || (s.dataCrcOk && !best->dataCrcOk))
+          best = &s;
+      }
+      if (!best) {
+        ++report.missingSectors;
+        continue;
+      }
+      if (!best->dataCrcOk)
+        ++report.badSectors;
+      std::memcpy(track + (n - 1) * SECTOR_SIZE, best->data.data(),
+                  SECTOR_SIZE);
+    }
+  }
+
+  report.tracks = static_cast<int>(cylinders);
+  report.sides = static_cast<int>(sides);
+  report.sectorsPerTrack = static_cast<int>(spt);
+  return true;
+}
+
+bool importHfe(const QString &path, std::vector<uint8_t> &image,
+               HfeReport &report, QString &error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    error = "cannot open " + path;
+    return false;
+  }
+  const QByteArray data = file.readAll();
+  return decodeHfe(reinterpret_cast<const uint8_t *>(data.constData()),
+                   static_cast<std::size_t>(data.size()), image, report,
+                   error);
+}
+
+} // namespace Atari
@@ -0,0 +1,315 @@
+// =============================================================================
+//  ImageDaemon.cpp
+//  Atari ST Toolkit — Local Query Daemon
+//
+//  A request only ever touches one cached image: lookups are a stat() of the
+//  host file plus a hash probe, and file bytes are read through views, so a
+//  warm request costs microseconds rather than a full image load.
+// =============================================================================
+
+#include "../include/ImageDaemon.h"
+#include "../include/ZipArchive.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+namespace Atari {
+
+namespace {
+
+/** Longest line a client may send before the connection is dropped. */
+constexpr qint64 kMaxRequestBytes = 64 * 1024;
+
+QJsonObject failure(const QString &error) {
+  return QJsonObject{{"ok", false}, {"error", error}};
+}
+
+/** The host file behind an image path ("a.zip!/b.st" lives in a.zip). */
+QString hostFile(const QString &path) {
+  QString archive;
+  QString member;
+  return ZipArchive::splitArchivePath(path, archive, member) ? archive : path;
+}
+
+/** One spelling per image, so "./a.st" and "a.st" share an entry. */
+QString cacheKey(const QString &path) {
+  QString archive;
+  QString member;
+  if (ZipArchive::splitArchivePath(path, archive, member))
+    return ZipArchive::memberPath(QFileInfo(archive).absoluteFilePath(),
+                                  member);
+  return QFileInfo(path).absoluteFilePath();
+}
+
+void walkTree(CachedImage &image, const std::vector<DirEntry> &entries,
+              const QString &prefix, int depth) {
+  for (const DirEntry &e : entries) {
+    if (e.name[0] == '.')
+      continue;
+    const QString path =
+        prefix + AtariDiskEngine::toQString(e.getFilename());
+    image.byPath.insert(path.toUpper(), static_cast<int>(image.files.size()));
+    image.files.push_back({path, e});
+    // Same guards as the tree model: bogus clusters and runaway nesting.
+    if (e.isDirectory() && e.getStartCluster() >= 2 && depth < 16)
+      walkTree(image, image.engine.readSubDirectory(e.getStartCluster()),
+               path + "/", depth + 1);
+  }
+}
+
+/** @return In-memory size in KiB, the unit of the cache budget. */
+int costOf(const CachedImage &image) {
+  const qint64 bytes =
+      static_cast<qint64>(image.engine.getRawImageData().size()) +
+      static_cast<qint64>(image.files.size()) *
+          static_cast<qint64>(sizeof(CachedImage::File) + 64);
+  return static_cast<int>(std::max<qint64>(1, bytes / 1024));
+}
+
+/** "0x" followed by hex digits is a byte pattern, anything else text. */
+QByteArray parsePattern(const QString &arg) {
+  if (arg.startsWith("0x", Qt::CaseInsensitive))
+    return QByteArray::fromHex(arg.mid(2).toLatin1());
+  return arg.toLatin1();
+}
+
+QString dosTimestamp(const DirEntry &e) {
+  const uint16_t date = readLE16(e.date);
+  const uint16_t time = readLE16(e.time);
+  return QString("%1-%2-%3T%4:%5:%6")
+      .arg(1980 + (date >> 9))
+      .arg((date >> 5) & 0x0F, 2, 10, QChar('0'))
+      .arg(date & 0x1F, 2, 10, QChar('0'))
+      .arg(time >> 11, 2, 10, QChar('0'))
+      .arg((time >> 5) & 0x3F, 2, 10, QChar('0'))
+      .arg((time & 0x1F) * 2, 2, 10, QChar('0'));
+}
+
+const CachedImage::File *findFile(const CachedImage &image,
+                                  const QString &path) {
+  const QStringList parts =
+      QString(path).replace('\\', '/').split('/', Qt::SkipEmptyParts);
+  const auto it = image.byPath.constFind(parts.join('/').toUpper());
+  return it == image.byPath.constEnd() ? nullptr : &image.files[it.value()];
+}
+
+} // namespace
+
+// =============================================================================
+//  ImageCache
+// =============================================================================
+
+ImageCache::ImageCache(qint64 budgetBytes)
+    : m_cache(static_cast<int>(std::clamp<qint64>(budgetBytes / 1024, 1,
+                                                    INT_MAX))) {}
+
+const CachedImage *ImageCache::image(const QString &path, QString &error) {
+  const QString key = cacheKey(path);
+  const QFileInfo host(hostFile(key));
+  if (!host.exists()) {
+    error = "no such file";
+    return nullptr;
+  }
+  const qint64 size = host.size();
+  const qint64 mtime = host.lastModified().toMSecsSinceEpoch();
+
+  if (CachedImage *cached = m_cache.object(key)) {
+    if (cached->fileSize == size && cached->fileMtime == mtime) {
+      ++m_hits;
+      return cached;
+    }
+    m_cache.remove(key); // Rewritten since it was loaded
+  }
+  ++m_misses;
+
+  auto loaded = std::make_unique<CachedImage>();
+  bool ok = false;
+  try {
+    ok = loaded->engine.loadImage(key);
+  } catch (const std::exception &e) {
+    error = e.what();
+    return nullptr;
+  }
+  if (!ok) {
+    error = "cannot load image";
+    return nullptr;
+  }
+  walkTree(*loaded, loaded->engine.readRootDirectory(), QString(), 0);
+  loaded->fileSize = size;
+  loaded->fileMtime = mtime;
+
+  const int cost = costOf(*loaded);
+  if (cost > m_cache.maxCost()) {
+    m_uncached = std::move(loaded);
+    return m_uncached.get();
+  }
+  CachedImage *raw = loaded.release();
+  m_cache.insert(key, raw, cost);
+  return raw;
+}
+
+void ImageCache::evict(const QString &path) {
+  m_uncached.reset();
+  if (path.isEmpty())
+    m_cache.clear();
+  else
+    m_cache.remove(cacheKey(path));
+}
+
+QJsonObject ImageCache::stats() const {
+  return QJsonObject{{"images", m_cache.count()},
+                     {"kib", m_cache.totalCost()},
+                     {"budgetKib", m_cache.maxCost()},
+                     {"hits", m_hits},
+                     {"misses", m_misses}};
+}
+
+// =============================================================================
+//  ImageDaemon
+// =============================================================================
+
+ImageDaemon::ImageDaemon(qint64 budgetBytes, QObject *parent)
+    : QObject(parent), m_cache(budgetBytes) {
+  connect(&m_server, &QLocalServer::newConnection, this,
+          &ImageDaemon::onNewConnection);
+}
+
+bool ImageDaemon::listen(const QString &socketPath, QString &error) {
+  QLocalServer::removeServer(socketPath);
+  m_server.setSocketOptions(QLocalServer::UserAccessOption);
+  if (!m_server.listen(socketPath)) {
+    error = m_server.errorString();
+    return false;
+  }
+  return true;
+}
+
+void ImageDaemon::onNewConnection() {
+  while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+    connect(socket, &QLocalSocket::disconnected, socket,
+            &QObject::deleteLater);
+    connect(socket, &QLocalSocket::readyRead, this,
+            [this, socket] { onReadyRead(socket); });
+  }
+}
+
+void ImageDaemon::onReadyRead(QLocalSocket *socket) {
+  while (socket->canReadLine()) {
+    const QByteArray line = socket->readLine().trimmed();
+    if (line.isEmpty())
+      continue;
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    const QJsonObject reply =
+        doc.isObject() ? handle(doc.object())
+                       : failure("bad request: " + parseError.errorString());
+    socket->write(QJsonDocument(reply).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+  }
+  if (socket->bytesAvailable() > kMaxRequestBytes)
+    socket->abort();
+}
+
+QJsonObject ImageDaemon::handle(const QJsonObject &request) {
+  const QString op = request.value("op").toString();
+  const QString path = request.value("image").toString();
+
+  if (op == "stats")
+    return QJsonObject{{"ok", true}, {"cache", m_cache.stats()}};
+  if (op == "evict") {
+    m_cache.evict(path);
+    return QJsonObject{{"ok", true}};
+  }
+  if (op != "list" && op != "stat" && op != "read" && op != "search")
+    return failure("unknown op: " + op);
+  if (path.isEmpty())
+    return failure("missing image");
+
+  QString error;
+  const CachedImage *image = m_cache.image(path, error);
+  if (!image)
+    return failure(path + ": " + error);
+
+  if (op == "list") {
+    QJsonArray entries;
+    for (const CachedImage::File &f : image->files)
+      entries.append(QJsonObject{{"path", f.path},
+                                 {"size", qint64(f.entry.getFileSize())},
+                                 {"dir", f.entry.isDirectory()}});
+    return QJsonObject{{"ok", true}, {"entries", entries}};
+  }
+
+  if (op == "search") {
+    const QByteArray pattern =
+        parsePattern(request.value("pattern").toString());
+    if (pattern.isEmpty())
+      return failure("empty search pattern");
+    const std::boyer_moore_horspool_searcher<const char *> searcher(
+        pattern.constData(), pattern.constData() + pattern.size());
+    QJsonArray hits;
+    std::vector<uint8_t> copy;
+    for (const CachedImage::File &f : image->files) {
+      if (f.entry.isDirectory())
+        continue;
+      const FileView view = image->engine.fileView(f.entry);
+      const uint8_t *bytes = view.contiguous(0, view.size());
+      if (!bytes && !view.isEmpty()) {
+        copy = view.toVector();
+        bytes = copy.data();
+      }
+      const char *begin = reinterpret_cast<const char *>(bytes);
+      const char *end = begin + view.size();
+      QJsonArray offsets;
+      for (const char *at = begin;; ++at) {
+        at = std::search(at, end, searcher);
+        if (at == end)
+          break;
+        offsets.append(qint64(at - begin));
+      }
+      if (!offsets.isEmpty())
+        hits.append(QJsonObject{{"path", f.path}, {"offsets", offsets}});
+    }
+    return QJsonObject{{"ok", true}, {"hits", hits}};
+  }
+
+  const CachedImage::File *file =
+      findFile(*image, request.value("path").toString());
+  if (!file)
+    return failure("no such file in image: " +
+                   request.value("path").toString());
+
+  if (op == "stat")
+    return QJsonObject{{"ok", true},
+                       {"path", file->path},
+                       {"size", qint64(file->entry.getFileSize())},
+                       {"dir", file->entry.isDirectory()},
+                       {"attr", file->entry.attr},
+                       {"cluster", file->entry.getStartCluster()},
+                       {"modified", dosTimestamp(file->entry)}};
+
+  // read: a window of the file, the whole file by default.
+  if (file->entry.isDirectory())
+    return failure("is a directory: " + file->path);
+  const FileView view = image->engine.fileView(file->entry);
+  const qint64 offset = std::clamp<qint64>(
+      static_cast<qint64>(request.value("offset").toDouble()), 0, view.size());
+  qint64 length = view.size() - offset;
+  if (request.contains("length"))
+    length = std::clamp<qint64>(
+        static_cast<qint64>(request.value("length").toDouble()), 0, length);
+  QByteArray data(static_cast<int>(length), '\0');
+  view.read(static_cast<uint32_t>(offset),
+            reinterpret_cast<uint8_t *>(data.data()),
+            static_cast<uint32_t>(length));
+  return QJsonObject{{"ok", true},
+                     {"size", qint64(view.size())},
+                     {"offset", offset},
+                     {"data", QString::fromLatin1(data.toBase64())}};
+}
+
+} // namespace Atari
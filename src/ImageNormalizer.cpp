@@ -0,0 +1,248 @@
+// =============================================================================
+//  ImageNormalizer.cpp
+//  Atari ST Toolkit — Slack Clearing & Compressibility
+//
+//  One walk over the directory tree claims every cluster that holds live
+//  data; slack is whatever lies outside those claims. Clearing goes through
+//  FatVolume::clear(), which skips ranges that are already zero, so a second
+//  run writes nothing.
+// =============================================================================
+
+#include "../include/ImageNormalizer.h"
+#include "../include/AtariDiskEngine.h"
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <zlib.h>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint8_t SLOT_DELETED = 0xE5;
+/** MSA marks runs with this byte; a literal 0xE5 must be coded as a run. */
+constexpr uint8_t MSA_RUN_MARKER = 0xE5;
+constexpr std::size_t MSA_HEADER_SIZE = 10;
+
+} // namespace
+
+const char *slackKindName(SlackKind kind) {
+  switch (kind) {
+  case SlackKind::FreeCluster:
+    return "free";
+  case SlackKind::FileTail:
+    return "tail";
+  case SlackKind::DirectorySlot:
+    return "slot";
+  }
+  return "?";
+}
+
+// =============================================================================
+//  Finding Slack
+// =============================================================================
+
+std::vector<SlackRegion> findSlack(const FatVolume &volume) {
+  std::vector<SlackRegion> slack;
+  if (!volume.isValid())
+    return slack;
+
+  const std::vector<uint8_t> &image = volume.image();
+  const uint32_t clusterBytes = volume.geometry().clusterBytes();
+  const uint32_t end = volume.geometry().clusterCount + 2;
+
+  auto add = [&](SlackKind kind, uint32_t offset, uint32_t length) {
+    if (length == 0 || offset + length > image.size())
+      return;
+    const uint8_t *p = image.data() + offset;
+    if (std::all_of(p, p + length, [](uint8_t b) { return b == 0; }))
+      return;
+    if (!slack.empty() && slack.back().kind == kind &&
+        slack.back().offset + slack.back().length == offset)
+      slack.back().length += length;
+    else
+      slack.push_back({kind, offset, length});
+  };
+
+  // 1. Claim the clusters that hold directories and file data.
+  struct File {
+    std::vector<uint16_t> chain;
+    uint32_t size;
+  };
+  std::vector<File> files;
+  std::vector<uint8_t> claims(end, 0);
+  auto claim = [&claims](uint16_t c) {
+    if (claims[c] < 255)
+      ++claims[c];
+  };
+
+  std::vector<uint16_t> dirs{0};
+  std::vector<bool> seenDir(end, false);
+  for (std::size_t d = 0; d < dirs.size(); ++d) {
+    for (uint16_t c : volume.chain(dirs[d]))
+      claim(c);
+    for (uint32_t slot : volume.liveEntries(dirs[d])) {
+      const uint16_t start = volume.startCluster(slot);
+      if (image[slot + 11] & ATTR_DIRECTORY) {
+        if (start >= 2 && start < end && !seenDir[start]) {
+          seenDir[start] = true;
+          dirs.push_back(start);
+        }
+        continue;
+      }
+      File f{volume.chain(start), readLE32(&image[slot + 28])};
+      const std::size_t needed = (f.size + clusterBytes - 1) / clusterBytes;
+      for (std::size_t k = 0; k < f.chain.size() && k < needed; ++k)
+        claim(f.chain[k]);
+      files.push_back(std::move(f));
+    }
+  }
+
+  // 2. Free clusters, straight from the FAT, in contiguous runs.
+  for (uint32_t c = 2; c < end; ++c) {
+    if (volume.next(static_cast<uint16_t>(c)) == 0 && claims[c] == 0)
+      add(SlackKind::FreeCluster,
+          volume.clusterOffset(static_cast<uint16_t>(c)), clusterBytes);
+  }
+
+  // 3. File tails: the end of the last cluster, then clusters past EOF.
+  std::vector<bool> tailDone(end, false);
+  for (const File &f : files) {
+    const std::size_t needed = (f.size + clusterBytes - 1) / clusterBytes;
+    if (needed > 0 && needed <= f.chain.size() &&
+        f.size % clusterBytes != 0 && claims[f.chain[needed - 1]] == 1) {
+      const uint32_t used = f.size % clusterBytes;
+      add(SlackKind::FileTail,
+          volume.clusterOffset(f.chain[needed - 1]) + used,
+          clusterBytes - used);
+    }
+    for (std::size_t k = needed; k < f.chain.size(); ++k) {
+      const uint16_t c = f.chain[k];
+      if (claims[c] == 0 && !tailDone[c]) {
+        tailDone[c] = true;
+        add(SlackKind::FileTail, volume.clusterOffset(c), clusterBytes);
+      }
+    }
+  }
+
+  // 4. Directory slots: deleted entries keep their marker, and everything
+  // after the last used entry is cleared whole.
+  for (uint16_t dir : dirs) {
+    const std::vector<uint16_t> clusters = volume.chain(dir);
+    if (std::any_of(clusters.begin(), clusters.end(),
+                    [&claims](uint16_t c) { return claims[c] > 1; }))
+      continue;
+
+    const std::vector<uint32_t> offsets = volume.directorySlots(dir);
+    std::size_t used = 0;
+    for (std::size_t i = 0; i < offsets.size() && image[offsets[i]] != 0;
+         ++i) {
+      if (image[offsets[i]] != SLOT_DELETED)
+        used = i + 1;
+    }
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+      if (i >= used)
+        add(SlackKind::DirectorySlot, offsets[i], DIRENT_SIZE);
+      else if (image[offsets[i]] == SLOT_DELETED)
+        add(SlackKind::DirectorySlot, offsets[i] + 1, DIRENT_SIZE - 1);
+    }
+  }
+  return slack;
+}
+
+bool saveSlack(const FatVolume &volume, const std::vector<SlackRegion> &slack,
+               const QString &dir, QString &error) {
+  if (!QDir().mkpath(dir)) {
+    error = "cannot create " + dir;
+    return false;
+  }
+
+  const std::vector<uint8_t> &image = volume.image();
+  for (const SlackRegion &r : slack) {
+    QFile out(QDir(dir).filePath(QString("%1-%2.bin")
+                                     .arg(r.offset, 8, 16, QChar('0'))
+                                     .arg(slackKindName(r.kind))));
+    if (!out.open(QIODevice::WriteOnly) ||
+        out.write(reinterpret_cast<const char *>(image.data() + r.offset),
+                  r.length) != static_cast<qint64>(r.length)) {
+      error = "cannot write " + out.fileName();
+      return false;
+    }
+  }
+  return true;
+}
+
+// =============================================================================
+//  Clearing & Measuring
+// =============================================================================
+
+NormalizeReport normalizeImage(FatVolume &volume,
+                               const std::vector<SlackRegion> &slack) {
+  NormalizeReport r;
+  const std::vector<uint8_t> &image = volume.image();
+  const uint32_t sectorsPerTrack = readLE16(image.data() + 0x18);
+  const uint32_t sides = readLE16(image.data() + 0x1A);
+
+  r.deflateBefore = deflatedSize(image.data(), image.size());
+  r.msaBefore =
+      msaPackedSize(image.data(), image.size(), sectorsPerTrack, sides);
+
+  for (const SlackRegion &s : slack) {
+    volume.clear(s.offset, s.length);
+    switch (s.kind) {
+    case SlackKind::FreeCluster:
+      r.freeBytes += s.length;
+      break;
+    case SlackKind::FileTail:
+      r.tailBytes += s.length;
+      break;
+    case SlackKind::DirectorySlot:
+      r.slotBytes += s.length;
+      break;
+    }
+  }
+
+  r.deflateAfter = deflatedSize(image.data(), image.size());
+  r.msaAfter =
+      msaPackedSize(image.data(), image.size(), sectorsPerTrack, sides);
+  return r;
+}
+
+std::size_t deflatedSize(const uint8_t *data, std::size_t size) {
+  uLongf packed = compressBound(static_cast<uLong>(size));
+  std::vector<Bytef> out(packed);
+  if (compress2(out.data(), &packed, data, static_cast<uLong>(size),
+                Z_BEST_COMPRESSION) != Z_OK)
+    return size;
+  return packed;
+}
+
+std::size_t msaPackedSize(const uint8_t *image, std::size_t size,
+                          uint32_t sectorsPerTrack, uint32_t sides) {
+  if (sectorsPerTrack == 0 || sectorsPerTrack > 63 || sides == 0 ||
+      sides > 2)
+    return 0;
+  const std::size_t trackBytes = sectorsPerTrack * SECTOR_SIZE;
+  const std::size_t tracks = size / trackBytes;
+  if (tracks == 0)
+    return 0;
+
+  std::size_t total = MSA_HEADER_SIZE;
+  for (std::size_t t = 0; t < tracks; ++t) {
+    const uint8_t *p = image + t * trackBytes;
+    std::size_t packed = 0;
+    for (std::size_t i = 0; i < trackBytes;) {
+      std::size_t j = i + 1;
+      while (j < trackBytes && p[j] == p[i])
+        ++j;
+      // A run costs marker, byte and a 16-bit count.
+      packed += (j - i >= 4 || p[i] == MSA_RUN_MARKER) ? 4 : j - i;
+      i = j;
+    }
+    // Each track carries a length word; tracks that grow are stored raw.
+    total += 2 + std::min(packed, trackBytes);
+  }
+  return total;
+}
+
+} // namespace Atari
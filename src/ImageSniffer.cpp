@@ -0,0 +1,397 @@
+// =============================================================================
+//  ImageSniffer.cpp
+//  Atari ST Toolkit — Image Type Classification
+//
+//  Decides what a file is from its first few KB and its size, so corpus
+//  tools can route or reject files without paying for a full loadImage().
+// =============================================================================
+
+#include "../include/ImageSniffer.h"
+#include "../include/AtariDiskEngine.h"
+#include "../include/ZipArchive.h"
+#include <QFile>
+#include <QIODevice>
+#include <algorithm>
+#include <cstring>
+
+namespace Atari {
+
+namespace {
+
+/** Floppy images never get anywhere near this; anything bigger is a HD. */
+constexpr uint64_t HARDDISK_MIN_SIZE = 3 * 1024 * 1024;
+
+void setGeometry(SniffResult &r, int tracks, int sides, int spt) {
+  r.tracks = tracks;
+  r.sides = sides;
+  r.sectorsPerTrack = spt;
+  r.totalSectors = static_cast<uint32_t>(tracks) * sides * spt;
+}
+
+// =============================================================================
+//  Container Formats (magic numbers only)
+// =============================================================================
+
+bool sniffCompressed(const uint8_t *h, std::size_t n, SniffResult &r) {
+  struct Magic {
+    const char *bytes;
+    std::size_t length;
+    std::size_t offset;
+    const char *name;
+  };
+  static const Magic kMagics[] = {
+      {"PK\x03\x04", 4, 0, "zip"},
+      {"\x1F\x8B", 2, 0, "gzip"},
+      {"BZh", 3, 0, "bzip2"},
+      {"\xFD" "7zXZ\x00", 6, 0, "xz"},
+      {"7z\xBC\xAF\x27\x1C", 6, 0, "7z"},
+      {"Rar!", 4, 0, "rar"},
+      {"\x28\xB5\x2F\xFD", 4, 0, "zstd"},
+  };
+
+  for (const Magic &m : kMagics) {
+    if (n >= m.offset + m.length &&
+        std::memcmp(h + m.offset, m.bytes, m.length) == 0) {
+      r.type = ImageType::Compressed;
+      r.confidence = 95;
+      r.detail = m.name;
+      return true;
+    }
+  }
+
+  // LHarc/LHA: "-lh?-" or "-lz?-" method id at offset 2 of the first header.
+  if (n >= 7 && h[2] == '-' && h[3] == 'l' && (h[4] == 'h' || h[4] == 'z') &&
+      h[6] == '-') {
+    r.type = ImageType::Compressed;
+    r.confidence = 90;
+    r.detail = "lzh";
+    return true;
+  }
+
+  // ARC: 0x1A marker, a method byte and a printable member name.
+  if (n >= 29 && h[0] == 0x1A && h[1] >= 1 && h[1] <= 9 && h[2] > 32 &&
+      h[2] < 127) {
+    r.type = ImageType::Compressed;
+    r.confidence = 70;
+    r.detail = "arc";
+    return true;
+  }
+  return false;
+}
+
+// =============================================================================
+//  Floppy Container Formats
+// =============================================================================
+
+bool sniffMsa(const uint8_t *h, std::size_t n, SniffResult &r) {
+  /**
+   * MSA header (10 bytes, big-endian words):
+   * 0x0E0F, sectors per track, sides - 1, start track, end track.
+   */
+  if (n < 10 || readBE16(h) != 0x0E0F)
+    return false;
+
+  uint16_t spt = readBE16(h + 2);
+  uint16_t sides = readBE16(h + 4);
+  uint16_t start = readBE16(h + 6);
+  uint16_t end = readBE16(h + 8);
+
+  r.type = ImageType::MSA;
+  if (spt == 0 || spt > 40 || sides > 1 || start > end || end > 255) {
+    r.confidence = 40;
+    r.detail = "MSA magic with implausible header";
+    return true;
+  }
+
+  setGeometry(r, end - start + 1, sides + 1, spt);
+  r.confidence = 98;
+  return true;
+}
+
+bool sniffStx(const uint8_t *h, std::size_t n, SniffResult &r) {
+  /**
+   * Pasti header: "RSY\0", version (LE word, 3), tool, reserved,
+   * track count (byte at 0x0A), revision.
+   */
+  if (n < 16 || std::memcmp(h, "RSY\0", 4) != 0)
+    return false;
+
+  r.type = ImageType::STX;
+  r.confidence = (readLE16(h + 4) == 3) ? 98 : 75;
+  r.detail = QString("Pasti v%1, %2 track records")
+                 .arg(readLE16(h + 4))
+                 .arg(static_cast<int>(h[0x0A]));
+  return true;
+}
+
+bool sniffHfe(const uint8_t *h, std::size_t n, SniffResult &r) {
+  /**
+   * HFE header: "HXCPICFE", revision, track count, side count, track
+   * encoding (0 = MFM). Sector counts live in the tracks themselves.
+   */
+  if (n < 12 || std::memcmp(h, "HXCPICFE", 8) != 0)
+    return false;
+
+  r.type = ImageType::HFE;
+  if (h[9] == 0 || h[10] == 0 || h[10] > 2) {
+    r.confidence = 40;
+    r.detail = "HFE magic with implausible header";
+    return true;
+  }
+
+  r.tracks = h[9];
+  r.sides = h[10];
+  r.confidence = 98;
+  if (h[11] != 0)
+    r.detail = "not MFM-encoded";
+  return true;
+}
+
+bool sniffScp(const uint8_t *h, std::size_t n, SniffResult &r) {
+  /**
+   * SCP header: "SCP", version, disk type, revolutions, start and end
+   * track (cylinder * 2 + side), flags, cell width, heads (0 = both).
+   */
+  if (n < 16 || std::memcmp(h, "SCP", 3) != 0)
+    return false;
+
+  r.type = ImageType::SCP;
+  const int start = h[6];
+  const int end = h[7];
+  if (h[5] == 0 || start > end || end >= 168) {
+    r.confidence = 40;
+    r.detail = "SCP magic with implausible header";
+    return true;
+  }
+
+  r.sides = h[0x0A] == 0 ? 2 : 1;
+  r.tracks = r.sides == 2 ? end / 2 - start / 2 + 1 : end - start + 1;
+  r.confidence = 95;
+  r.detail = QString("%1 revolutions").arg(static_cast<int>(h[5]));
+  return true;
+}
+
+bool sniffDim(const uint8_t *h, std::size_t n, SniffResult &r) {
+  /**
+   * FastCopy Pro header (32 bytes): 0x4242, auto-detect flag, used-sectors
+   * flag, sides - 1 at 0x06, sectors per track at 0x08, start/end track at
+   * 0x0A/0x0C, density at 0x0D, then a copy of the BPB.
+   */
+  if (n < 32 || h[0] != 0x42 || h[1] != 0x42)
+    return false;
+
+  int sides = h[0x06] + 1;
+  int spt = h[0x08];
+  int start = h[0x0A];
+  int end = h[0x0C];
+
+  r.type = ImageType::DIM;
+  if (sides > 2 || spt == 0 || spt > 40 || start > end) {
+    r.confidence = 35;
+    r.detail = "DIM magic with implausible header";
+    return true;
+  }
+
+  setGeometry(r, end - start + 1, sides, spt);
+  r.confidence = 90;
+  if (h[0x03] != 0)
+    r.detail = "used sectors only";
+  return true;
+}
+
+// =============================================================================
+//  Hard Disk Images
+// =============================================================================
+
+bool sniffHardDisk(const uint8_t *h, std::size_t n, uint64_t fileSize,
+                   SniffResult &r) {
+  if (fileSize < HARDDISK_MIN_SIZE || n < SECTOR_SIZE)
+    return false;
+
+  const uint64_t sectors = fileSize / SECTOR_SIZE;
+
+  /**
+   * AHDI root sector: four 12-byte partition entries at 0x1C6, each
+   * { flag, id[3], start (BE32), size (BE32) }.
+   */
+  int partitions = 0;
+  for (int i = 0; i < 4; ++i) {
+    const uint8_t *p = h + 0x1C6 + i * 12;
+    if (!(p[0] & 0x01))
+      continue;
+    bool knownId = std::memcmp(p + 1, "GEM", 3) == 0 ||
+                   std::memcmp(p + 1, "BGM", 3) == 0 ||
+                   std::memcmp(p + 1, "XGM", 3) == 0 ||
+                   std::memcmp(p + 1, "RAW", 3) == 0;
+    uint64_t start = readBE32(p + 4);
+    uint64_t size = readBE32(p + 8);
+    if (knownId && size > 0 && start + size <= sectors)
+      ++partitions;
+  }
+
+  r.type = ImageType::HardDisk;
+  r.totalSectors = static_cast<uint32_t>(sectors);
+  if (partitions > 0) {
+    r.confidence = 95;
+    r.detail = QString("AHDI, %1 partition(s)").arg(partitions);
+  } else if (h[510] == 0x55 && h[511] == 0xAA) {
+    r.confidence = 70;
+    r.detail = "DOS MBR";
+  } else {
+    r.confidence = 30;
+    r.detail = "unpartitioned";
+  }
+  return true;
+}
+
+// =============================================================================
+//  Raw Sector Dumps
+// =============================================================================
+
+bool sniffRawBpb(const uint8_t *h, std::size_t n, uint64_t fileSize,
+                 SniffResult &r) {
+  if (n < SECTOR_SIZE)
+    return false;
+
+  uint16_t bps = readLE16(h + 0x0B);
+  uint8_t spc = h[0x0D];
+  uint16_t reserved = readLE16(h + 0x0E);
+  uint8_t fats = h[0x10];
+  uint16_t total = readLE16(h + 0x13);
+  uint16_t spt = readLE16(h + 0x18);
+  uint16_t sides = readLE16(h + 0x1A);
+
+  if (bps != SECTOR_SIZE || spc == 0 || (spc & (spc - 1)) != 0 ||
+      reserved == 0 || fats == 0 || fats > 2 || total == 0 || spt == 0 ||
+      spt > 40 || sides == 0 || sides > 2)
+    return false;
+
+  r.type = ImageType::RawST;
+  setGeometry(r, total / (spt * sides), sides, spt);
+  r.totalSectors = total;
+
+  r.confidence = 70;
+  if (static_cast<uint64_t>(total) * SECTOR_SIZE == fileSize)
+    r.confidence += 25;
+  if (total % (spt * sides) == 0)
+    r.confidence += 4;
+  if (AtariDiskEngine::validateBootChecksum(h))
+    r.detail = "executable boot sector";
+  return true;
+}
+
+bool sniffRawSize(uint64_t fileSize, SniffResult &r) {
+  /**
+   * Many game disks carry a garbage BPB, so fall back on matching the size
+   * against the usual tracks x sides x sectors layouts.
+   */
+  if (fileSize == 0 || fileSize % SECTOR_SIZE != 0)
+    return false;
+
+  const uint64_t sectors = fileSize / SECTOR_SIZE;
+  static const int kSpt[] = {9, 10, 11, 18, 36};
+  for (int spt : kSpt) {
+    for (int sides = 2; sides >= 1; --sides) {
+      if (sectors % (spt * sides) != 0)
+        continue;
+      uint64_t tracks = sectors / (spt * sides);
+      if (tracks >= 40 && tracks <= 86) {
+        r.type = ImageType::RawST;
+        r.confidence = (tracks >= 79 && tracks <= 84) ? 55 : 40;
+        r.detail = "geometry from size, no valid BPB";
+        setGeometry(r, static_cast<int>(tracks), sides, spt);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+// =============================================================================
+//  Public API
+// =============================================================================
+
+SniffResult sniffImage(const uint8_t *head, std::size_t headSize,
+                       uint64_t fileSize) {
+  SniffResult r;
+  r.fileSize = fileSize;
+  const std::size_t n = std::min(headSize, SNIFF_PROBE_SIZE);
+
+  if (!head || n == 0) {
+    r.type = ImageType::Junk;
+    r.confidence = 100;
+    r.detail = "empty";
+    return r;
+  }
+
+  if (sniffCompressed(head, n, r) || sniffMsa(head, n, r) ||
+      sniffStx(head, n, r) || sniffHfe(head, n, r) || sniffScp(head, n, r) ||
+      sniffDim(head, n, r) ||
+      sniffHardDisk(head, n, fileSize, r) ||
+      sniffRawBpb(head, n, fileSize, r) || sniffRawSize(fileSize, r))
+    return r;
+
+  if (fileSize < SECTOR_SIZE || fileSize % SECTOR_SIZE != 0) {
+    r.type = ImageType::Junk;
+    r.confidence = (fileSize < SECTOR_SIZE) ? 100 : 80;
+    r.detail = "size is not a whole number of sectors";
+  }
+  return r;
+}
+
+SniffResult sniffImageFile(const QString &path) {
+  SniffResult unreadable;
+  unreadable.type = ImageType::Junk;
+  unreadable.confidence = 100;
+  unreadable.detail = "cannot open file";
+
+  // Zip members are first-class: inflate only the probe window.
+  QString archivePath, memberPath;
+  if (ZipArchive::splitArchivePath(path, archivePath, memberPath)) {
+    ZipArchive zip(archivePath);
+    const ZipMember *member =
+        zip.isOpen() ? zip.findMember(memberPath) : nullptr;
+    std::vector<uint8_t> head;
+    if (!member || !zip.readMember(*member, head, SNIFF_PROBE_SIZE))
+      return unreadable;
+    return sniffImage(head.data(), head.size(), member->uncompressedSize);
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return unreadable;
+
+  uint8_t head[SNIFF_PROBE_SIZE];
+  qint64 got = file.read(reinterpret_cast<char *>(head), sizeof(head));
+  return sniffImage(head, got > 0 ? static_cast<std::size_t>(got) : 0,
+                    static_cast<uint64_t>(file.size()));
+}
+
+const char *imageTypeName(ImageType type) {
+  switch (type) {
+  case ImageType::RawST:
+    return "ST";
+  case ImageType::MSA:
+    return "MSA";
+  case ImageType::DIM:
+    return "DIM";
+  case ImageType::STX:
+    return "STX";
+  case ImageType::HFE:
+    return "HFE";
+  case ImageType::SCP:
+    return "SCP";
+  case ImageType::HardDisk:
+    return "HD";
+  case ImageType::Compressed:
+    return "Archive";
+  case ImageType::Junk:
+    return "Junk";
+  default:
+    return "Unknown";
+  }
+}
+
+} // namespace Atari
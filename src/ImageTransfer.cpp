@@ -0,0 +1,188 @@
+// =============================================================================
+//  ImageTransfer.cpp
+//  Atari ST Toolkit — Image to Image Copy
+//
+//  A copy is FatVolume::writeFile() fed with the source's FileView: the
+//  target chain is allocated once and filled extent by extent, so no file
+//  is ever gathered into a buffer. Folders recurse over liveEntries()
+//  lists taken before anything is written, so a copy into the same image
+//  never sees its own output.
+// =============================================================================
+
+#include "../include/ImageTransfer.h"
+#include "../include/DiskBytes.h"
+#include <cstring>
+
+namespace Atari {
+
+namespace {
+
+/** Deeper trees only come from directory loops on damaged disks. */
+constexpr int kMaxDepth = 32;
+
+QString slotName(const FatVolume &volume, uint32_t slot) {
+  return QString::fromStdString(FatVolume::fromName83(&volume.image()[slot]));
+}
+
+bool isDirectorySlot(const FatVolume &volume, uint32_t slot) {
+  return volume.image()[slot + 11] & ATTR_DIRECTORY;
+}
+
+/** @return Slot whose 32 bytes equal the entry, searching the whole tree. */
+uint32_t findSlot(const FatVolume &volume, const DirEntry &entry) {
+  std::vector<uint16_t> dirs{0};
+  std::vector<bool> seen(volume.geometry().clusterCount + 2, false);
+  for (std::size_t d = 0; d < dirs.size(); ++d) {
+    for (uint32_t slot : volume.liveEntries(dirs[d])) {
+      if (std::memcmp(&volume.image()[slot], &entry, sizeof(DirEntry)) == 0)
+        return slot;
+      const uint16_t start = volume.startCluster(slot);
+      if (isDirectorySlot(volume, slot) && start >= 2 && start < seen.size() &&
+          !seen[start]) {
+        seen[start] = true;
+        dirs.push_back(start);
+      }
+    }
+  }
+  return 0;
+}
+
+/** @return The slot of entry in from, or 0 after noting why not. */
+uint32_t locate(const FatVolume &from, const DirEntry &entry,
+                const FatVolume &to, TransferReport &report) {
+  const uint32_t slot = from.isValid() ? findSlot(from, entry) : 0;
+  const QString name = AtariDiskEngine::toQString(entry.getFilename());
+  if (!slot)
+    report.failed << name + ": not found in the source image";
+  else if (!to.isValid())
+    report.failed << name + ": target has no writable FAT12 layout";
+  return to.isValid() ? slot : 0;
+}
+
+/** @return True if dir is ancestor or lies below it, following "..". */
+bool isWithin(const FatVolume &volume, uint16_t dir, uint16_t ancestor) {
+  for (uint32_t steps = 0;
+       dir >= 2 && steps <= volume.geometry().clusterCount; ++steps) {
+    if (dir == ancestor)
+      return true;
+    const std::vector<uint32_t> entries = volume.directorySlots(dir);
+    if (entries.size() < 2 || volume.image()[entries[1]] != '.' ||
+        volume.image()[entries[1] + 1] != '.')
+      return false;
+    dir = volume.startCluster(entries[1]);
+  }
+  return false;
+}
+
+void copyInto(const FatVolume &from, uint32_t slot, FatVolume &to,
+              uint16_t dirCluster, const QString &path, int depth,
+              TransferReport &report) {
+  const uint8_t *name83 = &from.image()[slot];
+  const bool isDir = isDirectorySlot(from, slot);
+  uint32_t target = to.findEntry(dirCluster, name83);
+  if (target && isDirectorySlot(to, target) != isDir) {
+    report.failed << path + (isDir ? ": a file of that name is in the way"
+                                   : ": a folder of that name is in the way");
+    return;
+  }
+
+  if (!isDir) {
+    const bool created = !target;
+    if (created)
+      target = to.createFile(dirCluster, name83);
+    const FileView view = from.fileView(slot);
+    if (!target || !to.writeFile(target, view)) {
+      if (created && target)
+        to.removeEntry(target);
+      report.failed << path + ": disk full";
+      return;
+    }
+    ++report.files;
+    report.bytes += view.size();
+  } else {
+    if (depth >= kMaxDepth) {
+      report.failed << path + ": folders nested too deep";
+      return;
+    }
+    if (!target)
+      target = to.createDirectory(dirCluster, name83);
+    if (!target) {
+      report.failed << path + ": disk full";
+      return;
+    }
+    ++report.dirs;
+  }
+
+  to.setAttributes(target, from.image()[slot + 11]);
+  to.setTimestamp(target, readLE16(&from.image()[slot + 22]),
+                  readLE16(&from.image()[slot + 24]));
+  if (!isDir)
+    return;
+
+  const uint16_t sub = to.startCluster(target);
+  for (uint32_t child : from.liveEntries(from.startCluster(slot)))
+    copyInto(from, child, to, sub, path + "/" + slotName(from, child),
+             depth + 1, report);
+}
+
+void removeTree(FatVolume &volume, uint32_t slot, int depth) {
+  if (isDirectorySlot(volume, slot) && depth < kMaxDepth) {
+    const uint16_t start = volume.startCluster(slot);
+    if (start >= 2) {
+      for (uint32_t child : volume.liveEntries(start))
+        removeTree(volume, child, depth + 1);
+    }
+  }
+  volume.removeEntry(slot);
+}
+
+} // namespace
+
+bool copyEntry(const FatVolume &from, uint32_t slot, FatVolume &to,
+               uint16_t dirCluster, TransferReport &report) {
+  const QString path = slotName(from, slot);
+  if (&from.image() == &to.image()) {
+    if (to.findEntry(dirCluster, &from.image()[slot]) == slot) {
+      report.failed << path + ": already in that folder";
+      return false;
+    }
+    if (isDirectorySlot(from, slot) &&
+        isWithin(to, dirCluster, from.startCluster(slot))) {
+      report.failed << path + ": cannot copy a folder into itself";
+      return false;
+    }
+  }
+
+  const int failedBefore = report.failed.size();
+  copyInto(from, slot, to, dirCluster, path, 0, report);
+  return report.failed.size() == failedBefore;
+}
+
+void removeTree(FatVolume &volume, uint32_t slot) {
+  removeTree(volume, slot, 0);
+}
+
+bool copyEntry(AtariDiskEngine &from, const DirEntry &entry,
+               AtariDiskEngine &to, uint16_t dirCluster,
+               TransferReport &report) {
+  // volume() binds for writing, but the source is only read through it.
+  const FatVolume source = from.volume();
+  FatVolume target = to.volume();
+  const uint32_t slot = locate(source, entry, target, report);
+  return slot && copyEntry(source, slot, target, dirCluster, report);
+}
+
+bool moveEntry(AtariDiskEngine &from, const DirEntry &entry,
+               AtariDiskEngine &to, uint16_t dirCluster,
+               TransferReport &report) {
+  FatVolume source = from.volume();
+  FatVolume target = to.volume();
+  // Found first: after a copy within one image, the copy may match too.
+  const uint32_t slot = locate(source, entry, target, report);
+  if (!slot || !copyEntry(source, slot, target, dirCluster, report))
+    return false;
+  removeTree(source, slot);
+  return true;
+}
+
+} // namespace Atari
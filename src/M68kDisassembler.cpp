@@ -0,0 +1,785 @@
+// =============================================================================
+//  M68kDisassembler.cpp
+//  Atari ST Toolkit — 68000 Disassembler
+//
+//  Opcode classification is a single lookup in a 64K table evaluated by the
+//  compiler from the pattern list below; operand formatting then only runs
+//  for the instructions a view actually asks for.
+// =============================================================================
+
+#include "../include/M68kDisassembler.h"
+#include "../include/AtariDiskEngine.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+namespace Atari {
+
+namespace {
+
+// =============================================================================
+//  Addressing Mode Classes
+// =============================================================================
+
+/** One bit per effective address form, as used by the 68000 manual. */
+enum EaBits : uint16_t {
+  EA_DN = 1 << 0,
+  EA_AN = 1 << 1,
+  EA_IND = 1 << 2,
+  EA_POSTINC = 1 << 3,
+  EA_PREDEC = 1 << 4,
+  EA_DISP = 1 << 5,
+  EA_INDEX = 1 << 6,
+  EA_ABSW = 1 << 7,
+  EA_ABSL = 1 << 8,
+  EA_PCDISP = 1 << 9,
+  EA_PCINDEX = 1 << 10,
+  EA_IMM = 1 << 11,
+
+  EA_ALL = 0x0FFF,
+  EA_DATA = EA_ALL & ~EA_AN,
+  EA_MEM = EA_DATA & ~EA_DN,
+  EA_CTRL = EA_IND | EA_DISP | EA_INDEX | EA_ABSW | EA_ABSL | EA_PCDISP |
+            EA_PCINDEX,
+  EA_ALT = EA_ALL & ~(EA_PCDISP | EA_PCINDEX | EA_IMM),
+  EA_DALT = EA_DATA & EA_ALT,
+  EA_MALT = EA_MEM & EA_ALT,
+  EA_CALT = EA_CTRL & EA_ALT
+};
+
+constexpr uint16_t eaClass(int mode, int reg) {
+  if (mode < 7)
+    return static_cast<uint16_t>(1 << mode);
+  switch (reg) {
+  case 0:
+    return EA_ABSW;
+  case 1:
+    return EA_ABSL;
+  case 2:
+    return EA_PCDISP;
+  case 3:
+    return EA_PCINDEX;
+  case 4:
+    return EA_IMM;
+  default:
+    return 0;
+  }
+}
+
+// =============================================================================
+//  Opcode Patterns
+// =============================================================================
+
+/** Operand layout; selects the formatter in Decoder::run(). */
+enum class Form : uint8_t {
+  None,        // rts
+  ImmCcr,      // ori #x,ccr
+  ImmSr,       // ori #x,sr
+  ImmEa,       // ori.b #x,<ea>
+  BitStatic,   // btst #n,<ea>
+  BitDynamic,  // btst dn,<ea>
+  Movep,       // movep.w d(ay),dx
+  Move,        // move.l <ea>,<ea>
+  Movea,       // movea.l <ea>,an
+  Stop,        // stop #x
+  Trap,        // trap #n
+  Link,        // link an,#d
+  AReg,        // unlk an
+  ToUsp,       // move an,usp
+  FromUsp,     // move usp,an
+  DReg,        // swap dn
+  Ext,         // ext.w dn
+  Ea,          // jmp <ea>
+  SizedEa,     // clr.w <ea>
+  Movem,       // movem.l regs,<ea>
+  EaToAReg,    // lea <ea>,an
+  EaToDRegW,   // mulu.w <ea>,dn
+  FromSr,      // move sr,<ea>
+  ToCcr,       // move <ea>,ccr
+  ToSr,        // move <ea>,sr
+  DBcc,        // dbra dn,label
+  Scc,         // seq <ea>
+  Quick,       // addq.w #n,<ea>
+  Branch,      // bne.s label
+  Moveq,       // moveq #n,dn
+  EaToDReg,    // add.w <ea>,dn
+  DRegToEa,    // add.w dn,<ea>
+  EaToARegSz,  // adda.l <ea>,an
+  Extended,    // addx.w dy,dx
+  Bcd,         // abcd dy,dx
+  Cmpm,        // cmpm.b (ay)+,(ax)+
+  Exg,         // exg dx,dy
+  ShiftMem,    // asl <ea>
+  ShiftReg,    // lsr.l #n,dn
+  LineA,       // Line-A trap
+  LineF        // Line-F trap
+};
+
+/** Extra encoding constraints checked while building the table. */
+enum PatternFlags : uint8_t {
+  P_SIZED = 1 << 0,     // bits 7-6 must not be 11
+  P_NO_BYTE_AN = 1 << 1 // byte-sized forms cannot read An
+};
+
+struct OpPattern {
+  uint16_t mask;
+  uint16_t match;
+  Form form;
+  const char *mnemonic;
+  uint16_t ea; // Allowed modes for the EA in bits 5-0 (0 = not an EA)
+  uint8_t flags;
+};
+
+/**
+ * Grouped by opcode line (top nibble) and, within a line, ordered so the
+ * more specific encodings come first; the first acceptable match wins.
+ */
+constexpr OpPattern kPatterns[] = {
+    // Line 0: immediates, bit operations, movep
+    {0xFFFF, 0x003C, Form::ImmCcr, "ori", 0, 0},
+    {0xFFFF, 0x007C, Form::ImmSr, "ori", 0, 0},
+    {0xFFFF, 0x023C, Form::ImmCcr, "andi", 0, 0},
+    {0xFFFF, 0x027C, Form::ImmSr, "andi", 0, 0},
+    {0xFFFF, 0x0A3C, Form::ImmCcr, "eori", 0, 0},
+    {0xFFFF, 0x0A7C, Form::ImmSr, "eori", 0, 0},
+    {0xFF00, 0x0000, Form::ImmEa, "ori", EA_DALT, P_SIZED},
+    {0xFF00, 0x0200, Form::ImmEa, "andi", EA_DALT, P_SIZED},
+    {0xFF00, 0x0400, Form::ImmEa, "subi", EA_DALT, P_SIZED},
+    {0xFF00, 0x0600, Form::ImmEa, "addi", EA_DALT, P_SIZED},
+    {0xFF00, 0x0A00, Form::ImmEa, "eori", EA_DALT, P_SIZED},
+    {0xFF00, 0x0C00, Form::ImmEa, "cmpi", EA_DALT, P_SIZED},
+    {0xFFC0, 0x0800, Form::BitStatic, "btst", EA_DATA & ~EA_IMM, 0},
+    {0xFFC0, 0x0840, Form::BitStatic, "bchg", EA_DALT, 0},
+    {0xFFC0, 0x0880, Form::BitStatic, "bclr", EA_DALT, 0},
+    {0xFFC0, 0x08C0, Form::BitStatic, "bset", EA_DALT, 0},
+    {0xF138, 0x0108, Form::Movep, "movep", 0, 0},
+    {0xF1C0, 0x0100, Form::BitDynamic, "btst", EA_DATA, 0},
+    {0xF1C0, 0x0140, Form::BitDynamic, "bchg", EA_DALT, 0},
+    {0xF1C0, 0x0180, Form::BitDynamic, "bclr", EA_DALT, 0},
+    {0xF1C0, 0x01C0, Form::BitDynamic, "bset", EA_DALT, 0},
+
+    // Lines 1-3: move (destination checked separately)
+    {0xF000, 0x1000, Form::Move, "move", EA_ALL & ~EA_AN, 0},
+    {0xF1C0, 0x2040, Form::Movea, "movea", EA_ALL, 0},
+    {0xF000, 0x2000, Form::Move, "move", EA_ALL, 0},
+    {0xF1C0, 0x3040, Form::Movea, "movea", EA_ALL, 0},
+    {0xF000, 0x3000, Form::Move, "move", EA_ALL, 0},
+
+    // Line 4: miscellaneous
+    {0xFFFF, 0x4AFC, Form::None, "illegal", 0, 0},
+    {0xFFFF, 0x4E70, Form::None, "reset", 0, 0},
+    {0xFFFF, 0x4E71, Form::None, "nop", 0, 0},
+    {0xFFFF, 0x4E72, Form::Stop, "stop", 0, 0},
+    {0xFFFF, 0x4E73, Form::None, "rte", 0, 0},
+    {0xFFFF, 0x4E75, Form::None, "rts", 0, 0},
+    {0xFFFF, 0x4E76, Form::None, "trapv", 0, 0},
+    {0xFFFF, 0x4E77, Form::None, "rtr", 0, 0},
+    {0xFFF0, 0x4E40, Form::Trap, "trap", 0, 0},
+    {0xFFF8, 0x4E50, Form::Link, "link", 0, 0},
+    {0xFFF8, 0x4E58, Form::AReg, "unlk", 0, 0},
+    {0xFFF8, 0x4E60, Form::ToUsp, "move", 0, 0},
+    {0xFFF8, 0x4E68, Form::FromUsp, "move", 0, 0},
+    {0xFFF8, 0x4840, Form::DReg, "swap", 0, 0},
+    {0xFFB8, 0x4880, Form::Ext, "ext", 0, 0},
+    {0xFFC0, 0x4840, Form::Ea, "pea", EA_CTRL, 0},
+    {0xFF80, 0x4880, Form::Movem, "movem", EA_CALT | EA_PREDEC, 0},
+    {0xFF80, 0x4C80, Form::Movem, "movem", EA_CTRL | EA_POSTINC, 0},
+    {0xFFC0, 0x4E80, Form::Ea, "jsr", EA_CTRL, 0},
+    {0xFFC0, 0x4EC0, Form::Ea, "jmp", EA_CTRL, 0},
+    {0xF1C0, 0x41C0, Form::EaToAReg, "lea", EA_CTRL, 0},
+    {0xF1C0, 0x4180, Form::EaToDRegW, "chk", EA_DATA, 0},
+    {0xFFC0, 0x40C0, Form::FromSr, "move", EA_DALT, 0},
+    {0xFFC0, 0x44C0, Form::ToCcr, "move", EA_DATA, 0},
+    {0xFFC0, 0x46C0, Form::ToSr, "move", EA_DATA, 0},
+    {0xFF00, 0x4000, Form::SizedEa, "negx", EA_DALT, P_SIZED},
+    {0xFF00, 0x4200, Form::SizedEa, "clr", EA_DALT, P_SIZED},
+    {0xFF00, 0x4400, Form::SizedEa, "neg", EA_DALT, P_SIZED},
+    {0xFF00, 0x4600, Form::SizedEa, "not", EA_DALT, P_SIZED},
+    {0xFFC0, 0x4800, Form::Ea, "nbcd", EA_DALT, 0},
+    {0xFFC0, 0x4AC0, Form::Ea, "tas", EA_DALT, 0},
+    {0xFF00, 0x4A00, Form::SizedEa, "tst", EA_DALT, P_SIZED},
+
+    // Line 5: addq, subq, Scc, DBcc
+    {0xF0F8, 0x50C8, Form::DBcc, "db", 0, 0},
+    {0xF0C0, 0x50C0, Form::Scc, "s", EA_DALT, 0},
+    {0xF100, 0x5000, Form::Quick, "addq", EA_ALT, P_SIZED | P_NO_BYTE_AN},
+    {0xF100, 0x5100, Form::Quick, "subq", EA_ALT, P_SIZED | P_NO_BYTE_AN},
+
+    // Line 6: branches
+    {0xF000, 0x6000, Form::Branch, "b", 0, 0},
+
+    // Line 7: moveq
+    {0xF100, 0x7000, Form::Moveq, "moveq", 0, 0},
+
+    // Line 8: or, div, sbcd
+    {0xF1C0, 0x80C0, Form::EaToDRegW, "divu", EA_DATA, 0},
+    {0xF1C0, 0x81C0, Form::EaToDRegW, "divs", EA_DATA, 0},
+    {0xF1F0, 0x8100, Form::Bcd, "sbcd", 0, 0},
+    {0xF100, 0x8000, Form::EaToDReg, "or", EA_DATA, P_SIZED},
+    {0xF100, 0x8100, Form::DRegToEa, "or", EA_MALT, P_SIZED},
+
+    // Line 9: sub
+    {0xF0C0, 0x90C0, Form::EaToARegSz, "suba", EA_ALL, 0},
+    {0xF130, 0x9100, Form::Extended, "subx", 0, P_SIZED},
+    {0xF100, 0x9000, Form::EaToDReg, "sub", EA_ALL, P_SIZED | P_NO_BYTE_AN},
+    {0xF100, 0x9100, Form::DRegToEa, "sub", EA_MALT, P_SIZED},
+
+    // Line A: unimplemented, used by the ST for Line-A graphics calls
+    {0xF000, 0xA000, Form::LineA, "linea", 0, 0},
+
+    // Line B: cmp, eor
+    {0xF0C0, 0xB0C0, Form::EaToARegSz, "cmpa", EA_ALL, 0},
+    {0xF138, 0xB108, Form::Cmpm, "cmpm", 0, P_SIZED},
+    {0xF100, 0xB100, Form::DRegToEa, "eor", EA_DALT, P_SIZED},
+    {0xF100, 0xB000, Form::EaToDReg, "cmp", EA_ALL, P_SIZED | P_NO_BYTE_AN},
+
+    // Line C: and, mul, abcd, exg
+    {0xF1C0, 0xC0C0, Form::EaToDRegW, "mulu", EA_DATA, 0},
+    {0xF1C0, 0xC1C0, Form::EaToDRegW, "muls", EA_DATA, 0},
+    {0xF1F0, 0xC100, Form::Bcd, "abcd", 0, 0},
+    {0xF1F8, 0xC140, Form::Exg, "exg", 0, 0},
+    {0xF1F8, 0xC148, Form::Exg, "exg", 0, 0},
+    {0xF1F8, 0xC188, Form::Exg, "exg", 0, 0},
+    {0xF100, 0xC000, Form::EaToDReg, "and", EA_DATA, P_SIZED},
+    {0xF100, 0xC100, Form::DRegToEa, "and", EA_MALT, P_SIZED},
+
+    // Line D: add
+    {0xF0C0, 0xD0C0, Form::EaToARegSz, "adda", EA_ALL, 0},
+    {0xF130, 0xD100, Form::Extended, "addx", 0, P_SIZED},
+    {0xF100, 0xD000, Form::EaToDReg, "add", EA_ALL, P_SIZED | P_NO_BYTE_AN},
+    {0xF100, 0xD100, Form::DRegToEa, "add", EA_MALT, P_SIZED},
+
+    // Line E: shifts and rotates
+    {0xF8C0, 0xE0C0, Form::ShiftMem, "", EA_MALT, 0},
+    {0xF000, 0xE000, Form::ShiftReg, "", 0, P_SIZED},
+
+    // Line F: unimplemented
+    {0xF000, 0xF000, Form::LineF, "linef", 0, 0},
+};
+
+constexpr int kPatternCount = sizeof(kPatterns) / sizeof(kPatterns[0]);
+static_assert(kPatternCount < 255, "pattern index must fit the table");
+
+constexpr bool patternAccepts(const OpPattern &p, uint16_t op) {
+  if ((op & p.mask) != p.match)
+    return false;
+
+  const int size = (op >> 6) & 3;
+  if ((p.flags & P_SIZED) && size == 3)
+    return false;
+
+  if (p.ea) {
+    const uint16_t cls = eaClass((op >> 3) & 7, op & 7);
+    if (!(cls & p.ea))
+      return false;
+    if ((p.flags & P_NO_BYTE_AN) && size == 0 && cls == EA_AN)
+      return false;
+  }
+
+  // Moves also carry a destination EA with register and mode swapped.
+  if (p.form == Form::Move) {
+    const uint16_t dst = eaClass((op >> 6) & 7, (op >> 9) & 7);
+    if (!(dst & EA_DALT))
+      return false;
+  }
+  return true;
+}
+
+constexpr bool patternsSortedByLine() {
+  for (int p = 1; p < kPatternCount; ++p)
+    if ((kPatterns[p].match >> 12) < (kPatterns[p - 1].match >> 12))
+      return false;
+  return true;
+}
+static_assert(patternsSortedByLine(), "patterns must be grouped by line");
+
+/** First pattern index of every opcode line, plus an end marker. */
+constexpr std::array<uint8_t, 17> buildLineStarts() {
+  std::array<uint8_t, 17> starts{};
+  int p = 0;
+  for (int line = 0; line < 16; ++line) {
+    while (p < kPatternCount && (kPatterns[p].match >> 12) < line)
+      ++p;
+    starts[line] = static_cast<uint8_t>(p);
+  }
+  starts[16] = static_cast<uint8_t>(kPatternCount);
+  return starts;
+}
+
+constexpr std::array<uint8_t, 17> kLineStarts = buildLineStarts();
+
+constexpr std::array<uint8_t, 65536> buildDecodeTable() {
+  std::array<uint8_t, 65536> table{};
+  for (uint32_t op = 0; op < 65536; ++op) {
+    const int line = op >> 12;
+    for (int p = kLineStarts[line]; p < kLineStarts[line + 1]; ++p) {
+      if (patternAccepts(kPatterns[p], static_cast<uint16_t>(op))) {
+        table[op] = static_cast<uint8_t>(p + 1);
+        break;
+      }
+    }
+  }
+  return table;
+}
+
+constexpr std::array<uint8_t, 65536> kDecodeTable = buildDecodeTable();
+
+static_assert(kDecodeTable[0x4E75] != 0, "rts must decode");
+static_assert(kDecodeTable[0x4AFC] != 0, "illegal must decode");
+static_assert(kDecodeTable[0x4E7A] == 0, "movec is not a 68000 opcode");
+
+// =============================================================================
+//  Formatting
+// =============================================================================
+
+const char *const kConditions[16] = {"t",  "f",  "hi", "ls", "cc", "cs",
+                                     "ne", "eq", "vc", "vs", "pl", "mi",
+                                     "ge", "lt", "gt", "le"};
+
+const char *const kShiftNames[4] = {"as", "ls", "rox", "ro"};
+
+const char kSizeSuffix[3] = {'b', 'w', 'l'};
+
+std::string hex(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "$%X", value);
+  return buf;
+}
+
+std::string signedHex(int32_t value) {
+  if (value < 0)
+    return "-" + hex(static_cast<uint32_t>(-static_cast<int64_t>(value)));
+  return hex(static_cast<uint32_t>(value));
+}
+
+std::string address(uint32_t value) {
+  char buf[16];
+  std::snprintf(buf, sizeof(buf), "$%06X", value & 0xFFFFFF);
+  return buf;
+}
+
+/** Decodes one instruction; extension words are consumed as formatted. */
+class Decoder {
+public:
+  Decoder(const uint8_t *code, std::size_t size, uint32_t base,
+          const M68kSymbolizer &symbolizer, uint32_t offset)
+      : m_code(code), m_size(size), m_base(base), m_symbolizer(symbolizer),
+        m_start(offset), m_pos(offset) {}
+
+  M68kInstruction run();
+
+private:
+  uint16_t word() {
+    if (m_pos + 2 > m_size) {
+      m_overrun = true;
+      m_pos += 2;
+      return 0;
+    }
+    const uint16_t v = readBE16(m_code + m_pos);
+    m_pos += 2;
+    return v;
+  }
+
+  uint32_t longword() {
+    const uint32_t hi = word();
+    return (hi << 16) | word();
+  }
+
+  /** Names a 32-bit operand stored at the given buffer offset. */
+  std::string longOperand(uint32_t at, uint32_t value, bool isAddress) {
+    std::string name;
+    if (m_symbolizer && m_symbolizer(at, value, name))
+      return name;
+    return isAddress ? address(value) : hex(value);
+  }
+
+  std::string indexSuffix(uint16_t ext) {
+    std::string s = (ext & 0x8000) ? "a" : "d";
+    s += static_cast<char>('0' + ((ext >> 12) & 7));
+    s += (ext & 0x0800) ? ".l" : ".w";
+    return s;
+  }
+
+  /** Formats the EA given by mode/reg; size is 0/1/2 for .b/.w/.l. */
+  std::string ea(int mode, int reg, int size) {
+    const std::string an = "a" + std::to_string(reg);
+    switch (mode) {
+    case 0:
+      return "d" + std::to_string(reg);
+    case 1:
+      return an;
+    case 2:
+      return "(" + an + ")";
+    case 3:
+      return "(" + an + ")+";
+    case 4:
+      return "-(" + an + ")";
+    case 5:
+      return signedHex(static_cast<int16_t>(word())) + "(" + an + ")";
+    case 6: {
+      const uint16_t ext = word();
+      return signedHex(static_cast<int8_t>(ext & 0xFF)) + "(" + an + "," +
+             indexSuffix(ext) + ")";
+    }
+    default:
+      break;
+    }
+
+    switch (reg) {
+    case 0:
+      return address(static_cast<uint32_t>(
+                 static_cast<int32_t>(static_cast<int16_t>(word())))) +
+             ".w";
+    case 1: {
+      const uint32_t at = m_pos;
+      return longOperand(at, longword(), true);
+    }
+    case 2: {
+      const uint32_t pc = m_base + m_pos;
+      return address(pc + static_cast<int16_t>(word())) + "(pc)";
+    }
+    case 3: {
+      const uint32_t pc = m_base + m_pos;
+      const uint16_t ext = word();
+      return address(pc + static_cast<int8_t>(ext & 0xFF)) + "(pc," +
+             indexSuffix(ext) + ")";
+    }
+    case 4:
+      return "#" + immediate(size);
+    default:
+      m_overrun = true;
+      return "?";
+    }
+  }
+
+  std::string ea(uint16_t op, int size) {
+    return ea((op >> 3) & 7, op & 7, size);
+  }
+
+  std::string immediate(int size) {
+    if (size == 2) {
+      const uint32_t at = m_pos;
+      return longOperand(at, longword(), false);
+    }
+    const uint16_t v = word();
+    return hex(size == 0 ? (v & 0xFF) : v);
+  }
+
+  std::string branchTarget(int32_t displacement, uint32_t pcOffset) {
+    return address(m_base + pcOffset + displacement);
+  }
+
+  static std::string regList(uint16_t mask, bool reversed) {
+    // Predecrement mode stores the mask bit-reversed (a7..d0).
+    if (reversed) {
+      uint16_t r = 0;
+      for (int i = 0; i < 16; ++i)
+        if (mask & (1u << i))
+          r |= static_cast<uint16_t>(1u << (15 - i));
+      mask = r;
+    }
+
+    std::string out;
+    for (int bank = 0; bank < 2; ++bank) {
+      const char prefix = bank ? 'a' : 'd';
+      int i = 0;
+      while (i < 8) {
+        if (!(mask & (1u << (bank * 8 + i)))) {
+          ++i;
+          continue;
+        }
+        int j = i;
+        while (j + 1 < 8 && (mask & (1u << (bank * 8 + j + 1))))
+          ++j;
+        if (!out.empty())
+          out += '/';
+        out += prefix;
+        out += static_cast<char>('0' + i);
+        if (j > i) {
+          out += '-';
+          out += prefix;
+          out += static_cast<char>('0' + j);
+        }
+        i = j + 1;
+      }
+    }
+    return out.empty() ? "#0" : out;
+  }
+
+  static std::string sized(const char *mnemonic, int size) {
+    std::string s = mnemonic;
+    s += '.';
+    s += kSizeSuffix[size];
+    return s;
+  }
+
+  const uint8_t *m_code;
+  std::size_t m_size;
+  uint32_t m_base;
+  const M68kSymbolizer &m_symbolizer;
+  uint32_t m_start;
+  uint32_t m_pos;
+  bool m_overrun = false;
+};
+
+M68kInstruction Decoder::run() {
+  M68kInstruction ins;
+  ins.offset = m_start;
+
+  const uint16_t op = word();
+  const uint8_t cls = m_overrun ? 0 : kDecodeTable[op];
+  const int size = (op >> 6) & 3;
+  const int rx = (op >> 9) & 7;
+  const int ry = op & 7;
+
+  std::string name;
+  std::string operands;
+
+  if (cls) {
+    const OpPattern &p = kPatterns[cls - 1];
+    name = p.mnemonic;
+
+    switch (p.form) {
+    case Form::None:
+      break;
+    case Form::ImmCcr:
+      operands = "#" + immediate(0) + ",ccr";
+      break;
+    case Form::ImmSr:
+      operands = "#" + immediate(1) + ",sr";
+      break;
+    case Form::ImmEa:
+      name = sized(p.mnemonic, size);
+      operands = "#" + immediate(size);
+      operands += "," + ea(op, size);
+      break;
+    case Form::BitStatic:
+      operands = "#" + std::to_string(word() & 0xFF);
+      operands += "," + ea(op, 0);
+      break;
+    case Form::BitDynamic:
+      operands = "d" + std::to_string(rx) + "," + ea(op, 0);
+      break;
+    case Form::Movep: {
+      name = (op & 0x40) ? "movep.l" : "movep.w";
+      const std::string mem =
+          signedHex(static_cast<int16_t>(word())) + "(a" +
+          std::to_string(ry) + ")";
+      const std::string reg = "d" + std::to_string(rx);
+      operands = (op & 0x80) ? reg + "," + mem : mem + "," + reg;
+      break;
+    }
+    case Form::Move:
+    case Form::Movea: {
+      static const int kMoveSize[4] = {0, 0, 2, 1};
+      const int msize = kMoveSize[op >> 12];
+      name = sized(p.mnemonic, msize);
+      operands = ea(op, msize);
+      if (p.form == Form::Movea)
+        operands += ",a" + std::to_string(rx);
+      else
+        operands += "," + ea((op >> 6) & 7, rx, msize);
+      break;
+    }
+    case Form::Stop:
+      operands = "#" + immediate(1);
+      break;
+    case Form::Trap:
+      operands = "#" + std::to_string(op & 0xF);
+      break;
+    case Form::Link:
+      operands = "a" + std::to_string(ry) + ",#" +
+                 signedHex(static_cast<int16_t>(word()));
+      break;
+    case Form::AReg:
+      operands = "a" + std::to_string(ry);
+      break;
+    case Form::ToUsp:
+      operands = "a" + std::to_string(ry) + ",usp";
+      break;
+    case Form::FromUsp:
+      operands = "usp,a" + std::to_string(ry);
+      break;
+    case Form::DReg:
+      operands = "d" + std::to_string(ry);
+      break;
+    case Form::Ext:
+      name = (op & 0x40) ? "ext.l" : "ext.w";
+      operands = "d" + std::to_string(ry);
+      break;
+    case Form::Ea:
+      operands = ea(op, 0);
+      break;
+    case Form::SizedEa:
+      name = sized(p.mnemonic, size);
+      operands = ea(op, size);
+      break;
+    case Form::Movem: {
+      const int msize = (op & 0x40) ? 2 : 1;
+      name = sized(p.mnemonic, msize);
+      const uint16_t mask = word();
+      const std::string regs = regList(mask, ((op >> 3) & 7) == 4);
+      const std::string target = ea(op, msize);
+      operands = (op & 0x0400) ? target + "," + regs : regs + "," + target;
+      break;
+    }
+    case Form::EaToAReg:
+      operands = ea(op, 2) + ",a" + std::to_string(rx);
+      break;
+    case Form::EaToDRegW:
+      name = sized(p.mnemonic, 1);
+      operands = ea(op, 1) + ",d" + std::to_string(rx);
+      break;
+    case Form::FromSr:
+      operands = "sr," + ea(op, 1);
+      break;
+    case Form::ToCcr:
+      operands = ea(op, 1) + ",ccr";
+      break;
+    case Form::ToSr:
+      operands = ea(op, 1) + ",sr";
+      break;
+    case Form::DBcc: {
+      const int cond = (op >> 8) & 0xF;
+      name = cond == 1 ? "dbra" : std::string("db") + kConditions[cond];
+      const uint32_t pc = m_pos;
+      const int16_t disp = static_cast<int16_t>(word());
+      operands = "d" + std::to_string(ry) + "," + branchTarget(disp, pc);
+      break;
+    }
+    case Form::Scc:
+      name = std::string("s") + kConditions[(op >> 8) & 0xF];
+      operands = ea(op, 0);
+      break;
+    case Form::Quick: {
+      const int data = rx ? rx : 8;
+      name = sized(p.mnemonic, size);
+      operands = "#" + std::to_string(data) + "," + ea(op, size);
+      break;
+    }
+    case Form::Branch: {
+      const int cond = (op >> 8) & 0xF;
+      name = cond == 0   ? "bra"
+             : cond == 1 ? "bsr"
+                         : std::string("b") + kConditions[cond];
+      const uint32_t pc = m_pos;
+      int32_t disp = static_cast<int8_t>(op & 0xFF);
+      if (disp == 0) {
+        disp = static_cast<int16_t>(word());
+        name += ".w";
+      } else {
+        name += ".s";
+      }
+      operands = branchTarget(disp, pc);
+      break;
+    }
+    case Form::Moveq:
+      operands = "#" + signedHex(static_cast<int8_t>(op & 0xFF)) + ",d" +
+                 std::to_string(rx);
+      break;
+    case Form::EaToDReg:
+      name = sized(p.mnemonic, size);
+      operands = ea(op, size) + ",d" + std::to_string(rx);
+      break;
+    case Form::DRegToEa:
+      name = sized(p.mnemonic, size);
+      operands = "d" + std::to_string(rx) + "," + ea(op, size);
+      break;
+    case Form::EaToARegSz: {
+      const int asize = (op & 0x0100) ? 2 : 1;
+      name = sized(p.mnemonic, asize);
+      operands = ea(op, asize) + ",a" + std::to_string(rx);
+      break;
+    }
+    case Form::Extended:
+    case Form::Bcd:
+      if (p.form == Form::Extended)
+        name = sized(p.mnemonic, size);
+      if (op & 0x08)
+        operands = "-(a" + std::to_string(ry) + "),-(a" + std::to_string(rx) +
+                   ")";
+      else
+        operands = "d" + std::to_string(ry) + ",d" + std::to_string(rx);
+      break;
+    case Form::Cmpm:
+      name = sized(p.mnemonic, size);
+      operands = "(a" + std::to_string(ry) + ")+,(a" + std::to_string(rx) +
+                 ")+";
+      break;
+    case Form::Exg: {
+      const int opmode = (op >> 3) & 0x1F;
+      const char *first = opmode == 0x09 ? "a" : "d";
+      const char *second = opmode == 0x08 ? "d" : "a";
+      operands = first + std::to_string(rx) + "," + second +
+                 std::to_string(ry);
+      break;
+    }
+    case Form::ShiftMem:
+      name = std::string(kShiftNames[(op >> 9) & 3]) +
+             ((op & 0x0100) ? "l" : "r");
+      operands = ea(op, 1);
+      break;
+    case Form::ShiftReg: {
+      name = std::string(kShiftNames[(op >> 3) & 3]) +
+             ((op & 0x0100) ? "l" : "r");
+      name = sized(name.c_str(), size);
+      const std::string count = (op & 0x20)
+                                    ? "d" + std::to_string(rx)
+                                    : "#" + std::to_string(rx ? rx : 8);
+      operands = count + ",d" + std::to_string(ry);
+      break;
+    }
+    case Form::LineA:
+    case Form::LineF:
+      operands = hex(op);
+      break;
+    }
+  }
+
+  if (!cls || m_overrun) {
+    // Illegal or cut off by the end of the buffer: show the raw word.
+    ins.valid = false;
+    ins.length = 2;
+    ins.text = "dc.w    " + hex(op);
+    if (m_start + 2 > m_size) {
+      ins.length = static_cast<uint16_t>(m_size - m_start);
+      ins.text = "dc.b    " + hex(m_code[m_start]);
+    }
+    return ins;
+  }
+
+  ins.valid = true;
+  ins.length = static_cast<uint16_t>(m_pos - m_start);
+  ins.text = name;
+  if (!operands.empty()) {
+    ins.text.resize(std::max<std::size_t>(ins.text.size() + 1, 8), ' ');
+    ins.text += operands;
+  }
+  return ins;
+}
+
+} // namespace
+
+// =============================================================================
+//  Public API
+// =============================================================================
+
+M68kDisassembler::M68kDisassembler(const uint8_t *code, std::size_t size,
+                                   uint32_t baseAddress)
+    : m_code(code), m_size(size), m_base(baseAddress) {}
+
+M68kInstruction M68kDisassembler::decode(uint32_t offset) const {
+  if (offset >= m_size) {
+    M68kInstruction ins;
+    ins.offset = offset;
+    ins.length = 0;
+    return ins;
+  }
+  return Decoder(m_code, m_size, m_base, m_symbolizer, offset).run();
+}
+
+uint8_t m68kOpcodeClass(uint16_t opcode) noexcept {
+  return kDecodeTable[opcode];
+}
+
+} // namespace Atari
@@ -0,0 +1,74 @@
+// =============================================================================
+//  MemoryBudget.cpp
+//  Atari ST Toolkit — Session Memory Limit
+//
+//  Trimming goes in two passes so that cheap losses come first: every idle
+//  client drops its caches before any client is asked to page its image
+//  out, since a paged-out image costs a file read to bring back.
+// =============================================================================
+
+#include "../include/MemoryBudget.h"
+#include <algorithm>
+
+namespace Atari {
+
+int MemoryBudget::add(Client client) {
+  m_clients.push_back({m_nextId, std::move(client), ++m_clock});
+  return m_nextId++;
+}
+
+void MemoryBudget::remove(int id) {
+  m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+                                 [id](const Entry &e) { return e.id == id; }),
+                  m_clients.end());
+}
+
+void MemoryBudget::touch(int id) {
+  for (Entry &e : m_clients) {
+    if (e.id == id)
+      e.lastUse = ++m_clock;
+  }
+}
+
+std::size_t MemoryBudget::residentBytes() const {
+  std::size_t total = 0;
+  for (const Entry &e : m_clients) {
+    if (e.client.residentBytes)
+      total += e.client.residentBytes();
+  }
+  return total;
+}
+
+std::size_t MemoryBudget::enforce() {
+  std::size_t used = residentBytes();
+  if (used <= m_limit || m_clients.size() < 2)
+    return used;
+
+  // Oldest first; the most recently used client is the one in use.
+  std::vector<Entry *> idle;
+  for (Entry &e : m_clients)
+    idle.push_back(&e);
+  std::sort(idle.begin(), idle.end(), [](const Entry *a, const Entry *b) {
+    return a->lastUse < b->lastUse;
+  });
+  idle.pop_back();
+
+  for (Entry *e : idle) {
+    if (!e->client.dropCaches)
+      continue;
+    e->client.dropCaches();
+    used = residentBytes();
+    if (used <= m_limit)
+      return used;
+  }
+  for (Entry *e : idle) {
+    if (!e->client.pageOut || !e->client.pageOut())
+      continue;
+    used = residentBytes();
+    if (used <= m_limit)
+      return used;
+  }
+  return used;
+}
+
+} // namespace Atari
@@ -0,0 +1,323 @@
+// =============================================================================
+//  MfmCodec.cpp
+//  Atari ST Toolkit — MFM Track Encoding & Decoding
+//
+//  Both directions are table-driven: a data byte and the last bit before it
+//  select 16 ready-made cells, and a cell byte selects the four data bits
+//  it carries. The CRC runs eight bytes per step over sliced tables.
+// =============================================================================
+
+#include "../include/MfmCodec.h"
+#include "../include/AtariDiskEngine.h"
+#include <algorithm>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint16_t SYNC_CELLS = 0x4489; /**< A1 with bit 4's clock missing. */
+constexpr uint64_t SYNC_RUN = 0x448944894489ULL;
+constexpr uint64_t SYNC_RUN_MASK = 0xFFFFFFFFFFFFULL;
+constexpr uint8_t MARK_ID = 0xFE;
+constexpr uint8_t MARK_DATA = 0xFB;
+constexpr uint8_t MARK_DELETED = 0xF8;
+constexpr uint8_t GAP_FILL = 0x4E;
+/** How far past an ID field its data mark may be, in cells. */
+constexpr std::size_t DATA_MARK_WINDOW = 64 * 16;
+/** Anything past 1024 bytes is not a sector the WD1772 can read. */
+constexpr uint8_t MAX_SIZE_CODE = 3;
+
+struct Tables {
+  uint16_t encode[2][256]; /**< [previous data bit][byte] -> cells. */
+  uint8_t decode[256];     /**< Four cell pairs -> four data bits. */
+  uint16_t crc[8][256];    /**< crc[k][b]: b followed by k zero bytes. */
+};
+
+const Tables &tables() {
+  static const Tables t = [] {
+    Tables t{};
+    for (unsigned prev = 0; prev < 2; ++prev) {
+      for (unsigned b = 0; b < 256; ++b) {
+        unsigned last = prev;
+        uint16_t cells = 0;
+        for (int i = 7; i >= 0; --i) {
+          const unsigned d = (b >> i) & 1;
+          const unsigned clock = !(last | d);
+          cells = static_cast<uint16_t>((cells << 2) | (clock << 1) | d);
+          last = d;
+        }
+        t.encode[prev][b] = cells;
+      }
+    }
+    for (unsigned c = 0; c < 256; ++c) {
+      t.decode[c] = static_cast<uint8_t>(((c >> 3) & 8) | ((c >> 2) & 4) |
+                                         ((c >> 1) & 2) | (c & 1));
+    }
+    for (unsigned b = 0; b < 256; ++b) {
+      uint16_t crc = static_cast<uint16_t>(b << 8);
+      for (int i = 0; i < 8; ++i)
+        crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021
+                                                   : crc << 1);
+      t.crc[0][b] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+      for (unsigned b = 0; b < 256; ++b) {
+        const uint16_t prev = t.crc[k - 1][b];
+        t.crc[k][b] =
+            static_cast<uint16_t>((prev << 8) ^ t.crc[0][prev >> 8]);
+      }
+    }
+    return t;
+  }();
+  return t;
+}
+
+/** Appends encoded bytes to a track, tracking the last data bit. */
+class MfmWriter {
+public:
+  explicit MfmWriter(std::vector<uint8_t> &out)
+      : m_out(out), m_encode(tables().encode) {}
+
+  void put(uint8_t b) {
+    const uint16_t cells = m_encode[m_last][b];
+    m_out.push_back(static_cast<uint8_t>(cells >> 8));
+    m_out.push_back(static_cast<uint8_t>(cells));
+    m_last = b & 1;
+  }
+
+  void put(const uint8_t *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i)
+      put(data[i]);
+  }
+
+  void fill(uint8_t b, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i)
+      put(b);
+  }
+
+  void sync() {
+    for (int i = 0; i < 3; ++i) {
+      m_out.push_back(SYNC_CELLS >> 8);
+      m_out.push_back(SYNC_CELLS & 0xFF);
+    }
+    m_last = 1; // A1 ends in a one
+  }
+
+private:
+  std::vector<uint8_t> &m_out;
+  const uint16_t (*m_encode)[256];
+  unsigned m_last = 0;
+};
+
+/** Reads MFM cells at any bit offset. */
+class MfmReader {
+public:
+  MfmReader(const uint8_t *cells, std::size_t cellCount)
+      : m_cells(cells), m_count(cellCount), m_decode(tables().decode) {}
+
+  std::size_t size() const { return m_count; }
+
+  bool bit(std::size_t pos) const {
+    return (m_cells[pos >> 3] >> (7 - (pos & 7))) & 1;
+  }
+
+  /** @return The data byte in the 16 cells at pos (caller checks range). */
+  uint8_t byteAt(std::size_t pos) const {
+    const std::size_t i = pos >> 3;
+    const unsigned shift = pos & 7;
+    uint32_t w = (static_cast<uint32_t>(m_cells[i]) << 16) |
+                 (static_cast<uint32_t>(m_cells[i + 1]) << 8);
+    if (shift != 0)
+      w |= m_cells[i + 2];
+    const uint16_t cells = static_cast<uint16_t>(w >> (8 - shift));
+    return static_cast<uint8_t>((m_decode[cells >> 8] << 4) |
+                                m_decode[cells & 0xFF]);
+  }
+
+  /** @return False if fewer than count bytes remain at pos. */
+  bool read(std::size_t pos, uint8_t *out, std::size_t count) const {
+    if (pos + count * 16 > m_count)
+      return false;
+    for (std::size_t i = 0; i < count; ++i, pos += 16)
+      out[i] = byteAt(pos);
+    return true;
+  }
+
+  /**
+   * @return Position just after the next A1 A1 A1 run starting at or after
+   * from and before limit, or 0 if there is none.
+   */
+  std::size_t findSync(std::size_t from, std::size_t limit) const {
+    uint64_t run = 0;
+    limit = std::min(limit, m_count);
+    for (std::size_t pos = from; pos < limit; ++pos) {
+      run = (run << 1) | bit(pos);
+      if ((run & SYNC_RUN_MASK) == SYNC_RUN && pos + 1 - from >= 48)
+        return pos + 1;
+    }
+    return 0;
+  }
+
+private:
+  const uint8_t *m_cells;
+  std::size_t m_count;
+  const uint8_t *m_decode;
+};
+
+/** @return CRC of the three A1 sync bytes that start every field. */
+uint16_t syncCrc() {
+  static const uint8_t marks[3] = {0xA1, 0xA1, 0xA1};
+  static const uint16_t crc = crc16Ccitt(marks, sizeof(marks));
+  return crc;
+}
+
+/** Per-sector overhead besides the data and the two variable gaps. */
+uint32_t fieldBytes(const MfmTrackLayout &l) {
+  const uint32_t idField = l.syncZeros + 3 + 1 + 4 + 2;
+  const uint32_t dataField = l.syncZeros + 3 + 1 + SECTOR_SIZE + 2;
+  return idField + l.gap2 + dataField + l.gap3;
+}
+
+} // namespace
+
+// =============================================================================
+//  CRC
+// =============================================================================
+
+uint16_t crc16Ccitt(const uint8_t *data, std::size_t size, uint16_t crc) {
+  const uint16_t(*t)[256] = tables().crc;
+  while (size >= 8) {
+    crc ^= static_cast<uint16_t>((data[0] << 8) | data[1]);
+    crc = t[7][crc >> 8] ^ t[6][crc & 0xFF] ^ t[5][data[2]] ^
+          t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^
+          t[0][data[7]];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0)
+    crc = static_cast<uint16_t>((crc << 8) ^ t[0][(crc >> 8) ^ *data++]);
+  return crc;
+}
+
+// =============================================================================
+//  Track Layout
+// =============================================================================
+
+MfmTrackLayout MfmTrackLayout::forSectors(uint32_t sectorsPerTrack) {
+  MfmTrackLayout l;
+  l.sectorsPerTrack = sectorsPerTrack;
+  if (sectorsPerTrack > 11)
+    l.trackBytes = MFM_HD_TRACK_BYTES;
+  if (l.usedBytes() > l.trackBytes) {
+    // The gaps 11-sector copiers use; the WD1772 still reads them.
+    l.gap1 = 10;
+    l.syncZeros = 3;
+    l.gap3 = 1;
+  }
+  return l;
+}
+
+uint32_t MfmTrackLayout::usedBytes() const {
+  return gap1 + sectorsPerTrack * fieldBytes(*this);
+}
+
+std::vector<uint8_t> MfmTrackLayout::sectorOrder(uint32_t cylinder) const {
+  std::vector<uint8_t> order(sectorsPerTrack, 0);
+  if (sectorsPerTrack == 0)
+    return order;
+  const uint32_t step = std::max<uint32_t>(interleave, 1);
+  uint32_t slot = (cylinder * skew) % sectorsPerTrack;
+  for (uint32_t s = 1; s <= sectorsPerTrack; ++s) {
+    while (order[slot] != 0)
+      slot = (slot + 1) % sectorsPerTrack;
+    order[slot] = static_cast<uint8_t>(s);
+    slot = (slot + step) % sectorsPerTrack;
+  }
+  return order;
+}
+
+// =============================================================================
+//  Encoding
+// =============================================================================
+
+std::vector<uint8_t> encodeMfmTrack(const uint8_t *sectors, uint8_t cylinder,
+                                    uint8_t side,
+                                    const MfmTrackLayout &layout) {
+  std::vector<uint8_t> cells;
+  cells.reserve(2 * std::max(layout.trackBytes, layout.usedBytes()));
+  MfmWriter w(cells);
+
+  w.fill(GAP_FILL, layout.gap1);
+  for (uint8_t sector : layout.sectorOrder(cylinder)) {
+    const uint8_t id[5] = {MARK_ID, cylinder, side, sector, 2};
+    const uint16_t idCrc = crc16Ccitt(id, sizeof(id), syncCrc());
+    w.fill(0x00, layout.syncZeros);
+    w.sync();
+    w.put(id, sizeof(id));
+    w.put(static_cast<uint8_t>(idCrc >> 8));
+    w.put(static_cast<uint8_t>(idCrc));
+    w.fill(GAP_FILL, layout.gap2);
+
+    const uint8_t *data = sectors + (sector - 1) * SECTOR_SIZE;
+    const uint8_t mark = MARK_DATA;
+    const uint16_t dataCrc =
+        crc16Ccitt(data, SECTOR_SIZE, crc16Ccitt(&mark, 1, syncCrc()));
+    w.fill(0x00, layout.syncZeros);
+    w.sync();
+    w.put(mark);
+    w.put(data, SECTOR_SIZE);
+    w.put(static_cast<uint8_t>(dataCrc >> 8));
+    w.put(static_cast<uint8_t>(dataCrc));
+    w.fill(GAP_FILL, layout.gap3);
+  }
+  if (cells.size() < 2 * layout.trackBytes)
+    w.fill(GAP_FILL,
+           layout.trackBytes - static_cast<uint32_t>(cells.size() / 2));
+  return cells;
+}
+
+// =============================================================================
+//  Decoding
+// =============================================================================
+
+std::vector<MfmSector> decodeMfmTrack(const uint8_t *cells,
+                                      std::size_t cellCount) {
+  std::vector<MfmSector> sectors;
+  const MfmReader r(cells, cellCount);
+
+  std::size_t pos = 0;
+  while ((pos = r.findSync(pos, r.size())) != 0) {
+    uint8_t id[7];
+    if (!r.read(pos, id, sizeof(id)))
+      break;
+    if (id[0] != MARK_ID ||
+        crc16Ccitt(id, sizeof(id), syncCrc()) != 0 ||
+        id[4] > MAX_SIZE_CODE)
+      continue;
+    pos += sizeof(id) * 16;
+
+    MfmSector s;
+    s.cylinder = id[1];
+    s.side = id[2];
+    s.sector = id[3];
+    s.sizeCode = id[4];
+
+    // The data field belongs to this ID only if it follows closely.
+    const std::size_t dataPos = r.findSync(pos, pos + DATA_MARK_WINDOW);
+    uint8_t mark = 0;
+    if (dataPos != 0 && r.read(dataPos, &mark, 1) &&
+        (mark == MARK_DATA || mark == MARK_DELETED)) {
+      const std::size_t size = std::size_t(128) << s.sizeCode;
+      std::vector<uint8_t> field(1 + size + 2);
+      if (r.read(dataPos, field.data(), field.size())) {
+        s.dataCrcOk = crc16Ccitt(field.data(), field.size(), syncCrc()) == 0;
+        s.data.assign(field.begin() + 1, field.begin() + 1 + size);
+        pos = dataPos + field.size() * 16;
+      }
+    }
+    sectors.push_back(std::move(s));
+  }
+  return sectors;
+}
+
+} // namespace Atari
@@ -0,0 +1,327 @@
+// =============================================================================
+//  ScpImage.cpp
+//  Atari ST Toolkit — SuperCard Pro Flux Import
+//
+//  Each revolution is an independent job: flux intervals go through the
+//  PLL into MFM cells and then through the MFM decoder. Only the final
+//  vote between revolutions looks at more than one job.
+// =============================================================================
+
+#include "../include/ScpImage.h"
+#include "../include/AtariDiskEngine.h"
+#include "../include/MfmCodec.h"
+#include <QFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+
+namespace Atari {
+
+namespace {
+
+/**
+ * SCP header (little-endian): "SCP", version, disk type, revolutions,
+ * start track, end track, flags, cell width (0 = 16 bits), heads
+ * (0 = both, 1 = side 0, 2 = side 1), resolution (25 ns * (n + 1); the
+ * PLL measures cells in ticks, so it is not needed), checksum of everything
+ * after it, then 168 track header offsets.
+ */
+constexpr std::size_t SCP_TRACK_TABLE = 0x10;
+constexpr std::size_t SCP_MAX_TRACKS = 168;
+
+/** Track header: "TRK", track number, then per revolution index time,
+ * flux count and data offset (from the track header), 32 bits each. */
+constexpr std::size_t SCP_TRACK_HEADER = 4;
+constexpr std::size_t SCP_REVOLUTION_ENTRY = 12;
+
+/**
+ * PLL loop filter, in 16.16 fixed point: 1/50 of each phase error moves
+ * the clock, 70% of it is carried to the next transition, and the clock
+ * stays within 1/10 of the measured cell width.
+ */
+constexpr int PLL_FRACTION_BITS = 16;
+constexpr int64_t PLL_PERIOD_DIVISOR = 50;
+constexpr int64_t PLL_PHASE_KEEP_PERCENT = 70;
+constexpr int64_t PLL_CLOCK_RANGE_DIVISOR = 10;
+/** Intervals are binned up to here (ticks) to find the cell width. */
+constexpr uint32_t PLL_HISTOGRAM_BINS = 4096;
+
+struct RevolutionJob {
+  int cylinder;
+  int side;
+  const uint8_t *flux; /**< Big-endian 16-bit intervals. */
+  uint32_t fluxCount;
+  std::vector<MfmSector> sectors;
+};
+
+/** Packs cells MSB first, as decodeMfmTrack() expects. */
+class CellWriter {
+public:
+  void reserve(std::size_t cells) { m_bytes.reserve(cells / 8 + 1); }
+
+  void put(bool one) {
+    m_pending = static_cast<uint8_t>((m_pending << 1) | one);
+    if ((++m_count & 7) == 0)
+      m_bytes.push_back(m_pending);
+  }
+
+  /** @brief Flushes a partial last byte. */
+  void finish() {
+    if ((m_count & 7) != 0)
+      m_bytes.push_back(static_cast<uint8_t>(m_pending << (8 - (m_count & 7))));
+  }
+
+  const std::vector<uint8_t> &bytes() const { return m_bytes; }
+  std::size_t count() const { return m_count; }
+
+private:
+  std::vector<uint8_t> m_bytes;
+  std::size_t m_count = 0;
+  uint8_t m_pending = 0;
+};
+
+std::vector<uint32_t> readIntervals(const uint8_t *flux, uint32_t count) {
+  std::vector<uint32_t> intervals;
+  intervals.reserve(count);
+  uint32_t carry = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint16_t v = readBE16(flux + 2 * i);
+    if (v == 0) {
+      carry += 0x10000; // Interval longer than 16 bits
+      continue;
+    }
+    intervals.push_back(carry + v);
+    carry = 0;
+  }
+  return intervals;
+}
+
+/**
+ * Clocks flux intervals into MFM cells. The cell width is measured from
+ * the track itself: the shortest MFM interval is two cells, and it makes
+ * up the bulk of the lower quartile. That copes with drive speed and
+ * density without being told either.
+ */
+void fluxToCells(const std::vector<uint32_t> &intervals, CellWriter &out) {
+  if (intervals.size() < 16)
+    return;
+  std::vector<uint32_t> histogram(PLL_HISTOGRAM_BINS, 0);
+  uint64_t total = 0;
+  for (uint32_t interval : intervals) {
+    ++histogram[std::min<uint32_t>(interval, PLL_HISTOGRAM_BINS - 1)];
+    total += interval;
+  }
+  uint32_t quartile = 0;
+  for (std::size_t seen = 0;
+       seen + histogram[quartile] < intervals.size() / 4; ++quartile)
+    seen += histogram[quartile];
+  if (quartile < 2)
+    return;
+  const int64_t centre =
+      (static_cast<int64_t>(quartile) << PLL_FRACTION_BITS) / 2;
+  out.reserve(static_cast<std::size_t>(
+      (total << PLL_FRACTION_BITS) / static_cast<uint64_t>(centre) + 1));
+
+  const int64_t minClock = centre - centre / PLL_CLOCK_RANGE_DIVISOR;
+  const int64_t maxClock = centre + centre / PLL_CLOCK_RANGE_DIVISOR;
+  int64_t clock = centre;
+  int64_t ticks = 0;
+  for (uint32_t interval : intervals) {
+    ticks += static_cast<int64_t>(interval) << PLL_FRACTION_BITS;
+    const int64_t half = clock / 2;
+    if (ticks < half)
+      continue; // Glitch: fold it into the next interval
+    while ((ticks -= clock) >= half)
+      out.put(false);
+    out.put(true);
+
+    // ticks is now the phase error of this transition.
+    clock = std::min(maxClock,
+                     std::max(minClock, clock + ticks / PLL_PERIOD_DIVISOR));
+    ticks = ticks * PLL_PHASE_KEEP_PERCENT / 100;
+  }
+  out.finish();
+}
+
+} // namespace
+
+int ScpReport::count(FluxSectorState state) const {
+  return static_cast<int>(
+      std::count_if(issues.begin(), issues.end(),
+                    [state](const FluxSectorIssue &i) {
+                      return i.state == state;
+                    }));
+}
+
+const char *fluxSectorStateName(FluxSectorState state) {
+  switch (state) {
+  case FluxSectorState::Weak:
+    return "weak";
+  case FluxSectorState::Bad:
+    return "bad";
+  case FluxSectorState::Missing:
+    return "missing";
+  }
+  return "?";
+}
+
+// =============================================================================
+//  Decoding
+// =============================================================================
+
+bool decodeScp(const uint8_t *data, std::size_t size,
+               std::vector<uint8_t> &image, ScpReport &report,
+               QString &error) {
+  report = ScpReport();
+  if (size < SCP_TRACK_TABLE + SCP_MAX_TRACKS * 4 ||
+      std::memcmp(data, "SCP", 3) != 0) {
+    error = "not an SCP file";
+    return false;
+  }
+  if (data[0x09] != 0) {
+    error = "only 16-bit flux cells are supported";
+    return false;
+  }
+  const uint32_t revolutions = data[0x05];
+  const uint8_t heads = data[0x0A];
+
+  const uint32_t checksum = readLE32(data + 0x0C);
+  if (checksum != 0) {
+    uint32_t sum = 0;
+    for (std::size_t i = SCP_TRACK_TABLE; i < size; ++i)
+      sum += data[i];
+    report.checksumOk = sum == checksum;
+  }
+
+  // Track numbers are cylinder * 2 + side. Single-sided captures (heads 1
+  // or 2) keep that numbering, except old ones that count 0, 1, 2, ...
+  struct TrackRef {
+    uint32_t number;
+    std::size_t offset;
+  };
+  std::vector<TrackRef> tracks;
+  std::vector<uint32_t> numbers;
+  for (std::size_t i = 0; i < SCP_MAX_TRACKS; ++i) {
+    const std::size_t offset = readLE32(data + SCP_TRACK_TABLE + i * 4);
+    if (offset == 0 || offset + SCP_TRACK_HEADER > size ||
+        std::memcmp(data + offset, "TRK", 3) != 0)
+      continue;
+    tracks.push_back({data[offset + 3], offset});
+    numbers.push_back(data[offset + 3]);
+  }
+  const int singleSide = (heads == 1 || heads == 2) ? heads - 1 : -1;
+  std::sort(numbers.begin(), numbers.end());
+  bool sequential = singleSide >= 0 && numbers.size() > 1;
+  for (std::size_t i = 0; sequential && i < numbers.size(); ++i)
+    sequential = numbers[i] == i;
+
+  std::vector<RevolutionJob> jobs;
+  for (const TrackRef &t : tracks) {
+    const int cylinder =
+        static_cast<int>(sequential ? t.number : t.number / 2);
+    const int side =
+        singleSide >= 0 ? singleSide : static_cast<int>(t.number & 1);
+    for (uint32_t r = 0; r < revolutions; ++r) {
+      const std::size_t entry =
+          t.offset + SCP_TRACK_HEADER + r * SCP_REVOLUTION_ENTRY;
+      if (entry + SCP_REVOLUTION_ENTRY > size)
+        break;
+      const uint32_t fluxCount = readLE32(data + entry + 4);
+      const std::size_t fluxOffset = t.offset + readLE32(data + entry + 8);
+      if (fluxOffset + std::size_t(fluxCount) * 2 > size)
+        continue;
+      jobs.push_back({cylinder, side, data + fluxOffset, fluxCount, {}});
+    }
+  }
+
+  QtConcurrent::blockingMap(jobs, [](RevolutionJob &job) {
+    CellWriter cells;
+    fluxToCells(readIntervals(job.flux, job.fluxCount), cells);
+    job.sectors = decodeMfmTrack(cells.bytes().data(), cells.count());
+  });
+
+  // Geometry: the highest 512-byte sector number and the last cylinder
+  // (and side) that held any sector.
+  int spt = 0;
+  int cylinders = 0;
+  int sides = 1;
+  for (const RevolutionJob &job : jobs) {
+    for (const MfmSector &s : job.sectors) {
+      if (s.sizeCode != 2 || s.sector > 63)
+        continue;
+      spt = std::max<int>(spt, s.sector);
+      cylinders = std::max(cylinders, job.cylinder + 1);
+      if (job.side == 1)
+        sides = 2;
+    }
+  }
+  if (spt == 0) {
+    error = "no readable sectors";
+    return false;
+  }
+
+  const std::size_t trackSize = std::size_t(spt) * SECTOR_SIZE;
+  image.assign(std::size_t(cylinders) * sides * trackSize, 0);
+  std::vector<std::vector<const MfmSector *>> copies(
+      std::size_t(cylinders) * sides * spt);
+  for (const RevolutionJob &job : jobs) {
+    if (job.cylinder >= cylinders || job.side >= sides)
+      continue;
+    for (const MfmSector &s : job.sectors) {
+      if (s.sizeCode == 2 && s.sector >= 1 && s.sector <= spt &&
+          !s.data.empty())
+        copies[(std::size_t(job.cylinder) * sides + job.side) * spt +
+               s.sector - 1]
+            .push_back(&s);
+    }
+  }
+
+  for (std::size_t i = 0; i < copies.size(); ++i) {
+    const int track = static_cast<int>(i / spt);
+    FluxSectorIssue issue{track / sides, track % sides,
+                          static_cast<int>(i % spt) + 1,
+                          FluxSectorState::Missing};
+    const std::vector<const MfmSector *> &c = copies[i];
+    if (c.empty()) {
+      report.issues.push_back(issue);
+      continue;
+    }
+
+    auto good = std::find_if(c.begin(), c.end(), [](const MfmSector *s) {
+      return s->dataCrcOk;
+    });
+    const MfmSector *chosen = good != c.end() ? *good : c.front();
+    std::memcpy(image.data() + i * SECTOR_SIZE, chosen->data.data(),
+                SECTOR_SIZE);
+    if (!chosen->dataCrcOk) {
+      issue.state = FluxSectorState::Bad;
+      report.issues.push_back(issue);
+    } else if (std::any_of(c.begin(), c.end(), [chosen](const MfmSector *s) {
+                 return s->data != chosen->data;
+               })) {
+      issue.state = FluxSectorState::Weak;
+      report.issues.push_back(issue);
+    }
+  }
+
+  report.tracks = cylinders;
+  report.sides = sides;
+  report.sectorsPerTrack = spt;
+  report.revolutions = static_cast<int>(revolutions);
+  return true;
+}
+
+bool importScp(const QString &path, std::vector<uint8_t> &image,
+               ScpReport &report, QString &error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    error = "cannot open " + path;
+    return false;
+  }
+  const QByteArray data = file.readAll();
+  return decodeScp(reinterpret_cast<const uint8_t *>(data.constData()),
+                   static_cast<std::size_t>(data.size()), image, report,
+                   error);
+}
+
+} // namespace Atari
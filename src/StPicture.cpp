@@ -0,0 +1,229 @@
+// =============================================================================
+//  StPicture.cpp
+//  Atari ST Toolkit — Picture Decoding
+//
+//  Bitplane to chunky conversion goes eight pixels at a time: a 256-entry
+//  table spreads each plane byte over eight output bytes, and the planes are
+//  merged with shifts and ORs on 64-bit words.
+// =============================================================================
+
+#include "../include/StPicture.h"
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <utility>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint32_t DEGAS_HEADER_SIZE = 34;
+constexpr uint32_t NEO_HEADER_SIZE = 128;
+constexpr uint16_t DEGAS_COMPRESSED = 0x8000;
+
+struct Resolution {
+  int width;
+  int height;
+  int planes;
+};
+
+/** ST low, medium and high resolution. */
+const Resolution kResolutions[3] = {
+    {320, 200, 4}, {640, 200, 2}, {640, 400, 1}};
+
+/**
+ * Entry b holds the eight bits of b as eight 0/1 bytes, most significant
+ * bit first in memory, whatever the host byte order.
+ */
+const std::array<uint64_t, 256> &spreadTable() {
+  static const std::array<uint64_t, 256> table = [] {
+    std::array<uint64_t, 256> t{};
+    for (int b = 0; b < 256; ++b) {
+      uint8_t bytes[8];
+      for (int i = 0; i < 8; ++i)
+        bytes[i] = (b >> (7 - i)) & 1;
+      std::memcpy(&t[b], bytes, 8);
+    }
+    return t;
+  }();
+  return table;
+}
+
+bool readPalette(const FileView &file, uint32_t at, int planes,
+                 uint32_t *palette) {
+  uint8_t raw[32];
+  if (file.read(at, raw, 32) != 32)
+    return false;
+  for (int i = 0; i < 16; ++i)
+    palette[i] = stColorToArgb(static_cast<uint16_t>((raw[2 * i] << 8) |
+                                                     raw[2 * i + 1]));
+  if (planes == 1) {
+    // Monochrome ignores the colours; bit 0 of colour 0 inverts the screen.
+    const bool inverted = !(raw[1] & 1);
+    palette[0] = inverted ? 0xFF000000 : 0xFFFFFFFF;
+    palette[1] = inverted ? 0xFFFFFFFF : 0xFF000000;
+  }
+  return true;
+}
+
+bool resolutionFromWord(uint16_t word, Resolution &res) {
+  if (word > 2)
+    return false;
+  res = kResolutions[word];
+  return true;
+}
+
+/** Converts a raw, word-interleaved 32000-byte screen. */
+void decodeScreen(const uint8_t *screen, StPicture &out) {
+  const std::size_t rowBytes = static_cast<std::size_t>(out.width) *
+                               out.planes / 8;
+  for (int y = 0; y < out.height; ++y)
+    planarRowToChunky(screen + y * rowBytes, out.planes, out.width, 2,
+                      2 * out.planes,
+                      out.pixels.data() + std::size_t(y) * out.width);
+}
+
+/**
+ * DEGAS Elite compression: every scanline is stored plane after plane,
+ * each plane line PackBits-coded on its own (runs never cross lines).
+ */
+bool decodeDegasCompressed(const FileView &file, StPicture &out) {
+  const int planeLine = out.width / 8;
+  std::vector<uint8_t> line(static_cast<std::size_t>(planeLine) *
+                            out.planes);
+  FileView::Cursor in(file, DEGAS_HEADER_SIZE);
+
+  for (int y = 0; y < out.height; ++y) {
+    for (int p = 0; p < out.planes; ++p) {
+      uint8_t *dst = line.data() + p * planeLine;
+      int filled = 0;
+      while (filled < planeLine) {
+        uint8_t control, value;
+        if (!in.next(control))
+          return false;
+        if (control < 128) {
+          if (filled + control + 1 > planeLine)
+            return false;
+          for (int k = 0; k <= control; ++k) {
+            if (!in.next(value))
+              return false;
+            dst[filled++] = value;
+          }
+        } else if (control > 128) {
+          const int count = 257 - control;
+          if (filled + count > planeLine || !in.next(value))
+            return false;
+          std::memset(dst + filled, value, count);
+          filled += count;
+        }
+      }
+    }
+    planarRowToChunky(line.data(), out.planes, out.width, planeLine, 2,
+                      out.pixels.data() + std::size_t(y) * out.width);
+  }
+  return true;
+}
+
+} // namespace
+
+uint32_t stColorToArgb(uint16_t color) {
+  // STE stores the extra (least significant) channel bit as bit 3.
+  auto channel = [color](int shift) {
+    const int n = (color >> shift) & 0xF;
+    const int v = ((n & 7) << 1) | (n >> 3);
+    return static_cast<uint32_t>(v * 17);
+  };
+  return 0xFF000000 | (channel(8) << 16) | (channel(4) << 8) | channel(0);
+}
+
+PictureFormat pictureFormatForName(const std::string &name) {
+  const std::size_t dot = name.rfind('.');
+  if (dot == std::string::npos || name.size() - dot != 4)
+    return PictureFormat::Unknown;
+
+  std::string ext = name.substr(dot + 1);
+  for (char &c : ext)
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  if (ext == "NEO")
+    return PictureFormat::Neochrome;
+  if (ext[0] == 'P' && ext[2] >= '1' && ext[2] <= '3') {
+    if (ext[1] == 'I')
+      return PictureFormat::Degas;
+    if (ext[1] == 'C')
+      return PictureFormat::DegasCompressed;
+  }
+  return PictureFormat::Unknown;
+}
+
+void planarRowToChunky(const uint8_t *row, int planes, int width,
+                       std::size_t planeStride, std::size_t groupStride,
+                       uint8_t *out) {
+  const std::array<uint64_t, 256> &spread = spreadTable();
+  for (int k = 0; k < width / 8; ++k) {
+    const uint8_t *src = row + (k / 2) * groupStride + (k & 1);
+    uint64_t chunky = 0;
+    for (int p = 0; p < planes; ++p)
+      chunky |= spread[src[p * planeStride]] << p;
+    std::memcpy(out + 8 * k, &chunky, 8);
+  }
+}
+
+bool decodeStPicture(const FileView &file, PictureFormat format,
+                     StPicture &out) {
+  uint32_t paletteAt = 2;
+  uint32_t screenAt = DEGAS_HEADER_SIZE;
+  uint16_t resWord = file.readBE16(0);
+
+  switch (format) {
+  case PictureFormat::Degas:
+    break;
+  case PictureFormat::DegasCompressed:
+    if (!(resWord & DEGAS_COMPRESSED))
+      return false;
+    resWord = static_cast<uint16_t>(resWord & ~DEGAS_COMPRESSED);
+    break;
+  case PictureFormat::Neochrome:
+    if (resWord != 0)
+      return false;
+    resWord = file.readBE16(2);
+    paletteAt = 4;
+    screenAt = NEO_HEADER_SIZE;
+    break;
+  case PictureFormat::Unknown:
+    return false;
+  }
+
+  Resolution res;
+  if (!resolutionFromWord(resWord, res))
+    return false;
+
+  StPicture pic;
+  pic.format = format;
+  pic.width = res.width;
+  pic.height = res.height;
+  pic.planes = res.planes;
+  if (!readPalette(file, paletteAt, pic.planes, pic.palette))
+    return false;
+  pic.pixels.resize(static_cast<std::size_t>(pic.width) * pic.height);
+
+  if (format == PictureFormat::DegasCompressed) {
+    if (!decodeDegasCompressed(file, pic))
+      return false;
+  } else {
+    // Screens are usually one extent; fall back to a copy if fragmented.
+    const uint8_t *screen = file.contiguous(screenAt, ST_SCREEN_SIZE);
+    std::vector<uint8_t> copy;
+    if (!screen) {
+      copy.resize(ST_SCREEN_SIZE);
+      if (file.read(screenAt, copy.data(), ST_SCREEN_SIZE) != ST_SCREEN_SIZE)
+        return false;
+      screen = copy.data();
+    }
+    decodeScreen(screen, pic);
+  }
+
+  out = std::move(pic);
+  return true;
+}
+
+} // namespace Atari
@@ -0,0 +1,335 @@
+// =============================================================================
+//  StructureMap.cpp
+//  Atari ST Toolkit — Byte-to-Structure Lookup
+//
+//  Regions follow from the BPB alone: boot sector, FAT copies, root
+//  directory, data. Within the data area a cluster only counts as
+//  directory slots if the tree walk in setImage() reached it; any other
+//  cluster is file contents and has no fields.
+// =============================================================================
+
+#include "../include/StructureMap.h"
+#include "../include/BootSectorAnalyzer.h"
+#include "../include/DiskBytes.h"
+#include <algorithm>
+
+namespace Atari {
+
+namespace {
+
+struct FieldSpan {
+  uint16_t offset;
+  uint16_t length;
+  const char *name;
+};
+
+/** Atari BPB fields; everything in between is loader or boot code. */
+constexpr FieldSpan kBootFields[] = {
+    {0x000, 2, "Branch"},
+    {0x002, 6, "OEM / loader"},
+    {0x008, 3, "Serial number"},
+    {0x00B, 2, "Bytes per sector"},
+    {0x00D, 1, "Sectors per cluster"},
+    {0x00E, 2, "Reserved sectors"},
+    {0x010, 1, "FAT copies"},
+    {0x011, 2, "Root directory entries"},
+    {0x013, 2, "Total sectors"},
+    {0x015, 1, "Media descriptor"},
+    {0x016, 2, "Sectors per FAT"},
+    {0x018, 2, "Sectors per track"},
+    {0x01A, 2, "Sides"},
+    {0x01C, 2, "Hidden sectors"},
+    {0x1FE, 2, "Checksum word"},
+};
+
+constexpr FieldSpan kSlotFields[] = {
+    {0, 8, "Name"},           {8, 3, "Extension"}, {11, 1, "Attributes"},
+    {12, 10, "Reserved"},     {22, 2, "Time"},     {24, 2, "Date"},
+    {26, 2, "Start cluster"}, {28, 4, "Size"},
+};
+
+constexpr uint32_t kNoField = ~0u;
+
+template <std::size_t N>
+uint32_t spanAt(const FieldSpan (&spans)[N], uint32_t offset) {
+  for (uint32_t i = 0; i < N; ++i) {
+    if (offset >= spans[i].offset &&
+        offset < spans[i].offset + spans[i].length)
+      return i;
+  }
+  return kNoField;
+}
+
+/**
+ * @return FAT12 entry owning a digit of a FAT byte. Entries 2n and 2n+1
+ * share three bytes; the middle byte's low digit ends the even entry.
+ */
+uint32_t fatEntryAt(uint32_t byte, int nibble) {
+  const uint32_t pair = byte / 3 * 2;
+  switch (byte % 3) {
+  case 0:
+    return pair;
+  case 1:
+    return nibble ? pair : pair + 1;
+  default:
+    return pair + 1;
+  }
+}
+
+QString hex(uint32_t value, int digits) {
+  return "$" + QString::number(value, 16).toUpper().rightJustified(digits, '0');
+}
+
+QString printable(const uint8_t *p, int length) {
+  QString text;
+  for (int i = 0; i < length; ++i)
+    text += (p[i] >= 32 && p[i] < 127) ? QChar(p[i]) : QChar('.');
+  return text;
+}
+
+} // namespace
+
+void StructureMap::setImage(std::vector<uint8_t> image) {
+  m_image = std::move(image);
+  m_hasGeometry =
+      m_image.size() >= SECTOR_SIZE &&
+      readFatGeometry(m_image.data(), m_image.size(), m_geo);
+  scanDirectories();
+}
+
+void StructureMap::scanDirectories() {
+  m_dirClusters.clear();
+  if (!m_hasGeometry)
+    return;
+  FatVolume volume(m_image);
+  m_dirClusters.assign(m_geo.clusterCount + 2, false);
+  std::vector<uint16_t> dirs{0};
+  for (std::size_t d = 0; d < dirs.size(); ++d) {
+    for (uint32_t slot : volume.liveEntries(dirs[d])) {
+      const uint16_t start = volume.startCluster(slot);
+      if (!(m_image[slot + 11] & ATTR_DIRECTORY) || start < 2 ||
+          start >= m_dirClusters.size() || m_dirClusters[start])
+        continue;
+      for (uint16_t c : volume.chain(start))
+        m_dirClusters[c] = true;
+      dirs.push_back(start);
+    }
+  }
+}
+
+bool StructureMap::update(uint32_t offset, const uint8_t *data,
+                          uint32_t length) {
+  if (offset >= m_image.size())
+    return false;
+  length = std::min<uint32_t>(length, m_image.size() - offset);
+  std::copy(data, data + length, m_image.begin() + offset);
+  const uint32_t end = offset + length;
+
+  // Bytes per sector up to sectors per FAT: what readFatGeometry() uses
+  if (offset < 0x18 && end > 0x0B) {
+    setImage(std::move(m_image));
+    return true;
+  }
+  if (!m_hasGeometry)
+    return false;
+  const uint32_t fatStart = m_geo.reservedSectors * SECTOR_SIZE;
+  const uint32_t dataStart = m_geo.dataSector * SECTOR_SIZE;
+  // Directory clusters are whole clusters, so checking both ends will do
+  if ((offset < dataStart && end > fatStart) || isDirectoryData(offset) ||
+      isDirectoryData(end - 1)) {
+    scanDirectories();
+    return true;
+  }
+  return false;
+}
+
+void StructureMap::clear() {
+  m_image.clear();
+  m_dirClusters.clear();
+  m_hasGeometry = false;
+}
+
+bool StructureMap::isDirectoryData(uint32_t offset) const {
+  const uint32_t dataStart = m_geo.dataSector * SECTOR_SIZE;
+  if (offset < dataStart)
+    return false;
+  const uint32_t cluster = 2 + (offset - dataStart) / m_geo.clusterBytes();
+  return cluster < m_dirClusters.size() && m_dirClusters[cluster];
+}
+
+StructureField StructureMap::fieldAt(uint32_t offset, int nibble) const {
+  if (offset >= m_image.size() || m_image.size() < SECTOR_SIZE)
+    return {};
+  if (offset < SECTOR_SIZE) {
+    const uint32_t field = spanAt(kBootFields, offset);
+    if (field == kNoField)
+      return {};
+    return {StructureKind::BootSector, field, field % 2 == 1};
+  }
+  if (!m_hasGeometry)
+    return {};
+
+  const uint32_t fatStart = m_geo.reservedSectors * SECTOR_SIZE;
+  const uint32_t fatBytes = m_geo.sectorsPerFat * SECTOR_SIZE;
+  const uint32_t rootStart = m_geo.rootSector * SECTOR_SIZE;
+  if (offset >= fatStart && offset < rootStart) {
+    const uint32_t copy = (offset - fatStart) / fatBytes;
+    const uint32_t entry = fatEntryAt((offset - fatStart) % fatBytes, nibble);
+    if (entry >= m_geo.clusterCount + 2)
+      return {};
+    return {StructureKind::Fat, copy << 16 | entry, entry % 2 == 1};
+  }
+  // Root and clusters start on sector boundaries, so slots are 32-aligned.
+  if (offset >= rootStart &&
+      (offset < m_geo.dataSector * SECTOR_SIZE || isDirectoryData(offset))) {
+    const uint32_t field = spanAt(kSlotFields, offset % DIRENT_SIZE);
+    return {StructureKind::Directory, offset / DIRENT_SIZE * 8 + field,
+            field % 2 == 1};
+  }
+  return {};
+}
+
+QString StructureMap::describe(uint32_t offset, int nibble) const {
+  const StructureField field = fieldAt(offset, nibble);
+  switch (field.kind) {
+  case StructureKind::BootSector:
+    return describeBoot(field.id);
+  case StructureKind::Fat:
+    return describeFat(field.id >> 16, field.id & 0xFFFF);
+  case StructureKind::Directory:
+    return describeSlot(offset);
+  case StructureKind::None:
+    break;
+  }
+  return QString();
+}
+
+QString StructureMap::describeBoot(uint32_t field) const {
+  const FieldSpan &span = kBootFields[field];
+  const uint8_t *p = &m_image[span.offset];
+  QString value;
+  switch (span.offset) {
+  case 0x000:
+    value = p[0] == 0x60
+                ? "BRA.S to " + hex(2 + static_cast<int8_t>(p[1]), 2)
+                : QString("no branch (%1)").arg(hex(readBE16(p), 4));
+    break;
+  case 0x002:
+    value = "\"" + printable(p, span.length) + "\"";
+    break;
+  case 0x008:
+    value = hex(p[0] << 16 | p[1] << 8 | p[2], 6);
+    break;
+  case 0x015:
+    value = hex(p[0], 2);
+    break;
+  case 0x1FE: {
+    const uint16_t sum = bootWordSum(m_image.data());
+    value = QString("%1, sector sums to %2 (%3)")
+                .arg(hex(readBE16(p), 4), hex(sum, 4),
+                     sum == BOOT_CHECKSUM_TARGET ? "executable"
+                                                 : "not executable");
+    break;
+  }
+  default:
+    value = QString::number(span.length == 1 ? p[0] : readLE16(p));
+  }
+  return QString("BPB %1: %2").arg(span.name, value);
+}
+
+QString StructureMap::describeFat(uint32_t copy, uint32_t entry) const {
+  const uint32_t at = (m_geo.reservedSectors + copy * m_geo.sectorsPerFat) *
+                          SECTOR_SIZE + entry * 3 / 2;
+  const uint16_t raw = readLE16(&m_image[at]);
+  const uint16_t value = (entry & 1) ? (raw >> 4) : (raw & 0x0FFF);
+
+  QString meaning;
+  if (entry < 2)
+    meaning = "reserved";
+  else if (value == 0)
+    meaning = "free";
+  else if (value == 0xFF7)
+    meaning = "bad cluster";
+  else if (value >= 0xFF8)
+    meaning = "end of chain";
+  else if (value >= 0xFF0 || value < 2 || value >= m_geo.clusterCount + 2)
+    meaning = "invalid link";
+  else
+    meaning = QString("next cluster %1").arg(value);
+  return QString("FAT %1, cluster %2: %3 (%4)")
+      .arg(copy + 1)
+      .arg(entry)
+      .arg(meaning, hex(value, 3));
+}
+
+QString StructureMap::describeSlot(uint32_t offset) const {
+  const uint32_t slot = offset - offset % DIRENT_SIZE;
+  const uint8_t *p = &m_image[slot];
+  const FieldSpan &span = kSlotFields[spanAt(kSlotFields, offset - slot)];
+  const uint32_t dataStart = m_geo.dataSector * SECTOR_SIZE;
+
+  QString where;
+  if (slot < dataStart) {
+    where = QString("Root directory, entry %1")
+                .arg((slot - m_geo.rootSector * SECTOR_SIZE) / DIRENT_SIZE);
+  } else {
+    const uint32_t clusterBytes = m_geo.clusterBytes();
+    where = QString("Directory cluster %1, entry %2")
+                .arg(2 + (slot - dataStart) / clusterBytes)
+                .arg((slot - dataStart) % clusterBytes / DIRENT_SIZE);
+  }
+  if (p[0] == 0x00)
+    where += " (unused)";
+  else if (p[0] == 0xE5)
+    where += " (deleted)";
+  else
+    where += " (" + QString::fromStdString(FatVolume::fromName83(p)) + ")";
+
+  const uint8_t *v = p + span.offset;
+  QString value;
+  switch (span.offset) {
+  case 0:
+  case 8:
+    value = "\"" + printable(v, span.length) + "\"";
+    break;
+  case 11: {
+    static const char kFlags[] = "RHSVDA";
+    value = hex(v[0], 2);
+    QString flags;
+    for (int bit = 0; bit < 6; ++bit) {
+      if (v[0] & (1 << bit))
+        flags += kFlags[bit];
+    }
+    if (!flags.isEmpty())
+      value += " " + flags;
+    break;
+  }
+  case 12:
+    value = "unused by GEMDOS";
+    break;
+  case 22: {
+    const uint16_t t = readLE16(v);
+    value = QString("%1:%2:%3")
+                .arg(t >> 11, 2, 10, QChar('0'))
+                .arg((t >> 5) & 0x3F, 2, 10, QChar('0'))
+                .arg((t & 0x1F) * 2, 2, 10, QChar('0'));
+    break;
+  }
+  case 24: {
+    const uint16_t d = readLE16(v);
+    value = QString("%1-%2-%3")
+                .arg(1980 + (d >> 9))
+                .arg((d >> 5) & 0x0F, 2, 10, QChar('0'))
+                .arg(d & 0x1F, 2, 10, QChar('0'));
+    break;
+  }
+  case 26:
+    value = QString::number(readLE16(v));
+    break;
+  default:
+    value = QString("%1 bytes").arg(readLE32(v));
+  }
+  return QString("%1\n%2: %3").arg(where, span.name, value);
+}
+
+} // namespace Atari
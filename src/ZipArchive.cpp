@@ -0,0 +1,252 @@
+// =============================================================================
+//  ZipArchive.cpp
+//  Atari ST Toolkit — Zip Container Support
+//
+//  Reads the zip central directory and inflates single members straight into
+//  a caller buffer, so images inside archives never touch the host disk.
+// =============================================================================
+
+#include "../include/ZipArchive.h"
+#include "../include/AtariDiskEngine.h"
+#include <QDebug>
+#include <QIODevice>
+#include <algorithm>
+#include <zlib.h>
+
+namespace Atari {
+
+namespace {
+
+constexpr uint32_t ZIP_EOCD_SIG = 0x06054b50;
+constexpr uint32_t ZIP_CENTRAL_SIG = 0x02014b50;
+constexpr uint32_t ZIP_LOCAL_SIG = 0x04034b50;
+constexpr int ZIP_EOCD_SIZE = 22;
+constexpr int ZIP_CENTRAL_SIZE = 46;
+constexpr int ZIP_LOCAL_SIZE = 30;
+constexpr int ZIP_CHUNK_SIZE = 64 * 1024;
+
+} // namespace
+
+ZipArchive::ZipArchive(const QString &path) : m_file(path) {
+  if (m_file.open(QIODevice::ReadOnly))
+    m_open = readCentralDirectory();
+  if (!m_open)
+    qDebug() << "[ZIP] Could not read archive:" << path;
+}
+
+// =============================================================================
+//  Directory Parsing
+// =============================================================================
+
+bool ZipArchive::readCentralDirectory() {
+  /**
+   * The End Of Central Directory record sits at the very end of the file,
+   * optionally followed by a comment of up to 64 KB, so scan backwards.
+   */
+  const qint64 fileSize = m_file.size();
+  if (fileSize < ZIP_EOCD_SIZE)
+    return false;
+
+  const qint64 tailSize = std::min<qint64>(fileSize, 0xFFFF + ZIP_EOCD_SIZE);
+  m_file.seek(fileSize - tailSize);
+  QByteArray tail = m_file.read(tailSize);
+  if (tail.size() != tailSize)
+    return false;
+
+  const uint8_t *t = reinterpret_cast<const uint8_t *>(tail.constData());
+  int eocd = -1;
+  for (int i = tail.size() - ZIP_EOCD_SIZE; i >= 0; --i) {
+    if (readLE32(t + i) == ZIP_EOCD_SIG) {
+      eocd = i;
+      break;
+    }
+  }
+  if (eocd < 0)
+    return false;
+
+  const uint16_t entryCount = readLE16(t + eocd + 10);
+  const uint32_t dirSize = readLE32(t + eocd + 12);
+  const uint32_t dirOffset = readLE32(t + eocd + 16);
+  if (static_cast<qint64>(dirOffset) + dirSize > fileSize)
+    return false;
+
+  m_file.seek(dirOffset);
+  QByteArray dir = m_file.read(dirSize);
+  if (static_cast<uint32_t>(dir.size()) != dirSize)
+    return false;
+
+  const uint8_t *d = reinterpret_cast<const uint8_t *>(dir.constData());
+  uint32_t pos = 0;
+  m_members.reserve(entryCount);
+  for (uint16_t i = 0; i < entryCount; ++i) {
+    if (pos + ZIP_CENTRAL_SIZE > dirSize ||
+        readLE32(d + pos) != ZIP_CENTRAL_SIG)
+      return false;
+
+    const uint8_t *h = d + pos;
+    const uint16_t nameLen = readLE16(h + 28);
+    const uint16_t extraLen = readLE16(h + 30);
+    const uint16_t commentLen = readLE16(h + 32);
+    if (pos + ZIP_CENTRAL_SIZE + nameLen > dirSize)
+      return false;
+
+    ZipMember m;
+    m.flags = readLE16(h + 8);
+    m.method = readLE16(h + 10);
+    m.crc32 = readLE32(h + 16);
+    m.compressedSize = readLE32(h + 20);
+    m.uncompressedSize = readLE32(h + 24);
+    m.localHeaderOffset = readLE32(h + 42);
+
+    const char *name = reinterpret_cast<const char *>(h + ZIP_CENTRAL_SIZE);
+    // Bit 11 marks UTF-8 names; otherwise CP437, which is Latin-1 for ASCII.
+    m.name = (m.flags & 0x0800) ? QString::fromUtf8(name, nameLen)
+                                : QString::fromLatin1(name, nameLen);
+    m.name.replace('\\', '/');
+    m_members.push_back(m);
+
+    pos += ZIP_CENTRAL_SIZE + nameLen + extraLen + commentLen;
+  }
+  return true;
+}
+
+std::vector<ZipMember> ZipArchive::imageMembers() const {
+  std::vector<ZipMember> images;
+  for (const ZipMember &m : m_members) {
+    if (!m.isDirectory() && isDiskImageName(m.name))
+      images.push_back(m);
+  }
+  return images;
+}
+
+const ZipMember *ZipArchive::findMember(const QString &name) const {
+  QString wanted = name;
+  wanted.replace('\\', '/');
+  while (wanted.startsWith('/'))
+    wanted.remove(0, 1);
+
+  for (const ZipMember &m : m_members) {
+    if (m.name == wanted)
+      return &m;
+  }
+  for (const ZipMember &m : m_members) {
+    if (m.name.compare(wanted, Qt::CaseInsensitive) == 0)
+      return &m;
+  }
+  return nullptr;
+}
+
+// =============================================================================
+//  Member Extraction
+// =============================================================================
+
+bool ZipArchive::readMember(const ZipMember &member, std::vector<uint8_t> &out,
+                            std::size_t maxBytes) {
+  out.clear();
+  if (!m_open || (member.flags & 0x0001)) // Encrypted members unsupported
+    return false;
+  if (member.method != 0 && member.method != 8)
+    return false;
+  if (member.uncompressedSize > ZIP_MEMBER_SIZE_LIMIT)
+    return false;
+
+  // Local header lengths can differ from the central copy; re-read them.
+  uint8_t local[ZIP_LOCAL_SIZE];
+  if (!m_file.seek(member.localHeaderOffset) ||
+      m_file.read(reinterpret_cast<char *>(local), ZIP_LOCAL_SIZE) !=
+          ZIP_LOCAL_SIZE ||
+      readLE32(local) != ZIP_LOCAL_SIG)
+    return false;
+
+  const qint64 dataOffset = static_cast<qint64>(member.localHeaderOffset) +
+                            ZIP_LOCAL_SIZE + readLE16(local + 26) +
+                            readLE16(local + 28);
+  if (!m_file.seek(dataOffset))
+    return false;
+
+  const std::size_t wanted =
+      std::min<std::size_t>(member.uncompressedSize, maxBytes);
+  const bool partial = wanted < member.uncompressedSize;
+  out.resize(wanted);
+
+  if (member.method == 0) {
+    if (m_file.read(reinterpret_cast<char *>(out.data()), wanted) !=
+        static_cast<qint64>(wanted))
+      return false;
+  } else {
+    /**
+     * Raw deflate stream (negative window bits, no zlib header). Input is
+     * fed in fixed chunks and inflated directly into the output buffer.
+     */
+    z_stream zs{};
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+      return false;
+
+    std::vector<uint8_t> chunk(ZIP_CHUNK_SIZE);
+    uint32_t inputLeft = member.compressedSize;
+    zs.next_out = out.data();
+    zs.avail_out = static_cast<uInt>(wanted);
+
+    int rc = Z_OK;
+    while (zs.avail_out > 0 && rc != Z_STREAM_END) {
+      if (zs.avail_in == 0) {
+        if (inputLeft == 0)
+          break;
+        const qint64 got = m_file.read(
+            reinterpret_cast<char *>(chunk.data()),
+            std::min<uint32_t>(inputLeft, ZIP_CHUNK_SIZE));
+        if (got <= 0)
+          break;
+        inputLeft -= static_cast<uint32_t>(got);
+        zs.next_in = chunk.data();
+        zs.avail_in = static_cast<uInt>(got);
+      }
+      rc = inflate(&zs, Z_NO_FLUSH);
+      if (rc != Z_OK && rc != Z_STREAM_END)
+        break;
+    }
+    const std::size_t produced = wanted - zs.avail_out;
+    inflateEnd(&zs);
+
+    if (rc != Z_OK && rc != Z_STREAM_END)
+      return false;
+    if (produced != wanted)
+      return false;
+  }
+
+  if (!partial &&
+      ::crc32(0L, out.data(), static_cast<uInt>(out.size())) != member.crc32) {
+    qDebug() << "[ZIP] CRC mismatch in member" << member.name;
+    return false;
+  }
+  return true;
+}
+
+// =============================================================================
+//  Path Helpers
+// =============================================================================
+
+/*static*/ bool ZipArchive::splitArchivePath(const QString &path,
+                                             QString &archive,
+                                             QString &member) {
+  const int pos = path.indexOf(".zip!/", 0, Qt::CaseInsensitive);
+  if (pos < 0)
+    return false;
+  archive = path.left(pos + 4);
+  member = path.mid(pos + 6);
+  return !member.isEmpty();
+}
+
+/*static*/ QString ZipArchive::memberPath(const QString &archive,
+                                          const QString &member) {
+  return archive + "!/" + member;
+}
+
+/*static*/ bool ZipArchive::isDiskImageName(const QString &name) {
+  return name.endsWith(".st", Qt::CaseInsensitive) ||
+         name.endsWith(".msa", Qt::CaseInsensitive) ||
+         name.endsWith(".dim", Qt::CaseInsensitive) ||
+         name.endsWith(".stx", Qt::CaseInsensitive);
+}
+
+} // namespace Atari
@@ -1,8 +1,16 @@
+#include "../include/CommandLine.h"
 #include "../ui/MainWindow.h"
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    // Headless commands never touch the display
+    if (Atari::isCommandLineInvocation(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return Atari::runCommandLine(app.arguments().mid(1));
+    }
+
     // High DPI scaling for modern displays
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     
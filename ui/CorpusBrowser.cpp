@@ -0,0 +1,462 @@
+#include "CorpusBrowser.h"
+#include "AtariDiskEngine.h"
+#include "BootSectorAnalyzer.h"
+#include "PictureBrowser.h"
+#include "ZipArchive.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTableView>
+#include <QThread>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+#include <exception>
+
+namespace {
+
+/** Rows handed to the view per batch while the folder is listed. */
+constexpr std::size_t kBatchRows = 512;
+/** How often described rows are pushed to the view. */
+constexpr int kFlushMs = 100;
+/** Visible rows remembered for priority; older requests fall back to order. */
+constexpr std::size_t kMaxWanted = 256;
+/** Same guard as the tree model against runaway nesting. */
+constexpr int kMaxDepth = 16;
+/** Thumbnail cell size; every ST resolution scales to it. */
+const QSize kThumbSize(64, 40);
+
+constexpr quint32 kCacheMagic = 0x41434958; // "ACIX"
+constexpr qint32 kCacheVersion = 1;
+
+QDataStream &operator<<(QDataStream &out, const CorpusRecord &r) {
+  return out << r.readable << r.format << r.label << qint32(r.fileCount)
+             << r.freeBytes << r.boot << r.hash << r.thumbnail;
+}
+
+QDataStream &operator>>(QDataStream &in, CorpusRecord &r) {
+  qint32 fileCount = 0;
+  in >> r.readable >> r.format >> r.label >> fileCount >> r.freeBytes >>
+      r.boot >> r.hash >> r.thumbnail;
+  r.fileCount = fileCount;
+  return in;
+}
+
+QImage firstPicture(const Atari::AtariDiskEngine &engine,
+                    const std::vector<Atari::DirEntry> &entries, int depth) {
+  for (const Atari::DirEntry &e : entries) {
+    if (e.name[0] == '.')
+      continue;
+    if (e.isDirectory()) {
+      if (e.getStartCluster() < 2 || depth >= kMaxDepth)
+        continue;
+      const QImage found = firstPicture(
+          engine, engine.readSubDirectory(e.getStartCluster()), depth + 1);
+      if (!found.isNull())
+        return found;
+      continue;
+    }
+    const Atari::PictureFormat format =
+        Atari::pictureFormatForName(e.getFilename());
+    if (format == Atari::PictureFormat::Unknown)
+      continue;
+    const QImage full = PictureBrowser::decode(engine.fileView(e), format);
+    if (!full.isNull())
+      return full.scaled(kThumbSize, Qt::IgnoreAspectRatio,
+                         Qt::SmoothTransformation);
+  }
+  return QImage();
+}
+
+/** @brief Loads one image and gathers its row; runs on the pool. */
+CorpusRecord describe(const QString &path) {
+  CorpusRecord r;
+  Atari::AtariDiskEngine engine;
+  try {
+    if (!engine.loadImage(path))
+      return r;
+  } catch (const std::exception &) {
+    return r; // Truncated or not an image after all
+  }
+  const std::vector<uint8_t> &image = engine.getRawImageData();
+  if (image.size() < Atari::SECTOR_SIZE)
+    return r;
+
+  r.readable = true;
+  const std::vector<Atari::DirEntry> root = engine.readRootDirectory();
+  r.format = engine.getFormatInfoString();
+  const Atari::DiskStats stats = engine.getDiskStats();
+  r.label = stats.label;
+  r.fileCount = stats.fileCount;
+  r.freeBytes = static_cast<qint64>(stats.freeBytes);
+  const Atari::BootAnalysis boot = Atari::analyzeBootSector(image.data());
+  r.boot = Atari::bootCategoryName(boot.category);
+  if (!boot.name.isEmpty())
+    r.boot += ": " + boot.name;
+  r.hash = Atari::FileView::fromBuffer(image.data(), image.size())
+               .contentHash();
+  r.thumbnail = firstPicture(engine, root, 0);
+  return r;
+}
+
+} // namespace
+
+// =============================================================================
+//  CorpusModel
+// =============================================================================
+
+CorpusModel::CorpusModel(const QString &root, QObject *parent)
+    : QAbstractTableModel(parent), m_root(QDir(root).absolutePath()) {
+  // One thread lists the folder while the others describe images.
+  m_pool.setMaxThreadCount(QThread::idealThreadCount() + 1);
+  m_flushTimer.setInterval(kFlushMs);
+  connect(&m_flushTimer, &QTimer::timeout, this,
+          [this] { applyResults(true); });
+  m_flushTimer.start();
+  QtConcurrent::run(&m_pool, [this] { list(); });
+}
+
+CorpusModel::~CorpusModel() {
+  m_stopping = true;
+  m_pool.waitForDone();
+  applyResults(false);
+  saveCache();
+}
+
+QString CorpusModel::cachePath() {
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         "/corpus-index.dat";
+}
+
+void CorpusModel::list() {
+  // 1. Everything described in earlier runs, in any folder.
+  QHash<QString, Row> cached;
+  QFile file(cachePath());
+  if (file.open(QIODevice::ReadOnly)) {
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    qint32 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    for (quint32 i = 0; magic == kCacheMagic && version == kCacheVersion &&
+                        i < count && in.status() == QDataStream::Ok;
+         ++i) {
+      Row row;
+      in >> row.path >> row.size >> row.mtime >> row.record;
+      row.done = true;
+      cached.insert(row.path, row);
+    }
+  }
+
+  // 2. The folder, in batches; unchanged files keep their cached row.
+  std::vector<Row> batch;
+  auto post = [this, &batch] {
+    QMetaObject::invokeMethod(
+        this,
+        [this, rows = std::move(batch)]() mutable {
+          appendRows(std::move(rows));
+        },
+        Qt::QueuedConnection);
+    batch.clear();
+  };
+  auto add = [&](const QString &path, const QFileInfo &host) {
+    Row row;
+    row.path = path;
+    row.size = host.size();
+    row.mtime = host.lastModified().toMSecsSinceEpoch();
+    const auto it = cached.find(path);
+    if (it != cached.end()) {
+      if (it->size == row.size && it->mtime == row.mtime) {
+        row.done = true;
+        row.record = it->record;
+      }
+      cached.erase(it);
+    }
+    batch.push_back(std::move(row));
+    if (batch.size() >= kBatchRows)
+      post();
+  };
+
+  QDirIterator it(m_root, QStringList() << "*.st" << "*.ST" << "*.zip"
+                                        << "*.ZIP",
+                  QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext() && !m_stopping) {
+    const QString path = it.next();
+    const QFileInfo info = it.fileInfo();
+    if (!path.endsWith(".zip", Qt::CaseInsensitive)) {
+      add(path, info);
+      continue;
+    }
+    for (const Atari::ZipMember &m : Atari::ZipArchive(path).imageMembers())
+      add(Atari::ZipArchive::memberPath(path, m.name), info);
+  }
+  if (!batch.empty())
+    post();
+
+  // 3. Rows of other folders go back into the cache untouched; rows of
+  // this folder that were not seen again are gone.
+  const QString prefix = m_root + "/";
+  QHash<QString, Row> others;
+  for (auto c = cached.cbegin(); c != cached.cend(); ++c) {
+    if (!c.key().startsWith(prefix))
+      others.insert(c.key(), c.value());
+  }
+  const bool complete = !m_stopping;
+  QMetaObject::invokeMethod(
+      this,
+      [this, others = std::move(others), complete]() mutable {
+        m_otherRoots = std::move(others);
+        m_listing = !complete;
+        emit progress(m_described, static_cast<int>(m_rows.size()),
+                      m_listing);
+      },
+      Qt::QueuedConnection);
+}
+
+void CorpusModel::appendRows(std::vector<Row> rows) {
+  const int first = static_cast<int>(m_rows.size());
+  beginInsertRows(QModelIndex(), first,
+                  first + static_cast<int>(rows.size()) - 1);
+  {
+    QMutexLocker lock(&m_mutex);
+    for (Row &row : rows) {
+      m_pending.push_back(row.done ? QString() : row.path);
+      m_described += row.done;
+      m_rows.push_back(std::move(row));
+    }
+  }
+  endInsertRows();
+  startWorkers();
+  emit progress(m_described, static_cast<int>(m_rows.size()), m_listing);
+}
+
+void CorpusModel::startWorkers() {
+  QMutexLocker lock(&m_mutex);
+  const int limit = std::max(1, m_pool.maxThreadCount() - 1);
+  while (m_workers < limit && m_cursor < m_pending.size()) {
+    ++m_workers;
+    QtConcurrent::run(&m_pool, [this] { work(); });
+  }
+}
+
+void CorpusModel::work() {
+  for (;;) {
+    QString path;
+    int row = -1;
+    {
+      QMutexLocker lock(&m_mutex);
+      if (!m_stopping)
+        row = takeRow(path);
+      if (row < 0) {
+        --m_workers;
+        return;
+      }
+    }
+    CorpusRecord record = describe(path);
+    QMutexLocker lock(&m_mutex);
+    m_results.emplace_back(row, std::move(record));
+  }
+}
+
+int CorpusModel::takeRow(QString &path) {
+  // Rows on screen first, most recently shown first; then in order.
+  while (!m_wanted.empty()) {
+    const int row = m_wanted.back();
+    m_wanted.pop_back();
+    if (!m_pending[row].isEmpty()) {
+      path = std::move(m_pending[row]);
+      m_pending[row].clear();
+      return row;
+    }
+  }
+  for (; m_cursor < m_pending.size(); ++m_cursor) {
+    if (!m_pending[m_cursor].isEmpty()) {
+      path = std::move(m_pending[m_cursor]);
+      m_pending[m_cursor].clear();
+      return static_cast<int>(m_cursor++);
+    }
+  }
+  return -1;
+}
+
+void CorpusModel::want(int row) const {
+  QMutexLocker lock(&m_mutex);
+  if (m_pending[row].isEmpty())
+    return;
+  m_wanted.push_back(row);
+  if (m_wanted.size() > kMaxWanted)
+    m_wanted.pop_front();
+}
+
+void CorpusModel::applyResults(bool notify) {
+  std::vector<std::pair<int, CorpusRecord>> results;
+  {
+    QMutexLocker lock(&m_mutex);
+    results.swap(m_results);
+  }
+  if (results.empty())
+    return;
+
+  int first = INT_MAX;
+  int last = -1;
+  for (auto &result : results) {
+    Row &row = m_rows[result.first];
+    row.record = std::move(result.second);
+    row.done = true;
+    first = std::min(first, result.first);
+    last = std::max(last, result.first);
+  }
+  m_described += static_cast<int>(results.size());
+  m_cacheDirty = true;
+  if (!notify)
+    return;
+  emit dataChanged(index(first, 0), index(last, COLUMN_COUNT - 1));
+  emit progress(m_described, static_cast<int>(m_rows.size()), m_listing);
+}
+
+void CorpusModel::saveCache() {
+  // An interrupted listing has not matched every cached row yet; writing
+  // now would drop the ones it had not reached.
+  if (!m_cacheDirty || m_listing)
+    return;
+  const QString path = cachePath();
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+    return;
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_12);
+  const auto done = std::count_if(m_rows.begin(), m_rows.end(),
+                                  [](const Row &r) { return r.done; });
+  out << kCacheMagic << kCacheVersion
+      << quint32(done + m_otherRoots.size());
+  auto write = [&out](const Row &r) {
+    out << r.path << r.size << r.mtime << r.record;
+  };
+  for (const Row &row : m_rows) {
+    if (row.done)
+      write(row);
+  }
+  for (const Row &row : m_otherRoots)
+    write(row);
+  file.commit();
+}
+
+int CorpusModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int CorpusModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant CorpusModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid())
+    return QVariant();
+  const Row &row = m_rows[index.row()];
+  const CorpusRecord &r = row.record;
+
+  if (role == Qt::ToolTipRole && index.column() == Name)
+    return row.path;
+  if (role == Qt::TextAlignmentRole &&
+      (index.column() == Files || index.column() == Free))
+    return int(Qt::AlignRight | Qt::AlignVCenter);
+  if (role == Qt::DecorationRole && index.column() == Thumbnail && row.done)
+    return r.thumbnail.isNull() ? QVariant() : QVariant(r.thumbnail);
+  if (role != Qt::DisplayRole)
+    return QVariant();
+
+  if (index.column() == Name)
+    return QDir(m_root).relativeFilePath(row.path);
+  if (!row.done) {
+    // The view only asks about rows on screen: describe those next.
+    if (index.column() == Format)
+      want(index.row());
+    return index.column() == Format ? QVariant("...") : QVariant();
+  }
+  if (!r.readable)
+    return index.column() == Format ? QVariant("Unreadable") : QVariant();
+
+  switch (index.column()) {
+  case Format:
+    return r.format;
+  case Label:
+    return r.label;
+  case Files:
+    return r.fileCount;
+  case Free:
+    return QString("%1 KB").arg(r.freeBytes / 1024);
+  case Boot:
+    return r.boot;
+  case Hash:
+    return QString("%1").arg(r.hash, 16, 16, QChar('0'));
+  default:
+    return QVariant();
+  }
+}
+
+QVariant CorpusModel::headerData(int section, Qt::Orientation orientation,
+                                 int role) const {
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    return QVariant();
+  static const char *const names[COLUMN_COUNT] = {
+      "Name", "Format", "Label", "Files", "Free", "Boot", "Hash", "Picture"};
+  return names[section];
+}
+
+// =============================================================================
+//  CorpusBrowser
+// =============================================================================
+
+CorpusBrowser::CorpusBrowser(const QString &root, QWidget *parent)
+    : QWidget(parent, Qt::Window) {
+  setAttribute(Qt::WA_DeleteOnClose);
+  setWindowTitle("Corpus - " + QDir(root).dirName());
+  resize(1000, 600);
+
+  m_model = new CorpusModel(root, this);
+  m_table = new QTableView(this);
+  m_table->setModel(m_model);
+  m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+  m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+  m_table->setWordWrap(false);
+  m_table->setIconSize(kThumbSize);
+  // Fixed row heights keep scrolling independent of the row count.
+  m_table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  m_table->verticalHeader()->setDefaultSectionSize(kThumbSize.height() + 4);
+  m_table->verticalHeader()->hide();
+  m_table->horizontalHeader()->setStretchLastSection(true);
+  m_table->setColumnWidth(CorpusModel::Name, 260);
+  m_table->setColumnWidth(CorpusModel::Format, 150);
+  m_table->setColumnWidth(CorpusModel::Boot, 160);
+  m_table->setColumnWidth(CorpusModel::Hash, 140);
+
+  m_status = new QLabel("Listing...", this);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(m_table);
+  layout->addWidget(m_status);
+
+  connect(m_model, &CorpusModel::progress, this, &CorpusBrowser::onProgress);
+  connect(m_table, &QTableView::activated, this,
+          [this](const QModelIndex &index) {
+            emit imageActivated(m_model->imagePath(index.row()));
+          });
+}
+
+void CorpusBrowser::onProgress(int described, int total, bool listing) {
+  m_status->setText(QString("%1 images%2, %3 described")
+                        .arg(total)
+                        .arg(listing ? " so far" : "")
+                        .arg(described));
+}
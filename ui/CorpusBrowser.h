@@ -0,0 +1,141 @@
+/**
+ * @file CorpusBrowser.h
+ * @brief Table of every disk image under a folder, filled in the
+ * background and remembered between runs.
+ */
+
+#ifndef CORPUSBROWSER_H
+#define CORPUSBROWSER_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include <QWidget>
+#include <atomic>
+#include <deque>
+#include <utility>
+#include <vector>
+
+class QLabel;
+class QTableView;
+
+/**
+ * @struct CorpusRecord
+ * @brief What the browser shows for one image.
+ */
+struct CorpusRecord {
+  bool readable = false; /**< False if the image did not load. */
+  QString format;
+  QString label;
+  int fileCount = 0;
+  qint64 freeBytes = 0;
+  QString boot;     /**< Boot sector category and name. */
+  quint64 hash = 0; /**< Content hash of the whole image. */
+  QImage thumbnail; /**< First DEGAS/NEOchrome picture; null if none. */
+};
+
+/**
+ * @class CorpusModel
+ * @brief Rows for the images under a root folder.
+ *
+ * The folder is listed on the pool and rows arrive in batches. Rows whose
+ * file size and mtime match the on-disk cache are complete at once; the
+ * rest are described by pool workers, rows the view asks for first, and
+ * reach the table in batches every 100 ms. The view only asks about
+ * visible rows, so 50k images cost no more to scroll than 50.
+ */
+class CorpusModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  enum Column { Name, Format, Label, Files, Free, Boot, Hash, Thumbnail };
+  static constexpr int COLUMN_COUNT = Thumbnail + 1;
+
+  explicit CorpusModel(const QString &root, QObject *parent = nullptr);
+
+  /** @brief Stops the workers and writes the cache. */
+  ~CorpusModel() override;
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role) const override;
+
+  /** @return Path to open for a row ("a.zip!/b.st" for zip members). */
+  QString imagePath(int row) const { return m_rows[row].path; }
+
+  /** @return Cache file shared by all corpus windows. */
+  static QString cachePath();
+
+signals:
+  /** @brief Emitted as rows are listed and described. */
+  void progress(int described, int total, bool listing);
+
+private:
+  struct Row {
+    QString path;
+    qint64 size = 0;  /**< Of the host file, for cache validation. */
+    qint64 mtime = 0;
+    bool done = false;
+    CorpusRecord record;
+  };
+
+  /** @brief Reads the cache and lists the folder; runs on the pool. */
+  void list();
+  void appendRows(std::vector<Row> rows);
+  void startWorkers();
+  void work();
+  /** @return Next row to describe, or -1; call with m_mutex held. */
+  int takeRow(QString &path);
+  void want(int row) const;
+  /** @brief Moves finished rows from the workers into the table. */
+  void applyResults(bool notify);
+  void saveCache();
+
+  QString m_root;
+  std::vector<Row> m_rows; // GUI thread only
+  int m_described = 0;
+  bool m_listing = true;
+  bool m_cacheDirty = false;
+  QHash<QString, Row> m_otherRoots; /**< Cached rows outside m_root. */
+
+  // Shared with the pool, under m_mutex
+  mutable QMutex m_mutex;
+  std::vector<QString> m_pending; /**< Path per row; empty once claimed. */
+  std::size_t m_cursor = 0;
+  mutable std::deque<int> m_wanted; /**< Visible rows, newest last. */
+  int m_workers = 0;
+  std::vector<std::pair<int, CorpusRecord>> m_results;
+
+  std::atomic<bool> m_stopping{false};
+  QTimer m_flushTimer;
+  QThreadPool m_pool;
+};
+
+/**
+ * @class CorpusBrowser
+ * @brief Window around a CorpusModel; activating a row opens the image.
+ */
+class CorpusBrowser : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit CorpusBrowser(const QString &root, QWidget *parent = nullptr);
+
+signals:
+  void imageActivated(const QString &path);
+
+private slots:
+  void onProgress(int described, int total, bool listing);
+
+private:
+  CorpusModel *m_model = nullptr;
+  QTableView *m_table = nullptr;
+  QLabel *m_status = nullptr;
+};
+
+#endif
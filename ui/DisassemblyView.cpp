@@ -0,0 +1,210 @@
+#include "DisassemblyView.h"
+#include "GemdosProgram.h"
+#include "M68kDisassembler.h"
+#include <QAbstractListModel>
+#include <QFontDatabase>
+#include <QLabel>
+#include <QListView>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/** Rows discovered per fetchMore() call. */
+constexpr std::size_t kFetchBatch = 512;
+/** Bytes shown per dc.b row. */
+constexpr uint32_t kDataRowBytes = 8;
+
+struct ByteRange {
+  uint32_t begin;
+  uint32_t end;
+};
+
+} // namespace
+
+/**
+ * @class DisassemblyModel
+ * @brief Row offsets are found lazily; text is formatted only in data().
+ */
+class DisassemblyModel : public QAbstractListModel {
+public:
+  using QAbstractListModel::QAbstractListModel;
+
+  void setCode(const QByteArray &bytes, uint32_t codeStart, uint32_t codeSize,
+               std::vector<ByteRange> dataRanges,
+               Atari::M68kSymbolizer symbolizer = {}) {
+    beginResetModel();
+    // Implicit sharing keeps the caller's buffer alive without a copy.
+    m_bytes = bytes;
+    m_codeStart = codeStart;
+    m_dis = std::make_unique<Atari::M68kDisassembler>(codeBytes(), codeSize);
+    m_dis->setSymbolizer(std::move(symbolizer));
+    m_dataRanges = std::move(dataRanges);
+    m_rows.clear();
+    m_scanned = 0;
+    endResetModel();
+  }
+
+  void clear() {
+    beginResetModel();
+    m_dis.reset();
+    m_bytes.clear();
+    m_dataRanges.clear();
+    m_rows.clear();
+    m_scanned = 0;
+    endResetModel();
+  }
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+  }
+
+  bool canFetchMore(const QModelIndex &parent) const override {
+    return !parent.isValid() && m_dis && m_scanned < m_dis->size();
+  }
+
+  void fetchMore(const QModelIndex &parent) override {
+    if (!canFetchMore(parent))
+      return;
+
+    std::vector<uint32_t> batch;
+    batch.reserve(kFetchBatch);
+    while (batch.size() < kFetchBatch && m_scanned < m_dis->size()) {
+      batch.push_back(m_scanned);
+      m_scanned += rowLength(m_scanned);
+    }
+
+    const int first = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), first,
+                    first + static_cast<int>(batch.size()) - 1);
+    m_rows.insert(m_rows.end(), batch.begin(), batch.end());
+    endInsertRows();
+  }
+
+  QVariant data(const QModelIndex &index, int role) const override {
+    if (!index.isValid() || role != Qt::DisplayRole || !m_dis)
+      return QVariant();
+
+    const uint32_t offset = m_rows[index.row()];
+    const uint32_t length = rowLength(offset);
+    const uint8_t *code = codeBytes();
+
+    QString text;
+    if (const ByteRange *r = dataRangeAt(offset)) {
+      text = "dc.b    ";
+      for (uint32_t i = offset; i < std::min(offset + kDataRowBytes, r->end);
+           ++i) {
+        if (i > offset)
+          text += ',';
+        text += QString("$%1").arg(code[i], 2, 16, QChar('0')).toUpper();
+      }
+    } else {
+      text = QString::fromStdString(m_dis->decode(offset).text);
+    }
+
+    QString raw;
+    for (uint32_t i = 0; i < length; ++i)
+      raw += QString("%1").arg(code[offset + i], 2, 16, QChar('0')).toUpper();
+
+    return QString("%1  %2  %3")
+        .arg(m_dis->addressOf(offset), 6, 16, QChar('0'))
+        .arg(raw, -20)
+        .arg(text);
+  }
+
+private:
+  const uint8_t *codeBytes() const {
+    return reinterpret_cast<const uint8_t *>(m_bytes.constData()) +
+           m_codeStart;
+  }
+
+  const ByteRange *dataRangeAt(uint32_t offset) const {
+    for (const ByteRange &r : m_dataRanges)
+      if (offset >= r.begin && offset < r.end)
+        return &r;
+    return nullptr;
+  }
+
+  uint32_t rowLength(uint32_t offset) const {
+    if (const ByteRange *r = dataRangeAt(offset))
+      return std::min(kDataRowBytes, r->end - offset);
+    const uint32_t length = m_dis->decode(offset).length;
+    return length ? length : 1;
+  }
+
+  QByteArray m_bytes;
+  uint32_t m_codeStart = 0;
+  std::unique_ptr<Atari::M68kDisassembler> m_dis;
+  std::vector<ByteRange> m_dataRanges;
+  std::vector<uint32_t> m_rows; /**< Code offset of every discovered row. */
+  uint32_t m_scanned = 0;       /**< Code offset where discovery resumes. */
+};
+
+// =============================================================================
+//  DisassemblyView
+// =============================================================================
+
+DisassemblyView::DisassemblyView(QWidget *parent)
+    : QWidget(parent), m_title(new QLabel(this)), m_list(new QListView(this)),
+      m_model(new DisassemblyModel(this)) {
+  m_list->setModel(m_model);
+  m_list->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  // Uniform rows let the view map scroll position to rows arithmetically.
+  m_list->setUniformItemSizes(true);
+  m_list->setSelectionMode(QAbstractItemView::SingleSelection);
+
+  auto *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->addWidget(m_title);
+  layout->addWidget(m_list);
+  setLayout(layout);
+
+  clear();
+}
+
+void DisassemblyView::setBootSector(const QByteArray &sector) {
+  if (sector.size() < 512) {
+    clear();
+    return;
+  }
+
+  // OEM, serial and BPB sit between the branch and the code; the last word
+  // only balances the checksum.
+  m_model->setCode(sector, 0, 512, {{0x02, 0x1E}, {0x1FE, 0x200}});
+  m_title->setText(tr("Boot sector code"));
+}
+
+bool DisassemblyView::setProgram(const QByteArray &file) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(file.constData());
+  const std::size_t size = static_cast<std::size_t>(file.size());
+
+  Atari::PrgHeader header;
+  std::vector<uint32_t> fixups;
+  if (!Atari::parsePrgHeader(bytes, size, header)) {
+    clear();
+    return false;
+  }
+
+  QString title = tr("PRG: TEXT %1, DATA %2, BSS %3")
+                      .arg(header.textSize)
+                      .arg(header.dataSize)
+                      .arg(header.bssSize);
+  if (Atari::decodePrgRelocations(bytes, size, header, fixups))
+    title += tr(", %1 fixups").arg(fixups.size());
+  else
+    title += tr(", relocation table damaged");
+
+  m_model->setCode(file, header.textOffset(),
+                   header.textSize + header.dataSize,
+                   {{header.textSize, header.textSize + header.dataSize}},
+                   Atari::prgSymbolizer(header, fixups));
+  m_title->setText(title);
+  return true;
+}
+
+void DisassemblyView::clear() {
+  m_model->clear();
+  m_title->setText(tr("No code selected"));
+}
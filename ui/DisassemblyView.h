@@ -0,0 +1,49 @@
+/**
+ * @file DisassemblyView.h
+ * @brief Virtualized 68000 listing shown next to the hex view.
+ */
+
+#ifndef DISASSEMBLYVIEW_H
+#define DISASSEMBLYVIEW_H
+
+#include <QByteArray>
+#include <QWidget>
+
+class QLabel;
+class QListView;
+class DisassemblyModel;
+
+/**
+ * @class DisassemblyView
+ * @brief Lists boot code or a PRG's TEXT segment as 68000 instructions.
+ *
+ * Rows are discovered in batches as the list scrolls (canFetchMore/
+ * fetchMore) and only the rows Qt paints are formatted, so large
+ * executables open immediately.
+ */
+class DisassemblyView : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit DisassemblyView(QWidget *parent = nullptr);
+
+  /** @brief Shows a boot sector; the BPB block is listed as data. */
+  void setBootSector(const QByteArray &sector);
+
+  /**
+   * @brief Shows a GEMDOS executable: TEXT as code, DATA as dc.b rows,
+   * relocated longwords as segment-relative names.
+   * @return False (and clears the view) if the bytes are not a valid PRG.
+   */
+  bool setProgram(const QByteArray &file);
+
+  /** @brief Empties the listing. */
+  void clear();
+
+private:
+  QLabel *m_title = nullptr;
+  QListView *m_list = nullptr;
+  DisassemblyModel *m_model = nullptr;
+};
+
+#endif
@@ -1,16 +1,114 @@
 #include "HexViewWidget.h"
 #include <QDebug>
 #include <QFontDatabase>
+#include <QFontMetricsF>
+#include <QHelpEvent>
+#include <QKeyEvent>
 #include <QLatin1Char>
+#include <QPainter>
+#include <QScrollBar>
 #include <QString>
 #include <QTextBlock>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <QToolTip>
+#include <algorithm>
+#include <functional>
 
-HexViewWidget::HexViewWidget(QWidget *parent)
-    : QWidget(parent), m_textEdit(new QPlainTextEdit(this)) {
+namespace {
 
+// Row layout: "OFFSET  " then 16 x "XX " then two spaces and the ASCII
+constexpr int kHexColumn = 10;
+constexpr int kAsciiColumn = kHexColumn + 16 * 3 + 2;
+
+// Lets the owner draw over the rows being painted and answer tooltips
+class OverlayTextEdit : public QPlainTextEdit {
+public:
+  using QPlainTextEdit::QPlainTextEdit;
+
+  std::function<void(QPainter &, int, const QRectF &)> paintRow;
+  std::function<QString(const QPoint &)> toolTipAt;
+  std::function<bool(QKeyEvent *)> editKey;
+
+protected:
+  void keyPressEvent(QKeyEvent *event) override {
+    if (!editKey || !editKey(event))
+      QPlainTextEdit::keyPressEvent(event);
+  }
+
+  void paintEvent(QPaintEvent *event) override {
+    QPlainTextEdit::paintEvent(event);
+    if (!paintRow)
+      return;
+    QPainter painter(viewport());
+    const int bottom = event->rect().bottom();
+    for (QTextBlock block = firstVisibleBlock(); block.isValid();
+         block = block.next()) {
+      const QRectF rect =
+          blockBoundingGeometry(block).translated(contentOffset());
+      if (rect.top() > bottom)
+        break;
+      paintRow(painter, block.blockNumber(), rect);
+    }
+  }
+
+  bool viewportEvent(QEvent *event) override {
+    if (event->type() == QEvent::ToolTip && toolTipAt) {
+      auto *help = static_cast<QHelpEvent *>(event);
+      const QString tip = toolTipAt(help->pos());
+      if (tip.isEmpty())
+        QToolTip::hideText();
+      else
+        QToolTip::showText(help->globalPos(), tip, viewport());
+      return true;
+    }
+    return QPlainTextEdit::viewportEvent(event);
+  }
+};
+
+// @return Byte in the row under a column, or -1 on the offset or a gap
+int byteAtColumn(int column, int &nibble) {
+  nibble = 0;
+  if (column >= kHexColumn && column < kAsciiColumn - 2 &&
+      (column - kHexColumn) % 3 != 2) {
+    nibble = (column - kHexColumn) % 3;
+    return (column - kHexColumn) / 3;
+  }
+  if (column >= kAsciiColumn && column < kAsciiColumn + 16)
+    return column - kAsciiColumn;
+  return -1;
+}
+
+QColor overlayColor(const Atari::StructureField &field) {
+  const int alpha = field.alternate ? 70 : 35;
+  switch (field.kind) {
+  case Atari::StructureKind::BootSector:
+    return QColor(255, 170, 0, alpha);
+  case Atari::StructureKind::Fat:
+    return QColor(0, 170, 60, alpha);
+  default:
+    return QColor(0, 110, 255, alpha);
+  }
+}
+
+} // namespace
+
+HexViewWidget::HexViewWidget(QWidget *parent) : QWidget(parent) {
+  auto *edit = new OverlayTextEdit(this);
+  edit->paintRow = [this](QPainter &painter, int row, const QRectF &rect) {
+    paintRow(painter, row, rect);
+  };
+  edit->toolTipAt = [this](const QPoint &pos) { return toolTipAt(pos); };
+  edit->editKey = [this](QKeyEvent *event) { return editKey(event); };
+  m_textEdit = edit;
+
+  // Read-only to the text edit itself: bytes are typed over via editKey()
   m_textEdit->setReadOnly(true);
+  m_textEdit->setTextInteractionFlags(Qt::TextSelectableByMouse |
+                                      Qt::TextSelectableByKeyboard);
+  m_textEdit->setUndoRedoEnabled(false);
+  // One block per row keeps block numbers and byte offsets in step
+  m_textEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
 
   // Use a fixed-pitch font for alignment
   const QFont fixedFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
@@ -23,6 +121,7 @@ HexViewWidget::HexViewWidget(QWidget *parent)
 }
 
 void HexViewWidget::setBuffer(const uint8_t *data, int size, int sectorIndex) {
+  m_structure.clear();
   if (!data || size <= 0) {
     m_textEdit->setPlainText(tr("No data available."));
     return;
@@ -95,6 +194,7 @@ void HexViewWidget::setDiskData(const std::vector<unsigned char> &data) {
     html += line + "\n";
   }
 
+  m_structure.setImage(data);
   m_textEdit->setPlainText(html); // Use setPlainText for speed
 
   // Diagnostic verify
@@ -153,6 +253,156 @@ void HexViewWidget::setData(const QByteArray &data) {
   setBuffer(reinterpret_cast<const uint8_t*>(data.constData()), data.size());
 }
 
+void HexViewWidget::setBootSector(const QByteArray &sector) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(sector.constData());
+  setBuffer(bytes, sector.size());
+  m_structure.setImage(std::vector<uint8_t>(bytes, bytes + sector.size()));
+  m_textEdit->viewport()->update();
+}
+
+qreal HexViewWidget::charWidth() const {
+  return QFontMetricsF(m_textEdit->font()).horizontalAdvance(QLatin1Char('0'));
+}
+
+void HexViewWidget::paintRow(QPainter &painter, int row,
+                             const QRectF &rect) const {
+  if (m_structure.isEmpty())
+    return;
+  const uint32_t base = static_cast<uint32_t>(row) * 16;
+  const std::size_t size = m_structure.image().size();
+  const qreal cw = charWidth();
+  const qreal left = rect.left() + m_textEdit->document()->documentMargin();
+  const QPen boundary(QColor(0, 0, 0, 110));
+
+  Atari::StructureField previous;
+  for (uint32_t j = 0; j < 16 && base + j < size; ++j) {
+    for (int nibble = 0; nibble < 2; ++nibble) {
+      const Atari::StructureField field =
+          m_structure.fieldAt(base + j, nibble);
+      const qreal x = left + (kHexColumn + 3 * j + nibble) * cw;
+      if (field.kind != Atari::StructureKind::None)
+        painter.fillRect(QRectF(x, rect.top(), cw, rect.height()),
+                         overlayColor(field));
+      // FAT12 entries can end mid-byte, between the two digits
+      if ((j > 0 || nibble > 0) && field != previous) {
+        const qreal edge = nibble ? x : x - cw / 2;
+        painter.setPen(boundary);
+        painter.drawLine(QPointF(edge, rect.top()),
+                         QPointF(edge, rect.bottom()));
+      }
+      previous = field;
+    }
+    const Atari::StructureField field = m_structure.fieldAt(base + j);
+    if (field.kind != Atari::StructureKind::None)
+      painter.fillRect(QRectF(left + (kAsciiColumn + j) * cw, rect.top(), cw,
+                              rect.height()),
+                       overlayColor(field));
+  }
+}
+
+QString HexViewWidget::toolTipAt(const QPoint &pos) const {
+  if (m_structure.isEmpty())
+    return QString();
+  const int row = m_textEdit->cursorForPosition(pos).blockNumber();
+  const qreal x = pos.x() + m_textEdit->horizontalScrollBar()->value() -
+                  m_textEdit->document()->documentMargin();
+  const int column = static_cast<int>(x / charWidth());
+
+  int nibble = 0;
+  const int byte = byteAtColumn(column, nibble);
+  if (byte < 0)
+    return QString();
+  return m_structure.describe(static_cast<uint32_t>(row) * 16 + byte, nibble);
+}
+
+bool HexViewWidget::editKey(QKeyEvent *event) {
+  const QString text = event->text();
+  if (m_structure.isEmpty() || text.size() != 1 ||
+      (event->modifiers() & (Qt::ControlModifier | Qt::AltModifier)))
+    return false;
+
+  QTextDocument *doc = m_textEdit->document();
+  const int position = m_textEdit->textCursor().selectionStart();
+  const QTextBlock block = doc->findBlock(position);
+  const int column = position - block.position();
+  int nibble = 0;
+  const int byte = byteAtColumn(column, nibble);
+  if (byte < 0)
+    return false;
+  const uint32_t offset =
+      static_cast<uint32_t>(block.blockNumber()) * 16 + byte;
+  if (offset >= m_structure.image().size())
+    return false;
+
+  const uint8_t old = m_structure.image()[offset];
+  const bool inHex = column < kAsciiColumn;
+  uint8_t value;
+  if (inHex) {
+    bool ok = false;
+    const int digit = text.toInt(&ok, 16);
+    if (!ok)
+      return false;
+    value = nibble ? (old & 0xF0) | digit : (old & 0x0F) | (digit << 4);
+  } else {
+    const ushort ch = text.at(0).unicode();
+    if (ch < 32 || ch > 126)
+      return false;
+    value = static_cast<uint8_t>(ch);
+  }
+  emit byteEdited(offset, value);
+
+  // On to the low digit, else the next byte (wrapping onto the next row)
+  uint32_t target = offset;
+  int targetNibble = 1;
+  if (!inHex || nibble == 1) {
+    target = std::min<uint32_t>(offset + 1, m_structure.image().size() - 1);
+    targetNibble = 0;
+  }
+  const int targetColumn =
+      inHex ? kHexColumn + 3 * static_cast<int>(target % 16) + targetNibble
+            : kAsciiColumn + static_cast<int>(target % 16);
+  QTextCursor cursor(doc);
+  cursor.setPosition(doc->findBlockByNumber(target / 16).position() +
+                     targetColumn);
+  m_textEdit->setTextCursor(cursor);
+  m_textEdit->ensureCursorVisible();
+  return true;
+}
+
+void HexViewWidget::updateBytes(uint32_t offset, const QByteArray &bytes) {
+  const std::size_t size = m_structure.image().size();
+  if (m_structure.isEmpty() || offset >= size)
+    return;
+  const auto *data = reinterpret_cast<const uint8_t *>(bytes.constData());
+  const auto length = std::min<uint32_t>(bytes.size(), size - offset);
+  const bool moved = m_structure.update(offset, data, length);
+
+  // Same-length replacements: only the blocks of edited rows relayout
+  QTextDocument *doc = m_textEdit->document();
+  QTextCursor cursor(doc);
+  cursor.beginEditBlock();
+  for (uint32_t i = 0; i < length; ++i) {
+    const QTextBlock block = doc->findBlockByNumber((offset + i) / 16);
+    const int j = static_cast<int>((offset + i) % 16);
+    const uint8_t b = data[i];
+    cursor.setPosition(block.position() + kHexColumn + 3 * j);
+    cursor.setPosition(cursor.position() + 2, QTextCursor::KeepAnchor);
+    cursor.insertText(
+        QStringLiteral("%1").arg(b, 2, 16, QLatin1Char('0')).toUpper());
+    // length() counts the newline; the last row's ASCII may be short
+    if (block.length() - 1 > kAsciiColumn + j) {
+      cursor.setPosition(block.position() + kAsciiColumn + j);
+      cursor.setPosition(cursor.position() + 1, QTextCursor::KeepAnchor);
+      cursor.insertText((b >= 32 && b < 127) ? QChar(b) : QChar('.'));
+    }
+  }
+  cursor.endEditBlock();
+
+  // A new BPB or directory can reshade any row on screen
+  if (moved)
+    m_textEdit->viewport()->update();
+}
+
 void HexViewWidget::scrollToOffset(int offset) {
   if (offset >= 0) {
     scrollToOffset(static_cast<uint32_t>(offset));
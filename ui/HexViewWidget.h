@@ -1,9 +1,16 @@
 #pragma once
 
+#include <QByteArray>
 #include <QPlainTextEdit>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <cstdint>
+#include <vector>
+
+#include "StructureMap.h"
+
+class QKeyEvent;
+class QPainter;
 
 class HexViewWidget : public QWidget {
   Q_OBJECT
@@ -11,15 +18,27 @@ class HexViewWidget : public QWidget {
 public:
   explicit HexViewWidget(QWidget *parent = nullptr);
 
-
-#include <vector>
-
   void setBuffer(const uint8_t *data, int size, int sectorIndex = -1);
   void setData(const QByteArray &data);
+  // Both of these outline BPB, FAT and directory fields, with tooltips
+  void setBootSector(const QByteArray &sector);
   void setDiskData(const std::vector<unsigned char> &data);
   void scrollToOffset(int offset);
   void scrollToOffset(uint32_t offset);
+  // Shows bytes written elsewhere; only their rows are redrawn
+  void updateBytes(uint32_t offset, const QByteArray &bytes);
+
+signals:
+  // Typing over a hex digit or ASCII cell; the owner writes it through
+  void byteEdited(uint32_t offset, uint8_t value);
 
 private:
+  bool editKey(QKeyEvent *event);
+  // Overlays are worked out per painted row, never for the whole buffer
+  void paintRow(QPainter &painter, int row, const QRectF &rect) const;
+  QString toolTipAt(const QPoint &pos) const;
+  qreal charWidth() const;
+
   QPlainTextEdit *m_textEdit;
+  Atari::StructureMap m_structure;
 };
@@ -1,11 +1,26 @@
 #include "MainWindow.h"
+#include "CorpusBrowser.h"
+#include "DisassemblyView.h"
 #include "HexViewWidget.h"
+#include "PictureBrowser.h"
+#include "TextViewWidget.h"
+#include "AsyncEngine.h"
+#include "BootSectorAnalyzer.h"
+#include "Depacker.h"
+#include "FolderSync.h"
+#include "GemdosProgram.h"
+#include "HfeImage.h"
+#include "ImageNormalizer.h"
+#include "ImageTransfer.h"
+#include "ScpImage.h"
+#include "ZipArchive.h"
 #include <QAction>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QHeaderView>
 #include <QIcon>
 #include <QInputDialog>
@@ -16,29 +31,68 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QSplitter>
+#include <QTabBar>
+#include <QTimer>
 #include <QToolBar>
+#include <QVBoxLayout>
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) { setupUi(); }
+namespace {
+/** Images and caches of all tabs; background tabs are trimmed past it. */
+constexpr std::size_t kMemoryBudgetBytes = 64 * 1024 * 1024;
+} // namespace
 
-void MainWindow::setupUi() {
-  /**
-   * Initializes the core logic engine and the filesystem model.
-   */
-  m_engine = new Atari::AtariDiskEngine();
-  m_model = new AtariFileSystemModel(this);
-  m_model->setEngine(m_engine);
+MainWindow::MainWindow(QWidget *parent)
+    : QMainWindow(parent), m_budget(kMemoryBudgetBytes) {
+  setupUi();
+}
+
+MainWindow::~MainWindow() { stopFolderSync(); }
 
-  // 1. Setup the Layout (Splitter for Tree and Hex View)
-  QSplitter *splitter = new QSplitter(Qt::Horizontal, this);
+void MainWindow::setupUi() {
+  // 1. Setup the Layout (Tabs over a Splitter for Tree and Hex View)
+  QWidget *central = new QWidget(this);
+  QVBoxLayout *centralLayout = new QVBoxLayout(central);
+  centralLayout->setContentsMargins(0, 0, 0, 0);
+  centralLayout->setSpacing(0);
+
+  m_tabBar = new QTabBar(central);
+  m_tabBar->setDocumentMode(true);
+  m_tabBar->setExpanding(false);
+  m_tabBar->setTabsClosable(true);
+  // Hovering a drag over a tab shows it, so files can be dropped there.
+  m_tabBar->setChangeCurrentOnDrag(true);
+  m_tabBar->setAcceptDrops(true);
+  connect(m_tabBar, &QTabBar::currentChanged, this,
+          &MainWindow::onTabChanged);
+  connect(m_tabBar, &QTabBar::tabCloseRequested, this,
+          &MainWindow::onTabCloseRequested);
+  // Every place that names the image sets the title; mirror it on the tab.
+  connect(this, &QWidget::windowTitleChanged, this, [this](const QString &t) {
+    if (m_currentSession >= 0)
+      m_tabBar->setTabText(m_currentSession,
+                           t.contains(" - ") ? t.section(" - ", 1)
+                                             : QString("(empty)"));
+  });
+  centralLayout->addWidget(m_tabBar);
+
+  QSplitter *splitter = new QSplitter(Qt::Horizontal, central);
   m_treeView = new QTreeView(this);
-  m_treeView->setModel(m_model);
   m_treeView->header()->setSectionResizeMode(QHeaderView::Stretch);
+  m_treeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  m_treeView->setDragDropMode(QAbstractItemView::DragDrop);
+  m_treeView->setDefaultDropAction(Qt::CopyAction);
+  m_treeView->setDropIndicatorShown(true);
 
   m_hexView = new HexViewWidget(this);
+  m_disasmView = new DisassemblyView(this);
+  m_disasmView->hide();
   splitter->addWidget(m_treeView);
   splitter->addWidget(m_hexView);
+  splitter->addWidget(m_disasmView);
   splitter->setStretchFactor(1, 1);
-  setCentralWidget(splitter);
+  splitter->setStretchFactor(2, 1);
+  centralLayout->addWidget(splitter, 1);
+  setCentralWidget(central);
 
   // Enable context menu for the tree view
   m_treeView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -56,6 +110,11 @@ void MainWindow::setupUi() {
   connect(openAction, &QAction::triggered, this, &MainWindow::onOpenFile);
   fileMenu->addAction(openAction);
 
+  QAction *corpusAction = new QAction("Browse &Corpus...", this);
+  connect(corpusAction, &QAction::triggered, this,
+          &MainWindow::onBrowseCorpus);
+  fileMenu->addAction(corpusAction);
+
   QAction *infoAction = diskMenu->addAction("Disk &Information");
   infoAction->setShortcut(QKeySequence("Ctrl+I"));
   connect(infoAction, &QAction::triggered, this, &MainWindow::onDiskInfo);
@@ -68,6 +127,10 @@ void MainWindow::setupUi() {
   connect(saveAction, &QAction::triggered, this, &MainWindow::onSaveDisk);
   fileMenu->addAction(saveAction);
   fileMenu->insertAction(closeAction, saveAction);
+
+  QAction *hfeAction = new QAction("Export as &HFE...", this);
+  connect(hfeAction, &QAction::triggered, this, &MainWindow::onExportHfe);
+  fileMenu->insertAction(closeAction, hfeAction);
   fileMenu->addAction(closeAction);
 
   QAction *extractAction = new QAction("&Extract Selected File...", this);
@@ -75,6 +138,23 @@ void MainWindow::setupUi() {
   connect(extractAction, &QAction::triggered, this, &MainWindow::onExtractFile);
   fileMenu->addAction(extractAction);
 
+  // Emulators write to the image while it is open here; follow along.
+  m_watchAction = new QAction("&Watch Image File", this);
+  m_watchAction->setCheckable(true);
+  m_watchAction->setChecked(true);
+  connect(m_watchAction, &QAction::toggled, this,
+          &MainWindow::watchImageFile);
+  fileMenu->addAction(m_watchAction);
+
+  m_imageWatcher = new QFileSystemWatcher(this);
+  m_reloadTimer = new QTimer(this);
+  m_reloadTimer->setSingleShot(true);
+  m_reloadTimer->setInterval(200); // Writers come in bursts
+  connect(m_imageWatcher, &QFileSystemWatcher::fileChanged, m_reloadTimer,
+          static_cast<void (QTimer::*)()>(&QTimer::start));
+  connect(m_reloadTimer, &QTimer::timeout, this,
+          &MainWindow::onImageFileChanged);
+
   QAction *newAction = new QAction("&New 720K Disk", this);
   newAction->setShortcut(QKeySequence::New);
   connect(newAction, &QAction::triggered, this, &MainWindow::onNewDisk);
@@ -103,6 +183,12 @@ void MainWindow::setupUi() {
   connect(m_viewFullDiskAction, &QAction::toggled, this,
           &MainWindow::onToggleHexViewMode);
 
+  QAction *disasmAction = mainToolBar->addAction("Disassembly");
+  disasmAction->setCheckable(true);
+  disasmAction->setShortcut(QKeySequence("Ctrl+D"));
+  connect(disasmAction, &QAction::toggled, this,
+          &MainWindow::onToggleDisassembly);
+
   // --- DISK TOOLS ---
   m_formatLabel = new QLabel("Ready", this);
   statusBar()->addPermanentWidget(m_formatLabel);
@@ -114,24 +200,231 @@ void MainWindow::setupUi() {
   QAction *oemAct = diskMenu->addAction("Edit &OEM Label...");
   connect(oemAct, &QAction::triggered, this, &MainWindow::onEditOemLabel);
 
+  QAction *undoEditAct = diskMenu->addAction("&Undo Byte Edit");
+  undoEditAct->setShortcut(QKeySequence::Undo);
+  connect(undoEditAct, &QAction::triggered, this, &MainWindow::onUndoHexEdit);
+
   QAction *fatMapAct = diskMenu->addAction("View &FAT Map");
   connect(fatMapAct, &QAction::triggered, this, &MainWindow::onViewFatTable);
 
+  QAction *fsckAct = diskMenu->addAction("&Check File System");
+  connect(fsckAct, &QAction::triggered, this, &MainWindow::onCheckFileSystem);
+
   QAction *searchAct = diskMenu->addAction("&Search Disk...");
   searchAct->setShortcut(QKeySequence::Find);
   connect(searchAct, &QAction::triggered, this, &MainWindow::onSearchDisk);
 
+  QAction *picturesAct = diskMenu->addAction("Browse &Pictures...");
+  picturesAct->setShortcut(QKeySequence("Ctrl+P"));
+  connect(picturesAct, &QAction::triggered, this,
+          &MainWindow::onBrowsePictures);
+
   QAction *fixBootAct = diskMenu->addAction("Make Disk Bootable");
   connect(fixBootAct, &QAction::triggered, this, &MainWindow::onFixBoot);
 
+  QAction *normalizeAct = diskMenu->addAction("&Normalize Free Space...");
+  connect(normalizeAct, &QAction::triggered, this,
+          &MainWindow::onNormalizeDisk);
+
+  diskMenu->addSeparator();
+  QAction *syncAct = diskMenu->addAction("Sync with F&older...");
+  connect(syncAct, &QAction::triggered, this, &MainWindow::onSyncFolder);
+
   connect(m_treeView, &QTreeView::clicked, this, &MainWindow::onFileSelected);
+  connect(m_hexView, &HexViewWidget::byteEdited, this,
+          &MainWindow::onHexByteEdited);
+  connect(m_treeView, &QTreeView::doubleClicked, this,
+          [this](const QModelIndex &index) {
+            // READMEs and DOCs open as text; everything else stays in hex.
+            const QString name =
+                m_model->data(index, Qt::DisplayRole).toString();
+            if (Atari::isTextFileName(name.toStdString()))
+              onViewAsText();
+          });
 
+  addSession();
   resize(1100, 750);
   setWindowTitle("Atari ST Toolkit");
 }
 
+// =============================================================================
+//  Tabs
+// =============================================================================
+
+void MainWindow::addSession() {
+  auto session = std::make_unique<Session>();
+  session->engine = std::make_unique<Atari::AtariDiskEngine>();
+  session->model = new AtariFileSystemModel(this);
+  session->model->setEngine(session->engine.get());
+  session->title = "Atari ST Toolkit";
+  connect(session->model, &AtariFileSystemModel::entriesDropped, this,
+          &MainWindow::onEntriesDropped);
+
+  Session *s = session.get();
+  Atari::MemoryBudget::Client client;
+  client.residentBytes = [s] {
+    return s->engine->getRawImageData().capacity() + s->model->cacheBytes();
+  };
+  client.dropCaches = [s] { s->model->dropCaches(); };
+  client.pageOut = [this, s] {
+    // Only background tabs are asked, so their fields are up to date.
+    if (s->pagedOut || !s->engine->isLoaded() || s->imagePath.isEmpty() ||
+        isModified(*s))
+      return false;
+    s->engine->load(std::vector<uint8_t>());
+    s->model->refresh();
+    s->pagedOut = true;
+    return true;
+  };
+  session->budgetId = m_budget.add(std::move(client));
+
+  m_sessions.push_back(std::move(session));
+  m_tabBar->addTab("(empty)");
+  m_tabBar->setCurrentIndex(static_cast<int>(m_sessions.size()) - 1);
+}
+
+bool MainWindow::pageIn(Session &session) {
+  if (!session.pagedOut)
+    return true;
+  if (!session.engine->loadImage(session.imagePath))
+    return false;
+  session.pagedOut = false;
+  session.flushedCounter = session.engine->changeCounter();
+  session.model->refresh();
+  return true;
+}
+
+bool MainWindow::isModified(const Session &session) const {
+  if (!session.engine->isLoaded() || session.pagedOut)
+    return false;
+  return session.imagePath.isEmpty() ||
+         session.engine->changeCounter() != session.flushedCounter;
+}
+
+void MainWindow::onTabChanged(int index) {
+  if (index < 0 || index >= static_cast<int>(m_sessions.size()))
+    return;
+  stopFolderSync();
+  if (m_currentSession >= 0 && m_currentSession != index) {
+    Session &old = *m_sessions[m_currentSession];
+    old.imagePath = m_imagePath;
+    old.flushedCounter = m_flushedCounter;
+    old.title = windowTitle();
+  }
+
+  Session &session = *m_sessions[index];
+  m_currentSession = index;
+  if (!pageIn(session)) {
+    session.pagedOut = false;
+    statusBar()->showMessage(
+        "Could not reload " + QFileInfo(session.imagePath).fileName(), 5000);
+    session.imagePath.clear();
+    session.model->refresh();
+  }
+  m_engine = session.engine.get();
+  m_model = session.model;
+  m_imagePath = session.imagePath;
+  m_flushedCounter = session.flushedCounter;
+
+  QItemSelectionModel *oldSelection = m_treeView->selectionModel();
+  m_treeView->setModel(m_model);
+  if (oldSelection)
+    oldSelection->deleteLater(); // A drag may still be running from it
+  m_treeView->expandAll();
+
+  m_hexView->setData(QByteArray());
+  m_disasmView->clear();
+  updateHexDisplay();
+  m_formatLabel->setText(m_engine->isLoaded() ? m_engine->getFormatInfoString()
+                                              : QString("No Disk Loaded"));
+  setWindowTitle(session.title);
+  m_tabBar->setTabToolTip(index, m_imagePath);
+  watchImageFile();
+  // Picks up writes made to the file while the tab was in the background.
+  onImageFileChanged();
+
+  m_budget.touch(session.budgetId);
+  m_budget.enforce();
+}
+
+void MainWindow::onTabCloseRequested(int index) {
+  m_tabBar->setCurrentIndex(index);
+  m_sessions[index]->flushedCounter = m_flushedCounter;
+  m_sessions[index]->imagePath = m_imagePath;
+  if (isModified(*m_sessions[index]) &&
+      QMessageBox::question(this, "Close Image",
+                            "Discard the unsaved changes to this image?") !=
+          QMessageBox::Yes)
+    return;
+  onCloseFile();
+}
+
+void MainWindow::onEntriesDropped(quintptr source,
+                                  const QVector<Atari::DirEntry> &entries,
+                                  uint16_t dirCluster, bool move) {
+  // The source is looked up, never dereferenced: its tab may be closed.
+  Session *from = nullptr;
+  for (const std::unique_ptr<Session> &s : m_sessions) {
+    if (reinterpret_cast<quintptr>(s->model) == source)
+      from = s.get();
+  }
+  if (!from || from->engine.get() == m_engine || !pageIn(*from))
+    return;
+
+  const uint32_t before = m_engine->changeCounter();
+  const uint32_t sourceBefore = from->engine->changeCounter();
+  Atari::TransferReport report;
+  for (const Atari::DirEntry &entry : entries) {
+    if (move)
+      Atari::moveEntry(*from->engine, entry, *m_engine, dirCluster, report);
+    else
+      Atari::copyEntry(*from->engine, entry, *m_engine, dirCluster, report);
+  }
+
+  const std::vector<uint32_t> changed = m_engine->dirtySectorsSince(before);
+  if (!changed.empty()) {
+    m_model->refreshSectors(changed);
+    m_treeView->expandAll();
+    if (m_isFullDiskMode)
+      updateHexDisplay();
+  }
+  // A move edits the source tab too; its tree is patched while hidden.
+  const std::vector<uint32_t> removed =
+      from->engine->dirtySectorsSince(sourceBefore);
+  if (!removed.empty())
+    from->model->refreshSectors(removed);
+
+  // No dialog here: this runs inside the drop event.
+  QString message = QString("%1 %2 file(s) and %3 folder(s) from %4")
+                        .arg(move ? "Moved" : "Copied")
+                        .arg(report.files)
+                        .arg(report.dirs)
+                        .arg(from->title.section(" - ", 1));
+  if (!report.failed.isEmpty())
+    message += "; not copied: " + report.failed.join(", ");
+  statusBar()->showMessage(message, 8000);
+}
+
 void MainWindow::onCloseFile() {
   qDebug() << "[UI] Closing file...";
+  stopFolderSync();
+
+  // With other tabs open, the tab goes; the last tab is only emptied.
+  if (m_sessions.size() > 1) {
+    const int index = m_currentSession;
+    std::unique_ptr<Session> closing = std::move(m_sessions[index]);
+    m_sessions.erase(m_sessions.begin() + index);
+    m_budget.remove(closing->budgetId);
+    m_currentSession = -1;
+    m_tabBar->removeTab(index); // Shows a neighbour through onTabChanged
+    if (m_currentSession < 0)
+      onTabChanged(m_tabBar->currentIndex());
+    closing->model->deleteLater();
+    return;
+  }
+
+  m_imagePath.clear();
+  watchImageFile();
 
   // Reset engine, hex display, and tree model
   if (m_engine) {
@@ -142,6 +435,10 @@ void MainWindow::onCloseFile() {
     m_hexView->setData(QByteArray());
   }
 
+  if (m_disasmView) {
+    m_disasmView->clear();
+  }
+
   if (m_model) {
     m_model->refresh();
   }
@@ -154,24 +451,138 @@ void MainWindow::onCloseFile() {
 }
 
 void MainWindow::onOpenFile() {
-  QString fileName = QFileDialog::getOpenFileName(this, "Open Disk", "",
-                                                  "Atari Disks (*.st *.msa)");
+  QString fileName = QFileDialog::getOpenFileName(
+      this, "Open Disk", "", "Atari Disks (*.st *.msa *.zip *.hfe *.scp)");
 
-  if (!fileName.isEmpty() && m_engine->loadImage(fileName)) {
-    // 1. Structural Analysis
-    m_engine->readRootDirectory();
-    m_model->refresh();
-    m_treeView->expandAll();
-    m_formatLabel->setText(m_engine->getFormatInfoString());
+  if (fileName.endsWith(".hfe", Qt::CaseInsensitive) ||
+      fileName.endsWith(".scp", Qt::CaseInsensitive)) {
+    openTrackImage(fileName);
+    return;
+  }
 
-    // 2. Updated: Use the centralized display logic
-    // This respects whether m_isFullDiskMode is true or false
-    updateHexDisplay();
+  // Zip archives: pick one of the images inside without extracting it
+  if (fileName.endsWith(".zip", Qt::CaseInsensitive)) {
+    Atari::ZipArchive zip(fileName);
+    QStringList images;
+    for (const Atari::ZipMember &m : zip.imageMembers())
+      images << m.name;
 
-    // 3. Reset view to top
-    m_hexView->scrollToOffset(0);
+    if (images.isEmpty()) {
+      QMessageBox::warning(this, "Open Disk",
+                           "No disk images found in this archive.");
+      return;
+    }
 
-    qDebug() << "[UI] File loaded. Hex view mode applied.";
+    bool ok = true;
+    QString member = images.size() == 1
+                         ? images.first()
+                         : QInputDialog::getItem(this, "Open Disk",
+                                                 "Image inside archive:",
+                                                 images, 0, false, &ok);
+    if (!ok)
+      return;
+    fileName = Atari::ZipArchive::memberPath(fileName, member);
+  }
+
+  if (!fileName.isEmpty())
+    openImagePath(fileName);
+}
+
+void MainWindow::openImagePath(const QString &fileName) {
+  // A tab already showing an image keeps it; the new one gets its own.
+  const bool newTab = m_engine->isLoaded();
+  if (newTab)
+    addSession();
+  if (!m_engine->loadImage(fileName)) {
+    if (newTab)
+      onCloseFile();
+    return;
+  }
+  stopFolderSync();
+  m_imagePath = fileName;
+  m_flushedCounter = m_engine->changeCounter();
+  watchImageFile();
+  setWindowTitle("Atari ST Toolkit - " + QFileInfo(fileName).fileName());
+
+  // 1. Structural Analysis
+  m_engine->readRootDirectory();
+  m_model->refresh();
+  m_treeView->expandAll();
+  m_formatLabel->setText(m_engine->getFormatInfoString());
+
+  // 2. Updated: Use the centralized display logic
+  // This respects whether m_isFullDiskMode is true or false
+  updateHexDisplay();
+
+  // 3. Reset view to top
+  m_hexView->scrollToOffset(0);
+
+  qDebug() << "[UI] File loaded. Hex view mode applied.";
+  m_budget.enforce();
+}
+
+void MainWindow::openTrackImage(const QString &path) {
+  std::vector<uint8_t> image;
+  QString error;
+  QString summary;
+  QStringList issues;
+  bool ok;
+  if (path.endsWith(".scp", Qt::CaseInsensitive)) {
+    Atari::ScpReport report;
+    ok = Atari::importScp(path, image, report, error);
+    summary = QString("Decoded %1 tracks x %2 sides x %3 sectors from %4 "
+                      "revolutions: %5 weak, %6 bad, %7 missing")
+                  .arg(report.tracks)
+                  .arg(report.sides)
+                  .arg(report.sectorsPerTrack)
+                  .arg(report.revolutions)
+                  .arg(report.count(Atari::FluxSectorState::Weak))
+                  .arg(report.count(Atari::FluxSectorState::Bad))
+                  .arg(report.count(Atari::FluxSectorState::Missing));
+    for (const Atari::FluxSectorIssue &i : report.issues)
+      issues << QString("Cylinder %1, side %2, sector %3: %4")
+                    .arg(i.cylinder)
+                    .arg(i.side)
+                    .arg(i.sector)
+                    .arg(Atari::fluxSectorStateName(i.state));
+  } else {
+    Atari::HfeReport report;
+    ok = Atari::importHfe(path, image, report, error);
+    summary = QString("Decoded %1 tracks x %2 sides x %3 sectors: %4 bad, "
+                      "%5 missing")
+                  .arg(report.tracks)
+                  .arg(report.sides)
+                  .arg(report.sectorsPerTrack)
+                  .arg(report.badSectors)
+                  .arg(report.missingSectors);
+  }
+  if (!ok) {
+    QMessageBox::critical(this, "Open Disk", error);
+    return;
+  }
+
+  // Tracks cannot be patched in place; saving writes a plain .ST.
+  if (m_engine->isLoaded())
+    addSession();
+  stopFolderSync();
+  m_engine->load(std::move(image));
+  m_imagePath.clear();
+  watchImageFile();
+  m_model->refresh();
+  m_treeView->expandAll();
+  m_formatLabel->setText(m_engine->getFormatInfoString());
+  updateHexDisplay();
+  m_hexView->scrollToOffset(0);
+  setWindowTitle("Atari ST Toolkit - " + QFileInfo(path).fileName());
+  statusBar()->showMessage(summary);
+  m_budget.enforce();
+
+  if (!issues.isEmpty()) {
+    QMessageBox box(QMessageBox::Warning, "Open Disk",
+                    "Some sectors did not read back cleanly.",
+                    QMessageBox::Ok, this);
+    box.setDetailedText(issues.join("\n"));
+    box.exec();
   }
 }
 
@@ -179,12 +590,18 @@ void MainWindow::onFileSelected(const QModelIndex &index) {
   if (!index.isValid())
     return;
 
+  if (m_model->isArchiveMember(index)) {
+    showArchiveMember(index);
+    return;
+  }
+
   Atari::DirEntry entry = m_model->getEntry(index);
   QString name = Atari::AtariDiskEngine::toQString(entry.getFilename());
 
   if (entry.isDirectory()) {
     // We don't show hex for directories currently
     m_hexView->setData(QByteArray());
+    m_disasmView->clear();
     return;
   }
 
@@ -195,11 +612,32 @@ void MainWindow::onFileSelected(const QModelIndex &index) {
     statusBar()->showMessage("Error: Could not read file data", 3000);
   } else {
     m_hexView->setData(fileData);
+    // Non-executables leave the pane empty rather than listing garbage.
+    m_disasmView->setProgram(fileData);
     statusBar()->showMessage(
         QString("Viewing %1 (%2 bytes)").arg(name).arg(fileData.size()));
   }
 }
 
+void MainWindow::showArchiveMember(const QModelIndex &index) {
+  const QString name = m_model->data(index, Qt::DisplayRole).toString();
+  QString error;
+  const QByteArray data = m_model->memberData(index, error);
+  if (!error.isEmpty()) {
+    m_hexView->setData(QByteArray());
+    m_disasmView->clear();
+    statusBar()->showMessage(
+        QString("Cannot decode %1: %2").arg(name, error), 3000);
+    return;
+  }
+
+  m_hexView->setData(data);
+  m_disasmView->setProgram(data);
+  statusBar()->showMessage(QString("Viewing %1 (%2 bytes, from archive)")
+                               .arg(name)
+                               .arg(data.size()));
+}
+
 void MainWindow::onFileLoaded() {
   /**
    * Helper slot called when an image is loaded programmatically or
@@ -220,6 +658,10 @@ void MainWindow::onExtractFile() {
     QMessageBox::warning(this, "Extract", "Please select a file first.");
     return;
   }
+  if (m_model->isArchiveMember(index)) {
+    saveArchiveMember(index);
+    return;
+  }
 
   Atari::DirEntry entry = m_model->getEntry(index);
   if (entry.isDirectory()) {
@@ -256,18 +698,18 @@ void MainWindow::onNewDisk() {
   /**
    * Creates a fresh in-memory 720K master disk.
    */
-  if (m_engine->isLoaded()) {
-    auto res = QMessageBox::question(
-        this, "New Disk", "Clear current disk and create a new 720KB image?");
-    if (res != QMessageBox::Yes)
-      return;
-  }
+  if (m_engine->isLoaded())
+    addSession();
 
+  stopFolderSync();
+  m_imagePath.clear();
+  watchImageFile();
   m_engine->createNew720KImage();
   m_model->refresh();
-  m_hexView->setData(m_engine->getSector(0)); // Show the new bootsector
+  m_hexView->setBootSector(m_engine->getSector(0)); // Show the new bootsector
   m_formatLabel->setText("New 720KB Disk (Unsaved)");
   setWindowTitle("Atari ST Toolkit - [New Disk]");
+  m_budget.enforce();
 }
 
 void MainWindow::onSaveDisk() {
@@ -295,6 +737,9 @@ void MainWindow::onSaveDisk() {
     const std::vector<uint8_t> &data = m_engine->getRawImageData();
     outFile.write(reinterpret_cast<const char *>(data.data()), data.size());
     outFile.close();
+    m_imagePath = savePath;
+    m_flushedCounter = m_engine->changeCounter();
+    watchImageFile();
 
     statusBar()->showMessage("Disk saved successfully: " + savePath, 3000);
     setWindowTitle("Atari ST Toolkit - " + QFileInfo(savePath).fileName());
@@ -303,6 +748,39 @@ void MainWindow::onSaveDisk() {
   }
 }
 
+void MainWindow::onExportHfe() {
+  if (!m_engine->isLoaded()) {
+    QMessageBox::warning(this, "Export HFE", "No disk image in memory.");
+    return;
+  }
+
+  QString path = QFileDialog::getSaveFileName(
+      this, "Export HFE", QDir::homePath(), "HxC Floppy Images (*.hfe)");
+  if (path.isEmpty())
+    return;
+  if (!path.endsWith(".hfe", Qt::CaseInsensitive))
+    path += ".hfe";
+
+  bool ok = false;
+  Atari::HfeOptions options;
+  options.interleave = static_cast<uint32_t>(QInputDialog::getInt(
+      this, "Export HFE", "Sector interleave:", 1, 1, 11, 1, &ok));
+  if (!ok)
+    return;
+  options.skew = static_cast<uint32_t>(QInputDialog::getInt(
+      this, "Export HFE", "Track skew (sectors per cylinder):", 0, 0, 10, 1,
+      &ok));
+  if (!ok)
+    return;
+
+  QString error;
+  if (!Atari::exportHfe(m_engine->getRawImageData(), path, options, error)) {
+    QMessageBox::critical(this, "Export HFE", error);
+    return;
+  }
+  statusBar()->showMessage("Exported " + path, 3000);
+}
+
 void MainWindow::onInjectFile() {
   /**
    * Triggers the engine's file injection logic for the currently loaded disk.
@@ -335,6 +813,19 @@ void MainWindow::onCustomContextMenu(const QPoint &pos) {
   QMenu contextMenu(this);
   contextMenu.addAction("Save File As...", this,
                         &MainWindow::onSaveFileAs); // New
+  if (m_model->isArchiveMember(index) ||
+      !m_model->getEntry(index).isDirectory())
+    contextMenu.addAction("View as Text...", this, &MainWindow::onViewAsText);
+  if (m_model->isArchiveMember(index)) {
+    // Members are read-only views into the archive file.
+    contextMenu.exec(m_treeView->mapToGlobal(pos));
+    return;
+  }
+  if (!m_model->getEntry(index).isDirectory())
+    contextMenu.addAction("Save Depacked As...", this,
+                          &MainWindow::onSaveDepackedAs);
+  if (Atari::isProgramFileName(m_model->getEntry(index).getFilename()))
+    contextMenu.addAction("Program Info...", this, &MainWindow::onProgramInfo);
   contextMenu.addSeparator();
   contextMenu.addAction("Rename File", this, &MainWindow::onRenameFile);
   contextMenu.addAction("Delete File", this, &MainWindow::onDeleteFile);
@@ -380,6 +871,10 @@ void MainWindow::onDiskInfo() {
   // Assuming you added checkBootSector() to the engine as discussed
   Atari::BootSectorInfo boot = m_engine->checkBootSector();
 
+  QByteArray bootSector = m_engine->getSector(0);
+  Atari::BootAnalysis bootCode = Atari::analyzeBootSector(
+      reinterpret_cast<const uint8_t *>(bootSector.constData()));
+
   QString bootStatus =
       boot.isExecutable
           ? "<font color='#00AA00'><b>Executable (Bootable)</b></font>"
@@ -389,6 +884,7 @@ void MainWindow::onDiskInfo() {
                          "<b>OEM Signature:</b> %1<br>"
                          "<b>Boot Status:</b> %2<br>"
                          "<b>Checksum:</b> %3 (Target: 0x1234)<br>"
+                         "<b>Boot Code:</b> %13 &ndash; %14<br>"
                          "<hr>"
                          "<h3>Disk Geometry</h3>"
                          "<b>Mode:</b> %4<br>"
@@ -414,7 +910,9 @@ void MainWindow::onDiskInfo() {
                      .arg(stats.dirCount)
                      .arg(stats.totalClusters)
                      .arg(stats.freeClusters)
-                     .arg(stats.sectorsPerCluster);
+                     .arg(stats.sectorsPerCluster)
+                     .arg(Atari::bootCategoryName(bootCode.category))
+                     .arg(bootCode.name.toHtmlEscaped());
 
   QMessageBox::information(this, "Atari ST Disk Information", info);
 }
@@ -462,6 +960,10 @@ void MainWindow::onSaveFileAs() {
   QModelIndex index = m_treeView->currentIndex();
   if (!index.isValid())
     return;
+  if (m_model->isArchiveMember(index)) {
+    saveArchiveMember(index);
+    return;
+  }
 
   Atari::DirEntry entry = m_model->getEntry(index);
   QString fileName = Atari::AtariDiskEngine::toQString(entry.getFilename());
@@ -483,6 +985,142 @@ void MainWindow::onSaveFileAs() {
   }
 }
 
+void MainWindow::saveArchiveMember(const QModelIndex &index) {
+  const QString name = m_model->data(index, Qt::DisplayRole).toString();
+  QString error;
+  const QByteArray data = m_model->memberData(index, error);
+  if (!error.isEmpty()) {
+    QMessageBox::warning(this, "Extract",
+                         QString("Cannot decode %1: %2.").arg(name, error));
+    return;
+  }
+
+  // Archive paths may carry folders; offer just the leaf name.
+  QString savePath = QFileDialog::getSaveFileName(
+      this, "Extract File", QDir::homePath() + "/" + name.section('/', -1));
+  if (savePath.isEmpty())
+    return;
+
+  QFile file(savePath);
+  if (file.open(QIODevice::WriteOnly) && file.write(data) == data.size()) {
+    statusBar()->showMessage("Extracted to " + savePath, 3000);
+  } else {
+    QMessageBox::critical(this, "Error", "Could not write to local file.");
+  }
+}
+
+void MainWindow::onSaveDepackedAs() {
+  QModelIndex index = m_treeView->currentIndex();
+  if (!index.isValid())
+    return;
+
+  Atari::DirEntry entry = m_model->getEntry(index);
+  QString fileName = Atari::AtariDiskEngine::toQString(entry.getFilename());
+
+  auto depacked = Atari::depackCached(m_engine->fileView(entry));
+  if (!depacked->packed) {
+    QMessageBox::information(this, "Depack",
+                             fileName + " is not packed with a known packer.");
+    return;
+  }
+  if (!depacked->ok) {
+    QMessageBox::warning(this, "Depack",
+                         QString("%1 is packed with %2, but cannot be "
+                                 "depacked: %3.")
+                             .arg(fileName, depacked->format,
+                                  QString::fromStdString(depacked->error)));
+    return;
+  }
+
+  QString savePath =
+      QFileDialog::getSaveFileName(this, "Save Depacked File", fileName);
+  if (savePath.isEmpty())
+    return;
+
+  QFile file(savePath);
+  const auto size = static_cast<qint64>(depacked->data.size());
+  if (file.open(QIODevice::WriteOnly) &&
+      file.write(reinterpret_cast<const char *>(depacked->data.data()),
+                 size) == size) {
+    statusBar()->showMessage(
+        QString("Depacked %1 (%2 bytes) to %3")
+            .arg(depacked->format)
+            .arg(size)
+            .arg(savePath),
+        3000);
+  } else {
+    QMessageBox::critical(this, "Error", "Could not write to local file.");
+  }
+}
+
+void MainWindow::onViewAsText() {
+  QModelIndex index = m_treeView->currentIndex();
+  if (!index.isValid())
+    return;
+
+  const QString name = m_model->data(index, Qt::DisplayRole).toString();
+  QByteArray memberBytes; // Keeps a decoded member alive for the viewer
+  std::vector<uint8_t> fileBytes;
+  Atari::FileView view;
+  if (m_model->isArchiveMember(index)) {
+    QString error;
+    memberBytes = m_model->memberData(index, error);
+    if (!error.isEmpty()) {
+      QMessageBox::warning(this, "View as Text",
+                           QString("Cannot decode %1: %2.").arg(name, error));
+      return;
+    }
+    view = Atari::FileView::fromBuffer(
+        reinterpret_cast<const uint8_t *>(memberBytes.constData()),
+        memberBytes.size());
+  } else {
+    Atari::DirEntry entry = m_model->getEntry(index);
+    if (entry.isDirectory())
+      return;
+    // A copy: watch mode and folder sync keep writing m_image (and may
+    // reallocate it) while the dialog runs and the lines are indexed.
+    fileBytes = m_engine->fileView(entry).toVector();
+    view = Atari::FileView::fromBuffer(fileBytes.data(), fileBytes.size());
+  }
+
+  QDialog dialog(this);
+  dialog.setWindowTitle(name);
+  dialog.resize(760, 560);
+  QVBoxLayout *layout = new QVBoxLayout(&dialog);
+  TextViewWidget *text = new TextViewWidget(&dialog);
+  layout->addWidget(text);
+  QLabel *status = new QLabel(&dialog);
+  layout->addWidget(status);
+  connect(text, &TextViewWidget::linesIndexed, status,
+          [status](int lines, bool complete) {
+            status->setText(QString(complete ? "%1 lines" : "%1 lines...")
+                                .arg(lines));
+          });
+  text->setFile(view);
+  dialog.exec();
+}
+
+void MainWindow::onBrowsePictures() {
+  if (!m_engine->isLoaded())
+    return;
+
+  PictureBrowser browser(*m_engine, this);
+  browser.exec();
+}
+
+void MainWindow::onBrowseCorpus() {
+  const QString dir = QFileDialog::getExistingDirectory(
+      this, "Browse Corpus", QDir::homePath());
+  if (dir.isEmpty())
+    return;
+
+  // A separate window, so several collections can stay open side by side.
+  CorpusBrowser *browser = new CorpusBrowser(dir, this);
+  connect(browser, &CorpusBrowser::imageActivated, this,
+          &MainWindow::openImagePath);
+  browser->show();
+}
+
 void MainWindow::onFormatDisk() {
   if (!m_engine->isLoaded())
     return;
@@ -531,6 +1169,40 @@ void MainWindow::onEditOemLabel() {
   }
 }
 
+void MainWindow::onCheckFileSystem() {
+  if (!m_engine->isLoaded())
+    return;
+  if (!m_async)
+    m_async = new Atari::AsyncEngine(this);
+
+  // Calls run in order, so the check sees this snapshot even if another
+  // tab is shown, or the image edited, before it finishes.
+  const QString name = m_imagePath.isEmpty()
+                           ? QString("the new disk")
+                           : QFileInfo(m_imagePath).fileName();
+  statusBar()->showMessage("Checking " + name + "...");
+  m_async->load(m_engine->getRawImageData());
+  m_async->fsck().then(this, [this, name](const Atari::FsckReport &report) {
+    statusBar()->clearMessage();
+    QString text = QString("%1 files and %2 folders checked on %3.")
+                       .arg(report.files)
+                       .arg(report.dirs)
+                       .arg(name);
+    if (report.isClean()) {
+      QMessageBox::information(this, "Check File System",
+                               text + "\n\nNo problems found.");
+      return;
+    }
+    text += QString("\n\n%1 problems:").arg(report.issues.size());
+    for (const Atari::FsckIssue &i : report.issues)
+      text += QString("\n%1 at cluster %2: %3 %4")
+                  .arg(Atari::fsckProblemName(i.problem))
+                  .arg(i.cluster)
+                  .arg(i.path.isEmpty() ? QString("-") : i.path, i.detail);
+    QMessageBox::warning(this, "Check File System", text);
+  });
+}
+
 void MainWindow::onViewFatTable() {
   if (!m_engine->isLoaded())
     return;
@@ -737,7 +1409,8 @@ void MainWindow::updateHexDisplay() {
              << m_engine->getFullImageBuffer().size() << " bytes)";
   } else {
     // Populates the view with just the 512-byte Boot Sector (Sector 0)
-    m_hexView->setData(m_engine->getSector(0));
+    m_hexView->setBootSector(m_engine->getSector(0));
+    m_disasmView->setBootSector(m_engine->getSector(0));
     qDebug() << "[UI] Hex View: BOOT SECTOR MODE (512 bytes)";
   }
 }
@@ -751,4 +1424,275 @@ void MainWindow::onToggleHexViewMode(bool fullDisk) {
     m_viewFullDiskAction->setText(fullDisk ? "Viewing: Full Disk"
                                            : "Viewing: Boot Sector");
   }
-}
\ No newline at end of file
+}
+
+void MainWindow::onToggleDisassembly(bool visible) {
+  m_disasmView->setVisible(visible);
+}
+
+void MainWindow::onProgramInfo() {
+  QModelIndex index = m_treeView->currentIndex();
+  if (!index.isValid())
+    return;
+
+  Atari::DirEntry entry = m_model->getEntry(index);
+  QString fileName = Atari::AtariDiskEngine::toQString(entry.getFilename());
+  if (entry.isDirectory())
+    return;
+
+  // Parsed in place over the image's clusters; nothing is extracted.
+  Atari::PrgAnalysis prg = Atari::analyzePrg(m_engine->fileView(entry));
+  if (!prg.valid) {
+    QMessageBox::information(this, "Program Info",
+                             fileName + " is not a GEMDOS executable.");
+    return;
+  }
+
+  const Atari::PrgHeader &h = prg.header;
+  QString packer =
+      prg.packer ? QString("%1 (magic at 0x%2)")
+                       .arg(prg.packer)
+                       .arg(prg.packerOffset, 0, 16)
+                 : QString("None detected");
+
+  QString summary =
+      QString("<h3>%1</h3>"
+              "<b>TEXT:</b> %2 bytes<br>"
+              "<b>DATA:</b> %3 bytes<br>"
+              "<b>BSS:</b> %4 bytes<br>"
+              "<b>Symbols:</b> %5 bytes%6<br>"
+              "<b>Flags:</b> 0x%7%8<br>"
+              "<b>Relocation:</b> %9<br>"
+              "<b>Packer:</b> %10")
+          .arg(fileName.toHtmlEscaped())
+          .arg(h.textSize)
+          .arg(h.dataSize)
+          .arg(h.bssSize)
+          .arg(h.symbolSize)
+          .arg(prg.symbolsOk ? "" : " (damaged)")
+          .arg(h.flags, 8, 16, QChar('0'))
+          .arg(h.absolute ? " (absolute)" : "")
+          .arg(prg.relocationsOk
+                   ? QString("%1 fixups").arg(prg.fixups.size())
+                   : QString("damaged after %1 fixups").arg(prg.fixups.size()))
+          .arg(packer.toHtmlEscaped());
+
+  QDialog dlg(this);
+  dlg.setWindowTitle("Program Info");
+  dlg.resize(450, 400);
+  QVBoxLayout *layout = new QVBoxLayout(&dlg);
+  layout->addWidget(new QLabel(summary));
+
+  if (!prg.symbols.empty()) {
+    QListWidget *list = new QListWidget(&dlg);
+    list->setFont(QFont("Monospace", 10));
+    for (const Atari::PrgSymbol &sym : prg.symbols) {
+      list->addItem(QString("%1  %2  %3")
+                        .arg(sym.segmentName(), -4)
+                        .arg(sym.value, 8, 16, QChar('0'))
+                        .arg(QString::fromStdString(sym.name)));
+    }
+    layout->addWidget(list);
+  }
+
+  dlg.exec();
+}
+
+void MainWindow::stopFolderSync() {
+  delete m_sync;
+  m_sync = nullptr;
+}
+
+void MainWindow::onSyncFolder() {
+  if (!m_engine->isLoaded())
+    return;
+
+  const QString dir = QFileDialog::getExistingDirectory(
+      this, "Sync with Folder", QDir::homePath());
+  if (dir.isEmpty())
+    return;
+
+  stopFolderSync();
+  m_sync = new Atari::FolderSync(*m_engine, dir, QString(), this);
+  if (!m_sync->isValid()) {
+    stopFolderSync();
+    QMessageBox::warning(this, "Sync with Folder",
+                         "This image has no writable FAT12 layout.");
+    return;
+  }
+
+  m_flushedCounter = m_engine->changeCounter();
+  connect(m_sync, &Atari::FolderSync::synced, this,
+          &MainWindow::onFolderSynced);
+  onFolderSynced(m_sync->syncNow());
+  m_sync->start();
+}
+
+void MainWindow::onFolderSynced(const Atari::SyncReport &report) {
+  QString message = QString("Synced: %1 to image, %2 to folder")
+                        .arg(report.toImage.size() +
+                             report.removedFromImage.size())
+                        .arg(report.toHost.size() +
+                             report.removedFromHost.size());
+  if (!report.conflicts.isEmpty())
+    message += QString(", %1 conflicts").arg(report.conflicts.size());
+  if (!report.skipped.isEmpty())
+    message += QString(", %1 skipped").arg(report.skipped.size());
+
+  if (report.imageChanged()) {
+    m_engine->readRootDirectory();
+    m_model->refresh();
+    m_treeView->expandAll();
+    updateHexDisplay();
+
+    // Only the sectors the sync touched go back to disk.
+    if (m_imagePath.isEmpty())
+      message += " (image unsaved)";
+    else if (!m_engine->saveChanges(m_imagePath, m_flushedCounter))
+      message += " (could not write " + QFileInfo(m_imagePath).fileName() +
+                 ")";
+    else
+      m_flushedCounter = m_engine->changeCounter();
+  }
+  statusBar()->showMessage(message, 5000);
+}
+
+void MainWindow::watchImageFile() {
+  const QStringList watched = m_imageWatcher->files();
+  if (!watched.isEmpty())
+    m_imageWatcher->removePaths(watched);
+
+  QString path = m_imagePath, archivePath, memberPath;
+  if (Atari::ZipArchive::splitArchivePath(m_imagePath, archivePath,
+                                          memberPath))
+    path = archivePath;
+  if (m_watchAction->isChecked() && !path.isEmpty() && QFileInfo::exists(path))
+    m_imageWatcher->addPath(path);
+}
+
+void MainWindow::onImageFileChanged() {
+  if (m_imagePath.isEmpty() || !m_engine->isLoaded())
+    return;
+  // Writers that replace the file (save to temp, rename) drop the watch.
+  watchImageFile();
+
+  if (m_engine->changeCounter() != m_flushedCounter) {
+    statusBar()->showMessage(
+        "Image changed on disk; not reloaded over unsaved edits", 5000);
+    return;
+  }
+
+  const uint32_t before = m_engine->changeCounter();
+  if (!m_engine->reloadImage(m_imagePath))
+    return;
+  m_flushedCounter = m_engine->changeCounter();
+  const std::vector<uint32_t> changed = m_engine->dirtySectorsSince(before);
+  if (changed.empty())
+    return;
+
+  // Only directories and archives on changed sectors are re-read.
+  m_model->refreshSectors(changed);
+  m_formatLabel->setText(m_engine->getFormatInfoString());
+  if (m_isFullDiskMode || changed.front() == 0)
+    updateHexDisplay();
+  statusBar()->showMessage(
+      QString("Reloaded %1 changed sectors").arg(changed.size()), 3000);
+}
+
+void MainWindow::onHexByteEdited(uint32_t offset, uint8_t value) {
+  if (!m_engine->isLoaded())
+    return;
+  const uint32_t before = m_engine->changeCounter();
+  if (m_engine->patchBytes(offset, QByteArray(1, static_cast<char>(value))))
+    showPatchedBytes(offset, 1, before);
+}
+
+void MainWindow::onUndoHexEdit() {
+  if (!m_engine->isLoaded() || !m_engine->canUndoPatch()) {
+    statusBar()->showMessage("No byte edit to undo", 3000);
+    return;
+  }
+  const uint32_t before = m_engine->changeCounter();
+  uint32_t offset = 0;
+  uint32_t length = 0;
+  if (!m_engine->undoPatch(offset, length)) {
+    statusBar()->showMessage(
+        "Undo history cleared: those bytes have been rewritten since", 5000);
+    return;
+  }
+  showPatchedBytes(offset, length, before);
+  statusBar()->showMessage(
+      QString("Undid edit at offset $%1").arg(offset, 0, 16), 3000);
+}
+
+void MainWindow::showPatchedBytes(uint32_t offset, uint32_t length,
+                                  uint32_t sinceCounter) {
+  const std::vector<uint32_t> changed =
+      m_engine->dirtySectorsSince(sinceCounter);
+  if (changed.empty())
+    return; // Same value typed over itself
+
+  // Directories re-read only where their sectors (or FAT chains) changed.
+  m_model->refreshSectors(changed);
+  const std::vector<unsigned char> &image = m_engine->getFullImageBuffer();
+  m_hexView->updateBytes(
+      offset, QByteArray(reinterpret_cast<const char *>(&image[offset]),
+                         static_cast<int>(length)));
+  if (changed.front() == 0) {
+    m_formatLabel->setText(m_engine->getFormatInfoString());
+    m_disasmView->setBootSector(m_engine->getSector(0));
+  }
+}
+
+void MainWindow::onNormalizeDisk() {
+  if (!m_engine->isLoaded())
+    return;
+  Atari::FatVolume volume = m_engine->volume();
+  if (!volume.isValid()) {
+    QMessageBox::warning(this, "Normalize",
+                         "This image has no writable FAT12 layout.");
+    return;
+  }
+
+  const std::vector<Atari::SlackRegion> slack = Atari::findSlack(volume);
+  if (slack.empty()) {
+    statusBar()->showMessage("Free space and slack are already clear", 3000);
+    return;
+  }
+
+  const auto answer = QMessageBox::question(
+      this, "Normalize",
+      QString("Zero %1 regions of leftover data in free clusters, file "
+              "tails and unused directory slots?\n\n"
+              "Save a forensic copy of them to a folder first?")
+          .arg(slack.size()),
+      QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+  if (answer == QMessageBox::Cancel)
+    return;
+  if (answer == QMessageBox::Yes) {
+    const QString dir = QFileDialog::getExistingDirectory(
+        this, "Save Slack To", QDir::homePath());
+    QString error;
+    if (dir.isEmpty())
+      return;
+    if (!Atari::saveSlack(volume, slack, dir, error)) {
+      QMessageBox::critical(this, "Normalize", error);
+      return;
+    }
+  }
+
+  const Atari::NormalizeReport r = Atari::normalizeImage(volume, slack);
+  updateHexDisplay();
+  QMessageBox::information(
+      this, "Normalize",
+      QString("Cleared %1 bytes of free clusters, %2 of file tails and %3 "
+              "of directory slots.\n\n"
+              "Deflated: %4 -> %5 bytes\nMSA: %6 -> %7 bytes")
+          .arg(r.freeBytes)
+          .arg(r.tailBytes)
+          .arg(r.slotBytes)
+          .arg(r.deflateBefore)
+          .arg(r.deflateAfter)
+          .arg(r.msaBefore)
+          .arg(r.msaAfter));
+}
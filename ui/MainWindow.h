@@ -11,12 +11,25 @@
 #include <QStatusBar>
 #include <QToolBar>
 #include <QTreeView>
+#include <memory>
+#include <vector>
 
 #include "AtariDiskEngine.h"
 #include "AtariFileSystemModel.h"
+#include "MemoryBudget.h"
+
+class QFileSystemWatcher;
+class QTabBar;
+class QTimer;
 
 // Forward declaration of your custom Hex Viewer
 class HexViewWidget;
+class DisassemblyView;
+namespace Atari {
+class AsyncEngine;
+class FolderSync;
+struct SyncReport;
+} // namespace Atari
 
 /**
  * @class MainWindow
@@ -25,6 +38,8 @@ class HexViewWidget;
  *
  * Manages the display of the disk filesystem, hex view of sectors, and
  * high-level actions like opening/saving images and injecting files.
+ * Each open image has its own tab; files dragged from one tab's tree onto
+ * another tab are copied straight between the two images.
  */
 class MainWindow : public QMainWindow {
   Q_OBJECT
@@ -33,8 +48,8 @@ public:
   /** @brief Constructs the main window. */
   explicit MainWindow(QWidget *parent = nullptr);
 
-  /** @brief Default destructor. */
-  ~MainWindow() override = default;
+  /** @brief Stops folder sync before the engines go away. */
+  ~MainWindow() override;
 
 private slots:
   /** @brief Opens a file dialog to select and load an existing disk image (.ST,
@@ -48,9 +63,24 @@ private slots:
   /** @brief Saves the current modified disk image back to a file. */
   void onSaveDisk();
 
-  /** @brief Closes the currently open disk image and resets the UI. */
+  /** @brief Writes the image as MFM tracks for Gotek drives and HxC. */
+  void onExportHfe();
+
+  /** @brief Closes the current tab, or empties it if it is the last. */
   void onCloseFile();
 
+  /** @brief Shows the image of another tab. */
+  void onTabChanged(int index);
+
+  /** @brief Closes a tab, asking first if its image has unsaved changes. */
+  void onTabCloseRequested(int index);
+
+  /** @brief Copies or moves files and folders dragged from another tab
+   * into the current image. */
+  void onEntriesDropped(quintptr source,
+                        const QVector<Atari::DirEntry> &entries,
+                        uint16_t dirCluster, bool move);
+
   /** @brief Handles selection changes in the tree view to update the hex viewer
    * and extraction state. */
   void onFileSelected(const QModelIndex &index);
@@ -92,22 +122,107 @@ private slots:
   /** @brief Views the FAT table. */
   void onViewFatTable();
 
+  /** @brief Checks FAT chains against the directory tree in the
+   * background and reports what is wrong. */
+  void onCheckFileSystem();
+
   /** @brief Searches for a byte pattern in the disk image. */
   void onSearchDisk();
 
   /** @brief Toggles the hex view mode between full disk and sector view. */
   void onToggleHexViewMode(bool fullDisk);
 
+  /** @brief Shows header, relocation, symbol and packer details of the
+   * selected executable. */
+  void onProgramInfo();
+
+  /** @brief Depacks the selected packed file and saves it to the host. */
+  void onSaveDepackedAs();
+
+  /** @brief Opens the selected file in the Atari text viewer. */
+  void onViewAsText();
+
+  /** @brief Opens the thumbnail grid of the pictures on the disk. */
+  void onBrowsePictures();
+
+  /** @brief Opens a corpus browser window over a chosen folder. */
+  void onBrowseCorpus();
+
+  /** @brief Shows or hides the disassembly pane next to the hex view. */
+  void onToggleDisassembly(bool visible);
+
+  /** @brief Zero-fills free clusters, file tails and unused directory
+   * slots, optionally saving them first. */
+  void onNormalizeDisk();
+
+  /** @brief Starts two-way sync between a host folder and the image root. */
+  void onSyncFolder();
+
+  /** @brief Refreshes the tree and saves the image after a sync pass. */
+  void onFolderSynced(const Atari::SyncReport &report);
+
+  /** @brief Follows the image file (or its zip) if watching is enabled. */
+  void watchImageFile();
+
+  /** @brief Pulls in sectors another program wrote to the image file. */
+  void onImageFileChanged();
+
+  /** @brief Writes a byte typed into the hex view through to the image. */
+  void onHexByteEdited(uint32_t offset, uint8_t value);
+
+  /** @brief Reverts the latest byte edit. */
+  void onUndoHexEdit();
+
 private:
   /** @brief Initializes UI components, layouts, and signal/slot connections. */
   void setupUi();
   void updateHexDisplay();
 
+  /** @brief Shows a decoded archive member in the hex and disassembly panes.
+   */
+  void showArchiveMember(const QModelIndex &index);
+  /** @brief Decodes an archive member and saves it to the host. */
+  void saveArchiveMember(const QModelIndex &index);
+  /** @brief Ends a running folder sync, if any. */
+  void stopFolderSync();
+  /** @brief Decodes an HFE or SCP file into an unsaved sector image. */
+  void openTrackImage(const QString &path);
+  /** @brief Loads an image file (or zip member path) and shows it. */
+  void openImagePath(const QString &fileName);
+  /** @brief Refreshes what raw byte edits since a change counter touched. */
+  void showPatchedBytes(uint32_t offset, uint32_t length,
+                        uint32_t sinceCounter);
+
+  /**
+   * @struct Session
+   * @brief One tab. The current tab's engine, model, path and counter are
+   * also held in m_engine, m_model, m_imagePath and m_flushedCounter, and
+   * are written back here when another tab is shown.
+   */
+  struct Session {
+    std::unique_ptr<Atari::AtariDiskEngine> engine;
+    AtariFileSystemModel *model = nullptr;
+    QString imagePath;
+    uint32_t flushedCounter = 0;
+    QString title;         /**< Window title while the tab is shown. */
+    bool pagedOut = false; /**< Image freed by m_budget; reload on use. */
+    int budgetId = 0;
+  };
+
+  /** @brief Adds an empty tab and shows it. */
+  void addSession();
+  /** @brief Reloads a paged-out image from its file. */
+  bool pageIn(Session &session);
+  /** @return True if the tab holds edits not written to its file. */
+  bool isModified(const Session &session) const;
+
   // UI Widgets
   QTreeView *m_treeView =
       nullptr; /**< Displays the FAT12 filesystem hierarchy. */
   HexViewWidget *m_hexView =
       nullptr; /**< Custom widget for viewing raw sector data. */
+  DisassemblyView *m_disasmView =
+      nullptr; /**< 68000 listing of boot code or the selected PRG. */
   QLabel *m_formatLabel =
       nullptr; /**< Status label showing disk geometry information. */
 
@@ -123,6 +238,22 @@ private:
       nullptr; /**< Pointer to the core disk manipulation engine. */
   AtariFileSystemModel *m_model =
       nullptr; /**< Qt Model bridging the engine to the QTreeView. */
+  Atari::FolderSync *m_sync =
+      nullptr; /**< Active folder sync, owned by the window. */
+  Atari::AsyncEngine *m_async =
+      nullptr; /**< Runs long checks on snapshots off the UI thread. */
+  QString m_imagePath; /**< File the image was opened from, if any. */
+  QFileSystemWatcher *m_imageWatcher =
+      nullptr; /**< Watches m_imagePath for writes by other programs. */
+  QTimer *m_reloadTimer = nullptr; /**< Debounces m_imageWatcher. */
+  QAction *m_watchAction = nullptr;
+  uint32_t m_flushedCounter =
+      0; /**< Engine change counter when m_imagePath was last written. */
+
+  QTabBar *m_tabBar = nullptr;
+  std::vector<std::unique_ptr<Session>> m_sessions; /**< One per tab. */
+  int m_currentSession = -1; /**< Index of the tab shown, -1 while none. */
+  Atari::MemoryBudget m_budget; /**< Shared by all tabs' images. */
 };
 
 #endif
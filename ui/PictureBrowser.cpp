@@ -0,0 +1,182 @@
+#include "PictureBrowser.h"
+#include <QCache>
+#include <QDialogButtonBox>
+#include <QLabel>
+#include <QListWidget>
+#include <QPixmap>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+#include <cstring>
+
+namespace {
+
+/** Thumbnail size; every ST resolution scales to it with correct aspect. */
+const QSize kThumbSize(160, 100);
+/** Full-size view: ST pixels are doubled up to square-ish screen pixels. */
+const QSize kFullSize(640, 400);
+/** Thumbnails kept across browser instances. */
+constexpr int kCacheEntries = 512;
+
+QCache<quint64, QImage> &thumbnailCache() {
+  static QCache<quint64, QImage> cache(kCacheEntries);
+  return cache;
+}
+
+QImage toImage(const Atari::StPicture &pic) {
+  QImage img(pic.width, pic.height, QImage::Format_Indexed8);
+  QVector<QRgb> colors(16);
+  for (int i = 0; i < 16; ++i)
+    colors[i] = pic.palette[i];
+  img.setColorTable(colors);
+  for (int y = 0; y < pic.height; ++y)
+    std::memcpy(img.scanLine(y), pic.pixels.data() + y * pic.width,
+                pic.width);
+  return img;
+}
+
+QImage decodePicture(const QByteArray &bytes, int format) {
+  const auto *data = reinterpret_cast<const uint8_t *>(bytes.constData());
+  return PictureBrowser::decode(Atari::FileView::fromBuffer(data, bytes.size()),
+                                static_cast<Atari::PictureFormat>(format));
+}
+
+QImage renderThumbnail(const PictureBrowser::Job &job) {
+  const QImage full = decodePicture(job.bytes, job.format);
+  if (full.isNull())
+    return QImage();
+  return full.scaled(kThumbSize, Qt::IgnoreAspectRatio,
+                     Qt::SmoothTransformation);
+}
+
+QIcon placeholderIcon() {
+  QPixmap blank(kThumbSize);
+  blank.fill(Qt::darkGray);
+  return QIcon(blank);
+}
+
+} // namespace
+
+QImage PictureBrowser::decode(const Atari::FileView &file,
+                              Atari::PictureFormat format) {
+  Atari::StPicture pic;
+  if (!Atari::decodeStPicture(file, format, pic))
+    return QImage();
+  return toImage(pic);
+}
+
+PictureBrowser::PictureBrowser(const Atari::AtariDiskEngine &engine,
+                               QWidget *parent)
+    : QDialog(parent), m_engine(engine) {
+  setWindowTitle("Pictures");
+  resize(760, 520);
+
+  m_grid = new QListWidget(this);
+  m_grid->setViewMode(QListView::IconMode);
+  m_grid->setIconSize(kThumbSize);
+  m_grid->setGridSize(kThumbSize + QSize(24, 36));
+  m_grid->setResizeMode(QListView::Adjust);
+  m_grid->setMovement(QListView::Static);
+  m_grid->setUniformItemSizes(true);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(m_grid);
+
+  collect(engine.readRootDirectory(), QString(), 0);
+  if (m_entries.isEmpty())
+    m_grid->addItem("No DEGAS or NEOchrome pictures on this disk.");
+
+  // Cache hits show up immediately; everything else renders in the pool.
+  const QIcon placeholder = placeholderIcon();
+  for (int row = 0; row < m_entries.size(); ++row) {
+    QListWidgetItem *item = m_grid->item(row);
+    const Atari::FileView view = m_engine.fileView(m_entries[row]);
+    const quint64 hash = view.contentHash();
+    if (QImage *thumb = thumbnailCache().object(hash)) {
+      item->setIcon(QIcon(QPixmap::fromImage(*thumb)));
+      continue;
+    }
+    item->setIcon(placeholder);
+
+    const std::vector<uint8_t> bytes = view.toVector();
+    const Atari::PictureFormat format = Atari::pictureFormatForName(
+        m_entries[row].getFilename());
+    m_jobs.push_back({row, hash, static_cast<int>(format),
+                      QByteArray(reinterpret_cast<const char *>(bytes.data()),
+                                 static_cast<int>(bytes.size()))});
+  }
+
+  connect(&m_watcher, &QFutureWatcher<QImage>::resultReadyAt, this,
+          &PictureBrowser::onThumbnailReady);
+  connect(m_grid, &QListWidget::itemActivated, this,
+          &PictureBrowser::onItemActivated);
+  m_watcher.setFuture(QtConcurrent::mapped(m_jobs, renderThumbnail));
+}
+
+PictureBrowser::~PictureBrowser() {
+  m_watcher.cancel();
+  m_watcher.waitForFinished();
+}
+
+void PictureBrowser::collect(const std::vector<Atari::DirEntry> &entries,
+                             const QString &prefix, int depth) {
+  for (const Atari::DirEntry &e : entries) {
+    if (e.name[0] == '.')
+      continue;
+    const QString path =
+        prefix + Atari::AtariDiskEngine::toQString(e.getFilename());
+    // Same guards as the tree model: bogus clusters and runaway nesting.
+    if (e.isDirectory()) {
+      if (e.getStartCluster() >= 2 && depth < 16)
+        collect(m_engine.readSubDirectory(e.getStartCluster()), path + "/",
+                depth + 1);
+      continue;
+    }
+    if (Atari::pictureFormatForName(e.getFilename()) ==
+        Atari::PictureFormat::Unknown)
+      continue;
+
+    QListWidgetItem *item = new QListWidgetItem(path, m_grid);
+    item->setData(Qt::UserRole, m_entries.size());
+    item->setTextAlignment(Qt::AlignHCenter);
+    m_entries.push_back(e);
+  }
+}
+
+void PictureBrowser::onThumbnailReady(int index) {
+  const Job &job = m_jobs[index];
+  const QImage thumb = m_watcher.resultAt(index);
+  QListWidgetItem *item = m_grid->item(job.row);
+  if (thumb.isNull()) {
+    item->setIcon(QIcon());
+    item->setToolTip("Not a valid picture");
+    return;
+  }
+  thumbnailCache().insert(job.hash, new QImage(thumb));
+  item->setIcon(QIcon(QPixmap::fromImage(thumb)));
+}
+
+void PictureBrowser::onItemActivated(QListWidgetItem *item) {
+  const QVariant row = item->data(Qt::UserRole);
+  if (!row.isValid())
+    return;
+
+  const Atari::DirEntry &entry = m_entries[row.toInt()];
+  const QByteArray bytes = m_engine.readFileQt(entry);
+  const QImage full = decodePicture(
+      bytes, static_cast<int>(
+                 Atari::pictureFormatForName(entry.getFilename())));
+  if (full.isNull())
+    return;
+
+  QDialog view(this);
+  view.setWindowTitle(item->text());
+  QVBoxLayout *layout = new QVBoxLayout(&view);
+  QLabel *label = new QLabel(&view);
+  label->setPixmap(QPixmap::fromImage(
+      full.scaled(kFullSize, Qt::IgnoreAspectRatio, Qt::FastTransformation)));
+  layout->addWidget(label);
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+  connect(buttons, &QDialogButtonBox::rejected, &view, &QDialog::reject);
+  layout->addWidget(buttons);
+  view.exec();
+}
@@ -0,0 +1,64 @@
+/**
+ * @file PictureBrowser.h
+ * @brief Thumbnail grid of the DEGAS and NEOchrome pictures on a disk.
+ */
+
+#ifndef PICTUREBROWSER_H
+#define PICTUREBROWSER_H
+
+#include "AtariDiskEngine.h"
+#include "StPicture.h"
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QVector>
+
+class QListWidget;
+class QListWidgetItem;
+
+/**
+ * @class PictureBrowser
+ * @brief Shows every picture file as a thumbnail; activating one opens it
+ * at full size.
+ *
+ * Thumbnails render on the global thread pool and land in a process-wide
+ * LRU cache keyed by file content hash, so reopening a disk (or another
+ * disk sharing the same pictures) previews instantly.
+ */
+class PictureBrowser : public QDialog {
+  Q_OBJECT
+
+public:
+  /** @brief Collects the pictures; the engine must outlive the dialog. */
+  explicit PictureBrowser(const Atari::AtariDiskEngine &engine,
+                          QWidget *parent = nullptr);
+  ~PictureBrowser() override;
+
+  /** @return The picture as an indexed image, null if it does not decode. */
+  static QImage decode(const Atari::FileView &file,
+                       Atari::PictureFormat format);
+
+  /** @brief Inputs for one background thumbnail render. */
+  struct Job {
+    int row;
+    quint64 hash;
+    int format; /**< Atari::PictureFormat */
+    QByteArray bytes;
+  };
+
+private slots:
+  void onThumbnailReady(int index);
+  void onItemActivated(QListWidgetItem *item);
+
+private:
+  void collect(const std::vector<Atari::DirEntry> &entries,
+               const QString &prefix, int depth);
+
+  const Atari::AtariDiskEngine &m_engine;
+  QListWidget *m_grid = nullptr;
+  QVector<Atari::DirEntry> m_entries;
+  QVector<Job> m_jobs;
+  QFutureWatcher<QImage> m_watcher;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "TextViewWidget.h"
+#include <QFontDatabase>
+#include <QPainter>
+#include <QScrollBar>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+/** Bytes indexed per worker step; small enough to cancel promptly. */
+constexpr uint32_t kIndexChunk = 256 * 1024;
+/** Indexed up front so the first screen paints without waiting. */
+constexpr uint32_t kFirstChunk = 64 * 1024;
+/** How often the scroll range follows the background indexer. */
+constexpr int kProgressMs = 100;
+/** Gap between the viewport edge and the text. */
+constexpr int kMargin = 4;
+
+} // namespace
+
+TextViewWidget::TextViewWidget(QWidget *parent) : QAbstractScrollArea(parent) {
+  setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  viewport()->setBackgroundRole(QPalette::Base);
+  viewport()->setAutoFillBackground(true);
+
+  m_progressTimer.setInterval(kProgressMs);
+  connect(&m_progressTimer, &QTimer::timeout, this,
+          &TextViewWidget::onIndexProgress);
+}
+
+TextViewWidget::~TextViewWidget() { stopIndexing(); }
+
+void TextViewWidget::setFile(const Atari::FileView &file) {
+  stopIndexing();
+  m_file = file;
+  m_index = std::make_shared<Atari::LineIndex>(m_file);
+
+  // Only the first chunk is indexed here; the rest follows in the pool.
+  if (m_index->indexMore(kFirstChunk)) {
+    m_cancel = false;
+    std::shared_ptr<Atari::LineIndex> index = m_index;
+    std::atomic<bool> *cancel = &m_cancel;
+    m_indexing = QtConcurrent::run([index, cancel] {
+      while (!cancel->load() && index->indexMore(kIndexChunk)) {
+      }
+    });
+    m_progressTimer.start();
+  }
+
+  verticalScrollBar()->setValue(0);
+  horizontalScrollBar()->setValue(0);
+  updateScrollBars();
+  emit linesIndexed(static_cast<int>(m_index->lineCount()),
+                    m_index->isComplete());
+  viewport()->update();
+}
+
+void TextViewWidget::clear() {
+  stopIndexing();
+  m_index.reset();
+  m_file = Atari::FileView();
+  updateScrollBars();
+  viewport()->update();
+}
+
+void TextViewWidget::stopIndexing() {
+  m_progressTimer.stop();
+  m_cancel = true;
+  m_indexing.waitForFinished();
+}
+
+void TextViewWidget::onIndexProgress() {
+  const bool done = m_indexing.isFinished();
+  if (done)
+    m_progressTimer.stop();
+
+  const int before = verticalScrollBar()->maximum();
+  updateScrollBars();
+  // Lines that just arrived may fall inside a partly empty viewport.
+  if (verticalScrollBar()->maximum() != before || done)
+    viewport()->update();
+  emit linesIndexed(static_cast<int>(m_index->lineCount()),
+                    m_index->isComplete());
+}
+
+void TextViewWidget::updateScrollBars() {
+  const QFontMetrics fm(font());
+  const int lines = m_index ? static_cast<int>(m_index->lineCount()) : 0;
+  const int visible = std::max(1, viewport()->height() / fm.height());
+  verticalScrollBar()->setRange(0, std::max(0, lines - visible));
+  verticalScrollBar()->setPageStep(visible);
+  verticalScrollBar()->setSingleStep(1);
+
+  // Measured in bytes, so tab-heavy lines may need a little more room.
+  const int charWidth = fm.averageCharWidth();
+  const int longest = m_index ? static_cast<int>(m_index->longestLine()) : 0;
+  const int textWidth = longest * charWidth + 2 * kMargin;
+  horizontalScrollBar()->setRange(
+      0, std::max(0, textWidth - viewport()->width()));
+  horizontalScrollBar()->setPageStep(viewport()->width());
+  horizontalScrollBar()->setSingleStep(charWidth);
+}
+
+void TextViewWidget::resizeEvent(QResizeEvent *event) {
+  QAbstractScrollArea::resizeEvent(event);
+  updateScrollBars();
+}
+
+void TextViewWidget::paintEvent(QPaintEvent *) {
+  if (!m_index)
+    return;
+
+  QPainter painter(viewport());
+  painter.setFont(font());
+  const QFontMetrics fm(font());
+  const int lineHeight = fm.height();
+  const int x = kMargin - horizontalScrollBar()->value();
+  const uint32_t first = static_cast<uint32_t>(verticalScrollBar()->value());
+  const int rows = viewport()->height() / lineHeight + 1;
+
+  std::u16string text;
+  for (int row = 0; row < rows; ++row) {
+    uint32_t begin, end;
+    if (!m_index->line(first + row, begin, end))
+      break;
+    Atari::decodeAtariText(m_file, begin, end, text);
+    painter.drawText(x, row * lineHeight + fm.ascent(),
+                     QString(reinterpret_cast<const QChar *>(text.data()),
+                             static_cast<int>(text.size())));
+  }
+}
@@ -0,0 +1,64 @@
+/**
+ * @file TextViewWidget.h
+ * @brief Virtualized viewer for Atari text files (READMEs, DOCs).
+ */
+
+#ifndef TEXTVIEWWIDGET_H
+#define TEXTVIEWWIDGET_H
+
+#include "AtariText.h"
+#include <QAbstractScrollArea>
+#include <QFuture>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+
+/**
+ * @class TextViewWidget
+ * @brief Paints only the visible lines, decoded from the ST character set
+ * straight out of the file's extents.
+ *
+ * Line offsets are indexed on the global thread pool; the scroll range
+ * grows as batches arrive, so the first screen shows up immediately even
+ * for very large files.
+ */
+class TextViewWidget : public QAbstractScrollArea {
+  Q_OBJECT
+
+public:
+  explicit TextViewWidget(QWidget *parent = nullptr);
+  ~TextViewWidget() override;
+
+  /**
+   * @brief Shows a file and starts indexing its lines.
+   * @param file Must stay valid until clear(), the next setFile() or
+   * destruction.
+   */
+  void setFile(const Atari::FileView &file);
+
+  /** @brief Stops indexing and empties the view. */
+  void clear();
+
+signals:
+  /** @brief Emitted as lines are indexed, and once more when done. */
+  void linesIndexed(int lines, bool complete);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+  void onIndexProgress();
+
+private:
+  void stopIndexing();
+  void updateScrollBars();
+
+  Atari::FileView m_file;
+  std::shared_ptr<Atari::LineIndex> m_index;
+  std::atomic<bool> m_cancel{false};
+  QFuture<void> m_indexing;
+  QTimer m_progressTimer;
+};
+
+#endif